@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace common
+{
+    // FNV-1a
+    constexpr uint64_t message_hash(std::string_view _name) noexcept
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (const auto c : _name)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // message names interned into dense ids, the id of a name is its position in the list.
+    //
+    // the table is built at compile time, a name is looked up by its hash in an open addressing
+    // index twice the size of the list, then compared once. the names are kept for logging
+    template <size_t N>
+    class message_table
+    {
+    public:
+        static constexpr size_t npos = N;
+
+        constexpr explicit message_table(const std::string_view (&_names)[N]) noexcept
+        {
+            for (auto& slot : slots_)
+                slot = npos;
+
+            for (size_t i = 0; i < N; ++i)
+            {
+                names_[i] = _names[i];
+                hashes_[i] = message_hash(_names[i]);
+
+                auto pos = hashes_[i] & slots_mask;
+                while (slots_[pos] != npos)
+                    pos = (pos + 1) & slots_mask;
+                slots_[pos] = i;
+            }
+        }
+
+        // npos for a name not in the list
+        constexpr size_t find(std::string_view _name) const noexcept
+        {
+            const auto hash = message_hash(_name);
+            for (auto pos = hash & slots_mask; slots_[pos] != npos; pos = (pos + 1) & slots_mask)
+            {
+                const auto id = slots_[pos];
+                if (hashes_[id] == hash && names_[id] == _name)
+                    return id;
+            }
+            return npos;
+        }
+
+        constexpr std::string_view name(size_t _id) const noexcept
+        {
+            return _id < N ? names_[_id] : std::string_view();
+        }
+
+        static constexpr size_t size() noexcept { return N; }
+
+        // false if two names are the same or share a hash, for a static_assert next to the list
+        constexpr bool is_collision_free() const noexcept
+        {
+            for (size_t i = 0; i < N; ++i)
+            {
+                for (size_t j = i + 1; j < N; ++j)
+                {
+                    if (hashes_[i] == hashes_[j])
+                        return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        static constexpr size_t get_slots_count() noexcept
+        {
+            size_t count = 1;
+            while (count < 2 * N)
+                count *= 2;
+            return count;
+        }
+
+        static constexpr uint64_t slots_mask = get_slots_count() - 1;
+
+        std::array<std::string_view, N> names_ = {};
+        std::array<uint64_t, N> hashes_ = {};
+        std::array<size_t, get_slots_count()> slots_ = {};
+    };
+}
@@ -5,6 +5,8 @@
 #include "options.h"
 #include "core.h"
 #include "network_log.h"
+#include "../tools/tlv_view.h"
+#include "../tools/system.h"
 
 #include <limits>
 
@@ -18,8 +20,7 @@ namespace
     {
         while (first != last)
         {
-            const auto &header = first->second;
-            if (!header.is_patch() && !header.is_deleted())
+            if (!first->is_patch() && !first->is_deleted())
                 return first;
             ++first;
         }
@@ -45,11 +46,14 @@ enum archive_index_types : uint32_t
     header        = 1,
     msgid        = 2,
     msgflags    = 3,
+    table_generation = 4,
 };
 
-archive_index::archive_index(std::wstring _file_name, std::string _aimid)
+archive_index::archive_index(std::wstring _file_name, std::wstring _table_file_name, std::string _aimid)
     : last_error_(archive::error::ok)
     , storage_(std::make_unique<storage>(std::move(_file_name)))
+    , table_file_name_(std::move(_table_file_name))
+    , table_generation_(0)
     , outgoing_count_(0)
     , loaded_from_local_(false)
     , aimid_(std::move(_aimid))
@@ -95,16 +99,16 @@ bool archive_index::serialize_from(int64_t _from, int64_t _count_early, int64_t
         {
             --iter_header;
 
-            if (iter_header->second.is_patch())
+            if (iter_header->is_patch())
                 continue;
 
             if (not_deleted >= size_type(_count_early))
                 break;
 
-            if (!iter_header->second.is_deleted())
+            if (!iter_header->is_deleted())
                 ++not_deleted;
 
-            _list.emplace_front(iter_header->second);
+            _list.emplace_front(headers_index_.get(iter_header));
         };
     }
     if (_count_later > 0)
@@ -113,14 +117,14 @@ bool archive_index::serialize_from(int64_t _from, int64_t _count_early, int64_t
         auto iter_header = iter_from;
         while (iter_header != headers_end)
         {
-            if (iter_header->second.is_patch() || iter_header->second.is_deleted())
+            if (iter_header->is_patch() || iter_header->is_deleted())
             {
                 ++iter_header;
                 continue;
             }
-            if (!iter_header->second.is_deleted())
+            if (!iter_header->is_deleted())
                 ++not_deleted;
-            _list.emplace_back(iter_header->second);
+            _list.emplace_back(headers_index_.get(iter_header));
             ++iter_header;
 
 
@@ -135,54 +139,85 @@ void archive_index::insert_block(archive::headers_list& _inserted_headers)
 {
     const auto prev_outgoing_count = get_outgoing_count();
 
-    const auto now = std::chrono::seconds(std::time(nullptr));
-
-    for (auto& header : _inserted_headers)
-        insert_header(header, now);
+    insert_headers(_inserted_headers.begin(), _inserted_headers.end(), std::chrono::seconds(std::time(nullptr)));
 
     if (get_outgoing_count() != prev_outgoing_count)
         notify_core_outgoing_msg_count();
 }
 
-void archive_index::insert_header(archive::message_header& header, const std::chrono::seconds _current_time)
+void archive_index::insert_headers(headers_list::iterator _first, headers_list::iterator _last, const std::chrono::seconds _current_time)
 {
-    const auto msg_id = header.get_id();
-    im_assert(msg_id > 0);
-
-    auto existing_iter = headers_index_.find(msg_id);
+    // consecutive new headers falling into one gap of the table are inserted together,
+    // so a block of older history moves the tail of the table once instead of once per header
+    auto run_first = _first;
+    headers_table::size_type run_pos = 0;
 
-    if (existing_iter == headers_index_.end())
+    for (auto it = _first; it != _last; ++it)
     {
-        if (is_outgoing_header(header, _current_time))
-            ++outgoing_count_;
+        const auto msg_id = it->get_id();
+        im_assert(msg_id > 0);
 
-        headers_index_.emplace_hint(
-            headers_index_.end(),
-            std::make_pair(msg_id, std::cref(header))
-        );
+        auto existing = headers_index_.lower_bound(msg_id);
+        auto is_new = (existing == headers_index_.end() || existing->get_id() != msg_id);
+        auto pos = headers_table::size_type(std::distance(headers_index_.begin(), existing));
 
-        return;
+        if (run_first != it)
+        {
+            if (is_new && pos == run_pos && std::prev(it)->get_id() < msg_id)
+            {
+                if (is_outgoing_header(*it, _current_time))
+                    ++outgoing_count_;
+                continue;
+            }
+
+            headers_index_.insert(std::next(headers_index_.begin(), run_pos), run_first, it);
+
+            existing = headers_index_.lower_bound(msg_id);
+            is_new = (existing == headers_index_.end() || existing->get_id() != msg_id);
+            pos = headers_table::size_type(std::distance(headers_index_.begin(), existing));
+        }
+
+        if (is_new)
+        {
+            if (is_outgoing_header(*it, _current_time))
+                ++outgoing_count_;
+
+            run_first = it;
+            run_pos = pos;
+            continue;
+        }
+
+        merge_header(existing, *it);
+        run_first = std::next(it);
     }
 
-    auto &existing_header = existing_iter->second;
-    if (header.is_deleted())
+    if (run_first != _last)
+        headers_index_.insert(std::next(headers_index_.begin(), run_pos), run_first, _last);
+}
+
+void archive_index::merge_header(headers_table::iterator _existing, archive::message_header& _header)
+{
+    auto existing_header = headers_index_.get(_existing);
+    if (_header.is_deleted())
     {
-        auto next = std::next(existing_iter);
-        if (next != headers_index_.end() && next->second.get_prev_msgid() == existing_header.get_id())
-            next->second.set_prev_msgid(existing_header.get_prev_msgid());
+        auto next = std::next(_existing);
+        if (next != headers_index_.end() && next->get_prev_msgid() == existing_header.get_id())
+            next->set_prev_msgid(existing_header.get_prev_msgid());
     }
     else if (existing_header.is_deleted())
     {
-        auto next = std::next(existing_iter);
-        if (next != headers_index_.end() && next->second.get_prev_msgid() == existing_header.get_prev_msgid())
-            next->second.set_prev_msgid(existing_header.get_id());
+        auto next = std::next(_existing);
+        if (next != headers_index_.end() && next->get_prev_msgid() == existing_header.get_prev_msgid())
+            next->set_prev_msgid(existing_header.get_id());
     }
 
-    existing_header.merge_with(header);
+    existing_header.merge_with(_header);
+    headers_index_.set(_existing, existing_header);
+
     if (!existing_header.is_deleted() && !existing_header.is_modified())
-        header = existing_header;
+        _header = std::move(existing_header);
 
-    if (!(header.is_patch() && header.is_modified()))
+    if (!(_header.is_patch() && _header.is_modified()))
         ++merged_count_;
 }
 
@@ -195,7 +230,7 @@ bool archive_index::get_header(int64_t _msgid, message_header& _header) const
 {
     if (const auto iter_header = headers_index_.find(_msgid); iter_header != headers_index_.end())
     {
-        _header = iter_header->second;
+        _header = headers_index_.get(iter_header);
         return true;
     }
     return false;
@@ -251,7 +286,7 @@ void archive_index::serialize_block(const R& _headers, core::tools::binary_strea
     tlv_headers.serialize(_data);
 }
 
-bool archive_index::unserialize_block(core::tools::binary_stream& _data, const std::chrono::seconds _current_time)
+bool archive_index::unserialize_block(core::tools::binary_stream& _data, headers_list& _headers) const
 {
     int64_t tlv_type = 0;
     int64_t tlv_length = 0;
@@ -271,7 +306,7 @@ bool archive_index::unserialize_block(core::tools::binary_stream& _data, const s
         if (!msg_header.unserialize(_data))
             return false;
 
-        insert_header(msg_header, _current_time);
+        _headers.push_back(std::move(msg_header));
     }
     return true;
 }
@@ -287,59 +322,64 @@ archive::storage::result_type archive_index::save_block(const archive::headers_l
     auto p_storage = storage_.get();
     core::tools::auto_scope lb([p_storage]{p_storage->close();});
 
-    core::tools::binary_stream block_data;
-    serialize_block(_block, block_data);
+    data_block_batch batch;
+    serialize_block(_block, batch.begin_block());
 
     int64_t offset = 0;
-    return storage_->write_data_block(block_data, offset);
+    uint32_t size = 0;
+    if (!batch.end_block(offset, size))
+        return { false, std::numeric_limits<std::int32_t>::max() };
+
+    return storage_->write_data_blocks(batch, offset);
 }
 
 bool archive_index::save_all()
 {
-    archive::storage_mode mode;
-    mode.flags_.write_ = true;
-    mode.flags_.truncate_ = true;
-    if (!storage_->open(mode))
+    // the table goes first: if the journal isn't reset after it,
+    // load_from_local finds the table one generation ahead and drops the journal
+    if (!headers_index_.save(table_file_name_, table_generation_ + 1))
         return false;
 
-    auto p_storage = storage_.get();
-    core::tools::auto_scope lb([p_storage]{p_storage->close();});
+    ++table_generation_;
 
-    if (headers_index_.empty())
+    if (reset_journal())
         return true;
 
-    std::vector<message_header> headers;
-
-    headers.reserve(size_t(history_block_size * 1.5));
+    // the blocks saved from now on go to the old journal, the table is put back to its generation
+    // so that load_from_local replays them instead of dropping the journal as stale
+    --table_generation_;
+    if (!headers_index_.save(table_file_name_, table_generation_))
+    {
+        std::stringstream s;
+        s << "archive index: failed to roll back the headers table of " << tools::from_utf16(table_file_name_) << "\r\n";
+        g_core->write_string_to_network_log(s.str());
+    }
 
-    const auto end = headers_index_.cend();
-    const auto iter_last = std::prev(end);
+    return false;
+}
 
-    core::tools::binary_stream block_data;
-    for (auto iter_header = headers_index_.cbegin(); iter_header != end; ++iter_header)
-    {
-        headers.emplace_back(iter_header->second);
+bool archive_index::reset_journal()
+{
+    archive::storage_mode mode;
+    mode.flags_.write_ = true;
+    mode.flags_.truncate_ = true;
+    if (!storage_->open(mode))
+        return false;
 
-        if (iter_header->second.is_modified())
-        {
-            for (const auto& h : iter_header->second.get_modifications())
-                headers.emplace_back(h);
-        }
+    auto p_storage = storage_.get();
+    core::tools::auto_scope lb([p_storage]{p_storage->close();});
 
-        if (headers.size() >= history_block_size || iter_header == iter_last)
-        {
-            serialize_block(headers, block_data);
+    core::tools::tlvpack marker;
+    marker.push_child(core::tools::tlv(archive_index_types::table_generation, table_generation_));
 
-            int64_t offset = 0;
-            if (!storage_->write_data_block(block_data, offset))
-                return false;
+    data_block_batch batch;
+    marker.serialize(batch.begin_block());
 
-            headers.clear();
-            block_data.reset();
-        }
-    }
+    int64_t offset = 0;
+    uint32_t size = 0;
+    batch.end_block(offset, size);
 
-    return true;
+    return storage_->write_data_blocks(batch, offset);
 }
 
 bool archive_index::load_from_local()
@@ -355,9 +395,6 @@ bool archive_index::load_from_local()
         return false;
     }
 
-    auto p_storage = storage_.get();
-    core::tools::auto_scope lb([p_storage]{p_storage->close();});
-
     auto tmp_headers = std::move(headers_index_);
     headers_index_.clear();
     outgoing_count_ = 0;
@@ -365,31 +402,109 @@ bool archive_index::load_from_local()
 
     const auto now = std::chrono::seconds(std::time(nullptr));
 
-    core::tools::binary_stream data_stream;
-    while (storage_->read_data_block(-1, data_stream))
+    const auto merge_tmp_headers = [this, &tmp_headers, now]()
+    {
+        headers_list headers;
+        for (auto it = tmp_headers.begin(); it != tmp_headers.end(); ++it)
+            headers.push_back(tmp_headers.get(it));
+
+        insert_headers(headers.begin(), headers.end(), now);
+    };
+
+    const auto load_table = [this, now]()
+    {
+        const auto generation = headers_index_.load(table_file_name_);
+        for (const auto& header : headers_index_)
+        {
+            if (is_outgoing_header(header, now))
+                ++outgoing_count_;
+        }
+        return generation;
+    };
+
+    auto need_reset_journal = false;
     {
-        if (!unserialize_block(data_stream, now))
+        auto p_storage = storage_.get();
+        core::tools::auto_scope lb([p_storage]{p_storage->close();});
+
+        auto first_block = true;
+
+        headers_list headers;
+        core::tools::binary_stream data_stream;
+        while (storage_->read_data_block(-1, data_stream))
         {
-            for (auto &x : tmp_headers)
-                insert_header(x.second, now);
+            if (std::exchange(first_block, false))
+            {
+                // an index written before the header table has no marker and holds all headers
+                core::tools::tlv_view marker;
+                const auto marker_data = std::string_view(data_stream.get_data_for_log(), size_t(data_stream.available()));
+                const auto generation = marker.unserialize(marker_data) ? marker.get_item(archive_index_types::table_generation) : nullptr;
+                if (generation)
+                {
+                    const auto journal_generation = generation->get_value<int64_t>();
+                    const auto table_generation = load_table();
+                    if (!table_generation || (*table_generation != journal_generation && *table_generation != journal_generation + 1))
+                    {
+                        headers_index_.clear();
+                        outgoing_count_ = 0;
+                        merge_tmp_headers();
+
+                        last_error_ = archive::error::parse_headers;
+
+                        return false;
+                    }
+
+                    table_generation_ = *table_generation;
+
+                    // the table was saved but the journal wasn't reset, the table has all of it
+                    if (*table_generation != journal_generation)
+                    {
+                        need_reset_journal = true;
+                        break;
+                    }
+
+                    data_stream.reset();
+                    continue;
+                }
+            }
+
+            headers.clear();
+            if (!unserialize_block(data_stream, headers))
+            {
+                merge_tmp_headers();
 
-            last_error_ = archive::error::parse_headers;
+                last_error_ = archive::error::parse_headers;
 
-            return false;
+                return false;
+            }
+
+            insert_headers(headers.begin(), headers.end(), now);
+
+            data_stream.reset();
         }
 
-        data_stream.reset();
-    }
+        // the journal was truncated but its marker wasn't written
+        if (first_block && tools::system::is_exist(table_file_name_))
+        {
+            if (const auto table_generation = load_table())
+            {
+                table_generation_ = *table_generation;
+                need_reset_journal = true;
+            }
+        }
 
-    for (auto &x : tmp_headers)
-        insert_header(x.second, now);
+        merge_tmp_headers();
 
-    if (storage_->get_last_error() != archive::error::end_of_file)
-    {
-        last_error_ = storage_->get_last_error();
-        return false;
+        if (!need_reset_journal && storage_->get_last_error() != archive::error::end_of_file)
+        {
+            last_error_ = storage_->get_last_error();
+            return false;
+        }
     }
 
+    if (need_reset_journal)
+        reset_journal();
+
     loaded_from_local_ = true;
 
     drop_outdated_headers(now);
@@ -402,7 +517,7 @@ bool archive_index::load_from_local()
 void archive_index::drop_header(int64_t _msgid)
 {
     if (auto it = headers_index_.find(_msgid); it != headers_index_.end())
-        headers_index_.erase(it);
+        headers_index_.erase(it, std::next(it));
 }
 
 void archive_index::delete_up_to(const int64_t _to)
@@ -421,19 +536,15 @@ void archive_index::delete_up_to(const int64_t _to)
         return;
     }
 
-    auto &header = iter->second;
-
-    const auto is_del_up_to_found = (header.get_id() == _to);
+    const auto is_del_up_to_found = (iter->get_id() == _to);
 
     if (is_del_up_to_found)
     {
-        const auto iter_after_deleted = std::next(iter);
-
-        headers_index_.erase(headers_index_.begin(), iter_after_deleted);
+        const auto iter_after_deleted = headers_index_.erase(headers_index_.begin(), std::next(iter));
 
         if (iter_after_deleted != headers_index_.end())
         {
-            auto &header_after_deleted = iter_after_deleted->second;
+            auto &header_after_deleted = *iter_after_deleted;
             if (header_after_deleted.get_prev_msgid() == _to)
             {
                 header_after_deleted.set_prev_msgid(-1);
@@ -459,7 +570,7 @@ int64_t archive_index::get_last_msgid() const
     if (headers_index_.empty())
         return -1;
 
-    return headers_index_.rbegin()->first;
+    return headers_index_.rbegin()->get_id();
 }
 
 int64_t archive_index::get_first_msgid() const
@@ -467,7 +578,7 @@ int64_t archive_index::get_first_msgid() const
     if (headers_index_.empty())
         return -1;
 
-    return headers_index_.begin()->first;
+    return headers_index_.begin()->get_id();
 }
 
 int32_t archive_index::get_outgoing_count() const
@@ -477,7 +588,8 @@ int32_t archive_index::get_outgoing_count() const
     return outgoing_count_;
 }
 
-bool archive_index::is_outgoing_header(const message_header& _header, const std::chrono::seconds _current_time) const
+template <typename H>
+bool archive_index::is_outgoing_header(const H& _header, const std::chrono::seconds _current_time) const
 {
     return _header.is_outgoing() && _current_time - std::chrono::seconds(_header.get_time()) <= outgoing_count_time_span;
 }
@@ -487,18 +599,17 @@ void archive_index::drop_outdated_headers(const std::chrono::seconds _current_ti
     if (headers_index_.empty())
         return;
 
-    auto it = std::next(headers_index_.end(), -std::min(static_cast<long>(drop_headers_count), static_cast<long>(headers_index_.size())));
-    auto& last_header = it->second;
+    const auto it = std::next(headers_index_.end(), -std::min(static_cast<long>(drop_headers_count), static_cast<long>(headers_index_.size())));
 
-    if (last_header.get_version() < reactions_header_version)
+    if (it->get_version() < reactions_header_version)
     {
-        auto lastIt = std::next(headers_index_.end(), -1);
-        while (it != headers_index_.end() && it != lastIt)
+        const auto lastIt = std::next(headers_index_.end(), -1);
+        for (auto outdated = it; outdated != lastIt; ++outdated)
         {
-            if (is_outgoing_header(it->second, _current_time))
+            if (is_outgoing_header(*outdated, _current_time))
                 outgoing_count_--;
-            it = headers_index_.erase(it);
         }
+        headers_index_.erase(it, lastIt);
     }
 }
 
@@ -515,7 +626,7 @@ bool archive_index::has_hole_in_range(int64_t _msgid, int32_t _count_before, int
     auto after = _count_after, before = 0;
     while (iter_cursor != headers_index_.crend())
     {
-        const auto& current_header = iter_cursor->second;
+        const auto& current_header = *iter_cursor;
         im_assert(!current_header.is_patch() || current_header.is_updated_message());
         if (current_header.get_id() == _msgid)
         {
@@ -550,7 +661,7 @@ bool archive_index::has_hole_in_range(int64_t _msgid, int32_t _count_before, int
             return false;
         }
 
-        const auto& prev_header = iter_next->second;
+        const auto& prev_header = *iter_next;
         im_assert(!prev_header.is_patch() || prev_header.is_updated_message());
 
         if (current_header.get_prev_msgid() != prev_header.get_id())
@@ -586,14 +697,14 @@ archive::archive_hole_error archive_index::get_next_hole(int64_t _from, archive_
     const auto is_from_specified = (_from != -1);
     if (is_from_specified)
     {
-        const auto last_header_key = iter_cursor->first;
+        const auto last_header_key = iter_cursor->get_id();
 
         const auto is_hole_at_the_end = (last_header_key < _from);
         if (is_hole_at_the_end)
         {
             // if "from" from dlg_state (still not in index obviously)
 
-            im_assert(iter_cursor->second.get_id() == last_header_key);
+            im_assert(iter_cursor->get_id() == last_header_key);
 
             _hole.set_from(-1);
             _hole.set_to(last_header_key);
@@ -623,7 +734,7 @@ archive::archive_hole_error archive_index::get_next_hole(int64_t _from, archive_
     {
         ++current_depth;
 
-        const auto &current_header = iter_cursor->second;
+        const auto &current_header = *iter_cursor;
         im_assert(!current_header.is_patch() || current_header.is_updated_message());
 
         const auto iter_next = skip_patches_and_deleted_forward(std::next(iter_cursor), headers_index_.crend());
@@ -640,7 +751,7 @@ archive::archive_hole_error archive_index::get_next_hole(int64_t _from, archive_
             return archive_hole_error::last_reached;
         }
 
-        const auto &prev_header = iter_next->second;
+        const auto &prev_header = *iter_next;
         im_assert(!prev_header.is_patch() || prev_header.is_updated_message());
 
         if (current_header.get_prev_msgid() != prev_header.get_id())
@@ -664,9 +775,9 @@ archive::archive_hole_error archive_index::get_next_hole(int64_t _from, archive_
 std::vector<int64_t> core::archive::archive_index::get_messages_for_update() const
 {
     std::vector<int64_t> ids;
-    for (const auto& [id, header] : headers_index_)
+    for (const auto& header : headers_index_)
         if (header.is_updated_message())
-            ids.push_back(id);
+            ids.push_back(header.get_id());
     return ids;
 }
 
@@ -679,12 +790,13 @@ int64_t archive_index::validate_hole_request(const archive_hole& _hole, const in
         if (_hole.get_from() <= 0 || _hole.get_to() <= 0 || abs(_count) <= 1)
             break;
 
-        auto from_iter = headers_index_.find(_hole.get_from());
-        if (from_iter == headers_index_.end())
+        const auto& headers_index = headers_index_;
+        auto from_iter = headers_index.find(_hole.get_from());
+        if (from_iter == headers_index.end())
             break;
 
         auto iter_cursor = std::make_reverse_iterator(++from_iter);
-        if (iter_cursor->second.is_patch())
+        if (iter_cursor->is_patch())
             break;
 
         const auto iter_prev = skip_patches_and_deleted_forward(std::next(iter_cursor), headers_index_.rend());
@@ -692,9 +804,9 @@ int64_t archive_index::validate_hole_request(const archive_hole& _hole, const in
         if (iter_prev == headers_index_.rend())
             break;
 
-        if (iter_prev->first != iter_cursor->second.get_prev_msgid())
+        if (iter_prev->get_id() != iter_cursor->get_prev_msgid())
         {
-            ret_from = iter_prev->first;
+            ret_from = iter_prev->get_id();
         }
     }
     while (false);
@@ -714,7 +826,7 @@ void archive_index::filter_deleted(std::vector<int64_t>& _ids) const
     auto pred = [this](auto id)
     {
         if (const auto it = headers_index_.find(id); it != headers_index_.end())
-            return it->second.is_patch() || it->second.is_deleted() || it->second.is_modified();
+            return it->is_patch() || it->is_deleted() || it->is_modified();
         return true;
     };
     _ids.erase(std::remove_if(_ids.begin(), _ids.end(), pred), _ids.end());
@@ -737,7 +849,7 @@ void archive_index::optimize()
 
         im_assert(!headers_index_.empty());
         if (!headers_index_.empty())
-            headers_index_.begin()->second.set_prev_msgid(-1);
+            headers_index_.begin()->set_prev_msgid(-1);
     }
 
     g_core->write_string_to_network_log(s.str());
@@ -751,17 +863,7 @@ void archive_index::make_holes()
 {
     srand(time(nullptr));
 
-    for (auto iter = std::begin(headers_index_), end = std::end(headers_index_); iter != end;)
-    {
-        int32_t cnt = rand() % 2;
-
-        auto iter_erase = iter;
-
-        ++iter;
-
-        if (cnt == 0)
-            headers_index_.erase(iter_erase);
-    }
+    headers_index_.erase_if([](const packed_header&) { return rand() % 2 == 0; });
 }
 
 void archive_index::invalidate()
@@ -769,7 +871,7 @@ void archive_index::invalidate()
     if (headers_index_.empty())
         return;
 
-    message_header hdr_last = headers_index_.crbegin()->second;
+    message_header hdr_last = headers_index_.get(std::prev(headers_index_.end()));
     hdr_last.set_prev_msgid(hdr_last.get_prev_msgid());
     hdr_last.set_id(INT64_MAX);
 
@@ -782,10 +884,9 @@ void archive_index::invalidate_message_data(int64_t _msgid, mark_as_updated _mar
 {
     if (auto it = headers_index_.find(_msgid); it != headers_index_.end())
     {
-        auto& header = it->second;
-        header.invalidate_data_offset();
-        if (_mark_as_updated == mark_as_updated::yes && !header.is_patch())
-            header.set_updated(true); // to request messages from server
+        it->invalidate_data_offset();
+        if (_mark_as_updated == mark_as_updated::yes && !it->is_patch())
+            it->set_updated(); // to request messages from server
     }
 }
 
@@ -811,13 +912,13 @@ void archive_index::invalidate_message_data(int64_t _from, int64_t _before_count
         {
             --iter_header;
 
-            if (iter_header->second.is_patch())
+            if (iter_header->is_patch())
                 continue;
 
             if (remaining-- <= 0)
                 break;
 
-            iter_header->second.invalidate_data_offset();
+            iter_header->invalidate_data_offset();
         };
     }
     if (_after_count > 0)
@@ -826,14 +927,14 @@ void archive_index::invalidate_message_data(int64_t _from, int64_t _before_count
         auto remaining = _after_count;
         while (iter_header != headers_end)
         {
-            if (iter_header->second.is_patch())
+            if (iter_header->is_patch())
             {
                 ++iter_header;
                 continue;
             }
             if (remaining-- <= 0)
                 break;
-            iter_header->second.invalidate_data_offset();
+            iter_header->invalidate_data_offset();
             ++iter_header;
         };
     }
@@ -849,7 +950,5 @@ void archive_index::free()
 
 int64_t archive_index::get_memory_usage() const
 {
-    const int32_t map_node_size = 40;
-
-    return (headers_index_.size() * (sizeof(message_header) + sizeof(int64_t) + map_node_size));
+    return headers_index_.get_memory_usage();
 }
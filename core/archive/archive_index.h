@@ -8,6 +8,7 @@
 #include "message_flags.h"
 #include "errors.h"
 #include "storage.h"
+#include "headers_table.h"
 
 namespace core
 {
@@ -19,8 +20,6 @@ namespace core
         typedef std::list<message_header> headers_list;
         typedef std::shared_ptr<headers_list> headers_list_sptr;
 
-        typedef std::map<int64_t, message_header> headers_map;
-
         class archive_hole
         {
             int64_t from_ = -1;
@@ -56,8 +55,10 @@ namespace core
         class archive_index
         {
             archive::error last_error_;
-            headers_map headers_index_;
+            headers_table headers_index_;
             std::unique_ptr<storage> storage_;
+            const std::wstring table_file_name_;
+            int64_t table_generation_;
             int32_t outgoing_count_;
             bool loaded_from_local_;
             std::string aimid_;
@@ -66,14 +67,19 @@ namespace core
 
             template <typename R>
             void serialize_block(const R& _headers, core::tools::binary_stream& _data) const;
-            bool unserialize_block(core::tools::binary_stream& _data, const std::chrono::seconds _current_time);
+            bool unserialize_block(core::tools::binary_stream& _data, headers_list& _headers) const;
             void insert_block(archive::headers_list& _headers);
-            void insert_header(archive::message_header& header, const std::chrono::seconds _current_time);
+            void insert_headers(headers_list::iterator _first, headers_list::iterator _last, const std::chrono::seconds _current_time);
+            void merge_header(headers_table::iterator _existing, archive::message_header& _header);
+
+            // _idx holds the blocks appended after the header table was saved, the first block is the table generation
+            bool reset_journal();
 
             void notify_core_outgoing_msg_count();
 
             int32_t get_outgoing_count() const;
-            bool is_outgoing_header(const archive::message_header& _header, const std::chrono::seconds _current_time) const;
+            template <typename H>
+            bool is_outgoing_header(const H& _header, const std::chrono::seconds _current_time) const;
 
             void drop_outdated_headers(const std::chrono::seconds _current_time);
 
@@ -129,7 +135,7 @@ namespace core
             void invalidate_message_data(int64_t _from, int64_t _before_count, int64_t _after_count);
             int64_t get_memory_usage() const;
 
-            archive_index(std::wstring _file_name, std::string _aimid);
+            archive_index(std::wstring _file_name, std::wstring _table_file_name, std::string _aimid);
             ~archive_index();
         };
 
@@ -42,8 +42,8 @@ using namespace archive;
 
 contact_archive::contact_archive(std::wstring _archive_path, const std::string& _contact_id)
     : path_(std::move(_archive_path))
-    , index_(std::make_unique<archive_index>(su::wconcat(path_, L'/', index_filename()), _contact_id))
-    , data_(std::make_unique<messages_data>(su::wconcat(path_, L'/', db_filename())))
+    , index_(std::make_unique<archive_index>(su::wconcat(path_, L'/', index_filename()), su::wconcat(path_, L'/', index_table_filename()), _contact_id))
+    , data_(std::make_unique<messages_data>(su::wconcat(path_, L'/', db_filename()), su::wconcat(path_, L'/', search_index_filename())))
     , state_(std::make_unique<archive_state>(su::wconcat(path_, L'/', dlg_state_filename()), _contact_id))
     , mentions_(std::make_unique<mentions_me>(su::wconcat(path_, L'/', mentions_filename())))
     , gallery_(std::make_unique<gallery_storage>(su::wconcat(path_, L'/', gallery_cache_filename()), su::wconcat(path_, L'/', gallery_state_filename())))
@@ -577,12 +577,20 @@ void contact_archive::optimize()
 {
     if (index_->need_optimize())
         index_->optimize();
+
+    data_->update_search_index();
+}
+
+bool contact_archive::update_search_index(int64_t _max_size)
+{
+    return data_->update_search_index(_max_size);
 }
 
 void contact_archive::free()
 {
     index_->free();
     gallery_->free();
+    data_->free();
 
     local_loaded_ = false;
 }
@@ -663,6 +671,18 @@ std::wstring_view archive::index_filename() noexcept
     return filename;
 }
 
+std::wstring_view archive::index_table_filename() noexcept
+{
+    static std::wstring filename = get_history_filename(L"_hidx");
+    return filename;
+}
+
+std::wstring_view archive::search_index_filename() noexcept
+{
+    static std::wstring filename = get_history_filename(L"_sidx");
+    return filename;
+}
+
 std::wstring_view archive::dlg_state_filename() noexcept
 {
     static std::wstring filename = get_history_filename(L"_ste");
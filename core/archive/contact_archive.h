@@ -112,6 +112,7 @@ namespace core
 
             bool need_optimize() const;
             void optimize();
+            bool update_search_index(int64_t _max_size);
             void free();
 
             void delete_messages_up_to(const int64_t _up_to);
@@ -145,6 +146,8 @@ namespace core
 
         std::wstring_view db_filename() noexcept;
         std::wstring_view index_filename() noexcept;
+        std::wstring_view index_table_filename() noexcept;
+        std::wstring_view search_index_filename() noexcept;
         std::wstring_view dlg_state_filename() noexcept;
         std::wstring_view cache_filename() noexcept;
         std::wstring_view mentions_filename() noexcept;
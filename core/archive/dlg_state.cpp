@@ -420,7 +420,7 @@ void dlg_state::serialize(core::tools::binary_stream& _data) const
 
 bool dlg_state::unserialize(core::tools::binary_stream& _data)
 {
-    core::tools::tlvpack state_pack;
+    core::tools::tlv_view state_pack;
     if (!state_pack.unserialize(_data))
         return false;
 
@@ -500,44 +500,31 @@ bool dlg_state::unserialize(core::tools::binary_stream& _data)
     if (tlv_no_recents_update)
         set_no_recents_update(tlv_no_recents_update->get_value<bool>());
 
-    core::tools::binary_stream bs_message = tlv_last_message->get_value<core::tools::binary_stream>();
-    last_message_->unserialize(bs_message);
+    last_message_->unserialize(tlv_last_message->get_value<core::tools::tlv_view>());
 
     if (tlv_pinned_message)
-    {
-        core::tools::binary_stream bs_pinned = tlv_pinned_message->get_value<core::tools::binary_stream>();
-        pinned_message_->unserialize(bs_pinned);
-    }
+        pinned_message_->unserialize(tlv_pinned_message->get_value<core::tools::tlv_view>());
 
     if (tlv_attention)
         set_attention(tlv_attention->get_value<bool>());
 
     if (tlv_heads)
     {
-        core::tools::tlvpack tlv_pack_heads;
-        if (tlv_pack_heads.unserialize(tlv_heads->get_value<core::tools::binary_stream>()))
+        const auto tlv_pack_heads = tlv_heads->get_value<core::tools::tlv_view>();
+        heads_.reserve(tlv_pack_heads.size());
+
+        for (const auto& val : tlv_pack_heads)
         {
-            heads_.reserve(tlv_pack_heads.size());
+            const auto tlv_pack_head = val.get_value<core::tools::tlv_view>();
 
-            auto val = tlv_pack_heads.get_first();
+            auto tlv_head_aimid = tlv_pack_head.get_item(dlg_state_fields::head_aimid);
+            auto tlv_head_friendly = tlv_pack_head.get_item(dlg_state_fields::head_friendly);
 
-            while (val)
+            if (tlv_head_aimid && tlv_head_friendly)
             {
-                core::tools::tlvpack tlv_pack_head;
-
-                tlv_pack_head.unserialize(val->get_value<core::tools::binary_stream>());
-
-                auto tlv_head_aimid = tlv_pack_head.get_item(dlg_state_fields::head_aimid);
-                auto tlv_head_friendly = tlv_pack_head.get_item(dlg_state_fields::head_friendly);
-
-                if (tlv_head_aimid && tlv_head_friendly)
-                {
-                    heads_.emplace_back(
-                        tlv_head_aimid->get_value<std::string>(),
-                        tlv_head_friendly->get_value<std::string>());
-                }
-
-                val = tlv_pack_heads.get_next();
+                heads_.emplace_back(
+                    tlv_head_aimid->get_value<std::string>(),
+                    tlv_head_friendly->get_value<std::string>());
             }
         }
     }
@@ -71,7 +71,7 @@ void draft::serialize(core::tools::binary_stream& _data) const
 
 bool draft::unserialize(const core::tools::binary_stream& _data)
 {
-    core::tools::tlvpack pack;
+    core::tools::tlv_view pack;
     if (!pack.unserialize(_data))
         return false;
 
@@ -95,9 +95,8 @@ bool draft::unserialize(const core::tools::binary_stream& _data)
 
     if (message_item)
     {
-        core::tools::binary_stream stream = message_item->get_value<core::tools::binary_stream>();
         auto message = std::make_shared<history_message>();
-        if (!message->unserialize(stream))
+        if (!message->unserialize(message_item->get_value<core::tools::tlv_view>()))
             message_ = message;
     }
 
@@ -137,12 +137,12 @@ void gallery_item::serialize(core::icollection* _collection) const
 
 bool gallery_item::unserialize(core::tools::binary_stream& _data)
 {
-    core::tools::tlvpack pack;
+    core::tools::tlv_view pack;
 
     if (!pack.unserialize(_data))
         return false;
 
-    for (auto tlv_field = pack.get_first(); tlv_field; tlv_field = pack.get_next())
+    for (auto tlv_field = pack.begin(); tlv_field != pack.end(); ++tlv_field)
     {
         switch (static_cast<tlv_fields_cache>(tlv_field->get_type()))
         {
@@ -950,11 +950,11 @@ bool gallery_storage::load_cache_from_local()
     {
         while (stream.available())
         {
-            core::tools::tlvpack block;
+            core::tools::tlv_view block;
             if (!block.unserialize(stream))
                 return false;
 
-            for (auto iter = block.get_first(); iter; iter = block.get_next())
+            for (auto iter = block.begin(); iter != block.end(); ++iter)
             {
                 gallery_item item;
                 auto s = iter->get_value<core::tools::binary_stream>();
@@ -992,11 +992,11 @@ bool gallery_storage::load_state_from_local()
     {
         while (stream.available())
         {
-            core::tools::tlvpack pack;
+            core::tools::tlv_view pack;
             if (!pack.unserialize(stream))
                 return false;
 
-            for (auto tlv_field = pack.get_first(); tlv_field; tlv_field = pack.get_next())
+            for (auto tlv_field = pack.begin(); tlv_field != pack.end(); ++tlv_field)
             {
                 switch (static_cast<tlv_fields_state>(tlv_field->get_type()))
                 {
@@ -0,0 +1,290 @@
+#include "stdafx.h"
+#include "headers_table.h"
+
+#include "../tools/mapped_file.h"
+#include "../tools/system.h"
+
+using namespace core;
+using namespace archive;
+
+namespace
+{
+    constexpr uint32_t table_magic = 0x58444948; // HIDX
+    constexpr uint32_t table_version = 1;
+
+    struct table_file_header
+    {
+        uint32_t magic_;
+        uint32_t version_;
+        int64_t generation_;
+        int64_t headers_count_;
+        int64_t extra_size_;
+    };
+
+    static_assert(sizeof(table_file_header) == 32);
+
+    bool has_extra(const message_header& _header)
+    {
+        const auto& patch = _header.get_update_patch_version();
+        return !patch.is_empty() || patch.get_offline_version() != 0 || _header.has_modifications();
+    }
+}
+
+void packed_header::set_prev_msgid(int64_t _value) noexcept
+{
+    im_assert(_value >= -1);
+    im_assert(id_ <= 0 || _value < id_);
+
+    prev_id_ = _value;
+}
+
+void packed_header::set_updated() noexcept
+{
+    auto flags = get_flags();
+    flags.flags_.updated_ = 1;
+    flags_ = flags.value_;
+}
+
+void headers_table::pack(packed_header& _packed, const message_header& _header)
+{
+    _packed.id_ = _header.id_;
+    _packed.prev_id_ = _header.prev_id_;
+    _packed.data_offset_ = _header.data_offset_;
+    _packed.time_ = _header.time_;
+    _packed.data_size_ = _header.data_size_;
+    _packed.flags_ = _header.flags_.value_;
+    _packed.version_ = _header.version_;
+
+    _packed.bits_ = 0;
+    if (_header.has_shared_contact_with_sn_)
+        _packed.bits_ |= packed_header::shared_contact_with_sn;
+    if (_header.has_poll_with_id_)
+        _packed.bits_ |= packed_header::poll_with_id;
+    if (_header.has_task_with_id_)
+        _packed.bits_ |= packed_header::task_with_id;
+    if (_header.has_reactions_)
+        _packed.bits_ |= packed_header::reactions;
+    if (_header.has_thread_)
+        _packed.bits_ |= packed_header::thread;
+
+    if (has_extra(_header))
+    {
+        _packed.bits_ |= packed_header::extra;
+        extra_[_header.id_] = { _header.update_patch_version_, _header.modifications_ };
+    }
+    else
+    {
+        extra_.erase(_header.id_);
+    }
+}
+
+void headers_table::drop_extra(const_iterator _first, const_iterator _last)
+{
+    for (; _first != _last; ++_first)
+    {
+        if (_first->has_extra())
+            extra_.erase(_first->get_id());
+    }
+}
+
+headers_table::iterator headers_table::lower_bound(int64_t _id) noexcept
+{
+    return std::lower_bound(headers_.begin(), headers_.end(), _id, [](const packed_header& _header, int64_t _id) { return _header.id_ < _id; });
+}
+
+headers_table::const_iterator headers_table::lower_bound(int64_t _id) const noexcept
+{
+    return std::lower_bound(headers_.cbegin(), headers_.cend(), _id, [](const packed_header& _header, int64_t _id) { return _header.id_ < _id; });
+}
+
+headers_table::iterator headers_table::find(int64_t _id) noexcept
+{
+    const auto it = lower_bound(_id);
+    return (it != headers_.end() && it->id_ == _id) ? it : headers_.end();
+}
+
+headers_table::const_iterator headers_table::find(int64_t _id) const noexcept
+{
+    const auto it = lower_bound(_id);
+    return (it != headers_.cend() && it->id_ == _id) ? it : headers_.cend();
+}
+
+message_header headers_table::get(const_iterator _it) const
+{
+    const auto& packed = *_it;
+
+    message_header header;
+    header.id_ = packed.id_;
+    header.prev_id_ = packed.prev_id_;
+    header.data_offset_ = packed.data_offset_;
+    header.time_ = packed.time_;
+    header.data_size_ = packed.data_size_;
+    header.flags_.value_ = packed.flags_;
+    header.version_ = packed.version_;
+
+    header.has_shared_contact_with_sn_ = packed.bits_ & packed_header::shared_contact_with_sn;
+    header.has_poll_with_id_ = packed.bits_ & packed_header::poll_with_id;
+    header.has_task_with_id_ = packed.bits_ & packed_header::task_with_id;
+    header.has_reactions_ = packed.bits_ & packed_header::reactions;
+    header.has_thread_ = packed.bits_ & packed_header::thread;
+
+    if (packed.has_extra())
+    {
+        if (const auto extra = extra_.find(packed.id_); extra != extra_.end())
+        {
+            header.update_patch_version_ = extra->second.update_patch_version_;
+            header.modifications_ = extra->second.modifications_;
+        }
+    }
+
+    return header;
+}
+
+void headers_table::set(iterator _it, const message_header& _header)
+{
+    im_assert(_it->id_ == _header.get_id());
+    pack(*_it, _header);
+}
+
+headers_table::iterator headers_table::insert(const_iterator _pos, const message_header& _header)
+{
+    im_assert(_pos == headers_.cend() || _header.get_id() < _pos->id_);
+    im_assert(_pos == headers_.cbegin() || std::prev(_pos)->id_ < _header.get_id());
+
+    const auto it = headers_.insert(_pos, packed_header());
+    pack(*it, _header);
+    return it;
+}
+
+headers_table::iterator headers_table::erase(const_iterator _first, const_iterator _last)
+{
+    drop_extra(_first, _last);
+    return headers_.erase(_first, _last);
+}
+
+void headers_table::clear() noexcept
+{
+    container().swap(headers_);
+    extra_.clear();
+}
+
+int64_t headers_table::get_memory_usage() const
+{
+    constexpr int64_t hash_node_size = 32;
+
+    int64_t extra_size = 0;
+    for (const auto& [_, extra] : extra_)
+        extra_size += sizeof(header_extra) + hash_node_size + extra.update_patch_version_.as_string().capacity() + extra.modifications_.capacity() * sizeof(message_header);
+
+    return int64_t(headers_.capacity() * sizeof(packed_header)) + extra_size;
+}
+
+bool headers_table::save(const std::wstring& _file_name, int64_t _generation) const
+{
+    tools::binary_stream extra;
+    for (const auto& [id, value] : extra_)
+    {
+        const auto& patch = value.update_patch_version_.as_string();
+        extra.write<int64_t>(id);
+        extra.write<uint32_t>(uint32_t(patch.size()));
+        extra.write(patch.data(), int64_t(patch.size()));
+        extra.write<int32_t>(value.update_patch_version_.get_offline_version());
+        extra.write<uint32_t>(uint32_t(value.modifications_.size()));
+        for (const auto& modification : value.modifications_)
+            modification.serialize(extra);
+    }
+
+    table_file_header header;
+    header.magic_ = table_magic;
+    header.version_ = table_version;
+    header.generation_ = _generation;
+    header.headers_count_ = int64_t(headers_.size());
+    header.extra_size_ = extra.available();
+
+    const auto path = boost::filesystem::wpath(_file_name).parent_path();
+    if (!tools::system::is_exist(path) && !tools::system::create_directory(path))
+        return false;
+
+    // the table is replaced as a whole, a crash leaves either the old or the new one
+    const auto tmp_file_name = _file_name + L".tmp";
+    {
+        auto file = tools::system::open_file_for_write(tmp_file_name, std::ios::binary | std::ios::out | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(headers_.data()), std::streamsize(headers_.size() * sizeof(packed_header)));
+        file.write(extra.get_data_for_log(), extra.available());
+        file.close();
+
+        if (file.fail())
+        {
+            tools::system::delete_file(tmp_file_name);
+            return false;
+        }
+    }
+
+    return tools::system::move_file(tmp_file_name, _file_name);
+}
+
+std::optional<int64_t> headers_table::load(const std::wstring& _file_name)
+{
+    clear();
+
+    tools::mapped_file file(_file_name);
+    if (!file.open() || file.size() < int64_t(sizeof(table_file_header)))
+        return std::nullopt;
+
+    table_file_header header;
+    memcpy(&header, file.data(), sizeof(header));
+
+    if (header.magic_ != table_magic || header.version_ != table_version || header.headers_count_ < 0 || header.extra_size_ < 0)
+        return std::nullopt;
+
+    const auto headers_size = header.headers_count_ * int64_t(sizeof(packed_header));
+    if (file.size() != int64_t(sizeof(header)) + headers_size + header.extra_size_)
+        return std::nullopt;
+
+    const auto headers_data = reinterpret_cast<const packed_header*>(file.data() + sizeof(header));
+    headers_.assign(headers_data, headers_data + header.headers_count_);
+
+    tools::binary_stream extra;
+    extra.write(file.data() + sizeof(header) + headers_size, header.extra_size_);
+
+    while (extra.available() > 0)
+    {
+        if (extra.available() < int64_t(sizeof(int64_t) + sizeof(uint32_t)))
+            break;
+
+        const auto id = extra.read<int64_t>();
+        const auto patch_size = extra.read<uint32_t>();
+        if (extra.available() < int64_t(patch_size + sizeof(int32_t) + sizeof(uint32_t)))
+            break;
+
+        header_extra value;
+        value.update_patch_version_.set_version(std::string_view(extra.read(patch_size), patch_size));
+        value.update_patch_version_.set_offline_version(extra.read<int32_t>());
+
+        const auto modifications_count = extra.read<uint32_t>();
+        for (uint32_t i = 0; i < modifications_count; ++i)
+        {
+            message_header modification;
+            if (!modification.unserialize(extra))
+            {
+                clear();
+                return std::nullopt;
+            }
+            value.modifications_.push_back(std::move(modification));
+        }
+
+        extra_.emplace(id, std::move(value));
+    }
+
+    if (extra.available() != 0)
+    {
+        clear();
+        return std::nullopt;
+    }
+
+    return header.generation_;
+}
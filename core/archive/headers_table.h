@@ -0,0 +1,156 @@
+#pragma once
+
+#include "history_message.h"
+#include "message_flags.h"
+
+namespace core
+{
+    namespace archive
+    {
+        // fixed-size part of message_header, stored as is in headers_table and in its file
+        class packed_header
+        {
+            friend class headers_table;
+
+            enum bits : uint8_t
+            {
+                shared_contact_with_sn = 1 << 0,
+                poll_with_id = 1 << 1,
+                task_with_id = 1 << 2,
+                reactions = 1 << 3,
+                thread = 1 << 4,
+                extra = 1 << 5 // patch version or modifications are in the side table
+            };
+
+            int64_t id_ = -1;
+            int64_t prev_id_ = -1;
+            int64_t data_offset_ = -1;
+            uint64_t time_ = 0;
+            uint32_t data_size_ = 0;
+            uint32_t flags_ = 0;
+            uint8_t version_ = 0;
+            uint8_t bits_ = 0;
+            uint8_t reserved_[6] = {};
+
+            message_flags get_flags() const noexcept { message_flags flags; flags.value_ = flags_; return flags; }
+
+        public:
+            int64_t get_id() const noexcept { return id_; }
+            uint64_t get_time() const noexcept { return time_; }
+            uint8_t get_version() const noexcept { return version_; }
+
+            int64_t get_prev_msgid() const noexcept { return prev_id_; }
+            void set_prev_msgid(int64_t _value) noexcept;
+
+            void invalidate_data_offset() noexcept { data_offset_ = std::numeric_limits<decltype(data_offset_)>::max(); }
+
+            bool is_deleted() const noexcept { return get_flags().flags_.deleted_; }
+            bool is_modified() const noexcept { return get_flags().flags_.modified_; }
+            bool is_patch() const noexcept { return get_flags().flags_.patch_; }
+            bool is_updated_message() const noexcept { return !is_patch() && get_flags().flags_.updated_; }
+            bool is_outgoing() const noexcept { return get_flags().flags_.outgoing_; }
+
+            void set_updated() noexcept;
+
+            bool has_extra() const noexcept { return bits_ & bits::extra; }
+        };
+
+        static_assert(sizeof(packed_header) == 48);
+        static_assert(std::is_trivially_copyable_v<packed_header>);
+
+        // message headers of a chat sorted by id
+        //
+        // a sorted vector of packed headers instead of a map of message_header, the rare
+        // patch versions and modifications are kept in a side table.
+        // the file is the header table followed by the side table, it's loaded with one copy
+        class headers_table
+        {
+        public:
+            using container = std::vector<packed_header>;
+            using size_type = container::size_type;
+            using iterator = container::iterator;
+            using const_iterator = container::const_iterator;
+            using const_reverse_iterator = container::const_reverse_iterator;
+
+        private:
+            struct header_extra
+            {
+                common::tools::patch_version update_patch_version_;
+                message_header_vec modifications_;
+            };
+
+            container headers_;
+            std::unordered_map<int64_t, header_extra> extra_;
+
+            void pack(packed_header& _packed, const message_header& _header);
+            void drop_extra(const_iterator _first, const_iterator _last);
+
+        public:
+            bool empty() const noexcept { return headers_.empty(); }
+            size_t size() const noexcept { return headers_.size(); }
+
+            iterator begin() noexcept { return headers_.begin(); }
+            iterator end() noexcept { return headers_.end(); }
+            const_iterator begin() const noexcept { return headers_.cbegin(); }
+            const_iterator end() const noexcept { return headers_.cend(); }
+            const_iterator cbegin() const noexcept { return headers_.cbegin(); }
+            const_iterator cend() const noexcept { return headers_.cend(); }
+            const_reverse_iterator rbegin() const noexcept { return headers_.crbegin(); }
+            const_reverse_iterator rend() const noexcept { return headers_.crend(); }
+            const_reverse_iterator crbegin() const noexcept { return headers_.crbegin(); }
+            const_reverse_iterator crend() const noexcept { return headers_.crend(); }
+
+            iterator lower_bound(int64_t _id) noexcept;
+            const_iterator lower_bound(int64_t _id) const noexcept;
+            iterator find(int64_t _id) noexcept;
+            const_iterator find(int64_t _id) const noexcept;
+
+            message_header get(const_iterator _it) const;
+            void set(iterator _it, const message_header& _header);
+
+            // _pos must keep the table sorted
+            iterator insert(const_iterator _pos, const message_header& _header);
+            template <typename It>
+            iterator insert(const_iterator _pos, It _first, It _last);
+
+            iterator erase(const_iterator _first, const_iterator _last);
+
+            template <typename P>
+            void erase_if(P _pred)
+            {
+                auto last = std::remove_if(headers_.begin(), headers_.end(), [this, &_pred](const packed_header& _header)
+                {
+                    if (!_pred(_header))
+                        return false;
+
+                    if (_header.has_extra())
+                        extra_.erase(_header.get_id());
+                    return true;
+                });
+
+                headers_.erase(last, headers_.end());
+            }
+
+            void clear() noexcept;
+
+            int64_t get_memory_usage() const;
+
+            bool save(const std::wstring& _file_name, int64_t _generation) const;
+            // the generation the table was saved with, std::nullopt if the file is missing or broken
+            std::optional<int64_t> load(const std::wstring& _file_name);
+        };
+
+        template <typename It>
+        headers_table::iterator headers_table::insert(const_iterator _pos, It _first, It _last)
+        {
+            const auto index = std::distance(headers_.cbegin(), _pos);
+            const auto it = headers_.insert(_pos, size_t(std::distance(_first, _last)), packed_header());
+
+            auto packed = it;
+            for (; _first != _last; ++_first, ++packed)
+                pack(*packed, *_first);
+
+            return headers_.begin() + index;
+        }
+    }
+}
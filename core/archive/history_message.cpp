@@ -131,10 +131,10 @@ namespace
     }
 
     void serialize_poll(const poll_data& _poll, core::tools::tlvpack& _pack);
-    archive::poll unserialize_poll(core::tools::tlvpack& _pack);
+    archive::poll unserialize_poll(const core::tools::tlv_view& _pack);
 
     void serialize_task(const core::tasks::task_data& _task, core::tools::tlvpack& _pack);
-    core::tasks::task unserialize_task(core::tools::tlvpack& _pack);
+    core::tasks::task unserialize_task(const core::tools::tlv_view& _pack);
 
     std::vector<std::vector<button_data>> unserialize_buttons(const rapidjson::Value& _node);
     std::vector<std::vector<button_data>> unserialize_buttons(const std::string& _buttons);
@@ -717,7 +717,7 @@ bool shared_contact_data::unserialize(const rapidjson::Value &_node)
     return result;
 }
 
-bool shared_contact_data::unserialize(const core::tools::tlvpack &_pack)
+bool shared_contact_data::unserialize(const core::tools::tlv_view& _pack)
 {
     if (const auto phone_item = _pack.get_item(message_fields::mf_shared_contact_phone))
     {
@@ -780,7 +780,7 @@ bool geo_data::unserialize(const rapidjson::Value &_node)
     return true;
 }
 
-bool geo_data::unserialize(const core::tools::tlvpack &_pack)
+bool geo_data::unserialize(const core::tools::tlv_view& _pack)
 {
     if (const auto name_item = _pack.get_item(message_fields::mf_geo_name))
         name_ = name_item->get_value<std::string>();
@@ -843,7 +843,7 @@ void message_reactions::unserialize(const rapidjson::Value &_node)
     }
 }
 
-bool message_reactions::unserialize(const core::tools::tlvpack& _pack)
+bool message_reactions::unserialize(const core::tools::tlv_view& _pack)
 {
     if (const auto name_item = _pack.get_item(message_fields::mf_reactions_exist))
     {
@@ -871,7 +871,7 @@ void core::archive::sticker_data::serialize(core::tools::tlvpack& _pack)
     _pack.push_child(core::tools::tlv(message_fields::mf_sticker_id, id_));
 }
 
-int32_t core::archive::sticker_data::unserialize(core::tools::tlvpack& _pack)
+int32_t core::archive::sticker_data::unserialize(const core::tools::tlv_view& _pack)
 {
     im_assert(id_.empty());
 
@@ -1114,7 +1114,7 @@ void core::archive::voip_data::serialize(Out core::tools::tlvpack &_pack) const
     _pack.push_child(tools::tlv(message_fields::mf_voip_sid, sid_));
 }
 
-bool core::archive::voip_data::unserialize(const core::tools::tlvpack &_pack)
+bool core::archive::voip_data::unserialize(const core::tools::tlv_view& _pack)
 {
     im_assert(type_ == voip_event_type::invalid);
     im_assert(sender_friendly_.empty());
@@ -1174,7 +1174,7 @@ bool core::archive::voip_data::unserialize(const core::tools::tlvpack &_pack)
 
     const auto tlv_conf = _pack.get_item(message_fields::mf_voip_conf_members);
     if (tlv_conf)
-        unserialize_conf_members(tlv_conf->get_value<tools::tlvpack>());
+        unserialize_conf_members(tlv_conf->get_value<tools::tlv_view>());
 
     const auto tlv_sid = _pack.get_item(message_fields::mf_voip_sid);
     if (tlv_sid)
@@ -1200,7 +1200,7 @@ void core::archive::voip_data::unserialize_duration(const rapidjson::Value &_nod
     }
 }
 
-void core::archive::voip_data::unserialize_conf_members(const tools::tlvpack& _pack)
+void core::archive::voip_data::unserialize_conf_members(const tools::tlv_view& _pack)
 {
     im_assert(conf_members_.empty());
 
@@ -1251,7 +1251,7 @@ void core::archive::chat_data::serialize(core::tools::tlvpack& _pack)
     _pack.push_child(core::tools::tlv(message_fields::mf_friendly_official, friendly_.official_));
 }
 
-int32_t core::archive::chat_data::unserialize(core::tools::tlvpack& _pack)
+int32_t core::archive::chat_data::unserialize(const core::tools::tlv_view& _pack)
 {
     auto tlv_sender = _pack.get_item(message_fields::mf_chat_sender);
     auto tlv_name = _pack.get_item(message_fields::mf_chat_name);
@@ -1338,7 +1338,7 @@ file_sharing_data::file_sharing_data(icollection* _collection)
         base_content_type_ = file_sharing_base_content_type(coll.get_value_as_int("base_content_type"));
 }
 
-file_sharing_data::file_sharing_data(const core::tools::tlvpack &_pack)
+file_sharing_data::file_sharing_data(const core::tools::tlv_view& _pack)
 {
     if (const auto uri_item = _pack.get_item(message_fields::mf_file_sharing_uri); uri_item)
     {
@@ -1637,7 +1637,7 @@ chat_event_data_sptr chat_event_data::make_modified_event(const rapidjson::Value
     return result;
 }
 
-chat_event_data_sptr chat_event_data::make_from_tlv(const tools::tlvpack& _pack)
+chat_event_data_sptr chat_event_data::make_from_tlv(const tools::tlv_view& _pack)
 {
     return chat_event_data_sptr(
         new chat_event_data(_pack)
@@ -1747,7 +1747,7 @@ chat_event_data::chat_event_data(const chat_event_type _type)
     im_assert(type_ < chat_event_type::max);
 }
 
-chat_event_data::chat_event_data(const tools::tlvpack& _pack)
+chat_event_data::chat_event_data(const tools::tlv_view& _pack)
 {
     type_ = _pack.get_item(message_fields::mf_chat_event_type)->get_value<chat_event_type>();
     im_assert(type_ > chat_event_type::min);
@@ -1779,10 +1779,10 @@ chat_event_data::chat_event_data(const tools::tlvpack& _pack)
 
         im_assert(item);
         if (item)
-            deserialize_mchat_members(item->get_value<tools::tlvpack>());
+            deserialize_mchat_members(item->get_value<tools::tlv_view>());
 
         if (item = _pack.get_item(message_fields::mf_chat_event_mchat_members_aimids))
-            deserialize_mchat_members_aimids(item->get_value<tools::tlvpack>());
+            deserialize_mchat_members_aimids(item->get_value<tools::tlv_view>());
 
         if (item = _pack.get_item(message_fields::mf_chat_requested_by))
             mchat_.requested_by_ = item->get_value<std::string>(std::string());
@@ -1927,7 +1927,7 @@ void chat_event_data::serialize(Out tools::tlvpack &_pack) const
         serialize_task_change(Out _pack);
 }
 
-void chat_event_data::deserialize_chat_modifications(const tools::tlvpack &_pack)
+void chat_event_data::deserialize_chat_modifications(const tools::tlv_view& _pack)
 {
     im_assert(chat_.new_name_.empty());
 
@@ -1975,7 +1975,7 @@ void chat_event_data::deserialize_chat_modifications(const tools::tlvpack &_pack
     }
 }
 
-void chat_event_data::deserialize_mchat_members(const tools::tlvpack &_pack)
+void chat_event_data::deserialize_mchat_members(const tools::tlv_view& _pack)
 {
     im_assert(mchat_.members_friendly_.empty());
 
@@ -1991,7 +1991,7 @@ void chat_event_data::deserialize_mchat_members(const tools::tlvpack &_pack)
     }
 }
 
-void chat_event_data::deserialize_mchat_members_aimids(const tools::tlvpack &_pack)
+void chat_event_data::deserialize_mchat_members_aimids(const tools::tlv_view& _pack)
 {
     im_assert(mchat_.members_.empty());
 
@@ -2007,7 +2007,7 @@ void chat_event_data::deserialize_mchat_members_aimids(const tools::tlvpack &_pa
     }
 }
 
-void chat_event_data::chat_event_data::deserialize_status_reply(const tools::tlvpack& _pack)
+void chat_event_data::chat_event_data::deserialize_status_reply(const tools::tlv_view& _pack)
 {
     if (auto sender_status_item = _pack.get_item(mf_chat_event_sender_status))
         status_reply_.sender_status_ = sender_status_item->get_value<std::string>();
@@ -2022,7 +2022,7 @@ void chat_event_data::chat_event_data::deserialize_status_reply(const tools::tlv
         status_reply_.owner_status_descriprion_ = owner_status_description_item->get_value<std::string>();
 }
 
-void chat_event_data::deserialize_task_change(const tools::tlvpack& _pack)
+void chat_event_data::deserialize_task_change(const tools::tlv_view& _pack)
 {
     if (const auto editor_item = _pack.get_item(mf_chat_event_task_editor))
         task_.editor_ = editor_item->get_value<std::string>();
@@ -2957,14 +2957,25 @@ int32_t history_message::unserialize(core::tools::binary_stream& _data)
     return unserialize_call(_data, dummy);
 }
 
+int32_t history_message::unserialize(const core::tools::tlv_view& _pack)
+{
+    std::string dummy;
+    return unserialize_call(_pack, dummy);
+}
+
 int32_t history_message::unserialize_call(core::tools::binary_stream& _data, std::string& _aimid)
 {
-    core::tools::tlvpack msg_pack;
+    core::tools::tlv_view msg_pack;
 
     if (!msg_pack.unserialize(_data))
         return -1;
 
-    for (auto tlv_field = msg_pack.get_first(); tlv_field; tlv_field = msg_pack.get_next())
+    return unserialize_call(msg_pack, _aimid);
+}
+
+int32_t history_message::unserialize_call(const core::tools::tlv_view& _pack, std::string& _aimid)
+{
+    for (auto tlv_field = _pack.begin(); tlv_field != _pack.end(); ++tlv_field)
     {
         switch (static_cast<message_fields>(tlv_field->get_type()))
         {
@@ -2992,7 +3003,7 @@ int32_t history_message::unserialize_call(core::tools::binary_stream& _data, std
         case message_fields::mf_format:
             {
                 format_ = std::make_unique<core::archive::format_data>();
-                auto pack = tlv_field->get_value<core::tools::tlvpack>();
+                auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 format_->unserialize(pack);
             }
             break;
@@ -3005,28 +3016,28 @@ int32_t history_message::unserialize_call(core::tools::binary_stream& _data, std
         case message_fields::mf_chat:
             {
                 chat_ = std::make_unique<core::archive::chat_data>();
-                core::tools::tlvpack pack = tlv_field->get_value<core::tools::tlvpack>();
+                const auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 chat_->unserialize(pack);
             }
             break;
         case message_fields::mf_sticker:
             {
                 sticker_ = std::make_unique<core::archive::sticker_data>();
-                core::tools::tlvpack pack = tlv_field->get_value<core::tools::tlvpack>();
+                const auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 sticker_->unserialize(pack);
             }
             break;
         case message_fields::mf_mult:
             {
                 mult_ = std::make_unique<core::archive::mult_data>();
-                core::tools::tlvpack pack = tlv_field->get_value<core::tools::tlvpack>();
+                const auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 mult_->unserialize(pack);
             }
             break;
         case message_fields::mf_voip:
             {
                 voip_ = std::make_unique<core::archive::voip_data>();
-                const auto pack = tlv_field->get_value<core::tools::tlvpack>();
+                const auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 if (!voip_->unserialize(pack))
                 {
                     im_assert(!"voip unserialization failed");
@@ -3036,27 +3047,27 @@ int32_t history_message::unserialize_call(core::tools::binary_stream& _data, std
             break;
         case message_fields::mf_file_sharing:
             {
-                const auto pack = tlv_field->get_value<core::tools::tlvpack>();
+                const auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 file_sharing_ = std::make_unique<core::archive::file_sharing_data>(pack);
             }
             break;
         case message_fields::mf_chat_event:
             {
-                const auto pack = tlv_field->get_value<core::tools::tlvpack>();
+                const auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 chat_event_ = chat_event_data::make_from_tlv(pack);
             }
             break;
         case message_fields::mf_quote:
             {
                 quote q;
-                const auto pack = tlv_field->get_value<core::tools::tlvpack>();
+                const auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 q.unserialize(pack);
                 quotes_.push_back(std::move(q));
             }
             break;
         case message_fields::mf_mention:
             {
-                const auto pack = tlv_field->get_value<core::tools::tlvpack>();
+                const auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 const auto sn = pack.get_item(mf_mention_sn);
                 const auto fr = pack.get_item(mf_mention_friendly);
                 if (sn && fr)
@@ -3071,7 +3082,7 @@ int32_t history_message::unserialize_call(core::tools::binary_stream& _data, std
         case message_fields::mf_snippet:
             {
                 url_snippet s;
-                const auto pack = tlv_field->get_value<core::tools::tlvpack>();
+                const auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 s.unserialize(pack);
                 snippets_.push_back(std::move(s));
             }
@@ -3082,7 +3093,7 @@ int32_t history_message::unserialize_call(core::tools::binary_stream& _data, std
         case message_fields::mf_description_format:
             {
                 description_format_ = std::make_unique<core::archive::format_data>();
-                auto pack = tlv_field->get_value<core::tools::tlvpack>();
+                auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 description_format_->unserialize(pack);
             }
             break;
@@ -3091,7 +3102,7 @@ int32_t history_message::unserialize_call(core::tools::binary_stream& _data, std
             break;
         case message_fields::mf_shared_contact:
             {
-                const auto pack = tlv_field->get_value<core::tools::tlvpack>();
+                const auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 shared_contact_data contact;
                 if (contact.unserialize(pack))
                     shared_contact_ = std::move(contact);
@@ -3099,7 +3110,7 @@ int32_t history_message::unserialize_call(core::tools::binary_stream& _data, std
             break;
         case message_fields::mf_geo:
             {
-                const auto pack = tlv_field->get_value<core::tools::tlvpack>();
+                const auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 geo_data geo;
                 if (geo.unserialize(pack))
                     geo_ = std::move(geo);
@@ -3107,19 +3118,19 @@ int32_t history_message::unserialize_call(core::tools::binary_stream& _data, std
             break;
         case message_fields::mf_poll:
             {
-                auto pack = tlv_field->get_value<core::tools::tlvpack>();
+                auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 poll_ = unserialize_poll(pack);
             }
             break;
         case message_fields::mf_task:
             {
-                auto pack = tlv_field->get_value<core::tools::tlvpack>();
+                auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 task_ = unserialize_task(pack);
             }
             break;
         case message_fields::mf_reactions:
             {
-                const auto pack = tlv_field->get_value<core::tools::tlvpack>();
+                const auto pack = tlv_field->get_value<core::tools::tlv_view>();
                 message_reactions reactions;
                 if (reactions.unserialize(pack))
                     reactions_ = std::move(reactions);
@@ -3582,6 +3593,42 @@ int64_t history_message::get_id_field(core::tools::binary_stream& _stream)
     return -1;
 }
 
+namespace
+{
+    // the first field of the type that isn't empty, like the stream scans above find it
+    const core::tools::tlv_field* find_non_empty_field(const core::tools::tlv_view& _pack, message_fields _type)
+    {
+        for (const auto& field : _pack)
+        {
+            if (field.get_type() == _type && field.value_size() != 0)
+                return &field;
+        }
+        return nullptr;
+    }
+}
+
+std::string_view history_message::get_text_field(const core::tools::tlv_view& _pack)
+{
+    const auto field = find_non_empty_field(_pack, message_fields::mf_text);
+    return field ? field->get_value<std::string_view>() : std::string_view();
+}
+
+int64_t history_message::get_id_field(const core::tools::tlv_view& _pack)
+{
+    const auto field = find_non_empty_field(_pack, message_fields::mf_msg_id);
+    return field ? field->get_value<int64_t>() : -1;
+}
+
+bool history_message::is_sticker(const core::tools::tlv_view& _pack)
+{
+    return find_non_empty_field(_pack, message_fields::mf_sticker) != nullptr;
+}
+
+bool history_message::is_chat_event(const core::tools::tlv_view& _pack)
+{
+    return find_non_empty_field(_pack, message_fields::mf_chat_event) != nullptr;
+}
+
 void core::archive::history_message::set_description_format(const core::data::format& _format)
 {
     description_format_ = std::make_unique<format_data>(_format);
@@ -4269,7 +4316,7 @@ bool quote::unserialize(const rapidjson::Value& _node, bool _is_forward, const m
     return true;
 }
 
-void quote::unserialize(const core::tools::tlvpack &_pack)
+void quote::unserialize(const core::tools::tlv_view& _pack)
 {
     auto get_value = [&_pack](auto _field, auto _def_value, Out auto _out_ptr)
     {
@@ -4293,7 +4340,7 @@ void quote::unserialize(const core::tools::tlvpack &_pack)
 
     if (auto contact_item = _pack.get_item(message_fields::mf_shared_contact))
     {
-        const auto pack = contact_item->get_value<core::tools::tlvpack>();
+        const auto pack = contact_item->get_value<core::tools::tlv_view>();
         shared_contact_data contact;
         if (contact.unserialize(pack))
             shared_contact_ = std::move(contact);
@@ -4301,7 +4348,7 @@ void quote::unserialize(const core::tools::tlvpack &_pack)
 
     if (auto geo_item = _pack.get_item(message_fields::mf_geo))
     {
-        const auto pack = geo_item->get_value<core::tools::tlvpack>();
+        const auto pack = geo_item->get_value<core::tools::tlv_view>();
         geo_data geo;
         if (geo.unserialize(pack))
             geo_ = std::move(geo);
@@ -4309,26 +4356,26 @@ void quote::unserialize(const core::tools::tlvpack &_pack)
 
     if (auto poll_item = _pack.get_item(message_fields::mf_poll))
     {
-        auto pack = poll_item->get_value<core::tools::tlvpack>();
+        auto pack = poll_item->get_value<core::tools::tlv_view>();
         poll_ = unserialize_poll(pack);
     }
 
     if (auto task_item = _pack.get_item(message_fields::mf_task))
     {
-        auto pack = task_item->get_value<core::tools::tlvpack>();
+        auto pack = task_item->get_value<core::tools::tlv_view>();
         task_ = unserialize_task(pack);
     }
 
     if (auto format_item = _pack.get_item(message_fields::mf_format))
     {
-        auto pack = format_item->get_value<core::tools::tlvpack>();
+        auto pack = format_item->get_value<core::tools::tlv_view>();
         format_.emplace();
         format_->unserialize(pack);
     }
 
     if (auto format_item = _pack.get_item(message_fields::mf_description_format))
     {
-        auto pack = format_item->get_value<core::tools::tlvpack>();
+        auto pack = format_item->get_value<core::tools::tlv_view>();
         description_format_.emplace();
         description_format_->unserialize(pack);
     }
@@ -4402,7 +4449,7 @@ void url_snippet::unserialize(const rapidjson::Value& _node)
         preview_height_ = std::stoi(tmp);
 }
 
-void url_snippet::unserialize(const core::tools::tlvpack& _pack)
+void url_snippet::unserialize(const core::tools::tlv_view& _pack)
 {
     auto get_value = [&_pack](auto _field, auto _def_value, Out auto _out_ptr)
     {
@@ -4715,11 +4762,11 @@ namespace
         _pack.push_child(core::tools::tlv(message_fields::mf_poll, pack));
     }
 
-    archive::poll unserialize_poll(core::tools::tlvpack& _pack)
+    archive::poll unserialize_poll(const core::tools::tlv_view& _pack)
     {
         // unserialize only the fields which could be in message with poll
         poll_data poll;
-        for (auto field = _pack.get_first(); field; field = _pack.get_next())
+        for (auto field = _pack.begin(); field != _pack.end(); ++field)
         {
             switch ((message_fields) field->get_type())
             {
@@ -4764,7 +4811,7 @@ namespace
         _pack.push_child(core::tools::tlv(message_fields::mf_task, pack));
     }
 
-    core::tasks::task unserialize_task(core::tools::tlvpack& _pack)
+    core::tasks::task unserialize_task(const core::tools::tlv_view& _pack)
     {
         core::tasks::task_data task;
         if (const auto id_item = _pack.get_item(message_fields::mf_task_id))
@@ -4886,7 +4933,7 @@ void core::archive::format_data::serialize(tools::tlvpack& _pack) const
     }
 }
 
-bool core::archive::format_data::unserialize(core::tools::tlvpack& _pack)
+bool core::archive::format_data::unserialize(const core::tools::tlv_view& _pack)
 {
     const auto from_mf_type = [](message_fields _mf_type)
     {
@@ -4921,10 +4968,10 @@ bool core::archive::format_data::unserialize(core::tools::tlvpack& _pack)
         return format_type::bold;
     };
 
-    const auto read_format_info = [](core::tools::tlvpack& _info_pack)
+    const auto read_format_info = [](const core::tools::tlv_view& _info_pack)
     {
         auto result = core::data::range_format();
-        for (auto field = _info_pack.get_first(); field; field = _info_pack.get_next())
+        for (auto field = _info_pack.begin(); field != _info_pack.end(); ++field)
         {
             switch (static_cast<message_fields>(field->get_type()))
             {
@@ -4948,11 +4995,11 @@ bool core::archive::format_data::unserialize(core::tools::tlvpack& _pack)
     };
 
     formats_.clear();
-    for (auto field = _pack.get_first(); field; field = _pack.get_next())
+    for (auto field = _pack.begin(); field != _pack.end(); ++field)
     {
         const auto mf_type = static_cast<message_fields>(field->get_type());
         const auto type = from_mf_type(mf_type);
-        auto range_info_pack = field->get_value<core::tools::tlvpack>();
+        auto range_info_pack = field->get_value<core::tools::tlv_view>();
         auto info = read_format_info(range_info_pack);
         info.type_ = type;
         formats_.emplace_back(info);
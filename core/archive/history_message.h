@@ -48,7 +48,7 @@ namespace core
             void serialize(core::tools::tlvpack& _pack) const;
             bool unserialize(icollection* _coll);
             bool unserialize(const rapidjson::Value& _node);
-            bool unserialize(const core::tools::tlvpack& _pack);
+            bool unserialize(const core::tools::tlv_view& _pack);
         };
         using shared_contact = std::optional<shared_contact_data>;
 
@@ -62,7 +62,7 @@ namespace core
             void serialize(core::tools::tlvpack& _pack) const;
             bool unserialize(icollection* _coll);
             bool unserialize(const rapidjson::Value& _node);
-            bool unserialize(const core::tools::tlvpack& _pack);
+            bool unserialize(const core::tools::tlv_view& _pack);
         };
         using geo = std::optional<geo_data>;
 
@@ -85,7 +85,7 @@ namespace core
             void serialize(icollection* _collection) const;
             void serialize(core::tools::tlvpack& _pack) const;
             void unserialize(const rapidjson::Value& _node);
-            bool unserialize(const core::tools::tlvpack& _pack);
+            bool unserialize(const core::tools::tlv_view& _pack);
         };
         using reactions = std::optional<message_reactions>;
 
@@ -123,6 +123,8 @@ namespace core
 
             uint32_t min_data_sizeof(uint8_t _version) const noexcept;
 
+            friend class headers_table;
+
         public:
 
             message_header();
@@ -225,7 +227,7 @@ namespace core
             void serialize(icollection* _collection);
             void serialize(core::tools::tlvpack& _pack);
             int32_t unserialize(const rapidjson::Value& _node);
-            int32_t unserialize(core::tools::tlvpack& _pack);
+            int32_t unserialize(const core::tools::tlv_view& _pack);
         };
 
         class mult_data
@@ -234,7 +236,7 @@ namespace core
             void serialize(icollection* _collection) {}
             void serialize(core::tools::tlvpack& _pack) {}
             int32_t unserialize(const rapidjson::Value& _node) { return 0; }
-            int32_t unserialize(core::tools::tlvpack& _pack) { return 0; }
+            int32_t unserialize(const core::tools::tlv_view& _pack) { return 0; }
         };
 
         class voip_data
@@ -252,7 +254,7 @@ namespace core
             virtual bool unserialize(const coll_helper &_coll) override;
 
             virtual void serialize(Out core::tools::tlvpack &_pack) const override;
-            virtual bool unserialize(const core::tools::tlvpack &_pack) override;
+            virtual bool unserialize(const core::tools::tlv_view& _pack) override;
 
             int32_t is_incoming() const;
 
@@ -267,7 +269,7 @@ namespace core
             std::vector<std::string> conf_members_;
 
             virtual void unserialize_duration(const rapidjson::Value &_node);
-            void unserialize_conf_members(const tools::tlvpack& _pack);
+            void unserialize_conf_members(const tools::tlv_view& _pack);
         };
 
         using voip_data_uptr = std::unique_ptr<voip_data>;
@@ -293,7 +295,7 @@ namespace core
             void serialize(core::tools::tlvpack& _pack);
             void serialize(icollection* _collection);
             int32_t unserialize(const rapidjson::Value& _node);
-            int32_t unserialize(core::tools::tlvpack& _pack);
+            int32_t unserialize(const core::tools::tlv_view& _pack);
         };
 
         typedef std::unique_ptr<class file_sharing_data> file_sharing_data_uptr;
@@ -306,7 +308,7 @@ namespace core
 
             file_sharing_data(icollection* _collection);
 
-            file_sharing_data(const core::tools::tlvpack &_pack);
+            file_sharing_data(const core::tools::tlv_view& _pack);
 
             file_sharing_data();
             ~file_sharing_data();
@@ -343,7 +345,7 @@ namespace core
             static chat_event_data_sptr make_added_to_buddy_list(const std::string &_sender_aimid);
             static chat_event_data_sptr make_mchat_event(const rapidjson::Value& _node);
             static chat_event_data_sptr make_modified_event(const rapidjson::Value& _node);
-            static chat_event_data_sptr make_from_tlv(const tools::tlvpack& _pack);
+            static chat_event_data_sptr make_from_tlv(const tools::tlv_view& _pack);
             static chat_event_data_sptr make_simple_event(const chat_event_type _type);
             static chat_event_data_sptr make_generic_event(const rapidjson::Value& _text_node);
             static chat_event_data_sptr make_generic_event(std::string _text);
@@ -364,13 +366,13 @@ namespace core
 
         private:
             chat_event_data(const chat_event_type _type);
-            chat_event_data(const tools::tlvpack &_pack);
+            chat_event_data(const tools::tlv_view& _pack);
 
-            void deserialize_chat_modifications(const tools::tlvpack &_pack);
-            void deserialize_mchat_members(const tools::tlvpack &_pack);
-            void deserialize_mchat_members_aimids(const tools::tlvpack &_pack);
-            void deserialize_status_reply(const tools::tlvpack& _pack);
-            void deserialize_task_change(const tools::tlvpack& _pack);
+            void deserialize_chat_modifications(const tools::tlv_view& _pack);
+            void deserialize_mchat_members(const tools::tlv_view& _pack);
+            void deserialize_mchat_members_aimids(const tools::tlv_view& _pack);
+            void deserialize_status_reply(const tools::tlv_view& _pack);
+            void deserialize_task_change(const tools::tlv_view& _pack);
 
             chat_event_type get_type() const;
             bool has_generic_text() const;
@@ -442,7 +444,7 @@ namespace core
             void serialize(icollection* _collection, std::string_view _name) const;
             void serialize(tools::tlvpack& _pack) const;
             rapidjson::Value serialize(rapidjson_allocator& _a) const { return core::data::format::serialize(_a); }
-            bool unserialize(core::tools::tlvpack& _pack);
+            bool unserialize(const core::tools::tlv_view& _pack);
             void unserialize(const coll_helper& _coll, std::string_view _name);
         };
         using format_data_uptr = std::unique_ptr<format_data>;
@@ -529,13 +531,21 @@ namespace core
 
             int32_t unserialize(const rapidjson::Value& _node, const std::string &_sender_aimid);
             int32_t unserialize(core::tools::binary_stream& _data);
+            int32_t unserialize(const core::tools::tlv_view& _pack);
             int32_t unserialize_call(core::tools::binary_stream& _data, std::string& _aimid);
+            int32_t unserialize_call(const core::tools::tlv_view& _pack, std::string& _aimid);
 
             static void jump_to_text_field(core::tools::binary_stream& _stream, uint32_t& length);
             static int64_t get_id_field(core::tools::binary_stream& _stream);
             static bool is_sticker(core::tools::binary_stream& _stream);
             static bool is_chat_event(core::tools::binary_stream& _stream);
 
+            // the same checks on a pack read in place, the text points into the buffer of the pack
+            static std::string_view get_text_field(const core::tools::tlv_view& _pack);
+            static int64_t get_id_field(const core::tools::tlv_view& _pack);
+            static bool is_sticker(const core::tools::tlv_view& _pack);
+            static bool is_chat_event(const core::tools::tlv_view& _pack);
+
             void set_msgid(const int64_t _msgid) noexcept { msgid_ = _msgid; }
             int64_t get_msgid() const noexcept { return msgid_; }
             bool has_msgid() const noexcept { return msgid_ > 0; }
@@ -692,7 +702,7 @@ namespace core
             void serialize(core::tools::tlvpack& _pack) const;
             void unserialize(icollection* _coll);
             bool unserialize(const rapidjson::Value& _node, bool _is_forward, const message_fields_set& _new_fields);
-            void unserialize(const core::tools::tlvpack &_pack);
+            void unserialize(const core::tools::tlv_view& _pack);
 
             const std::string& get_text() const { return text_; }
             const std::optional<format_data>& get_format() const { return format_; }
@@ -725,7 +735,7 @@ namespace core
             void serialize(icollection* _collection) const;
             void serialize(core::tools::tlvpack& _pack) const;
             void unserialize(const rapidjson::Value& _node);
-            void unserialize(const core::tools::tlvpack& _pack);
+            void unserialize(const core::tools::tlv_view& _pack);
 
             const std::string& get_url() const { return url_; }
 
@@ -41,18 +41,28 @@ namespace
     }
 
     constexpr auto msg_stat_delivered_timeout = std::chrono::hours(1);
+
+    // the part of a dialog indexed by one backfill task
+    constexpr int64_t search_index_backfill_step = 1024 * 1024;
 }
 
 using namespace core;
 using namespace archive;
 
 local_history::local_history(const std::wstring& _archive_path)
+    : local_history(_archive_path, configuration::get_app_config().archives_memory_budget())
+{
+}
+
+local_history::local_history(const std::wstring& _archive_path, int64_t _memory_budget)
     : archive_path_(_archive_path)
     , po_(std::make_unique<pending_operations>(
         _archive_path + L"/pending.db",
         _archive_path + L"/pending.delete.db"))
     , pending_drafts_(std::make_unique<pending_drafts>(_archive_path + L"/pending.drafts.db"))
+    , memory_budget_(_memory_budget)
 {
+    cache_stats_.memory_budget_ = memory_budget_;
 }
 
 
@@ -62,18 +72,66 @@ std::shared_ptr<contact_archive> local_history::get_contact_archive(const std::s
 {
     // load contact archive, insert to map
 
+    // the archive used last is done with its previous request by now
+    if (!recent_archives_.empty())
+        update_memory_usage(archives_[recent_archives_.front()]);
+
     if (const auto it = archives_.find(_contact); it != archives_.end())
-        return it->second;
+    {
+        recent_archives_.splice(recent_archives_.begin(), recent_archives_, it->second.recent_position_);
+        return it->second.archive_;
+    }
 
     std::wstring contact_folder = core::tools::from_utf8(_contact);
     std::replace(contact_folder.begin(), contact_folder.end(), L'|', L'_');
     auto contact_arch = std::make_shared<contact_archive>(su::wconcat(archive_path_, L'/', contact_folder), _contact);
 
-    archives_.insert(std::make_pair(_contact, contact_arch));
+    if (evicted_archives_.erase(_contact))
+        ++cache_stats_.reloaded_count_;
+
+    recent_archives_.push_front(_contact);
+    archives_.insert(std::make_pair(_contact, cached_archive{ contact_arch, 0, recent_archives_.begin() }));
+
+    evict_archives();
 
     return contact_arch;
 }
 
+void local_history::update_memory_usage(cached_archive& _archive) const
+{
+    int64_t index_size = 0;
+    int64_t gallery_size = 0;
+    _archive.archive_->get_memory_usage(index_size, gallery_size);
+
+    archives_memory_usage_ += index_size + gallery_size - _archive.memory_usage_;
+    _archive.memory_usage_ = index_size + gallery_size;
+}
+
+void local_history::evict_archives() const
+{
+    if (memory_budget_ <= 0)
+        return;
+
+    // the most recent archive is the one being requested, it stays
+    auto it = recent_archives_.end();
+    while (archives_memory_usage_ > memory_budget_ && --it != recent_archives_.begin())
+    {
+        const auto archive = archives_.find(*it);
+        im_assert(archive != archives_.end());
+
+        // someone still works with the archive, dropping it here would load a second copy of it
+        if (archive->second.archive_.use_count() > 1)
+            continue;
+
+        archives_memory_usage_ -= archive->second.memory_usage_;
+        ++cache_stats_.evicted_count_;
+
+        evicted_archives_.insert(*it);
+        archives_.erase(archive);
+        it = recent_archives_.erase(it);
+    }
+}
+
 void local_history::update_history(
     const std::string& _contact,
     archive::history_block_sptr _data,
@@ -131,14 +189,61 @@ bool local_history::get_messages(const std::string& _contact,
     return true;
 }
 
-bool local_history::get_history_file(const std::string& _contact, /*out*/ core::tools::binary_stream& _history_archive
-    , std::shared_ptr<int64_t> _offset, std::shared_ptr<int64_t> _remaining_size, int64_t& _cur_index, std::shared_ptr<int64_t> _mode)
+bool local_history::get_history_block(const std::wstring& _archive_path, contact_and_offsets_v& _contacts, /*out*/ contact_and_msgs& _archive
+    , /*out*/ core::tools::binary_stream& _data, /*out*/ contact_and_offsets_v& _remaining, const std::function<bool()>& _cancel)
+{
+    auto remain_size = std::make_shared<int64_t>(search::archive_block_size());
+    auto index = 0u;
+
+    _archive.clear();
+    auto has_result = false;
+    int64_t cur_index = 0;
+
+    while (*remain_size > 0 && index < _contacts.size())
+    {
+        if (_cancel && _cancel())
+            return false;
+
+        auto [contact, regim, offset] = _contacts[index];
+        ++index;
+
+        std::wstring contact_folder = core::tools::from_utf8(contact);
+        std::replace(contact_folder.begin(), contact_folder.end(), L'|', L'_');
+        const std::wstring file_name = su::wconcat(_archive_path, L'/', contact_folder, L'/', db_filename());
+
+        const auto prev_cur_index = cur_index;
+        const auto cur_result = contact_archive::get_history_file(file_name, _data, offset, remain_size, cur_index, regim);
+        has_result |= cur_result;
+
+        if (!cur_result)
+            *offset = -2;
+
+        _archive.push_back(std::make_pair(contact, prev_cur_index));
+    }
+    _archive.push_back(std::make_pair(std::string(), cur_index));
+
+    const auto last_index = index;
+    _remaining.reserve(_contacts.size() - last_index);
+    for (; index < _contacts.size(); ++index)
+        _remaining.push_back(_contacts[index]);
+    _contacts.resize(last_index);
+
+    return has_result;
+}
+
+bool local_history::search_in_index(const std::string& _contact, const coded_term& _cterm, /*out*/ search::found_messages& _found_messages)
 {
     std::wstring contact_folder = core::tools::from_utf8(_contact);
     std::replace(contact_folder.begin(), contact_folder.end(), L'|', L'_');
-    std::wstring file_name = su::wconcat(archive_path_, L'/', contact_folder, L'/', db_filename());
+    const auto folder = su::wconcat(archive_path_, L'/', contact_folder, L'/');
+
+    std::vector<history_message_sptr> found;
+    if (!messages_data::search_in_index(su::wconcat(folder, db_filename()), su::wconcat(folder, search_index_filename()), _cterm, found))
+        return false;
+
+    if (!found.empty())
+        _found_messages[_contact] = std::move(found);
 
-    contact_archive::get_history_file(file_name, _history_archive, _offset, _remaining_size, _cur_index, _mode);
     return true;
 }
 
@@ -537,6 +642,19 @@ void local_history::free_dialog(const std::string& _contact)
     get_contact_archive(_contact)->free();
 }
 
+bool local_history::update_search_index(const std::string& _contact, int64_t _max_size)
+{
+    // a loaded archive remembers the size its index covers, so it has to be updated through it
+    if (const auto it = archives_.find(_contact); it != archives_.end())
+        return it->second.archive_->update_search_index(_max_size);
+
+    std::wstring contact_folder = core::tools::from_utf8(_contact);
+    std::replace(contact_folder.begin(), contact_folder.end(), L'|', L'_');
+    const auto folder = su::wconcat(archive_path_, L'/', contact_folder, L'/');
+
+    return messages_data(su::wconcat(folder, db_filename()), su::wconcat(folder, search_index_filename())).update_search_index(_max_size);
+}
+
 int64_t local_history::get_last_msgid(const std::string& _contact) const
 {
     return get_contact_archive(_contact)->get_last_msgid();
@@ -638,21 +756,29 @@ void local_history::invalidate_message_data(const std::string& _aimId, int64_t _
     get_contact_archive(_aimId)->invalidate_message_data(_from, _before_count, _after_count);
 }
 
-void local_history::get_memory_usage(int64_t& _index_size, int64_t& _gallery_size)
+void local_history::get_memory_usage(int64_t& _index_size, int64_t& _gallery_size, archives_cache_stats& _cache_stats)
 {
     _index_size = 0;
     _gallery_size = 0;
 
-    for (const auto& [_contact, _index] : archives_)
+    archives_memory_usage_ = 0;
+
+    for (auto& [_contact, _index] : archives_)
     {
         int64_t _i_index_size = 0;
         int64_t _i_gallery_size = 0;
 
-        _index->get_memory_usage(_i_index_size, _i_gallery_size);
+        _index.archive_->get_memory_usage(_i_index_size, _i_gallery_size);
+
+        _index.memory_usage_ = _i_index_size + _i_gallery_size;
+        archives_memory_usage_ += _index.memory_usage_;
 
         _index_size += _i_index_size;
         _gallery_size += _i_gallery_size;
     }
+
+    _cache_stats = cache_stats_;
+    _cache_stats.loaded_count_ = int64_t(archives_.size());
 }
 
 void local_history::insert_reactions(const std::string& _contact, const reactions_vector_sptr& _reactions)
@@ -852,75 +978,43 @@ std::shared_ptr<request_buddies_handler> face::get_messages(const std::string& _
     return handler;
 }
 
-std::shared_ptr<request_history_file_handler> face::get_history_block(std::shared_ptr<contact_and_offsets_v> _contacts,
-                                                                      std::shared_ptr<contact_and_msgs> _archive,
-                                                                      std::shared_ptr<tools::binary_stream> _data,
-                                                                      std::function<bool()> _cancel)
+const std::wstring& face::get_archive_path() const noexcept
 {
-    im_assert(!_contacts->empty());
+    return history_cache_->get_archive_path();
+}
 
+std::shared_ptr<search_in_index_handler> face::search_in_index(std::shared_ptr<std::vector<std::string>> _contacts, std::shared_ptr<coded_term> _cterm, std::function<bool()> _cancel)
+{
     auto history_cache = history_cache_;
-    auto handler = std::make_shared<request_history_file_handler>();
-
-    auto remaining = std::make_shared<contact_and_offsets_v>();
+    auto handler = std::make_shared<search_in_index_handler>();
+    auto found_messages = std::make_shared<search::found_messages>();
+    auto unindexed = std::make_shared<std::vector<std::string>>();
 
-    static constexpr char task_name[] = "face::get_history_block";
+    static constexpr char task_name[] = "face::search_in_index";
 
-    thread_->run_async_function([_contacts, _archive, history_cache, remaining, _data, _cancel]() -> int32_t
+    thread_->run_async_function([_contacts, _cterm, history_cache, found_messages, unindexed, _cancel]() -> int32_t
     {
-        auto remain_size = std::make_shared<int64_t>(search::archive_block_size());
-        auto index = 0u;
-
-        _archive->clear();
-        auto has_result = false;
-        int64_t cur_index = 0;
-
-        while (*remain_size > 0 && index < _contacts->size())
+        for (const auto& contact : *_contacts)
         {
             if (_cancel())
                 return -1;
 
-            auto [contact, regim, offset] = (*_contacts)[index];
-            ++index;
-
-            auto prev_cur_index = cur_index;
-            auto cur_result = history_cache->get_history_file(contact, *_data, offset, remain_size, cur_index, regim);
-            has_result |= cur_result;
-
-            if (!cur_result)
-            {
-                *offset = -2;
-            }
-
-            //if (cur_result && cur_index != prev_cur_index)
-            {
-                _archive->push_back(std::make_pair(contact, prev_cur_index));
-            }
-        }
-        _archive->push_back(std::make_pair(std::string(), cur_index));
-
-        const auto last_index = index;
-        const auto contacts_size = _contacts->size();
-        remaining->reserve(contacts_size - last_index);
-        for (; index < contacts_size; ++index)
-        {
-            remaining->push_back((*_contacts)[index]);
+            if (!history_cache->search_in_index(contact, *_cterm, *found_messages))
+                unindexed->push_back(contact);
         }
-        _contacts->resize(last_index);
 
-        return (has_result ? 0 : -1);
-    }, task_name, _cancel)->on_result_ = [wr_this = weak_from_this(), handler, _archive, history_cache, remaining, _data](int32_t _error)
+        return 0;
+    }, task_name, _cancel)->on_result_ = [wr_this = weak_from_this(), handler, found_messages, unindexed](int32_t _error)
     {
-        // we calc count of finished threads
-        // if (_error == -1)
-        //    return;
+        if (_error != 0)
+            return;
 
         auto ptr_this = wr_this.lock();
         if (!ptr_this)
             return;
 
         if (handler->on_result)
-            handler->on_result(_archive, remaining, _data);
+            handler->on_result(found_messages, unindexed);
     };
 
     return handler;
@@ -1957,6 +2051,25 @@ void face::free_dialog(const std::string& _contact)
     }, task_name);
 }
 
+void face::backfill_search_index(std::shared_ptr<std::vector<std::string>> _contacts, size_t _from)
+{
+    if (_from >= _contacts->size())
+        return;
+
+    static constexpr char task_name[] = "face::backfill_search_index";
+
+    thread_->run_async_function([history_cache = history_cache_, contact = (*_contacts)[_from]]()->int32_t
+    {
+        return history_cache->update_search_index(contact, search_index_backfill_step) ? 0 : 1;
+
+    }, task_name)->on_result_ = [wr_this = weak_from_this(), _contacts, _from](int32_t _error)
+    {
+        // the rest of a big dialog is indexed by the next task, the tasks queued meanwhile run in between
+        if (auto ptr_this = wr_this.lock())
+            ptr_this->backfill_search_index(_contacts, _error == 0 ? _from + 1 : _from);
+    };
+}
+
 int64_t face::get_last_msgid(const std::string& _contact) const
 {
     return history_cache_->get_last_msgid(_contact);
@@ -1968,18 +2081,19 @@ std::shared_ptr<memory_usage> face::get_memory_usage()
 
     auto index_size = std::make_shared<int64_t>(0);
     auto gallery_size = std::make_shared<int64_t>(0);
+    auto cache_stats = std::make_shared<archives_cache_stats>();
 
     static constexpr char task_name[] = "face::get_memory_usage";
 
-    thread_->run_async_function([history_cache = history_cache_, index_size, gallery_size]()->int32_t
+    thread_->run_async_function([history_cache = history_cache_, index_size, gallery_size, cache_stats]()->int32_t
     {
-        history_cache->get_memory_usage(*index_size, *gallery_size);
+        history_cache->get_memory_usage(*index_size, *gallery_size, *cache_stats);
 
         return 0;
 
-    }, task_name)->on_result_ = [handler, index_size, gallery_size](int32_t _error)
+    }, task_name)->on_result_ = [handler, index_size, gallery_size, cache_stats](int32_t _error)
     {
-        handler->on_result(*index_size, *gallery_size);
+        handler->on_result(*index_size, *gallery_size, *cache_stats);
     };
 
     return handler;
@@ -25,6 +25,16 @@ namespace core
         class binary_stream;
     }
 
+    namespace archive
+    {
+        class history_message;
+    }
+
+    namespace search
+    {
+        using found_messages = std::unordered_map<std::string, std::vector<std::shared_ptr<archive::history_message>>>;
+    }
+
     namespace archive
     {
         class contact_archive;
@@ -46,13 +56,21 @@ namespace core
         struct thread_update;
         struct draft;
         class pending_drafts;
+        struct coded_term;
 
         struct message_stat_time;
         using message_stat_time_v = std::vector<message_stat_time>;
 
         using not_sent_message_sptr = std::shared_ptr<not_sent_message>;
         using history_message_sptr = std::shared_ptr<history_message>;
-        using archives_map = std::unordered_map<std::string, std::shared_ptr<contact_archive>>;
+        struct cached_archive
+        {
+            std::shared_ptr<contact_archive> archive_;
+            int64_t memory_usage_ = 0;
+            std::list<std::string>::iterator recent_position_;
+        };
+
+        using archives_map = std::unordered_map<std::string, cached_archive>;
         using history_block = std::vector<history_message_sptr>;
         using history_block_sptr = std::shared_ptr<history_block>;
         using image_list = std::list<image_data>;
@@ -219,14 +237,14 @@ namespace core
             }
         };
 
-        struct request_history_file_handler
+        struct search_in_index_handler
         {
-            using on_result_type = std::function<void(std::shared_ptr<contact_and_msgs>, std::shared_ptr<contact_and_offsets_v>, std::shared_ptr<tools::binary_stream> _data)>;
+            using on_result_type = std::function<void(std::shared_ptr<search::found_messages>, std::shared_ptr<std::vector<std::string>> _unindexed)>;
             on_result_type on_result;
 
-            request_history_file_handler()
+            search_in_index_handler()
             {
-                on_result = [](std::shared_ptr<contact_and_msgs>, std::shared_ptr<contact_and_offsets_v>, std::shared_ptr<tools::binary_stream>){};
+                on_result = [](std::shared_ptr<search::found_messages>, std::shared_ptr<std::vector<std::string>>){};
             }
         };
 
@@ -370,16 +388,31 @@ namespace core
             on_result_type on_result;
         };
 
+        struct archives_cache_stats
+        {
+            int64_t loaded_count_ = 0;
+            int64_t memory_budget_ = 0;
+            int64_t evicted_count_ = 0;
+            int64_t reloaded_count_ = 0;
+        };
+
         struct memory_usage
         {
             std::function<void(
                 const int64_t _memory_usage_index,
-                const int64_t _memory_usage_gallery)> on_result = [](const int64_t, const int64_t){};
+                const int64_t _memory_usage_gallery,
+                const archives_cache_stats& _cache_stats)> on_result = [](const int64_t, const int64_t, const archives_cache_stats&){};
         };
 
         class local_history : public std::enable_shared_from_this<local_history>
         {
+            // loaded archives, the least recently used ones are dropped when they take more than memory_budget_
             mutable archives_map archives_;
+            mutable std::list<std::string> recent_archives_;
+            mutable std::unordered_set<std::string> evicted_archives_;
+            mutable int64_t archives_memory_usage_ = 0;
+            mutable archives_cache_stats cache_stats_;
+            const int64_t memory_budget_;
 
             const std::wstring archive_path_;
 
@@ -390,6 +423,8 @@ namespace core
             message_stat_time_v stat_message_times_;
 
             std::shared_ptr<contact_archive> get_contact_archive(const std::string& _contact) const;
+            void update_memory_usage(cached_archive& _archive) const;
+            void evict_archives() const;
 
             const pending_operations& get_pending_operations() const;
             pending_operations& get_pending_operations();
@@ -411,16 +446,26 @@ namespace core
             };
 
             local_history(const std::wstring& _archive_path);
+            local_history(const std::wstring& _archive_path, int64_t _memory_budget);
             virtual ~local_history();
 
             void optimize_contact_archive(const std::string& _contact);
             void free_dialog(const std::string& _contact);
 
+            // builds or catches up the search index of the dialog without loading its archive,
+            // indexes at most _max_size bytes, true if the whole dialog is indexed
+            bool update_search_index(const std::string& _contact, int64_t _max_size);
+
             int64_t get_last_msgid(const std::string& _contact) const;
             void get_messages_buddies(const std::string& _contact, std::shared_ptr<archive::msgids_list> _ids, /*out*/ std::shared_ptr<history_block> _messages, /*out*/ bool& _first_load, /*out*/ std::shared_ptr<error_vector> _errors);
             bool get_messages(const std::string& _contact, int64_t _from, int64_t _count_early, int64_t _count_later, /*out*/ std::shared_ptr<history_block> _messages, /*out*/ bool& _first_load, /*out*/ std::shared_ptr<error_vector> _errors);
-            bool get_history_file(const std::string& _contact, /*out*/ core::tools::binary_stream& _history_archive
-                , std::shared_ptr<int64_t> _offset, std::shared_ptr<int64_t> _remaining_size, int64_t& _cur_index, std::shared_ptr<int64_t> _mode);
+            const std::wstring& get_archive_path() const noexcept { return archive_path_; }
+
+            // reads the next search block of _contacts into _data, doesn't touch any cached archive
+            // so it may run on any thread; contacts which didn't fit are moved to _remaining
+            static bool get_history_block(const std::wstring& _archive_path, contact_and_offsets_v& _contacts, /*out*/ contact_and_msgs& _archive
+                , /*out*/ core::tools::binary_stream& _data, /*out*/ contact_and_offsets_v& _remaining, const std::function<bool()>& _cancel);
+            bool search_in_index(const std::string& _contact, const coded_term& _cterm, /*out*/ search::found_messages& _found_messages);
 
             dlg_state get_dlg_state(const std::string& _contact);
 
@@ -520,7 +565,7 @@ namespace core
             void invalidate_history(const std::string& _aimid);
             void invalidate_message_data(const std::string& _aimId, const std::vector<int64_t>& _ids);
             void invalidate_message_data(const std::string& _aimId, int64_t _from, int64_t _before_count, int64_t _after_count);
-            void get_memory_usage(int64_t& _index_size, int64_t& _gallery_size);
+            void get_memory_usage(int64_t& _index_size, int64_t& _gallery_size, archives_cache_stats& _cache_stats);
             void insert_reactions(const std::string& _contact, const reactions_vector_sptr& _reactions);
             void get_reactions(const std::string& _contact, const std::shared_ptr<msgids_list>& _msg_ids, /*out*/ reactions_vector_sptr _reactions, /*out*/ std::shared_ptr<core::archive::msgids_list> _missing);
             void insert_thread_updates(const std::string& _contact, const thread_updates_v_sptr& _updates);
@@ -543,6 +588,9 @@ namespace core
 
             void free_dialog(const std::string& _contact);
 
+            // indexes the dialogs not indexed yet a part of a dialog per task, so the archive thread is never held for long
+            void backfill_search_index(std::shared_ptr<std::vector<std::string>> _contacts, size_t _from = 0);
+
             int64_t get_last_msgid(const std::string& _contact) const;
 
             std::shared_ptr<update_history_handler> update_history(const std::string& _contact, const std::shared_ptr<archive::history_block>& _data, int64_t _from = -1, local_history::has_older_message_id _has_older_msgid = local_history::has_older_message_id::yes);
@@ -554,8 +602,9 @@ namespace core
             std::shared_ptr<get_mentions_handler> get_mentions(std::string_view _contact);
             std::shared_ptr<filter_deleted_handler> filter_deleted_messages(const std::string& _contact, std::vector<int64_t>&& _ids);
 
-            std::shared_ptr<request_history_file_handler> get_history_block(std::shared_ptr<contact_and_offsets_v> _contacts
-                , std::shared_ptr<contact_and_msgs> _archive, std::shared_ptr<tools::binary_stream> _data, std::function<bool()> _cancel);
+            const std::wstring& get_archive_path() const noexcept;
+            std::shared_ptr<search_in_index_handler> search_in_index(std::shared_ptr<std::vector<std::string>> _contacts
+                , std::shared_ptr<coded_term> _cterm, std::function<bool()> _cancel);
 
             std::shared_ptr<request_dlg_state_handler> get_dlg_state(std::string_view _contact, bool _debug = false);
 
@@ -3,15 +3,32 @@
 #include "storage.h"
 #include "archive_index.h"
 #include "search_dialog_result.h"
+#include "search_index.h"
+#include "../core.h"
 #include "../tools/system.h"
+#include "../tools/tlv_view.h"
 #include "../../common.shared/common_defs.h"
 #include "../../common.shared/constants.h"
 
+#include <shared_mutex>
+
 using namespace core;
 using namespace archive;
 
-messages_data::messages_data(std::wstring _file_name)
+namespace
+{
+    // the history search reads the db files on its own threads, the archive thread
+    // appends to them and truncates them, so a read never sees a half written block
+    std::shared_mutex& db_files_mutex()
+    {
+        static std::shared_mutex mutex;
+        return mutex;
+    }
+}
+
+messages_data::messages_data(std::wstring _file_name, std::wstring _search_index_file_name)
     : storage_(std::make_unique<storage>(std::move(_file_name)))
+    , search_index_(std::make_unique<search_index>(std::move(_search_index_file_name)))
 {
 }
 
@@ -19,26 +36,44 @@ messages_data::messages_data(std::wstring _file_name)
 messages_data::~messages_data() = default;
 
 
+bool messages_data::read_data_block(int64_t _offset, core::tools::binary_stream& _buffer, std::string_view& _data) const
+{
+    if (storage_->is_mapped())
+        return storage_->read_data_block(_offset, _data);
+
+    if (!storage_->read_data_block(_offset, _buffer))
+        return false;
+
+    const auto size = _buffer.available();
+    _data = size > 0 ? std::string_view(_buffer.read(size), size_t(size)) : std::string_view();
+    return true;
+}
+
 messages_data::error_vector messages_data::get_messages(const headers_list& _headers, history_block& _messages) const
 {
     error_vector res;
+
     auto p_storage = storage_.get();
+
+    // the mapping stays alive between calls and is only extended when the file grows
+    const auto mapped = storage_->map();
     archive::storage_mode mode;
     mode.flags_.read_ = mode.flags_.append_ = true;
-    if (!storage_->open(mode))
+    if (!mapped && !storage_->open(mode))
     {
         res.emplace_back(-1, -1);
         return res;
     }
-    core::tools::auto_scope lb([p_storage]{p_storage->close();});
+    core::tools::auto_scope lb([p_storage, mapped]{ if (!mapped) p_storage->close(); });
 
     _messages.reserve(_headers.size());
 
-    core::tools::binary_stream message_data;
+    core::tools::binary_stream buffer;
+    core::tools::tlv_view pack;
 
     for (const auto &header : _headers)
     {
-        message_data.reset();
+        buffer.reset();
         im_assert(!header.is_patch() || header.is_updated_message());
 
         auto make_fake_mesage = [](const auto& header)
@@ -53,7 +88,8 @@ messages_data::error_vector messages_data::get_messages(const headers_list& _hea
             return msg;
         };
 
-        if (!storage_->read_data_block(header.get_data_offset(), message_data))
+        std::string_view message_data;
+        if (!read_data_block(header.get_data_offset(), buffer, message_data))
         {
             im_assert(!"invalid message data");
             res.emplace_back(header.get_id(), 1);
@@ -62,7 +98,7 @@ messages_data::error_vector messages_data::get_messages(const headers_list& _hea
         }
 
         auto msg = std::make_shared<history_message>();
-        if (msg->unserialize(message_data) != 0)
+        if (!pack.unserialize(message_data) || msg->unserialize(pack) != 0)
         {
             im_assert(!"unserialize message error");
             res.emplace_back(header.get_id(), 2);
@@ -94,50 +130,77 @@ messages_data::error_vector messages_data::get_messages(const headers_list& _hea
 
 void messages_data::drop()
 {
+    storage_->unmap();
+    search_index_->drop();
+
+    std::unique_lock lock(db_files_mutex());
+
     archive::storage_mode mode;
     mode.flags_.write_ = mode.flags_.truncate_ = true;
     storage_->open(mode);
     storage_->close();
 }
 
-bool is_equal(const char* _str1, const char* _str2, int _b, int _l)
+void messages_data::free()
 {
-    if (_l == 1)
-        return *_str1 == *(_str2 + _b);
-
-    return std::memcmp(_str1, _str2 + _b, _l) == 0;
+    storage_->unmap();
 }
 
-int32_t kmp_strstr(const char* _str, uint32_t _str_sz, const std::vector<int32_t>& _term
-               , const std::vector<int32_t>& _prefix, const std::string& _symbs, const std::vector<int32_t>& _symb_indexes)
+bool messages_data::search_in_index(const std::wstring& _file_name, const std::wstring& _search_index_file_name
+    , const coded_term& _cterm, std::vector<history_message_sptr>& _found_messages)
 {
-    if (!_str)
-        return -1;
+    if (!core::tools::system::is_exist(_file_name))
+        return true;
+
+    const auto candidates = search_index::find(_search_index_file_name, core::tools::system::get_file_size(_file_name), _cterm.lower_term);
+    if (!candidates)
+        return false;
+
+    if (candidates->empty())
+        return true;
 
-    auto j = 0u;
+    storage db(_file_name);
+    if (!db.map())
+        return false;
 
-    for (auto i = 0u; i < _str_sz; )
+    const auto limit = ::common::get_limit_search_results();
+    const term_matcher matcher(_cterm);
+
+    core::tools::tlv_view pack;
+
+    // the index may give false positives, every candidate is checked against the message text
+    for (const auto& candidate : *candidates)
     {
-        auto len = tools::utf8_char_size(*(_str + i));
+        if (_found_messages.size() >= limit)
+            break;
 
-        while (j > 0 && (!is_equal(_symbs.c_str() + _symb_indexes[2 * j], _str, i, len) && !is_equal(_symbs.c_str() + _symb_indexes[2 * j + 1], _str, i, len)))
-            j = _prefix[j - 1];
+        std::string_view block;
+        if (!db.read_data_block(candidate.data_offset_, block) || block.empty())
+            continue;
 
-        if (is_equal(_symbs.c_str() + _symb_indexes[2 * j], _str, i, len) || is_equal(_symbs.c_str() + _symb_indexes[2 * j + 1], _str, i, len))
-            j += 1;
+        if (!pack.unserialize(block))
+            continue;
 
-        if (j == _term.size())
-        {
-            return i - j + 1;
-        }
-        i += len;
+        const auto text = history_message::get_text_field(pack);
+        if (text.empty())
+            continue;
+
+        if (matcher.find(text.data(), uint32_t(text.size())) == -1)
+            continue;
+
+        auto msg = std::make_shared<history_message>();
+        if (msg->unserialize(pack) == 0 && msg->get_msgid() == candidate.msgid_)
+            _found_messages.push_back(std::move(msg));
     }
-    return -1;
+
+    return true;
 }
 
 bool messages_data::get_history_archive(const std::wstring& _file_name, core::tools::binary_stream& _buffer
     , std::shared_ptr<int64_t> _offset, std::shared_ptr<int64_t> _remaining_size, int64_t& _cur_index, std::shared_ptr<int64_t> _mode)
 {
+    std::shared_lock lock(db_files_mutex());
+
     auto file = tools::system::open_file_for_read(_file_name, std::ios::binary | std::ios::ate);
 
     auto init_size = static_cast<int64_t>(file.tellg());
@@ -185,10 +248,19 @@ void messages_data::search_in_archive(std::shared_ptr<contact_and_offsets_v> _co
                 , std::shared_ptr<archive::contact_and_msgs> _archive
                 , std::shared_ptr<tools::binary_stream> _data
                 , search::found_messages& found_messages
-                , int64_t _min_id)
+                , const std::atomic_int64_t& _min_id
+                , const std::function<bool()>& _cancel)
 {
-    std::set<int64_t, std::greater<int64_t>> top_ids;
+    // min-heap of the best ids matched by this batch, once it's full
+    // nothing older than its top can get into the results
+    const auto limit = ::common::get_limit_search_results();
+    std::vector<int64_t> top_ids;
+    top_ids.reserve(limit + 1);
+
+    const term_matcher matcher(*_cterm);
 
+    constexpr uint32_t cancel_check_period = 256;
+    uint32_t blocks_count = 0;
 
     auto find_by_id = [](auto term_id, auto id)
     {
@@ -214,36 +286,34 @@ void messages_data::search_in_archive(std::shared_ptr<contact_and_offsets_v> _co
 
     for (auto contact_i = 0u; contact_i < _archive->size() - 1; ++contact_i)
     {
+        if (_cancel && _cancel())
+            return;
+
         auto current_pos = (*_archive)[contact_i].second;
         auto end_pos = (*_archive)[contact_i + 1].second;
         auto _offset = std::get<2>((*_contacts_and_offsets)[contact_i]);
         auto _contact = (*_archive)[contact_i].first;
 
+        // get_history_archive marks the chunk that reached the end of the file
+        const auto is_file_end = *_offset == -1;
+
         int64_t begin_of_block;
 
-        while (storage::fast_read_data_block((*_data), current_pos, begin_of_block, end_pos))
+        while (storage::fast_read_data_block((*_data), current_pos, begin_of_block, end_pos, is_file_end))
         {
+            if (++blocks_count % cancel_check_period == 0 && _cancel && _cancel())
+                return;
+
             _data->set_output(begin_of_block);
             auto mess_id = history_message::get_id_field(*_data);
 
-            if (mess_id == -1 || mess_id <= _min_id)
+            // _min_id is the worst result merged so far from all the workers;
+            // an equal id is still read as it may be an edit of a found message
+            if (mess_id == -1 || mess_id < _min_id.load(std::memory_order_relaxed))
                 continue;
 
-            if (top_ids.size() > ::common::get_limit_search_results())
-            {
-                auto greater = top_ids.upper_bound(mess_id);
-
-                if (greater != top_ids.end())
-                {
-                    auto min_id = (*top_ids.rbegin());
-                    top_ids.erase(min_id);
-                    top_ids.insert(mess_id);
-                }
-                else
-                {
-                    continue;
-                }
-            }
+            if (top_ids.size() >= limit && mess_id < top_ids.front())
+                continue;
 
             uint32_t text_length = 0;
 
@@ -269,19 +339,30 @@ void messages_data::search_in_archive(std::shared_ptr<contact_and_offsets_v> _co
                 pointer = _data->read_available();
 
             if (find_by_id(term_id, mess_id)
-                || kmp_strstr(pointer, text_length, _cterm->coded_string, _cterm->prefix, _cterm->symbs, _cterm->symb_indexes) != -1)
+                || matcher.find(pointer, text_length) != -1)
             {
                 _data->set_output(begin_of_block);
                 auto msg = std::make_shared<history_message>();
                 if (msg->unserialize(*_data) == 0)
                 {
-                    top_ids.insert(mess_id);
                     auto& messages = found_messages[_contact];
                     const auto msg_it = std::find_if(messages.begin(), messages.end(), [mess_id](const auto& msg) { return msg->get_msgid() == mess_id; });
                     if (msg_it != messages.end())
+                    {
                         *msg_it = std::move(msg);
+                    }
                     else
+                    {
                         messages.push_back(std::move(msg));
+
+                        top_ids.push_back(mess_id);
+                        std::push_heap(top_ids.begin(), top_ids.end(), std::greater<>());
+                        if (top_ids.size() > limit)
+                        {
+                            std::pop_heap(top_ids.begin(), top_ids.end(), std::greater<>());
+                            top_ids.pop_back();
+                        }
+                    }
                 }
             }
             else
@@ -310,20 +391,23 @@ history_block messages_data::get_message_modifications(const message_header& _he
     if (!_header.is_modified() && !_header.is_updated())
         return modifications;
 
-    core::tools::binary_stream message_data;
+    core::tools::binary_stream buffer;
+    core::tools::tlv_view pack;
 
     const auto &modification_headers = _header.get_modifications();
     modifications.reserve(modification_headers.size());
     for (const auto &header : modification_headers)
     {
-        if (!storage_->read_data_block(header.get_data_offset(), message_data))
+        buffer.reset();
+        std::string_view message_data;
+        if (!read_data_block(header.get_data_offset(), buffer, message_data))
         {
             im_assert(!"invalid modification data");
             continue;
         }
 
         auto modification = std::make_shared<history_message>();
-        if (modification->unserialize(message_data) != 0)
+        if (!pack.unserialize(message_data) || modification->unserialize(pack) != 0)
         {
             im_assert(!"unserialize modification error");
             continue;
@@ -351,22 +435,119 @@ storage::result_type messages_data::update(const archive::history_block& _data)
         return { false, 0 };
     core::tools::auto_scope lb([p_storage]{p_storage->close();});
 
-    core::tools::binary_stream message_data;
+    // the whole block is framed in memory and appended with one write,
+    // offsets are assigned only after it has reached the file
+    data_block_batch batch;
+
+    std::vector<std::pair<int64_t, uint32_t>> blocks(_data.size(), { -1, 0 });
 
+    auto block = blocks.begin();
     for (const auto& msg : _data)
     {
-        message_data.reset();
-        msg->serialize(message_data);
+        msg->serialize(batch.begin_block());
+
+        if (!batch.end_block(block->first, block->second))
+            return { false, std::numeric_limits<std::int32_t>::max() };
 
-        const auto data_size = message_data.available();
+        ++block;
+    }
 
-        int64_t offset = 0;
-        if (auto res = storage_->write_data_block(message_data, offset); !res)
+    int64_t db_size_before = 0;
+    {
+        std::unique_lock lock(db_files_mutex());
+        if (auto res = storage_->write_data_blocks(batch, db_size_before); !res)
             return res;
+    }
+
+    search_index::text_entries texts;
+    texts.reserve(_data.size());
+
+    block = blocks.begin();
+    for (const auto& msg : _data)
+    {
+        const auto offset = db_size_before + block->first;
 
         msg->set_data_offset(offset);
-        msg->set_data_size(data_size);
+        msg->set_data_size(block->second);
+
+        if (!msg->is_sticker() && !msg->is_chat_event())
+            texts.push_back({ msg->get_msgid(), offset, msg->get_text() });
+
+        ++block;
     }
 
+    search_index_->append(texts, db_size_before, db_size_before + batch.size());
+
     return { true, 0 };
 }
+
+bool messages_data::update_search_index(int64_t _max_size)
+{
+    const auto db_size = int64_t(core::tools::system::get_file_size(storage_->get_file_name()));
+    const auto indexed_size = search_index_->get_indexed_db_size();
+    if (indexed_size == db_size)
+        return true;
+
+    if (!storage_->map())
+        return true;
+
+    // the index of a file truncated since it was built is built anew
+    const auto from = indexed_size > 0 && indexed_size < db_size ? indexed_size : 0;
+
+    std::vector<std::string> texts_data;
+    search_index::text_entries texts;
+
+    core::tools::tlv_view pack;
+
+    int64_t offset = from;
+    while (offset < db_size && offset - from < _max_size)
+    {
+        std::string_view block;
+        if (!storage_->read_data_block(offset, block))
+        {
+            // a broken block would leave the file unindexed for good, the blocks after it are indexed
+            const auto next = storage_->find_data_block(offset + 1);
+
+            std::stringstream info;
+            info << "search index: skipped a broken block of " << tools::from_utf16(storage_->get_file_name()) << " at " << offset << "\r\n";
+            g_core->write_string_to_network_log(info.str());
+
+            offset = next == -1 ? db_size : next;
+            continue;
+        }
+
+        const auto block_offset = offset;
+        offset += block.size() + 4 * sizeof(uint32_t);
+
+        if (block.empty())
+            continue;
+
+        if (!pack.unserialize(block))
+            continue;
+
+        const auto msgid = history_message::get_id_field(pack);
+        if (msgid == -1)
+            continue;
+
+        if (history_message::is_sticker(pack) || history_message::is_chat_event(pack))
+            continue;
+
+        const auto text = history_message::get_text_field(pack);
+        if (text.empty())
+            continue;
+
+        texts_data.emplace_back(text);
+        texts.push_back({ msgid, block_offset, {} });
+    }
+
+    for (size_t i = 0; i < texts.size(); ++i)
+        texts[i].text_ = texts_data[i];
+
+    if (from == 0)
+        search_index_->rebuild(texts, offset);
+    else
+        search_index_->append(texts, from, offset);
+
+    // an index that can't be written isn't retried by this pass
+    return offset >= db_size || !search_index_->is_synced(offset);
+}
@@ -3,6 +3,7 @@
 #include "history_message.h"
 #include "dlg_state.h"
 #include "storage.h"
+#include "term_matcher.h"
 
 namespace core
 {
@@ -28,25 +29,20 @@ namespace core
         using contact_and_offset = std::tuple<std::string, std::shared_ptr<int64_t>, std::shared_ptr<int64_t>>;
         using contact_and_offsets_v = std::vector<contact_and_offset>;
 
-        struct coded_term
-        {
-            std::string lower_term;
-            std::vector<std::pair<std::string, int32_t>> symb_table;
-            std::string symbs;
-            std::vector<int32_t> coded_string;
-            std::vector<int32_t> prefix;
-            std::vector<int32_t> symb_indexes;
-        };
+        class search_index;
 
         class messages_data
         {
             std::unique_ptr<storage> storage_;
+            std::unique_ptr<search_index> search_index_;
 
             history_block get_message_modifications(const message_header& _header) const;
+            // _data points into the mapping, or into _buffer when the file isn't mapped
+            bool read_data_block(int64_t _offset, core::tools::binary_stream& _buffer, std::string_view& _data) const;
 
         public:
 
-            messages_data(std::wstring _file_name);
+            messages_data(std::wstring _file_name, std::wstring _search_index_file_name);
             ~messages_data();
 
             storage::result_type update(const history_block& _data);
@@ -56,12 +52,22 @@ namespace core
             error_vector get_messages(const headers_list& _headers, history_block& _messages) const;
 
             void drop();
+            void free();
+
+            // indexes at most _max_size bytes of the file not covered by the search index yet,
+            // true if the index covers the whole file now
+            bool update_search_index(int64_t _max_size = std::numeric_limits<int64_t>::max());
 
             static void search_in_archive(std::shared_ptr<contact_and_offsets_v> _contacts, std::shared_ptr<coded_term> _cterm
                 , std::shared_ptr<archive::contact_and_msgs> _archive
                 , std::shared_ptr<tools::binary_stream> _data
                 , search::found_messages& found_messages
-                , int64_t _min_id);
+                , const std::atomic_int64_t& _min_id
+                , const std::function<bool()>& _cancel);
+
+            // false if the contact has no up to date search index and has to be scanned
+            static bool search_in_index(const std::wstring& _file_name, const std::wstring& _search_index_file_name
+                , const coded_term& _cterm, std::vector<history_message_sptr>& _found_messages);
 
             static bool get_history_archive(const std::wstring& _file_name, core::tools::binary_stream& _buffer
                 , std::shared_ptr<int64_t> _offset, std::shared_ptr<int64_t> _remaining_size, int64_t& _cur_index, std::shared_ptr<int64_t> _mode);
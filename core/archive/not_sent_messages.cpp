@@ -39,7 +39,7 @@ namespace
     };
 }
 
-not_sent_message_sptr not_sent_message::make(const core::tools::tlvpack& _pack)
+not_sent_message_sptr not_sent_message::make(const core::tools::tlv_view& _pack)
 {
     const not_sent_message_sptr msg(new not_sent_message);
     if (msg->unserialize(_pack))
@@ -281,7 +281,7 @@ void not_sent_message::serialize(core::coll_helper& _coll, const time_t _offset)
     get_message()->serialize(_coll.get(), _offset);
 }
 
-bool not_sent_message::unserialize(const core::tools::tlvpack& _pack)
+bool not_sent_message::unserialize(const core::tools::tlv_view& _pack)
 {
     auto tlv_aimid = _pack.get_item(not_sent_message_fields::contact);
     auto tlv_message = _pack.get_item(not_sent_message_fields::message);
@@ -325,8 +325,7 @@ bool not_sent_message::unserialize(const core::tools::tlvpack& _pack)
     if (tlv_draft_delete_time)
         draft_delete_time_.emplace(tlv_draft_delete_time->get_value<int64_t>());
 
-    core::tools::binary_stream stream = tlv_message->get_value<core::tools::binary_stream>();
-    return !message_->unserialize(stream);
+    return !message_->unserialize(tlv_message->get_value<core::tools::tlv_view>());
 }
 
 void not_sent_message::mark_duplicated()
@@ -560,7 +559,7 @@ void delete_message::serialize(core::tools::tlvpack& _pack) const
     _pack.push_child(tools::tlv(delete_message_fields::operation, (int32_t) get_operation()));
 }
 
-std::unique_ptr<delete_message> delete_message::make(const core::tools::tlvpack& _pack)
+std::unique_ptr<delete_message> delete_message::make(const core::tools::tlv_view& _pack)
 {
     auto tlv_aimid = _pack.get_item(delete_message_fields::contact);
     auto tlv_message_id = _pack.get_item(delete_message_fields::message_id);
@@ -1144,29 +1143,21 @@ bool pending_operations::load(storage& _storage, container_type_& _pendings)
         return false;
     }
 
-    core::tools::tlvpack pack_root;
+    core::tools::tlv_view pack_root;
     if (!pack_root.unserialize(bs_data))
     {
         return false;
     }
 
-    auto tlv_msg = pack_root.get_first();
-    while (tlv_msg)
+    for (const auto& tlv_msg : pack_root)
     {
-        auto bs_message = tlv_msg->get_value<core::tools::binary_stream>();
-
-        core::tools::tlvpack pack_message;
+        const auto pack_message = tlv_msg.get_value<core::tools::tlv_view>();
 
-        if (pack_message.unserialize(bs_message))
+        auto msg = entry_type_::make(pack_message);
+        if (msg)
         {
-            auto msg = entry_type_::make(pack_message);
-            if (msg)
-            {
-                _pendings[msg->get_aimid()].emplace_back(std::move(msg));
-            }
+            _pendings[msg->get_aimid()].emplace_back(std::move(msg));
         }
-
-        tlv_msg = pack_root.get_next();
     }
 
     return true;
@@ -11,6 +11,7 @@ namespace core
     namespace tools
     {
         class tlvpack;
+        class tlv_view;
     }
 
     namespace archive
@@ -70,7 +71,7 @@ namespace core
         class not_sent_message
         {
         public:
-            static not_sent_message_sptr make(const core::tools::tlvpack& _pack);
+            static not_sent_message_sptr make(const core::tools::tlv_view& _pack);
 
             static not_sent_message_sptr make(
                 const not_sent_message_sptr& _message,
@@ -221,7 +222,7 @@ namespace core
 
             void copy_from(const not_sent_message_sptr& _message);
 
-            bool unserialize(const core::tools::tlvpack& _pack);
+            bool unserialize(const core::tools::tlv_view& _pack);
         };
 
         typedef std::list<not_sent_message_sptr> not_sent_messages_list;
@@ -271,7 +272,7 @@ namespace core
 
             void serialize(core::tools::tlvpack& _pack) const;
 
-            static std::unique_ptr<delete_message> make(const core::tools::tlvpack& _pack);
+            static std::unique_ptr<delete_message> make(const core::tools::tlv_view& _pack);
         };
 
 
@@ -75,7 +75,7 @@ void pending_drafts::load()
 
     while (storage_->read_data_block(-1, data))
     {
-        core::tools::tlvpack pack;
+        core::tools::tlv_view pack;
         if (!pack.unserialize(data))
             return;
 
@@ -50,7 +50,7 @@ void reactions_data::reaction::serialize(core::tools::tlvpack& _pack) const
     _pack.push_child(core::tools::tlv(tlv_reaction_item, pack));
 }
 
-bool reactions_data::reaction::unserialize(core::tools::tlvpack& _pack)
+bool reactions_data::reaction::unserialize(const core::tools::tlv_view& _pack)
 {
     if (const auto reaction_item = _pack.get_item(tlv_reaction))
     {
@@ -108,11 +108,11 @@ void reactions_data::serialize(core::tools::binary_stream& _data) const
 
 bool reactions_data::unserialize(core::tools::binary_stream& _data)
 {
-    core::tools::tlvpack pack;
+    core::tools::tlv_view pack;
     if (!pack.unserialize(_data))
         return false;
 
-    for (auto field = pack.get_first(); field; field = pack.get_next())
+    for (auto field = pack.begin(); field != pack.end(); ++field)
     {
         switch ((data_tlv_fields) field->get_type())
         {
@@ -125,7 +125,7 @@ bool reactions_data::unserialize(core::tools::binary_stream& _data)
             case tlv_reaction_item:
             {
                 reaction item;
-                core::tools::tlvpack pack = field->get_value<core::tools::tlvpack>();
+                const auto pack = field->get_value<core::tools::tlv_view>();
                 if (item.unserialize(pack))
                     reactions_.push_back(std::move(item));
             }
@@ -366,7 +366,7 @@ void reactions_storage::index_record::serialize(core::tools::binary_stream& _dat
 
 bool reactions_storage::index_record::unserialize(core::tools::binary_stream& _data)
 {
-    core::tools::tlvpack pack;
+    core::tools::tlv_view pack;
     if (!pack.unserialize(_data))
         return false;
 
@@ -15,7 +15,7 @@ namespace core::archive
 
             void serialize(icollection* _collection) const;
             void serialize(core::tools::tlvpack& _pack) const;
-            bool unserialize(core::tools::tlvpack& _pack);
+            bool unserialize(const core::tools::tlv_view& _pack);
             bool unserialize(const rapidjson::Value& _node);
         };
 
@@ -0,0 +1,561 @@
+#include "stdafx.h"
+#include "search_index.h"
+
+#include "../tools/mapped_file.h"
+#include "../tools/system.h"
+
+using namespace core;
+using namespace archive;
+
+namespace
+{
+    constexpr uint32_t index_magic = 0x58444953; // SIDX
+    constexpr uint32_t index_version = 1;
+    constexpr size_t max_segments_count = 16;
+
+    constexpr uint32_t code_point_mask = 0x1FFFFF;
+
+    struct segment_header
+    {
+        uint32_t magic_;
+        uint32_t version_;
+        int64_t segment_size_;
+        int64_t db_size_;
+        uint32_t entries_count_;
+        uint32_t keys_count_;
+        uint32_t postings_count_;
+        uint32_t reserved_;
+    };
+
+    // sorted by (msgid, offset), postings refer to positions in this table
+    struct segment_entry
+    {
+        int64_t msgid_;
+        int64_t data_offset_;
+    };
+
+    struct segment_key
+    {
+        uint64_t key_;
+        uint32_t first_;
+        uint32_t count_;
+    };
+
+    static_assert(sizeof(segment_header) == 40);
+    static_assert(sizeof(segment_entry) == 16);
+    static_assert(sizeof(segment_key) == 16);
+
+    constexpr int64_t align8(int64_t _size) noexcept
+    {
+        return (_size + 7) & ~int64_t(7);
+    }
+
+    int64_t calc_segment_size(uint32_t _entries, uint32_t _keys, uint32_t _postings) noexcept
+    {
+        return sizeof(segment_header)
+            + int64_t(_entries) * sizeof(segment_entry)
+            + int64_t(_keys) * sizeof(segment_key)
+            + align8(int64_t(_postings) * sizeof(uint32_t));
+    }
+
+    struct segment_view
+    {
+        const segment_header* header_ = nullptr;
+        const segment_entry* entries_ = nullptr;
+        const segment_key* keys_ = nullptr;
+        const uint32_t* postings_ = nullptr;
+        int64_t file_offset_ = 0;
+
+        bool contains(int64_t _msgid) const
+        {
+            const auto end = entries_ + header_->entries_count_;
+            const auto it = std::lower_bound(entries_, end, _msgid, [](const segment_entry& _e, int64_t _id) { return _e.msgid_ < _id; });
+            return it != end && it->msgid_ == _msgid;
+        }
+
+        std::pair<const segment_key*, const segment_key*> keys_range(uint64_t _from, uint64_t _to) const
+        {
+            const auto end = keys_ + header_->keys_count_;
+            const auto first = std::lower_bound(keys_, end, _from, [](const segment_key& _k, uint64_t _key) { return _k.key_ < _key; });
+            const auto last = std::upper_bound(first, end, _to, [](uint64_t _key, const segment_key& _k) { return _key < _k.key_; });
+            return { first, last };
+        }
+    };
+
+    // complete segments only, a torn tail left by a crash is ignored
+    std::vector<segment_view> read_segments(std::string_view _file)
+    {
+        std::vector<segment_view> segments;
+
+        int64_t offset = 0;
+        const auto file_size = int64_t(_file.size());
+        while (offset + int64_t(sizeof(segment_header)) <= file_size)
+        {
+            const auto header = reinterpret_cast<const segment_header*>(_file.data() + offset);
+            if (header->magic_ != index_magic || header->version_ != index_version)
+                break;
+
+            if (header->segment_size_ != calc_segment_size(header->entries_count_, header->keys_count_, header->postings_count_) || offset + header->segment_size_ > file_size)
+                break;
+
+            segment_view view;
+            view.header_ = header;
+            view.entries_ = reinterpret_cast<const segment_entry*>(header + 1);
+            view.keys_ = reinterpret_cast<const segment_key*>(view.entries_ + header->entries_count_);
+            view.postings_ = reinterpret_cast<const uint32_t*>(view.keys_ + header->keys_count_);
+            view.file_offset_ = offset;
+            segments.push_back(view);
+
+            offset += header->segment_size_;
+        }
+
+        return segments;
+    }
+
+    struct segment_data
+    {
+        std::vector<segment_entry> entries_;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> postings_;
+        int64_t db_size_ = 0;
+    };
+
+    std::vector<uint32_t> decode_utf8(std::string_view _text)
+    {
+        std::vector<uint32_t> result;
+        result.reserve(_text.size());
+
+        for (size_t i = 0; i < _text.size(); )
+        {
+            const auto len = std::min<size_t>(tools::utf8_char_size(_text[i]), _text.size() - i);
+            auto b = static_cast<unsigned char>(_text[i]);
+
+            uint32_t cp = len == 1 ? b : (b & (0xFF >> (len + 1)));
+            for (size_t j = 1; j < len; ++j)
+                cp = (cp << 6) | (static_cast<unsigned char>(_text[i + j]) & 0x3F);
+
+            result.push_back(cp & code_point_mask);
+            i += len;
+        }
+
+        return result;
+    }
+
+    constexpr uint64_t make_key(uint32_t _c1, uint32_t _c2, uint32_t _c3) noexcept
+    {
+        return (uint64_t(_c1 & code_point_mask) << 42) | (uint64_t(_c2 & code_point_mask) << 21) | uint64_t(_c3 & code_point_mask);
+    }
+
+    std::string to_lower_safe(std::string_view _text)
+    {
+        try
+        {
+            return tools::system::to_lower(_text);
+        }
+        catch (...)
+        {
+        }
+
+        return std::string(_text);
+    }
+
+    // text is padded with two zero code points, so every one or two symbol substring
+    // is a prefix of some trigram
+    std::vector<uint64_t> make_keys(std::string_view _text)
+    {
+        auto code_points = decode_utf8(to_lower_safe(_text));
+        code_points.push_back(0);
+        code_points.push_back(0);
+
+        std::vector<uint64_t> keys;
+        keys.reserve(code_points.size() - 2);
+        for (size_t i = 0; i + 2 < code_points.size(); ++i)
+            keys.push_back(make_key(code_points[i], code_points[i + 1], code_points[i + 2]));
+
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+        return keys;
+    }
+
+    segment_data build_segment(const search_index::text_entries& _texts, int64_t _db_size)
+    {
+        std::vector<const search_index::text_entry*> sorted;
+        sorted.reserve(_texts.size());
+        for (const auto& text : _texts)
+        {
+            if (text.msgid_ > 0 && !text.text_.empty())
+                sorted.push_back(&text);
+        }
+
+        std::sort(sorted.begin(), sorted.end(), [](auto _l, auto _r) { return std::tie(_l->msgid_, _l->data_offset_) < std::tie(_r->msgid_, _r->data_offset_); });
+
+        segment_data segment;
+        segment.db_size_ = _db_size;
+        segment.entries_.reserve(sorted.size());
+
+        for (auto text : sorted)
+        {
+            const auto index = uint32_t(segment.entries_.size());
+            segment.entries_.push_back({ text->msgid_, text->data_offset_ });
+
+            for (auto key : make_keys(text->text_))
+                segment.postings_[key].push_back(index);
+        }
+
+        return segment;
+    }
+
+    // _segments are ordered from the oldest one
+    segment_data merge_segments(const std::vector<segment_view>& _segments)
+    {
+        segment_data merged;
+        if (_segments.empty())
+            return merged;
+
+        merged.db_size_ = _segments.back().header_->db_size_;
+
+        struct position
+        {
+            segment_entry entry_;
+            size_t segment_;
+            uint32_t index_;
+        };
+
+        std::vector<position> positions;
+        for (size_t s = 0; s < _segments.size(); ++s)
+        {
+            const auto& header = *_segments[s].header_;
+            for (uint32_t i = 0; i < header.entries_count_; ++i)
+                positions.push_back({ _segments[s].entries_[i], s, i });
+        }
+
+        std::sort(positions.begin(), positions.end(), [](const position& _l, const position& _r)
+        {
+            return std::tie(_l.entry_.msgid_, _l.entry_.data_offset_) < std::tie(_r.entry_.msgid_, _r.entry_.data_offset_);
+        });
+
+        std::vector<std::vector<uint32_t>> remap(_segments.size());
+        for (size_t s = 0; s < _segments.size(); ++s)
+            remap[s].resize(_segments[s].header_->entries_count_);
+
+        merged.entries_.reserve(positions.size());
+        for (const auto& pos : positions)
+        {
+            remap[pos.segment_][pos.index_] = uint32_t(merged.entries_.size());
+            merged.entries_.push_back(pos.entry_);
+        }
+
+        for (size_t s = 0; s < _segments.size(); ++s)
+        {
+            const auto& view = _segments[s];
+            for (uint32_t k = 0; k < view.header_->keys_count_; ++k)
+            {
+                const auto& key = view.keys_[k];
+                auto& postings = merged.postings_[key.key_];
+                for (uint32_t p = key.first_; p < key.first_ + key.count_; ++p)
+                    postings.push_back(remap[s][view.postings_[p]]);
+            }
+        }
+
+        for (auto& [_, postings] : merged.postings_)
+            std::sort(postings.begin(), postings.end());
+
+        return merged;
+    }
+
+    tools::binary_stream serialize_segment(const segment_data& _segment)
+    {
+        std::vector<uint64_t> keys;
+        keys.reserve(_segment.postings_.size());
+        size_t postings_count = 0;
+        for (const auto& [key, postings] : _segment.postings_)
+        {
+            keys.push_back(key);
+            postings_count += postings.size();
+        }
+        std::sort(keys.begin(), keys.end());
+
+        segment_header header = {};
+        header.magic_ = index_magic;
+        header.version_ = index_version;
+        header.db_size_ = _segment.db_size_;
+        header.entries_count_ = uint32_t(_segment.entries_.size());
+        header.keys_count_ = uint32_t(keys.size());
+        header.postings_count_ = uint32_t(postings_count);
+        header.segment_size_ = calc_segment_size(header.entries_count_, header.keys_count_, header.postings_count_);
+
+        tools::binary_stream bs;
+        bs.reserve(header.segment_size_);
+        bs.write(header);
+
+        if (!_segment.entries_.empty())
+            bs.write(reinterpret_cast<const char*>(_segment.entries_.data()), int64_t(_segment.entries_.size() * sizeof(segment_entry)));
+
+        uint32_t first = 0;
+        for (auto key : keys)
+        {
+            const auto count = uint32_t(_segment.postings_.find(key)->second.size());
+            bs.write(segment_key{ key, first, count });
+            first += count;
+        }
+
+        for (auto key : keys)
+        {
+            const auto& postings = _segment.postings_.find(key)->second;
+            bs.write(reinterpret_cast<const char*>(postings.data()), int64_t(postings.size() * sizeof(uint32_t)));
+        }
+
+        for (auto padding = header.segment_size_ - bs.available(); padding > 0; --padding)
+            bs.write<char>(0);
+
+        return bs;
+    }
+
+    bool write_to_file(const std::wstring& _file_name, const tools::binary_stream& _data, bool _append)
+    {
+        const auto path = boost::filesystem::wpath(_file_name).parent_path();
+        if (!tools::system::is_exist(path) && !tools::system::create_directory(path))
+            return false;
+
+        auto mode = std::ios::binary | std::ios::out;
+        mode |= (_append ? std::ios::app : std::ios::trunc);
+        auto file = tools::system::open_file_for_write(_file_name, mode);
+        if (!file.is_open())
+            return false;
+
+        file.write(_data.get_data_for_log(), _data.available());
+        file.close();
+
+        return !file.fail();
+    }
+
+    std::vector<uint32_t> intersect(std::vector<std::vector<uint32_t>>& _lists)
+    {
+        if (_lists.empty())
+            return {};
+
+        std::sort(_lists.begin(), _lists.end(), [](const auto& _l, const auto& _r) { return _l.size() < _r.size(); });
+
+        auto result = std::move(_lists.front());
+        for (size_t i = 1; i < _lists.size() && !result.empty(); ++i)
+        {
+            std::vector<uint32_t> next;
+            std::set_intersection(result.begin(), result.end(), _lists[i].begin(), _lists[i].end(), std::back_inserter(next));
+            result = std::move(next);
+        }
+
+        return result;
+    }
+
+    // positions of the entries whose text may contain the term
+    std::vector<uint32_t> match_segment(const segment_view& _segment, const std::vector<uint32_t>& _term)
+    {
+        const auto postings = [&_segment](const segment_key& _key)
+        {
+            return std::vector<uint32_t>(_segment.postings_ + _key.first_, _segment.postings_ + _key.first_ + _key.count_);
+        };
+
+        if (_term.size() >= 3)
+        {
+            std::vector<std::vector<uint32_t>> lists;
+            lists.reserve(_term.size() - 2);
+            for (size_t i = 0; i + 2 < _term.size(); ++i)
+            {
+                const auto key = make_key(_term[i], _term[i + 1], _term[i + 2]);
+                const auto [first, last] = _segment.keys_range(key, key);
+                if (first == last)
+                    return {};
+
+                lists.push_back(postings(*first));
+            }
+
+            return intersect(lists);
+        }
+
+        // short terms are matched as trigram prefixes
+        const auto c2_from = _term.size() == 2 ? _term[1] : 0;
+        const auto c2_to = _term.size() == 2 ? _term[1] : code_point_mask;
+        const auto [first, last] = _segment.keys_range(make_key(_term[0], c2_from, 0), make_key(_term[0], c2_to, code_point_mask));
+
+        std::vector<uint32_t> result;
+        for (auto it = first; it != last; ++it)
+            result.insert(result.end(), _segment.postings_ + it->first_, _segment.postings_ + it->first_ + it->count_);
+
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+
+        return result;
+    }
+}
+
+search_index::search_index(std::wstring _file_name)
+    : file_name_(std::move(_file_name))
+{
+}
+
+search_index::~search_index() = default;
+
+int64_t search_index::get_indexed_db_size()
+{
+    if (indexed_db_size_)
+        return *indexed_db_size_;
+
+    indexed_db_size_ = 0;
+
+    int64_t valid_size = 0;
+    int64_t file_size = 0;
+    {
+        tools::mapped_file file(file_name_);
+        if (!file.open())
+            return *indexed_db_size_;
+
+        file_size = file.size();
+
+        if (const auto segments = read_segments(std::string_view(file.data(), file.size())); !segments.empty())
+        {
+            const auto& last = segments.back();
+            indexed_db_size_ = last.header_->db_size_;
+            valid_size = last.file_offset_ + last.header_->segment_size_;
+        }
+    }
+
+    // cut a segment torn by a crash, so the next one is appended right after the valid data
+    if (valid_size != file_size)
+    {
+        boost::system::error_code error;
+        boost::filesystem::resize_file(file_name_, valid_size, error);
+        if (error)
+            indexed_db_size_ = -1;
+    }
+
+    return *indexed_db_size_;
+}
+
+bool search_index::is_synced(int64_t _db_size)
+{
+    return get_indexed_db_size() == _db_size;
+}
+
+void search_index::append(const text_entries& _texts, int64_t _db_size_before, int64_t _db_size)
+{
+    // the file isn't indexed yet, rebuild() will pick up these messages later
+    if (!is_synced(_db_size_before))
+        return;
+
+    if (!write_to_file(file_name_, serialize_segment(build_segment(_texts, _db_size)), _db_size_before != 0))
+    {
+        indexed_db_size_.reset();
+        return;
+    }
+
+    indexed_db_size_ = _db_size;
+
+    compact();
+}
+
+bool search_index::rebuild(const text_entries& _texts, int64_t _db_size)
+{
+    indexed_db_size_.reset();
+
+    if (!write_to_file(file_name_, serialize_segment(build_segment(_texts, _db_size)), false))
+        return false;
+
+    indexed_db_size_ = _db_size;
+    return true;
+}
+
+void search_index::drop()
+{
+    if (tools::system::is_exist(file_name_))
+        tools::system::delete_file(file_name_);
+
+    indexed_db_size_ = 0;
+}
+
+void search_index::compact()
+{
+    tools::binary_stream merged;
+    int64_t merge_from = -1;
+
+    {
+        tools::mapped_file file(file_name_);
+        if (!file.open())
+            return;
+
+        const auto segments = read_segments(std::string_view(file.data(), file.size()));
+        if (segments.size() < 2)
+            return;
+
+        const auto segment_size = [](const segment_view& _s) { return _s.header_->segment_size_; };
+
+        // merge the tail while the preceding segment isn't much larger than it
+        auto first = segments.size() - 1;
+        auto tail_size = segment_size(segments[first]);
+        while (first > 0 && segment_size(segments[first - 1]) <= 2 * tail_size)
+        {
+            --first;
+            tail_size += segment_size(segments[first]);
+        }
+
+        if (first + 1 > max_segments_count)
+            first = 0;
+
+        if (first == segments.size() - 1)
+            return;
+
+        const std::vector<segment_view> to_merge(segments.begin() + first, segments.end());
+        merged = serialize_segment(merge_segments(to_merge));
+        merge_from = to_merge.front().file_offset_;
+    }
+
+    boost::system::error_code error;
+    boost::filesystem::resize_file(file_name_, merge_from, error);
+    if (error || !write_to_file(file_name_, merged, true))
+        indexed_db_size_.reset();
+}
+
+std::optional<search_index::candidates> search_index::find(const std::wstring& _file_name, int64_t _db_size, std::string_view _lower_term)
+{
+    const auto term = decode_utf8(_lower_term);
+    if (term.empty())
+        return std::nullopt;
+
+    tools::mapped_file file(_file_name);
+    if (!file.open())
+        return _db_size == 0 ? std::make_optional<candidates>() : std::nullopt;
+
+    const auto segments = read_segments(std::string_view(file.data(), file.size()));
+    const auto indexed_db_size = segments.empty() ? 0 : segments.back().header_->db_size_;
+    if (indexed_db_size != _db_size)
+        return std::nullopt;
+
+    candidates result;
+
+    for (size_t s = 0; s < segments.size(); ++s)
+    {
+        const auto& segment = segments[s];
+        const auto& header = *segment.header_;
+
+        for (auto index : match_segment(segment, term))
+        {
+            const auto& entry = segment.entries_[index];
+
+            // an edited message is stored once per version, only the latest one counts
+            if (index + 1 < header.entries_count_ && segment.entries_[index + 1].msgid_ == entry.msgid_)
+                continue;
+
+            // _db is append only, so any version in a later segment is newer
+            const auto has_newer = std::any_of(segments.begin() + s + 1, segments.end(), [&entry](const segment_view& _s)
+            {
+                return _s.contains(entry.msgid_);
+            });
+
+            if (!has_newer)
+                result.push_back({ entry.msgid_, entry.data_offset_ });
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const candidate& _l, const candidate& _r) { return _l.msgid_ > _r.msgid_; });
+
+    return result;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+namespace core
+{
+    namespace archive
+    {
+        // case-insensitive trigram index over the message texts of one _db file
+        //
+        // the file is a chain of immutable segments, each history block appends a new one
+        // and trailing segments of similar size are merged, so a chat keeps O(log n) segments.
+        // every segment remembers the _db size it covers, the index is only trusted
+        // when that size matches the actual _db file
+        class search_index
+        {
+            const std::wstring file_name_;
+
+            std::optional<int64_t> indexed_db_size_;
+
+            void compact();
+
+        public:
+
+            struct text_entry
+            {
+                int64_t msgid_ = -1;
+                int64_t data_offset_ = -1;
+                std::string_view text_;
+            };
+
+            struct candidate
+            {
+                int64_t msgid_ = -1;
+                int64_t data_offset_ = -1;
+            };
+
+            using text_entries = std::vector<text_entry>;
+            using candidates = std::vector<candidate>;
+
+            explicit search_index(std::wstring _file_name);
+            ~search_index();
+
+            bool is_synced(int64_t _db_size);
+            // the _db size the index covers, -1 if the index file can't be fixed
+            int64_t get_indexed_db_size();
+
+            // _texts were appended to _db growing it from _db_size_before to _db_size
+            void append(const text_entries& _texts, int64_t _db_size_before, int64_t _db_size);
+            bool rebuild(const text_entries& _texts, int64_t _db_size);
+            void drop();
+
+            // messages which may contain _lower_term, latest versions only, ordered by msgid descending
+            // std::nullopt if the index doesn't cover the _db file of _db_size bytes
+            static std::optional<candidates> find(const std::wstring& _file_name, int64_t _db_size, std::string_view _lower_term);
+        };
+    }
+}
@@ -2,6 +2,8 @@
 #include "storage.h"
 #include "history_message.h"
 #include "../tools/system.h"
+#include "../tools/mapped_file.h"
+#include "../profiling/trace.h"
 
 using namespace core;
 using namespace archive;
@@ -9,6 +11,102 @@ using namespace archive;
 namespace
 {
     constexpr uint32_t max_data_block_size() noexcept { return 1024 * 1024; };
+
+    enum class block_parse_result
+    {
+        ok,
+        incomplete,
+        invalid
+    };
+
+    block_parse_result parse_data_block(std::string_view _file, int64_t _offset, std::string_view& _data)
+    {
+        constexpr int64_t size_len = sizeof(uint32_t);
+
+        if (_offset < 0 || _offset + 2 * size_len > int64_t(_file.size()))
+            return block_parse_result::incomplete;
+
+        uint32_t sz1 = 0, sz2 = 0;
+        memcpy(&sz1, _file.data() + _offset, size_len);
+        memcpy(&sz2, _file.data() + _offset + size_len, size_len);
+
+        if (sz1 != sz2 || sz1 > max_data_block_size())
+            return block_parse_result::invalid;
+
+        if (_offset + 4 * size_len + sz1 > int64_t(_file.size()))
+            return block_parse_result::incomplete;
+
+        uint32_t sz3 = 0, sz4 = 0;
+        memcpy(&sz3, _file.data() + _offset + 2 * size_len + sz1, size_len);
+        memcpy(&sz4, _file.data() + _offset + 3 * size_len + sz1, size_len);
+
+        if (sz1 != sz3 || sz1 != sz4)
+            return block_parse_result::invalid;
+
+        _data = _file.substr(_offset + 2 * size_len, sz1);
+        return block_parse_result::ok;
+    }
+}
+
+core::tools::binary_stream& data_block_batch::begin_block()
+{
+    im_assert(block_begin_ == -1);
+
+    block_begin_ = data_.available();
+
+    const uint32_t data_size = 0;
+    data_.write(data_size);
+    data_.write(data_size);
+
+    return data_;
+}
+
+bool data_block_batch::end_block(int64_t& _offset, uint32_t& _data_size)
+{
+    im_assert(block_begin_ != -1);
+
+    constexpr int64_t size_len = sizeof(uint32_t);
+
+    const auto begin = std::exchange(block_begin_, -1);
+    const auto data_size = data_.available() - begin - 2 * size_len;
+    if (data_size <= 0)
+    {
+        data_.set_input(begin);
+        return false;
+    }
+
+    im_assert(data_size <= max_data_block_size());
+
+    _offset = begin;
+    _data_size = uint32_t(data_size);
+
+    auto header = data_.get_data_for_write() + begin;
+    memcpy(header, &_data_size, size_len);
+    memcpy(header + size_len, &_data_size, size_len);
+
+    data_.write(_data_size);
+    data_.write(_data_size);
+
+    return true;
+}
+
+bool data_block_batch::add_block(const core::tools::binary_stream& _data, int64_t& _offset)
+{
+    const auto data_size = _data.available();
+    if (data_size <= 0)
+        return false;
+
+    auto& block = begin_block();
+    block.write(_data.get_data_for_log(), data_size);
+
+    uint32_t size = 0;
+    return end_block(_offset, size);
+}
+
+void data_block_batch::clear() noexcept
+{
+    data_.reset();
+    block_begin_ = -1;
 }
 
 storage::storage(std::wstring _file_name)
@@ -17,7 +115,10 @@ storage::storage(std::wstring _file_name)
 }
 
 
-storage::~storage() = default;
+storage::~storage()
+{
+    unmap();
+}
 
 void storage::clear()
 {
@@ -26,6 +127,8 @@ void storage::clear()
 
 bool storage::open(storage_mode _mode)
 {
+    PROFILER_ZONE("archive", "open");
+
     last_error_ = archive::error::ok;
 
     if (active_file_stream_)
@@ -105,6 +208,8 @@ static std::int32_t get_system_last_error()
 
 storage::result_type storage::write_data_block(core::tools::binary_stream& _data, int64_t& _offset)
 {
+    PROFILER_ZONE("archive", "write block");
+
     if (!active_file_stream_)
     {
         im_assert(!"file stream not opened");
@@ -147,8 +252,45 @@ storage::result_type storage::write_data_block_at(core::tools::binary_stream& _d
     return res;
 }
 
+storage::result_type storage::write_data_blocks(const data_block_batch& _batch, int64_t& _offset)
+{
+    PROFILER_ZONE("archive", "write blocks");
+
+    if (!active_file_stream_)
+    {
+        im_assert(!"file stream not opened");
+        return { false, 0 };
+    }
+
+    _offset = active_file_stream_->tellp();
+
+    if (_batch.empty())
+        return { true, 0 };
+
+    active_file_stream_->write(_batch.data(), _batch.size());
+    if (!active_file_stream_->fail())
+        active_file_stream_->flush();
+
+    if (active_file_stream_->fail())
+    {
+        const auto error = get_system_last_error();
+
+        // drop whatever part of the batch reached the file, the next append has to start on a block boundary
+        active_file_stream_->clear();
+        boost::system::error_code ec;
+        boost::filesystem::resize_file(boost::filesystem::wpath(file_name_), uint64_t(_offset), ec);
+        active_file_stream_->seekp(0, std::ios_base::end);
+
+        return { false, error };
+    }
+
+    return { true, 0 };
+}
+
 bool storage::read_data_block(int64_t _offset, core::tools::binary_stream& _data)
 {
+    PROFILER_ZONE("archive", "read block");
+
     if (_offset != -1)
         active_file_stream_->seekp(_offset);
 
@@ -192,7 +334,94 @@ bool storage::read_data_block(int64_t _offset, core::tools::binary_stream& _data
     return true;
 }
 
-bool storage::fast_read_data_block(core::tools::binary_stream& buffer, int64_t& current_pos, int64_t& _begin, int64_t _end_position)
+bool storage::map()
+{
+    PROFILER_ZONE("archive", "map");
+
+    last_error_ = archive::error::ok;
+
+    if (is_mapped())
+        return true;
+
+    if (!core::tools::system::is_exist(file_name_))
+    {
+        last_error_ = archive::error::file_not_exist;
+        return false;
+    }
+
+    auto mapped_file = std::make_unique<tools::mapped_file>(file_name_);
+    if (!mapped_file->open())
+    {
+        last_error_ = archive::error::open_file_error;
+        return false;
+    }
+
+    mapped_file_ = std::move(mapped_file);
+    return true;
+}
+
+void storage::unmap()
+{
+    mapped_file_.reset();
+}
+
+bool storage::is_mapped() const
+{
+    return mapped_file_ && mapped_file_->is_open();
+}
+
+bool storage::read_data_block(int64_t _offset, std::string_view& _data)
+{
+    if (!is_mapped())
+    {
+        im_assert(!"file not mapped");
+        return false;
+    }
+
+    const auto read = [this, _offset, &_data]()
+    {
+        return parse_data_block(std::string_view(mapped_file_->data(), mapped_file_->size()), _offset, _data);
+    };
+
+    auto res = read();
+    if (res == block_parse_result::incomplete)
+    {
+        // the file was appended after it had been mapped
+        if (!mapped_file_->remap())
+        {
+            last_error_ = archive::error::open_file_error;
+            return false;
+        }
+
+        res = read();
+    }
+
+    if (res == block_parse_result::incomplete)
+        last_error_ = archive::error::end_of_file;
+
+    return res == block_parse_result::ok;
+}
+
+int64_t storage::find_data_block(int64_t _offset) const
+{
+    if (!is_mapped())
+    {
+        im_assert(!"file not mapped");
+        return -1;
+    }
+
+    const std::string_view file(mapped_file_->data(), mapped_file_->size());
+    for (auto offset = std::max<int64_t>(_offset, 0); offset + 4 * int64_t(sizeof(uint32_t)) <= int64_t(file.size()); ++offset)
+    {
+        std::string_view data;
+        if (parse_data_block(file, offset, data) == block_parse_result::ok)
+            return offset;
+    }
+
+    return -1;
+}
+
+bool storage::fast_read_data_block(core::tools::binary_stream& buffer, int64_t& current_pos, int64_t& _begin, int64_t _end_position, bool _is_file_end)
 {
     bool is_small_file = false;
 
@@ -236,8 +465,16 @@ bool storage::fast_read_data_block(core::tools::binary_stream& buffer, int64_t&
                 else
                     break;
             }
+            else if (_is_file_end)
+            {
+                // a block torn by a crash can claim more data than is left in the file,
+                // the blocks appended after it still have to be found
+                ++current_pos;
+                continue;
+            }
             else
             {
+                // the block goes on in the next chunk, it starts from here
                 is_small_file = true;
                 break;
             }
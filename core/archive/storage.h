@@ -7,6 +7,11 @@
 
 namespace core
 {
+    namespace tools
+    {
+        class mapped_file;
+    }
+
     namespace archive
     {
         union storage_mode
@@ -29,12 +34,39 @@ namespace core
             }
         };
 
+        // data blocks framed back to back in one buffer, so a whole history block
+        // goes to the file with a single write
+        class data_block_batch
+        {
+            core::tools::binary_stream data_;
+            int64_t block_begin_ = -1;
+
+        public:
+            // starts a new block, its payload is written to the returned stream
+            core::tools::binary_stream& begin_block();
+
+            // frames the payload written since begin_block(); returns false and drops the block if it is empty.
+            // _offset is the offset of the block from the beginning of the batch
+            bool end_block(int64_t& _offset, uint32_t& _data_size);
+
+            // adds an already serialized block
+            bool add_block(const core::tools::binary_stream& _data, int64_t& _offset);
+
+            const char* data() const noexcept { return data_.get_data(); }
+            int64_t size() const noexcept { return data_.available(); }
+            bool empty() const noexcept { return size() == 0; }
+
+            void clear() noexcept;
+        };
+
         class storage
         {
             const std::wstring file_name_;
 
             std::unique_ptr<std::fstream> active_file_stream_;
 
+            std::unique_ptr<tools::mapped_file> mapped_file_;
+
             archive::error last_error_;
 
         public:
@@ -54,8 +86,22 @@ namespace core
 
             result_type write_data_block(core::tools::binary_stream& _data, int64_t& _offset);
             result_type write_data_block_at(core::tools::binary_stream& _data, int64_t _offset); // write data block at offset
+            // appends the batch with one write, _offset receives the file offset of the batch;
+            // if the write fails the file is truncated back so no torn block is left at the end
+            result_type write_data_blocks(const data_block_batch& _batch, int64_t& _offset);
             bool read_data_block(int64_t _offset, core::tools::binary_stream& _data);
-            static bool fast_read_data_block(core::tools::binary_stream& buffer, int64_t& current_pos, int64_t& _begin, int64_t _end_position);
+
+            // read-only mapping of the whole file, independent of open()/close()
+            bool map();
+            void unmap();
+            bool is_mapped() const;
+            // _data points into the mapping and stays valid until the next remap or unmap()
+            bool read_data_block(int64_t _offset, std::string_view& _data);
+            // the offset of the first whole block at or after _offset in the mapping, -1 if there is none
+            int64_t find_data_block(int64_t _offset) const;
+            // stops at a block that goes past _end_position leaving current_pos on it,
+            // unless _end_position is the end of the file and the block is a torn one
+            static bool fast_read_data_block(core::tools::binary_stream& buffer, int64_t& current_pos, int64_t& _begin, int64_t _end_position, bool _is_file_end);
 
             archive::error get_last_error() const { return last_error_; }
 
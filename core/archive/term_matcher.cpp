@@ -0,0 +1,316 @@
+#include "stdafx.h"
+#include "term_matcher.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TERM_MATCHER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TERM_MATCHER_TARGET_AVX2
+#else
+#define TERM_MATCHER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace core;
+using namespace archive;
+
+namespace
+{
+    enum class isa
+    {
+        scalar,
+        sse2,
+        avx2
+    };
+
+    isa detect_isa()
+    {
+#ifdef TERM_MATCHER_X86
+#ifdef _MSC_VER
+        int info[4] = {};
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return isa::sse2;
+
+        __cpuid(info, 1);
+        constexpr int osxsave = 1 << 27;
+        constexpr int avx = 1 << 28;
+        if ((info[2] & osxsave) == 0 || (info[2] & avx) == 0 || (_xgetbv(0) & 6) != 6)
+            return isa::sse2;
+
+        __cpuidex(info, 7, 0);
+        constexpr int avx2 = 1 << 5;
+        return (info[1] & avx2) ? isa::avx2 : isa::sse2;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? isa::avx2 : isa::sse2;
+#endif
+#else
+        return isa::scalar;
+#endif
+    }
+
+    isa get_isa()
+    {
+        static const isa value = detect_isa();
+        return value;
+    }
+
+    bool is_equal(const char* _str1, const char* _str2, int _b, int _l)
+    {
+        if (_l == 1)
+            return *_str1 == *(_str2 + _b);
+
+        return std::memcmp(_str1, _str2 + _b, _l) == 0;
+    }
+
+#ifdef TERM_MATCHER_X86
+    uint32_t count_trailing_zeros(uint32_t _mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index = 0;
+        _BitScanForward(&index, _mask);
+        return index;
+#else
+        return __builtin_ctz(_mask);
+#endif
+    }
+#endif
+}
+
+term_matcher::term_matcher(const coded_term& _cterm)
+{
+    const auto& indexes = _cterm.symb_indexes;
+    const std::string_view symbs = _cterm.symbs;
+
+    const auto count = std::min(_cterm.coded_string.size(), indexes.size() / 2);
+    symbols_.reserve(count);
+
+    auto fixed_size = true;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const size_t lower_begin = indexes[2 * i];
+        const size_t upper_begin = indexes[2 * i + 1];
+        const size_t upper_end = (2 * i + 2 < indexes.size()) ? size_t(indexes[2 * i + 2]) : symbs.size();
+
+        symbol s;
+        s.lower_ = symbs.substr(lower_begin, upper_begin - lower_begin);
+        s.upper_ = symbs.substr(upper_begin, upper_end - upper_begin);
+
+        if (s.lower_.empty())
+            s.lower_ = s.upper_;
+        if (s.upper_.empty())
+            s.upper_ = s.lower_;
+
+        if (s.lower_.empty())
+        {
+            symbols_.clear();
+            return;
+        }
+
+        fixed_size &= (s.lower_.size() == s.upper_.size());
+        min_size_ += std::min(s.lower_.size(), s.upper_.size());
+
+        symbols_.push_back(s);
+    }
+
+    if (symbols_.empty())
+        return;
+
+    first_[0] = symbols_.front().lower_.front();
+    first_[1] = symbols_.front().upper_.front();
+    last_[0] = symbols_.back().lower_.back();
+    last_[1] = symbols_.back().upper_.back();
+
+    if (fixed_size)
+        last_offset_ = int32_t(min_size_ - 1);
+}
+
+bool term_matcher::match_at(const char* _str, uint32_t _str_sz, uint32_t _pos) const
+{
+    for (const auto& s : symbols_)
+    {
+        if (_pos >= _str_sz)
+            return false;
+
+        const uint32_t len = tools::utf8_char_size(_str[_pos]);
+        if (len > _str_sz - _pos)
+            return false;
+
+        const std::string_view c(_str + _pos, len);
+        if (c != s.lower_ && c != s.upper_)
+            return false;
+
+        _pos += len;
+    }
+
+    return true;
+}
+
+int32_t term_matcher::find(const char* _str, uint32_t _str_sz) const
+{
+    if (!_str || symbols_.empty() || _str_sz < min_size_)
+        return -1;
+
+    switch (get_isa())
+    {
+    case isa::avx2:
+        return find_avx2(_str, _str_sz);
+    case isa::sse2:
+        return find_sse2(_str, _str_sz);
+    default:
+        return find_scalar(_str, _str_sz, 0);
+    }
+}
+
+int32_t term_matcher::find_scalar(const char* _str, uint32_t _str_sz, uint32_t _from) const
+{
+    const uint32_t end = _str_sz - min_size_ + 1;
+    for (auto i = _from; i < end; ++i)
+    {
+        const auto c = _str[i];
+        if (c != first_[0] && c != first_[1])
+            continue;
+
+        if (last_offset_ >= 0)
+        {
+            const auto l = _str[i + last_offset_];
+            if (l != last_[0] && l != last_[1])
+                continue;
+        }
+
+        if (match_at(_str, _str_sz, i))
+            return int32_t(i);
+    }
+
+    return -1;
+}
+
+#ifdef TERM_MATCHER_X86
+
+int32_t term_matcher::find_sse2(const char* _str, uint32_t _str_sz) const
+{
+    constexpr uint32_t width = 16;
+
+    const auto last_offset = uint32_t(std::max(last_offset_, 0));
+    const auto first_lower = _mm_set1_epi8(first_[0]);
+    const auto first_upper = _mm_set1_epi8(first_[1]);
+    const auto last_lower = _mm_set1_epi8(last_[0]);
+    const auto last_upper = _mm_set1_epi8(last_[1]);
+
+    uint32_t i = 0;
+    for (; i + last_offset + width <= _str_sz; i += width)
+    {
+        const auto first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_str + i));
+        auto eq = _mm_or_si128(_mm_cmpeq_epi8(first, first_lower), _mm_cmpeq_epi8(first, first_upper));
+
+        if (last_offset_ >= 0)
+        {
+            const auto last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_str + i + last_offset));
+            eq = _mm_and_si128(eq, _mm_or_si128(_mm_cmpeq_epi8(last, last_lower), _mm_cmpeq_epi8(last, last_upper)));
+        }
+
+        auto mask = uint32_t(_mm_movemask_epi8(eq));
+        while (mask)
+        {
+            const auto pos = i + count_trailing_zeros(mask);
+            if (match_at(_str, _str_sz, pos))
+                return int32_t(pos);
+
+            mask &= mask - 1;
+        }
+    }
+
+    return find_scalar(_str, _str_sz, i);
+}
+
+TERM_MATCHER_TARGET_AVX2 int32_t term_matcher::find_avx2(const char* _str, uint32_t _str_sz) const
+{
+    constexpr uint32_t width = 32;
+
+    const auto last_offset = uint32_t(std::max(last_offset_, 0));
+    const auto first_lower = _mm256_set1_epi8(first_[0]);
+    const auto first_upper = _mm256_set1_epi8(first_[1]);
+    const auto last_lower = _mm256_set1_epi8(last_[0]);
+    const auto last_upper = _mm256_set1_epi8(last_[1]);
+
+    uint32_t i = 0;
+    for (; i + last_offset + width <= _str_sz; i += width)
+    {
+        const auto first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_str + i));
+        auto eq = _mm256_or_si256(_mm256_cmpeq_epi8(first, first_lower), _mm256_cmpeq_epi8(first, first_upper));
+
+        if (last_offset_ >= 0)
+        {
+            const auto last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_str + i + last_offset));
+            eq = _mm256_and_si256(eq, _mm256_or_si256(_mm256_cmpeq_epi8(last, last_lower), _mm256_cmpeq_epi8(last, last_upper)));
+        }
+
+        auto mask = uint32_t(_mm256_movemask_epi8(eq));
+        while (mask)
+        {
+            const auto pos = i + count_trailing_zeros(mask);
+            if (match_at(_str, _str_sz, pos))
+                return int32_t(pos);
+
+            mask &= mask - 1;
+        }
+    }
+
+    return find_scalar(_str, _str_sz, i);
+}
+
+#else
+
+int32_t term_matcher::find_sse2(const char* _str, uint32_t _str_sz) const
+{
+    return find_scalar(_str, _str_sz, 0);
+}
+
+int32_t term_matcher::find_avx2(const char* _str, uint32_t _str_sz) const
+{
+    return find_scalar(_str, _str_sz, 0);
+}
+
+#endif
+
+std::string_view term_matcher::get_isa_name()
+{
+    switch (get_isa())
+    {
+    case isa::avx2:
+        return "avx2";
+    case isa::sse2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+int32_t core::archive::kmp_strstr(const char* _str, uint32_t _str_sz, const std::vector<int32_t>& _term
+    , const std::vector<int32_t>& _prefix, const std::string& _symbs, const std::vector<int32_t>& _symb_indexes)
+{
+    if (!_str)
+        return -1;
+
+    auto j = 0u;
+
+    for (auto i = 0u; i < _str_sz; )
+    {
+        auto len = tools::utf8_char_size(*(_str + i));
+
+        while (j > 0 && (!is_equal(_symbs.c_str() + _symb_indexes[2 * j], _str, i, len) && !is_equal(_symbs.c_str() + _symb_indexes[2 * j + 1], _str, i, len)))
+            j = _prefix[j - 1];
+
+        if (is_equal(_symbs.c_str() + _symb_indexes[2 * j], _str, i, len) || is_equal(_symbs.c_str() + _symb_indexes[2 * j + 1], _str, i, len))
+            j += 1;
+
+        if (j == _term.size())
+        {
+            return i - j + 1;
+        }
+        i += len;
+    }
+    return -1;
+}
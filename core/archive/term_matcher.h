@@ -0,0 +1,59 @@
+#pragma once
+
+namespace core
+{
+    namespace archive
+    {
+        struct coded_term
+        {
+            std::string lower_term;
+            std::vector<std::pair<std::string, int32_t>> symb_table;
+            std::string symbs;
+            std::vector<int32_t> coded_string;
+            std::vector<int32_t> prefix;
+            std::vector<int32_t> symb_indexes;
+        };
+
+        // case-insensitive search of a coded_term in utf-8 text
+        //
+        // candidate positions are found by the first and the last byte of the term in both cases,
+        // 16 or 32 bytes at a time depending on the cpu, and only they are checked symbol by symbol
+        // against the case variants of the term
+        class term_matcher
+        {
+            struct symbol
+            {
+                std::string_view lower_;
+                std::string_view upper_;
+            };
+
+            std::vector<symbol> symbols_;
+
+            char first_[2] = {};
+            char last_[2] = {};
+
+            // distance from the first to the last byte of any match, -1 if case variants differ in length
+            int32_t last_offset_ = -1;
+            uint32_t min_size_ = 0;
+
+            int32_t find_scalar(const char* _str, uint32_t _str_sz, uint32_t _from) const;
+            int32_t find_sse2(const char* _str, uint32_t _str_sz) const;
+            int32_t find_avx2(const char* _str, uint32_t _str_sz) const;
+
+        public:
+
+            explicit term_matcher(const coded_term& _cterm);
+
+            // byte offset of the first match or -1
+            int32_t find(const char* _str, uint32_t _str_sz) const;
+
+            bool match_at(const char* _str, uint32_t _str_sz, uint32_t _pos) const;
+
+            static std::string_view get_isa_name();
+        };
+
+        // the former one symbol at a time matcher, kept as the reference implementation
+        int32_t kmp_strstr(const char* _str, uint32_t _str_sz, const std::vector<int32_t>& _term
+            , const std::vector<int32_t>& _prefix, const std::string& _symbs, const std::vector<int32_t>& _symb_indexes);
+    }
+}
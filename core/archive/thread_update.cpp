@@ -76,11 +76,11 @@ namespace core::archive
 
     bool thread_update::unserialize(core::tools::binary_stream& _data)
     {
-        core::tools::tlvpack pack;
+        core::tools::tlv_view pack;
         if (!pack.unserialize(_data))
             return false;
 
-        for (auto field = pack.get_first(); field; field = pack.get_next())
+        for (auto field = pack.begin(); field != pack.end(); ++field)
         {
             switch ((data_tlv_fields)field->get_type())
             {
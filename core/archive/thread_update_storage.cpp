@@ -236,7 +236,7 @@ namespace core::archive
 
     bool thread_update_storage::index_record::unserialize(core::tools::binary_stream& _data)
     {
-        core::tools::tlvpack pack;
+        core::tools::tlv_view pack;
         if (!pack.unserialize(_data))
             return false;
 
@@ -18,11 +18,11 @@ async_task::~async_task() = default;
 //////////////////////////////////////////////////////////////////////////
 // async_executer
 //////////////////////////////////////////////////////////////////////////
-async_executer::async_executer(std::string_view _name, size_t _count, bool _task_trace)
+async_executer::async_executer(std::string_view _name, size_t _count, bool _task_trace, tools::threadpool_mode _mode)
     : threadpool(su::concat("ae_", _name), _count, []()
 {
     g_core->on_thread_finish();
-}, _task_trace)
+}, _task_trace, _mode)
 {
 
 }
@@ -49,3 +49,113 @@ std::shared_ptr<async_task_handlers> core::async_executer::run_async_function(st
 
     return handler;
 }
+
+//////////////////////////////////////////////////////////////////////////
+// async_task_graph
+//////////////////////////////////////////////////////////////////////////
+async_task_graph::task_id async_task_graph::add(std::string_view _name, start_function _start, std::vector<task_id> _dependencies, bool _required)
+{
+    im_assert(!on_finished_);
+    im_assert(std::all_of(_dependencies.begin(), _dependencies.end(), [this](auto _id) { return _id < stages_.size(); }));
+
+    stage s;
+    s.name_ = _name;
+    s.dependencies_ = std::move(_dependencies);
+    s.required_ = _required;
+
+    stages_.push_back(std::move(s));
+    start_functions_.push_back(std::move(_start));
+
+    return stages_.size() - 1;
+}
+
+void async_task_graph::run(std::function<void(bool)> _on_finished)
+{
+    im_assert(!on_finished_);
+
+    on_finished_ = std::move(_on_finished);
+    start_time_ = clock::now();
+
+    start_ready_tasks();
+}
+
+void async_task_graph::start_ready_tasks()
+{
+    // a task may report its result right from its start function
+    if (starting_)
+        return;
+
+    starting_ = true;
+
+    for (bool started = true; started;)
+    {
+        started = false;
+
+        for (task_id id = 0; id < stages_.size(); ++id)
+        {
+            auto& s = stages_[id];
+            if (s.started_ || failed_)
+                continue;
+
+            const auto ready = std::all_of(s.dependencies_.begin(), s.dependencies_.end(), [this](auto _id) { return stages_[_id].finished_; });
+            if (!ready)
+                continue;
+
+            s.started_ = true;
+            s.start_time_ = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start_time_);
+            ++running_;
+            started = true;
+
+            auto start = std::move(start_functions_[id]);
+            start()->on_result_ = [ptr_this = shared_from_this(), id](int32_t _error)
+            {
+                ptr_this->on_task_finished(id, _error);
+            };
+        }
+    }
+
+    starting_ = false;
+
+    if (running_ == 0 && !finished_)
+    {
+        finished_ = true;
+        duration_ = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start_time_);
+
+        if (on_finished_)
+            on_finished_(!failed_);
+    }
+}
+
+void async_task_graph::on_task_finished(task_id _id, int32_t _error)
+{
+    auto& s = stages_[_id];
+    im_assert(s.started_ && !s.finished_);
+
+    s.finished_ = true;
+    s.error_ = _error;
+    s.duration_ = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start_time_) - s.start_time_;
+
+    if (_error != 0 && s.required_)
+        failed_ = true;
+
+    --running_;
+
+    start_ready_tasks();
+}
+
+std::string async_task_graph::get_timings_for_log() const
+{
+    std::stringstream info;
+    info << "total: " << duration_.count() << " ms\r\n";
+
+    for (const auto& s : stages_)
+    {
+        info << s.name_ << ": ";
+        if (s.finished_)
+            info << "started at " << s.start_time_.count() << " ms, took " << s.duration_.count() << " ms, error " << s.error_ << "\r\n";
+        else
+            info << "skipped\r\n";
+    }
+
+    return info.str();
+}
@@ -59,7 +59,7 @@ namespace core
     class async_executer : core::tools::threadpool
     {
     public:
-        explicit async_executer(std::string_view _name, size_t _count = 1, bool _task_trace = false);
+        explicit async_executer(std::string_view _name, size_t _count = 1, bool _task_trace = false, tools::threadpool_mode _mode = tools::threadpool_mode::shared_queue);
         virtual ~async_executer();
 
         virtual std::shared_ptr<async_task_handlers> run_async_task(std::shared_ptr<async_task> task, std::string_view _task_name = {}, std::function<bool()> _cancel = {});
@@ -86,6 +86,60 @@ namespace core
 
     using async_executer_uptr = std::unique_ptr<async_executer>;
 
+    // starts asynchronous tasks in the order of their dependencies: a task is started once all the tasks
+    // it depends on have reported their results, tasks without pending dependencies run at the same time.
+    // a failed required task stops the graph, tasks not started yet are skipped.
+    // results are expected on one thread (the core thread for async_executer tasks)
+    class async_task_graph : public std::enable_shared_from_this<async_task_graph>
+    {
+    public:
+        using task_id = size_t;
+        using start_function = std::function<std::shared_ptr<async_task_handlers>()>;
+        using clock = std::chrono::steady_clock;
+
+        struct stage
+        {
+            std::string name_;
+            std::vector<task_id> dependencies_;
+            bool required_ = false;
+
+            bool started_ = false;
+            bool finished_ = false;
+            int32_t error_ = 0;
+
+            // from the start of the graph
+            std::chrono::milliseconds start_time_ = {};
+            std::chrono::milliseconds duration_ = {};
+        };
+
+        task_id add(std::string_view _name, start_function _start, std::vector<task_id> _dependencies = {}, bool _required = false);
+
+        // _on_finished is called with false if a required task failed
+        void run(std::function<void(bool)> _on_finished);
+
+        const std::vector<stage>& get_stages() const noexcept { return stages_; }
+        std::chrono::milliseconds get_duration() const noexcept { return duration_; }
+
+        std::string get_timings_for_log() const;
+
+    private:
+        void start_ready_tasks();
+        void on_task_finished(task_id _id, int32_t _error);
+
+        std::vector<stage> stages_;
+        std::vector<start_function> start_functions_;
+
+        std::function<void(bool)> on_finished_;
+
+        clock::time_point start_time_;
+        std::chrono::milliseconds duration_ = {};
+
+        size_t running_ = 0;
+        bool starting_ = false;
+        bool failed_ = false;
+        bool finished_ = false;
+    };
+
 }
 
 
@@ -37,6 +37,7 @@ namespace
 
     constexpr auto default_http_connect_timeout = std::chrono::seconds(5);
     constexpr auto default_http_execute_timeout = std::chrono::seconds(8);
+    constexpr int64_t default_archives_memory_budget = 64 << 20;
 }
 
 app_config::app_config()
@@ -145,6 +146,9 @@ pt::ptree app_config::as_ptree() const
         case app_config::AppConfigOption::curl_connection_timeout:
             result.add(option_name(key), get_curl_connection_timeout().count());
             break;
+        case app_config::AppConfigOption::archives_memory_budget_mb:
+            result.add(option_name(key), int(archives_memory_budget() >> 20));
+            break;
         default:
             im_assert(!"unhandled option for as_ptree");
             continue;
@@ -457,6 +461,13 @@ std::chrono::seconds app_config::get_curl_connection_timeout() const
         : std::chrono::seconds(boost::any_cast<int>(it->second));
 }
 
+int64_t app_config::archives_memory_budget() const
+{
+    auto it = app_config_options_.find(app_config::AppConfigOption::archives_memory_budget_mb);
+    return it == app_config_options_.end() ? default_archives_memory_budget
+        : int64_t(boost::any_cast<int>(it->second)) << 20;
+}
+
 uint32_t app_config::update_interval() const
 {
     auto it = app_config_options_.find(app_config::AppConfigOption::update_interval);
@@ -500,6 +511,7 @@ void app_config::serialize(Out core::coll_helper& _collection) const
     _collection.set<bool>(option_name(app_config::AppConfigOption::ssl_verification_enabled), is_ssl_verification_enabled());
     _collection.set<int>(option_name(app_config::AppConfigOption::curl_timeout), get_curl_timeout().count());
     _collection.set<int>(option_name(app_config::AppConfigOption::curl_connection_timeout), get_curl_timeout().count());
+    _collection.set<int>(option_name(app_config::AppConfigOption::archives_memory_budget_mb), int(archives_memory_budget() >> 20));
 
     // urls
     _collection.set<std::string_view>("urls.url_update_mac_alpha", get_update_mac_alpha_url());
@@ -715,6 +727,11 @@ namespace
                 app_config::AppConfigOption::curl_connection_timeout,
                 property_tree_.get<int>(option_name(app_config::AppConfigOption::curl_connection_timeout), default_http_connect_timeout.count())
             }
+            ,
+            {
+                app_config::AppConfigOption::archives_memory_budget_mb,
+                property_tree_.get<int>(option_name(app_config::AppConfigOption::archives_memory_budget_mb), int(default_archives_memory_budget >> 20))
+            }
         };
     }
 
@@ -778,6 +795,8 @@ namespace
             return "dev.curl_timeout";
         case app_config::AppConfigOption::curl_connection_timeout:
             return "dev.curl_connection_timeout";
+        case app_config::AppConfigOption::archives_memory_budget_mb:
+            return "dev.archives_memory_budget_mb";
         default:
             im_assert(!"unhandled option for option_name");
             return "";
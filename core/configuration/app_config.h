@@ -44,7 +44,8 @@ public:
         cache_history_pages_check_interval_secs = 24,
         ssl_verification_enabled = 25,
         curl_timeout = 26,
-        curl_connection_timeout = 27
+        curl_connection_timeout = 27,
+        archives_memory_budget_mb = 28
     };
 
     enum class gdpr_report_to_server_state
@@ -101,6 +102,9 @@ public:
     std::chrono::seconds get_curl_timeout() const;
     std::chrono::seconds get_curl_connection_timeout() const;
 
+    // bytes the loaded chat archives may take in the core, 0 keeps all of them
+    int64_t archives_memory_budget() const;
+
     void serialize(Out core::coll_helper& _collection) const;
 
     template <typename ValueType>
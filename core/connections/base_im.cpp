@@ -143,6 +143,11 @@ std::wstring core::base_im::get_contactlist_file_name() const
     return su::wconcat(get_im_data_path(), L"/contacts/cache.cl");
 }
 
+std::wstring core::base_im::get_contactlist_journal_file_name() const
+{
+    return su::wconcat(get_im_data_path(), L"/contacts/journal.cl");
+}
+
 std::wstring core::base_im::get_my_info_file_name() const
 {
     return su::wconcat(get_im_data_path(), L"/info/cache");
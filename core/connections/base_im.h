@@ -140,6 +140,7 @@ namespace core
         std::shared_ptr<core::memory_stats::memory_stats_collector> memory_stats_collector_;
 
         std::wstring get_contactlist_file_name() const;
+        std::wstring get_contactlist_journal_file_name() const;
         std::wstring get_my_info_file_name() const;
         std::wstring get_active_dialogs_file_name() const;
         std::wstring get_pinned_chats_file_name() const;
@@ -511,6 +512,7 @@ namespace core
         virtual void report_memory_usage(const int64_t _seq,
                                          memory_stats::request_id _req_handle,
                                          const memory_stats::partial_response& _partial_response) = 0;
+        virtual void report_archives_memory_usage(memory_stats::request_id _req_id) = 0;
         virtual void get_ram_usage(const int64_t _seq) = 0;
 
         virtual void make_archive_holes(const int64_t _seq, const std::string& _archive) = 0;
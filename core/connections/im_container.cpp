@@ -74,265 +74,14 @@ im_container::im_container(const std::shared_ptr<voip_manager::VoipManager>& voi
     , voip_manager_(voip_manager),
       memory_stats_collector_(memory_stats_collector)
 {
-    REGISTER_IM_MESSAGE("login_by_password", on_login_by_password);
-    REGISTER_IM_MESSAGE("login_get_sms_code", on_login_get_sms_code);
-    REGISTER_IM_MESSAGE("login_by_phone", on_login_by_phone);
-    REGISTER_IM_MESSAGE("login_by_oauth2", on_login_by_oauth2);
-    REGISTER_IM_MESSAGE("logout", on_logout);
-    REGISTER_IM_MESSAGE("connect_after_migration", on_connect_after_migration);
-    REGISTER_IM_MESSAGE("avatars/get", on_get_contact_avatar);
-    REGISTER_IM_MESSAGE("avatars/show", on_show_contact_avatar);
-    REGISTER_IM_MESSAGE("avatars/remove", on_remove_contact_avatars);
-    REGISTER_IM_MESSAGE("send_message", on_send_message);
-    REGISTER_IM_MESSAGE("update_message", on_update_message);
-    REGISTER_IM_MESSAGE("message/typing", on_message_typing);
-    //REGISTER_IM_MESSAGE("set_state", on_set_state);
-    REGISTER_IM_MESSAGE("archive/buddies/get", on_get_archive_messages_buddies);
-    REGISTER_IM_MESSAGE("archive/messages/get", on_get_archive_messages);
-    REGISTER_IM_MESSAGE("archive/messages/delete", on_delete_archive_messages);
-    REGISTER_IM_MESSAGE("archive/messages/delete_from", on_delete_archive_messages_from);
-    REGISTER_IM_MESSAGE("archive/messages/delete_all", on_delete_archive_all_messages);
-    REGISTER_IM_MESSAGE("archive/mentions/get", on_get_archive_mentions);
-    REGISTER_IM_MESSAGE("archive/log/model", on_archive_log_model);
-    REGISTER_IM_MESSAGE("messages/context/get", on_get_message_context);
-    REGISTER_IM_MESSAGE("archive/make/holes", on_make_archive_holes);
-    REGISTER_IM_MESSAGE("archive/invalidate/history", on_invalidate_history);
-    REGISTER_IM_MESSAGE("archive/invalidate/message_data", on_invalidate_archive_data);
-
-    REGISTER_IM_MESSAGE("dialogs/search/local", on_dialogs_search_local);
-    REGISTER_IM_MESSAGE("dialogs/search/local/end", on_dialogs_search_local_ended);
-    REGISTER_IM_MESSAGE("dialogs/search/server", on_dialogs_search_server);
-    REGISTER_IM_MESSAGE("dialogs/search/add_pattern", on_dialogs_search_add_pattern);
-    REGISTER_IM_MESSAGE("dialogs/search/remove_pattern", on_dialogs_search_remove_pattern);
-
-    REGISTER_IM_MESSAGE("thread/feed/search/local", on_thread_feed_search_local);
-    REGISTER_IM_MESSAGE("threads/search/local", on_threads_search_local);
-    REGISTER_IM_MESSAGE("threads/search/local/end", on_threads_search_local_ended);
-    REGISTER_IM_MESSAGE("threads/search/server", on_threads_search_server);
-
-    REGISTER_IM_MESSAGE("dialogs/add", on_add_opened_dialog);
-    REGISTER_IM_MESSAGE("dialogs/remove", on_remove_opened_dialog);
-    REGISTER_IM_MESSAGE("dialogs/hide", on_hide_chat);
-    REGISTER_IM_MESSAGE("dialogs/mute", on_mute_chat);
-    REGISTER_IM_MESSAGE("dialogs/set_attention_attribute", on_set_attention_attribute);
-    REGISTER_IM_MESSAGE("dlg_state/set_last_read", on_set_last_read);
-    REGISTER_IM_MESSAGE("dlg_state/set_last_read_mention", on_set_last_read_mention);
-    REGISTER_IM_MESSAGE("dlg_state/set_last_read_partial", on_set_last_read_partial);
-    REGISTER_IM_MESSAGE("dlg_state/close_stranger", on_close_stranger);
-    REGISTER_IM_MESSAGE("files/upload", on_upload_file_sharing);
-    REGISTER_IM_MESSAGE("files/upload/abort", on_abort_file_sharing_uploading);
-    REGISTER_IM_MESSAGE("files/preview_size", on_get_file_sharing_preview_size);
-    REGISTER_IM_MESSAGE("files/download/metainfo", on_download_file_sharing_metainfo);
-    REGISTER_IM_MESSAGE("files/download", on_download_file);
-    REGISTER_IM_MESSAGE("files/download/abort", on_abort_file_downloading);
-    REGISTER_IM_MESSAGE("image/download", on_download_image);
-    REGISTER_IM_MESSAGE("loader/download/cancel", on_cancel_loader_task);
-    REGISTER_IM_MESSAGE("external_file_path/get", on_get_external_file_path);
-    REGISTER_IM_MESSAGE("link_metainfo/download", on_download_link_preview);
-    REGISTER_IM_MESSAGE("download/raise_priority", on_download_raise_priority);
-
-    REGISTER_IM_MESSAGE("stickers/meta/get", on_get_stickers_meta);
-    REGISTER_IM_MESSAGE("stickers/sticker/get", on_get_sticker);
-    REGISTER_IM_MESSAGE("stickers/sticker/get/cancel", on_get_sticker_cancel);
-    REGISTER_IM_MESSAGE("stickers/fs_by_ids/get", on_get_fs_stickers_by_ids);
-    REGISTER_IM_MESSAGE("stickers/pack/info", on_get_stickers_pack_info);
-    REGISTER_IM_MESSAGE("stickers/pack/add", on_add_stickers_pack);
-    REGISTER_IM_MESSAGE("stickers/pack/remove", on_remove_stickers_pack);
-    REGISTER_IM_MESSAGE("stickers/store/get", on_get_stickers_store);
-    REGISTER_IM_MESSAGE("stickers/store/search", on_search_stickers_store);
-    REGISTER_IM_MESSAGE("stickers/big_set_icon/get", on_get_set_icon_big);
-    REGISTER_IM_MESSAGE("stickers/big_set_icon/clean", on_clean_set_icon_big);
-    REGISTER_IM_MESSAGE("stickers/set/order", on_set_sticker_order);
-    REGISTER_IM_MESSAGE("stickers/suggests/get", on_get_sticker_suggests);
-    REGISTER_IM_MESSAGE("smartreply/suggests/clearall", on_clear_smartreply_suggests);
-    REGISTER_IM_MESSAGE("smartreply/suggests/clear", on_clear_smartreply_suggests);
-    REGISTER_IM_MESSAGE("smartreply/suggests/load", on_load_smartreply_suggests);
-    REGISTER_IM_MESSAGE("smartreply/get", on_get_smartreplies);
-
-    REGISTER_IM_MESSAGE("chats/info/get", on_get_chat_info);
-    REGISTER_IM_MESSAGE("chats/home/get", on_get_chat_home);
-    REGISTER_IM_MESSAGE("chats/pending/resolve", on_resolve_pending);
-    REGISTER_IM_MESSAGE("chats/member/info", on_get_chat_member_info);
-    REGISTER_IM_MESSAGE("chats/members/get", on_get_chat_members);
-    REGISTER_IM_MESSAGE("chats/members/search", on_search_chat_members);
-    REGISTER_IM_MESSAGE("chats/contacts/get", on_get_chat_contacts);
-    REGISTER_IM_MESSAGE("contacts/search/server", on_search_contacts_server);
-    REGISTER_IM_MESSAGE("contacts/search/local", on_search_contacts_local);
-    REGISTER_IM_MESSAGE("contacts/add", on_add_contact);
-    REGISTER_IM_MESSAGE("contacts/remove", on_remove_contact);
-    REGISTER_IM_MESSAGE("contacts/rename", on_rename_contact);
-    REGISTER_IM_MESSAGE("contacts/ignore", on_ignore_contact);
-    REGISTER_IM_MESSAGE("contacts/get_ignore", on_get_ignore_contacts);
-    REGISTER_IM_MESSAGE("contact/switched", on_contact_switched);
-    REGISTER_IM_MESSAGE("dlg_states/hide", on_hide_dlg_state);
-    REGISTER_IM_MESSAGE("add_members", on_add_members);
-    REGISTER_IM_MESSAGE("remove_members", on_remove_members);
-    REGISTER_IM_MESSAGE("stats", on_stats);
-    REGISTER_IM_MESSAGE("im_stats", on_im_stats);
-    REGISTER_IM_MESSAGE("addressbook/sync", on_syncronize_addressbook);
-
-    REGISTER_IM_MESSAGE("themes/meta/check", on_check_theme_meta_updates);
-    REGISTER_IM_MESSAGE("themes/wallpaper/get", on_get_theme_wallpaper);
-    REGISTER_IM_MESSAGE("themes/wallpaper/preview/get", on_get_theme_wallpaper_preview);
-    REGISTER_IM_MESSAGE("themes/wallpaper/user/set", on_set_user_wallpaper);
-    REGISTER_IM_MESSAGE("themes/wallpaper/user/remove", on_set_user_wallpaper);
-
-    REGISTER_IM_MESSAGE("files/speech_to_text", on_speech_to_text);
-    REGISTER_IM_MESSAGE("pin_chat", on_pin_chat);
-    REGISTER_IM_MESSAGE("unfavorite", on_unfavorite);
-    REGISTER_IM_MESSAGE("update_profile", on_update_profile);
-    REGISTER_IM_MESSAGE("mark_unimportant", on_mark_unimportant);
-    REGISTER_IM_MESSAGE("remove_from_unimportant", on_remove_from_unimportant);
-    REGISTER_IM_MESSAGE("set_user_proxy_settings", on_set_user_proxy);
-    REGISTER_IM_MESSAGE("livechat/join", on_join_livechat);
-    REGISTER_IM_MESSAGE("livechat/join/cancel", on_cancel_join_livechat);
-    REGISTER_IM_MESSAGE("livechat/invite/cancel", on_cancel_chat_invitation);
-    REGISTER_IM_MESSAGE("set_locale", on_set_locale);
-    REGISTER_IM_MESSAGE("set_avatar", on_set_avatar);
-
-    REGISTER_IM_MESSAGE("chats/create", on_create_chat);
-
-    REGISTER_IM_MESSAGE("chats/mod/params", on_mod_chat_params);
-    REGISTER_IM_MESSAGE("chats/mod/name", on_mod_chat_name);
-    REGISTER_IM_MESSAGE("chats/mod/about", on_mod_chat_about);
-    REGISTER_IM_MESSAGE("chats/mod/rules", on_mod_chat_rules);
-
-    REGISTER_IM_MESSAGE("chats/block", on_block_chat_member);
-    REGISTER_IM_MESSAGE("chats/role/set", on_set_chat_member_role);
-    REGISTER_IM_MESSAGE("chats/message/pin", on_chat_pin_message);
-    REGISTER_IM_MESSAGE("phoneinfo", on_phoneinfo);
-    REGISTER_IM_MESSAGE("mrim/get_key", on_mrim_get_key);
-
-    REGISTER_IM_MESSAGE("mentions/suggests/get", on_get_mentions_suggests);
-    REGISTER_IM_MESSAGE("get_code_by_phone_call", on_get_code_by_phone_call);
-
-    REGISTER_IM_MESSAGE("get_logs_path", on_get_logs_path);
-    REGISTER_IM_MESSAGE("change_app_config", on_change_app_config);
-    REGISTER_IM_MESSAGE("remove_content_cache", on_remove_content_cache);
-    REGISTER_IM_MESSAGE("clear_avatars", on_clear_avatars);
-    REGISTER_IM_MESSAGE("remove_ominron_stg", on_remove_omicron_stg);
-
-    REGISTER_IM_MESSAGE("report/contact", on_report_contact);
-    REGISTER_IM_MESSAGE("report/stickerpack", on_report_stickerpack);
-    REGISTER_IM_MESSAGE("report/sticker", on_report_sticker);
-    REGISTER_IM_MESSAGE("report/message", on_report_message);
-
-    REGISTER_IM_MESSAGE("agreement/gdpr", on_user_accept_gdpr);
+    messages_.reserve(im_messages.size());
 
-#ifndef STRIP_VOIP
-    REGISTER_IM_MESSAGE("voip_call", on_voip_call_message);
-    REGISTER_IM_MESSAGE("get_voip_calls_quality_popup_conf", on_get_voip_calls_quality_popup_conf);
-    REGISTER_IM_MESSAGE("send_voip_calls_quality_report", on_send_voip_calls_quality_report);
-#endif
-
-    REGISTER_IM_MESSAGE("get_dialog_gallery", on_get_dialog_gallery);
-    REGISTER_IM_MESSAGE("get_dialog_gallery_by_msg", on_get_dialog_gallery_by_msg);
-    REGISTER_IM_MESSAGE("request_gallery_state", on_request_gallery_state);
-    REGISTER_IM_MESSAGE("get_gallery_index", on_get_gallery_index);
-    REGISTER_IM_MESSAGE("make_gallery_hole", on_make_gallery_hole);
-    REGISTER_IM_MESSAGE("stop_gallery_holes_downloading", on_stop_gallery_holes_downloading);
-
-    REGISTER_IM_MESSAGE("request_memory_usage", on_request_memory_usage);
-    REGISTER_IM_MESSAGE("report_memory_usage", on_report_memory_usage);
-    REGISTER_IM_MESSAGE("get_ram_usage", on_get_ram_usage);
-    REGISTER_IM_MESSAGE("_ui_activity", on_ui_activity);
-
-    REGISTER_IM_MESSAGE("localpin/set", on_local_pin_set);
-    REGISTER_IM_MESSAGE("localpin/entered", on_local_pin_entered);
-    REGISTER_IM_MESSAGE("localpin/disable", on_local_pin_disable);
-
-    REGISTER_IM_MESSAGE("idinfo/get", on_get_id_info);
-
-    REGISTER_IM_MESSAGE("update/check", on_update_check);
-
-    REGISTER_IM_MESSAGE("get_id_info", on_get_id_info);
-    REGISTER_IM_MESSAGE("get_user_info", on_get_user_info);
-    REGISTER_IM_MESSAGE("get_user_last_seen", on_get_user_last_seen);
-
-    REGISTER_IM_MESSAGE("privacy_settings/set", on_set_privacy_settings);
-    REGISTER_IM_MESSAGE("privacy_settings/get", on_get_privacy_settings);
-
-    REGISTER_IM_MESSAGE("nickname/check", on_nickname_check);
-    REGISTER_IM_MESSAGE("group_nickname/check", on_group_nickname_check);
-    REGISTER_IM_MESSAGE("common_chats/get", on_get_common_chats);
-
-    REGISTER_IM_MESSAGE("connection/reset", on_reset_connection);
-
-    REGISTER_IM_MESSAGE("recent_avatars_size/update", on_update_recent_avatars_size);
-    REGISTER_IM_MESSAGE("set_install_beta_updates", on_set_install_beta_updates);
-
-    REGISTER_IM_MESSAGE("poll/get", on_get_poll);
-    REGISTER_IM_MESSAGE("poll/vote", on_vote_in_poll);
-    REGISTER_IM_MESSAGE("poll/revoke", on_revoke_vote);
-    REGISTER_IM_MESSAGE("poll/stop", on_stop_poll);
-
-    REGISTER_IM_MESSAGE("task/create", on_create_task);
-    REGISTER_IM_MESSAGE("task/edit", on_edit_task);
-    REGISTER_IM_MESSAGE("task/request_initial", on_request_initial_tasks);
-    REGISTER_IM_MESSAGE("task/update_last_used", on_task_update_last_used);
-
-    REGISTER_IM_MESSAGE("group/subscribe", on_group_subscribe);
-    REGISTER_IM_MESSAGE("group/cancel_subscription", on_group_cancel_subscription);
-
-    REGISTER_IM_MESSAGE("group/invitebl/add", on_group_inviteblacklist_add);
-    REGISTER_IM_MESSAGE("group/invitebl/remove", on_group_inviteblacklist_remove);
-    REGISTER_IM_MESSAGE("group/invitebl/search", on_group_inviteblacklist_search);
-    REGISTER_IM_MESSAGE("group/invitebl/cl", group_blacklisted_cl_inviters);
-
-    REGISTER_IM_MESSAGE("suggest_group_nick", on_suggest_group_nick);
-
-    REGISTER_IM_MESSAGE("get_bot_callback_answer", on_get_bot_callback_answer);
-    REGISTER_IM_MESSAGE("bot/start", on_start_bot);
-
-    REGISTER_IM_MESSAGE("conference/create", on_create_confrence);
-
-    REGISTER_IM_MESSAGE("sessions/get", on_get_sessions);
-    REGISTER_IM_MESSAGE("sessions/reset", on_reset_session);
-    REGISTER_IM_MESSAGE("sessions/resetall", on_reset_session);
-
-    REGISTER_IM_MESSAGE("reaction/get", on_get_reactions);
-    REGISTER_IM_MESSAGE("reaction/add", on_add_reaction);
-    REGISTER_IM_MESSAGE("reaction/remove", on_remove_reaction);
-    REGISTER_IM_MESSAGE("reaction/list", on_list_reactions);
-
-    REGISTER_IM_MESSAGE("status/set", on_status_set);
-
-    REGISTER_IM_MESSAGE("subscribe/status", on_subscribe_status);
-    REGISTER_IM_MESSAGE("unsubscribe/status", on_unsubscribe_status);
-    REGISTER_IM_MESSAGE("subscribe/call_room_info", on_subscribe_call_room_info);
-    REGISTER_IM_MESSAGE("unsubscribe/call_room_info", on_unsubscribe_call_room_info);
-    REGISTER_IM_MESSAGE("subscribe/thread", on_subscribe_thread_events);
-    REGISTER_IM_MESSAGE("unsubscribe/thread", on_unsubscribe_thread_events);
-    REGISTER_IM_MESSAGE("subscribe/task", on_subscribe_task);
-    REGISTER_IM_MESSAGE("unsubscribe/task", on_unsubscribe_task);
-    REGISTER_IM_MESSAGE("subscribe/filesharing_antivirus", on_subscribe_filesharing_antivirus);
-    REGISTER_IM_MESSAGE("unsubscribe/filesharing_antivirus", on_unsubscribe_filesharing_antivirus);
-    REGISTER_IM_MESSAGE("subscribe/mails_counter", on_subscribe_mails_counter);
-    REGISTER_IM_MESSAGE("unsubscribe/mails_counter", on_unsubscribe_mails_counter);
-    REGISTER_IM_MESSAGE("subscribe/tasks_counter", on_subscribe_tasks_counter);
-    REGISTER_IM_MESSAGE("unsubscribe/tasks_counter", on_unsubscribe_tasks_counter);
-
-    REGISTER_IM_MESSAGE("emoji/get", on_get_emoji);
-
-    REGISTER_IM_MESSAGE("send_notify_sms", on_send_notify_sms);
-
-    REGISTER_IM_MESSAGE("threads/add", on_add_thread);
-    REGISTER_IM_MESSAGE("threads/get", on_get_thread);
-    REGISTER_IM_MESSAGE("threads/feed/get", on_threads_feed_get);
-    REGISTER_IM_MESSAGE("threads/subscribe", on_subscribe_thread);
-    REGISTER_IM_MESSAGE("threads/unsubscribe", on_unsubscribe_thread);
-    REGISTER_IM_MESSAGE("threads/subscribers/get", on_threads_subscribers_get);
-    REGISTER_IM_MESSAGE("threads/subscribers/search", on_threads_subscribers_search);
-    REGISTER_IM_MESSAGE("thread/autosubscribe", on_thread_autosubscribe);
-
-    REGISTER_IM_MESSAGE("chats/thread/add", on_chats_thread_add);
-    REGISTER_IM_MESSAGE("chats/thread/remove", on_chats_thread_remove);
-
-
-    REGISTER_IM_MESSAGE("draft/set", on_draft_set);
-    REGISTER_IM_MESSAGE("draft/get", on_draft_get);
+#define IM_MESSAGE(_message_string, _callback) \
+    messages_.push_back(std::bind(&im_container::_callback, this, std::placeholders::_1, std::placeholders::_2));
+#include "im_container_messages.inc"
+#undef IM_MESSAGE
 
-    REGISTER_IM_MESSAGE("miniapp/start_session", on_miniapp_start_session);
+    im_assert(messages_.size() == im_messages.size());
 }
 
 
@@ -403,12 +152,12 @@ void core::im_container::download_file(priority_t _priority, const std::string&
     im->download_file(_priority, _file_url, _destination, _normalized_url, _is_binary_data, std::move(_on_result));
 }
 
-void core::im_container::on_message_from_gui(std::string_view _message, int64_t _seq, coll_helper& _params)
+void core::im_container::on_message_from_gui(size_t _message_id, int64_t _seq, coll_helper& _params)
 {
-    if (const auto iter_handler = messages_map_.find(_message); iter_handler != messages_map_.end())
+    if (_message_id < messages_.size())
     {
-        if (iter_handler->second)
-            iter_handler->second(_seq, _params);
+        if (const auto& handler = messages_[_message_id])
+            handler(_seq, _params);
     }
     else
     {
@@ -2,6 +2,8 @@
 
 #include <memory>
 
+#include "../../common.shared/message_table.h"
+
 namespace voip_manager {
     struct VoipProxySettings;
     class VoipManager;
@@ -24,14 +26,21 @@ namespace core
 
     using message_function = std::function<void(int64_t, coll_helper&)>;
 
-    #define REGISTER_IM_MESSAGE(_message_string, _callback)                                             \
-        messages_map_.emplace(                                                                          \
-            _message_string,                                                                            \
-            std::bind(&im_container::_callback, this, std::placeholders::_1, std::placeholders::_2));
+    inline constexpr std::string_view im_message_names[] =
+    {
+#define IM_MESSAGE(_message_string, _callback) _message_string,
+#include "im_container_messages.inc"
+#undef IM_MESSAGE
+    };
+
+    // ids of the messages im_container handles, resolved once where a message from gui enters core
+    inline constexpr common::message_table im_messages(im_message_names);
+    static_assert(im_messages.is_collision_free(), "im_container message names must be unique");
 
     class im_container : public std::enable_shared_from_this<im_container>
     {
-        std::unordered_map<std::string_view, message_function> messages_map_;
+        // handlers indexed by the message id in im_messages
+        std::vector<message_function> messages_;
 
         std::unique_ptr<im_login_list> logins_;
         ims_list ims_;
@@ -336,7 +345,7 @@ namespace core
 
     public:
 
-        void on_message_from_gui(std::string_view _message, int64_t _seq, coll_helper& _params);
+        void on_message_from_gui(size_t _message_id, int64_t _seq, coll_helper& _params);
         std::shared_ptr<base_im> get_im_by_id(int32_t _id) const;
         bool update_login(im_login_id& _login);
         void replace_uin_in_login(im_login_id& old_login, im_login_id& new_login);
@@ -111,7 +111,7 @@ namespace
 core::wim::async_loader::async_loader(std::wstring _content_cache_dir)
     : content_cache_dir_(std::move(_content_cache_dir))
     , cancelled_tasks_(std::make_shared<cancelled_tasks>())
-    , async_tasks_(std::make_shared<async_executer>("al async tasks", 3))
+    , async_tasks_(std::make_shared<async_executer>("al async tasks", 3, false, tools::threadpool_mode::work_stealing))
     , file_save_thread_(std::make_shared<async_executer>("al file save", 1))
 {
 }
@@ -0,0 +1,45 @@
+#include "stdafx.h"
+#include "archives_memory_consumption_reporter.h"
+#include "../../base_im.h"
+#include "../../../archive/local_history.h"
+#include "core.h"
+
+CORE_NS_BEGIN
+
+namespace
+{
+    const memory_stats::name_string_t Name = "cached_archives";
+}
+
+archives_memory_consumption_reporter::archives_memory_consumption_reporter()
+{
+
+}
+
+archives_memory_consumption_reporter::~archives_memory_consumption_reporter()
+{
+
+}
+
+void archives_memory_consumption_reporter::request_report(const memory_stats::request_handle& _req_handle)
+{
+    if (auto im = g_core->find_im_by_id(0))
+        im->report_archives_memory_usage(_req_handle.id_);
+}
+
+memory_stats::memory_stats_report archives_memory_consumption_reporter::make_report(int64_t _index_size, int64_t _gallery_size, const archive::archives_cache_stats& _cache_stats)
+{
+    memory_stats::memory_stats_report report(Name, _index_size + _gallery_size, memory_stats::stat_type::cached_archives);
+    report.addSubcategory("index", _index_size);
+    report.addSubcategory("gallery", _gallery_size);
+
+    // the counters go as subcategories too, the budget is in bytes, the rest are archive counts
+    report.addSubcategory("budget", _cache_stats.memory_budget_);
+    report.addSubcategory("loaded_count", _cache_stats.loaded_count_);
+    report.addSubcategory("evicted_count", _cache_stats.evicted_count_);
+    report.addSubcategory("reloaded_count", _cache_stats.reloaded_count_);
+
+    return report;
+}
+
+CORE_NS_END
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "stats/memory/memory_consumption_reporter.h"
+#include "namespaces.h"
+
+CORE_NS_BEGIN
+
+namespace archive
+{
+    struct archives_cache_stats;
+}
+
+// the loaded contact archives, their budget and how often the budget dropped them.
+// the archives live on the archive thread, so the report is made by the active im
+class archives_memory_consumption_reporter: public memory_stats::memory_consumption_async_reporter
+{
+public:
+    archives_memory_consumption_reporter();
+    virtual ~archives_memory_consumption_reporter();
+
+    virtual void request_report(const memory_stats::request_handle& _req_handle) override;
+
+    static memory_stats::memory_stats_report make_report(int64_t _index_size, int64_t _gallery_size, const archive::archives_cache_stats& _cache_stats);
+};
+
+CORE_NS_END
@@ -118,6 +118,12 @@ void my_info_cache::set_info(const std::shared_ptr<my_info>& _info)
     changed_ = true;
 }
 
+void my_info_cache::assign_loaded(const my_info_cache& _loaded)
+{
+    *info_ = *_loaded.info_;
+    status_ = _loaded.status_;
+}
+
 void my_info_cache::set_status(status _status)
 {
     status_ = std::move(_status);
@@ -72,6 +72,9 @@ namespace core
             int32_t serialize(rapidjson::Value& _node, rapidjson_allocator& _a) const;
 
             int32_t load(std::wstring_view _filename);
+
+            // takes the info and the status read by load into another cache, not marking them as changed
+            void assign_loaded(const my_info_cache& _loaded);
         };
     }
 }
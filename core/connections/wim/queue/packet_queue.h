@@ -2,27 +2,23 @@
 
 namespace core::wim
 {
+    // elements are popped by priority, then by arrival, skipping the keys popped and not allowed yet.
+    //
+    // every key keeps its own queue, the head of every key that can be popped is indexed in ready_,
+    // so enqueue, pop and allow_using are O(log n) however many elements wait
     template <typename T, typename key_getter>
     class packet_queue
     {
         using set_key = typename std::result_of<decltype(&key_getter::key)(key_getter, T)>::type;
+
+        // a string_view key points into the element, it must not outlive it
+        using stored_key = std::conditional_t<std::is_same_v<set_key, std::string_view>, std::string, set_key>;
+
     public:
         bool is_empty() const;
         bool is_limit_reached() const;
         bool can_pop_element() const;
 
-        using container = std::list<T>;
-        using iterator = typename container::iterator;
-        using const_iterator = typename container::const_iterator;
-
-        iterator begin() noexcept { return queue_.begin(); }
-        const_iterator begin() const noexcept { return queue_.begin(); }
-        const_iterator cbegin() const noexcept { return queue_.cbegin(); }
-
-        iterator end() noexcept { return queue_.end(); }
-        const_iterator end() const noexcept { return queue_.end(); }
-        const_iterator cend() const noexcept { return queue_.cend(); }
-
         [[nodiscard]] std::shared_ptr<T> pop();
 
         void clear();
@@ -38,17 +34,27 @@ namespace core::wim
         template <typename Value>
         void emplace(Value&& _element);
 
-        auto contains_extracted_predicate() const
+    private:
+        struct order
         {
-            return [this](const T& _elem) -> bool
+            priority_t priority_;
+            uint64_t arrival_;
+
+            bool operator<(const order& _other) const noexcept
             {
-                return extracted_elements_.find(key_getter_.key(_elem)) == extracted_elements_.end();
-            };
-        }
+                return std::tie(priority_, arrival_) < std::tie(_other.priority_, _other.arrival_);
+            }
+        };
 
-    private:
-        std::set<set_key> extracted_elements_;
-        container queue_;
+        using key_queue = std::map<order, T>;
+        using key_queues = std::map<stored_key, key_queue, std::less<>>;
+
+        key_queues queues_;
+        std::map<order, typename key_queues::iterator> ready_;
+        std::set<stored_key, std::less<>> extracted_elements_;
+
+        size_t size_ = 0;
+        uint64_t arrival_ = 0;
         size_t limit_ = 1;
         key_getter key_getter_;
     };
@@ -56,7 +62,7 @@ namespace core::wim
     template <typename T, typename key_getter>
     inline bool packet_queue<T, key_getter>::is_empty() const
     {
-        return queue_.empty();
+        return size_ == 0;
     }
 
     template <typename T, typename key_getter>
@@ -68,30 +74,40 @@ namespace core::wim
     template <typename T, typename key_getter>
     inline bool packet_queue<T, key_getter>::can_pop_element() const
     {
-        return !is_empty() && !is_limit_reached() && std::any_of(queue_.cbegin(), queue_.cend(), contains_extracted_predicate());
+        return !is_limit_reached() && !ready_.empty();
     }
 
     template <typename T, typename key_getter>
     inline std::shared_ptr<T> packet_queue<T, key_getter>::pop()
     {
-        auto it = std::find_if(queue_.begin(), queue_.end(), contains_extracted_predicate());
-        if (it == queue_.end())
+        if (ready_.empty())
         {
             im_assert(!"element did not pop");
             return std::make_shared<T>();
         }
-        const auto element = std::make_shared<T>(std::move(*it));
-        queue_.erase(it);
 
-        extracted_elements_.insert(key_getter_.key(*element));
+        const auto queue_it = ready_.begin()->second;
+        ready_.erase(ready_.begin());
+
+        auto& elements = queue_it->second;
+        const auto element = std::make_shared<T>(std::move(elements.begin()->second));
+        elements.erase(elements.begin());
+        --size_;
+
+        extracted_elements_.insert(queue_it->first);
+        if (elements.empty())
+            queues_.erase(queue_it);
+
         return element;
     }
 
     template <typename T, typename key_getter>
     inline void packet_queue<T, key_getter>::clear()
     {
-        queue_.clear();
+        ready_.clear();
+        queues_.clear();
         extracted_elements_.clear();
+        size_ = 0;
     }
 
     template <typename T, typename key_getter>
@@ -115,23 +131,43 @@ namespace core::wim
     template<typename T, typename key_getter>
     inline void packet_queue<T, key_getter>::allow_using(const set_key& _key)
     {
-        extracted_elements_.erase(_key);
+        const auto extracted_it = extracted_elements_.find(_key);
+        if (extracted_it == extracted_elements_.end())
+            return;
+
+        extracted_elements_.erase(extracted_it);
+
+        if (const auto queue_it = queues_.find(_key); queue_it != queues_.end())
+            ready_.emplace(queue_it->second.begin()->first, queue_it);
     }
 
     template <typename T, typename key_getter>
     template <typename Value>
     inline void packet_queue<T, key_getter>::emplace(Value&& _value)
     {
-        auto iter = queue_.begin();
-        while (iter != queue_.end())
+        const order value_order = { key_getter_.priority(_value), arrival_++ };
+        const auto key = key_getter_.key(_value);
+
+        auto queue_it = queues_.find(key);
+        if (queue_it == queues_.end())
+            queue_it = queues_.emplace(stored_key(key), key_queue()).first;
+
+        auto& elements = queue_it->second;
+        if (extracted_elements_.find(key) == extracted_elements_.end())
         {
-            if (key_getter_.priority(_value) < key_getter_.priority(*iter))
+            // the element becomes the head of its key
+            if (elements.empty())
             {
-                queue_.insert(iter, std::forward<Value>(_value));
-                return;
+                ready_.emplace(value_order, queue_it);
+            }
+            else if (value_order < elements.begin()->first)
+            {
+                ready_.erase(elements.begin()->first);
+                ready_.emplace(value_order, queue_it);
             }
-            ++iter;
         }
-        queue_.push_back(std::forward<Value>(_value));
+
+        elements.emplace(value_order, std::forward<Value>(_value));
+        ++size_;
     }
 }; // namespace core::wim
@@ -10,11 +10,33 @@
 #include "../../log/log.h"
 #include "../../../common.shared/json_helper.h"
 #include "../../tools/system.h"
+#include "../../archive/storage.h"
 #include "../libomicron/include/omicron/omicron.h"
 
 using namespace core;
 using namespace wim;
 
+namespace
+{
+    enum journal_fields : uint32_t
+    {
+        generation = 1,
+        record_type = 2,
+        aimid = 3,
+        group_id = 4,
+        presence = 5
+    };
+
+    constexpr size_t min_journal_compaction_size = 256;
+
+    constexpr std::string_view chat_domain = "@chat.agent";
+
+    bool is_chat_aimid(std::string_view _aimid)
+    {
+        return _aimid.size() > chat_domain.size() && _aimid.substr(_aimid.size() - chat_domain.size()) == chat_domain;
+    }
+}
+
 void cl_presence::serialize(icollection* _coll)
 {
     coll_helper cl(_coll, false);
@@ -312,9 +334,229 @@ void contactlist::update_presence(const std::string& _aimid, const std::shared_p
         contact_presence->large_icon_id_ = _presence->large_icon_id_;
     }
 
+    set_presence_changed(_aimid);
+}
+
+void contactlist::set_presence_changed(const std::string& _aimid)
+{
+    add_to_journal(cl_journal_record::type::presence, _aimid);
     set_changed_status(contactlist::changed_status::presence);
 }
 
+void contactlist::add_to_journal(cl_journal_record::type _type, const std::string& _aimid, uint32_t _group_id)
+{
+    // the presence is serialized when the record is written, one record per contact is enough
+    if (_type == cl_journal_record::type::presence && !journal_presence_.insert(_aimid).second)
+        return;
+
+    journal_.push_back({ _type, _aimid, _group_id });
+}
+
+bool contactlist::need_snapshot() const noexcept
+{
+    return changed_status_ == changed_status::full || !journal_started_ || journal_size_ + journal_.size() > std::max(min_journal_compaction_size, contacts_index_.size() / 2);
+}
+
+uint32_t contactlist::start_snapshot(archive::data_block_batch& _journal_header)
+{
+    // the records go to the snapshot, new ones wait for it in memory until it has been saved
+    snapshot_generation_ = journal_generation_ + 1;
+    journal_started_ = false;
+    journal_size_ = 0;
+    journal_.clear();
+    journal_presence_.clear();
+
+    tools::tlvpack pack;
+    pack.push_child(tools::tlv(journal_fields::generation, snapshot_generation_));
+    pack.serialize(_journal_header.begin_block());
+
+    int64_t offset = 0;
+    uint32_t size = 0;
+    _journal_header.end_block(offset, size);
+
+    return snapshot_generation_;
+}
+
+void contactlist::commit_snapshot(uint32_t _generation) noexcept
+{
+    journal_generation_ = _generation;
+    journal_started_ = true;
+}
+
+void contactlist::serialize_journal(archive::data_block_batch& _batch)
+{
+    rapidjson::Document doc(rapidjson::Type::kObjectType);
+    rapidjson::StringBuffer buffer;
+
+    for (const auto& record : journal_)
+    {
+        tools::tlvpack pack;
+        pack.push_child(tools::tlv(journal_fields::record_type, static_cast<uint32_t>(record.type_)));
+        pack.push_child(tools::tlv(journal_fields::aimid, record.aimid_));
+
+        if (record.type_ != cl_journal_record::type::presence)
+            pack.push_child(tools::tlv(journal_fields::group_id, record.group_id_));
+
+        if (record.type_ != cl_journal_record::type::remove)
+        {
+            const auto presence = get_presence(record.aimid_);
+            if (!presence)
+                continue;
+
+            doc.SetObject();
+            presence->serialize(doc, doc.GetAllocator());
+
+            buffer.Clear();
+            rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+            doc.Accept(writer);
+
+            pack.push_child(tools::tlv(journal_fields::presence, std::string_view(buffer.GetString(), buffer.GetSize())));
+        }
+
+        pack.serialize(_batch.begin_block());
+
+        int64_t offset = 0;
+        uint32_t size = 0;
+        if (_batch.end_block(offset, size))
+            ++journal_size_;
+    }
+
+    journal_.clear();
+    journal_presence_.clear();
+}
+
+void contactlist::replay_journal(const std::wstring& _file_name)
+{
+    archive::storage storage(_file_name);
+
+    archive::storage_mode mode;
+    mode.flags_.read_ = true;
+    if (!storage.open(mode))
+        return;
+
+    core::tools::binary_stream block;
+    if (storage.read_data_block(-1, block))
+    {
+        tools::tlv_view header;
+        header.unserialize(block);
+
+        const auto generation = header.get_item(journal_fields::generation);
+        if (generation && generation->get_value<uint32_t>() == journal_generation_)
+        {
+            journal_started_ = true;
+
+            block.reset();
+            while (storage.read_data_block(-1, block))
+            {
+                if (!apply_journal_record(std::string_view(block.get_data_for_log(), size_t(block.available()))))
+                    break;
+
+                ++journal_size_;
+                block.reset();
+            }
+
+            // records appended after a torn one can't be read, compact them into a new snapshot
+            if (storage.get_last_error() != archive::error::end_of_file)
+                set_changed_status(changed_status::full);
+        }
+    }
+
+    storage.close();
+}
+
+bool contactlist::apply_journal_record(std::string_view _record)
+{
+    tools::tlv_view pack;
+    if (!pack.unserialize(_record))
+        return false;
+
+    const auto type_item = pack.get_item(journal_fields::record_type);
+    const auto aimid_item = pack.get_item(journal_fields::aimid);
+    if (!type_item || !aimid_item)
+        return false;
+
+    const auto type = static_cast<cl_journal_record::type>(type_item->get_value<uint32_t>());
+    const auto aimid = aimid_item->get_value<std::string>();
+    const auto group_item = pack.get_item(journal_fields::group_id);
+    const auto group_id = group_item ? group_item->get_value<uint32_t>() : 0;
+
+    const auto find_group = [this, group_id]()
+    {
+        return std::find_if(groups_.begin(), groups_.end(), [group_id](const auto& _group) { return _group->id_ == group_id; });
+    };
+
+    auto presence = std::make_shared<cl_presence>();
+    if (type != cl_journal_record::type::remove)
+    {
+        const auto presence_item = pack.get_item(journal_fields::presence);
+        if (!presence_item)
+            return false;
+
+        auto json = presence_item->get_value<std::string>();
+
+        rapidjson::Document doc;
+        if (doc.ParseInsitu(json.data()).HasParseError())
+            return false;
+
+        presence->unserialize(doc);
+        if (is_chat_aimid(aimid))
+            presence->is_chat_ = true;
+    }
+
+    switch (type)
+    {
+    case cl_journal_record::type::presence:
+        if (const auto it = contacts_index_.find(aimid); it != contacts_index_.end())
+        {
+            *it->second->presence_ = std::move(*presence);
+            persons_->erase(aimid);
+            add_to_persons(it->second);
+        }
+        break;
+
+    case cl_journal_record::type::add:
+        if (const auto group = find_group(); group != groups_.end())
+        {
+            auto buddy = std::make_shared<cl_buddy>();
+            buddy->aimid_ = aimid;
+            buddy->presence_ = std::move(presence);
+
+            persons_->erase(aimid);
+            add_to_persons(buddy);
+            contacts_index_[aimid] = buddy;
+
+            // the snapshot may already have the contact if the journal is replayed over it
+            auto& buddies = (*group)->buddies_;
+            if (auto it = std::find_if(buddies.begin(), buddies.end(), [&aimid](const auto& _buddy) { return _buddy->aimid_ == aimid; }); it != buddies.end())
+                *it = std::move(buddy);
+            else
+                buddies.push_back(std::move(buddy));
+        }
+        break;
+
+    case cl_journal_record::type::remove:
+        if (const auto group = find_group(); group != groups_.end())
+        {
+            auto& buddies = (*group)->buddies_;
+            buddies.erase(std::remove_if(buddies.begin(), buddies.end(), [&aimid](const auto& _buddy) { return _buddy->aimid_ == aimid; }), buddies.end());
+
+            const auto in_other_group = std::any_of(groups_.begin(), groups_.end(), [&aimid](const auto& _group)
+            {
+                return std::any_of(_group->buddies_.begin(), _group->buddies_.end(), [&aimid](const auto& _buddy) { return _buddy->aimid_ == aimid; });
+            });
+
+            if (!in_other_group)
+                contacts_index_.erase(aimid);
+        }
+        break;
+
+    default:
+        return false;
+    }
+
+    return true;
+}
+
 void contactlist::serialize(rapidjson::Value& _node, rapidjson_allocator& _a) const
 {
     rapidjson::Value node_groups(rapidjson::Type::kArrayType);
@@ -357,6 +599,8 @@ void contactlist::serialize(rapidjson::Value& _node, rapidjson_allocator& _a) co
     }
 
     _node.AddMember("ignorelist", std::move(node_ignorelist), _a);
+
+    _node.AddMember("journalGeneration", snapshot_generation_, _a);
 }
 
 void core::wim::contactlist::serialize(icollection* _coll, const std::string& type) const
@@ -983,8 +1227,6 @@ int32_t contactlist::unserialize(const rapidjson::Value& _node)
 {
     static long buddy_id = 0;
 
-    constexpr std::string_view chat_domain = "@chat.agent";
-
     const auto node_end = _node.MemberEnd();
     const auto iter_groups = _node.FindMember("groups");
     if (iter_groups == node_end || !iter_groups->value.IsArray())
@@ -1021,7 +1263,7 @@ int32_t contactlist::unserialize(const rapidjson::Value& _node)
                 buddy->aimid_ = aimid;
                 buddy->presence_->unserialize(bd);
 
-                if (buddy->aimid_.length() > chat_domain.length() && aimid.substr(aimid.length() - chat_domain.length(), chat_domain.length()) == chat_domain)
+                if (is_chat_aimid(aimid))
                     buddy->presence_->is_chat_ = true;
 
                 add_to_persons(buddy);
@@ -1035,6 +1277,9 @@ int32_t contactlist::unserialize(const rapidjson::Value& _node)
         groups_.push_back(std::move(group));
     }
 
+    tools::unserialize_value(_node, "journalGeneration", journal_generation_);
+    snapshot_generation_ = journal_generation_;
+
     const auto iter_ignorelist = _node.FindMember("ignorelist");
     if (iter_ignorelist == node_end || !iter_ignorelist->value.IsArray())
         return 0;
@@ -1052,8 +1297,6 @@ int32_t contactlist::unserialize_from_diff(const rapidjson::Value& _node)
 {
     static long buddy_id = 0;
 
-    constexpr std::string_view chat_domain = "@chat.agent";
-
     for (const auto& grp : _node.GetArray())
     {
         int grp_id;
@@ -1095,7 +1338,7 @@ int32_t contactlist::unserialize_from_diff(const rapidjson::Value& _node)
                 buddy->aimid_ = aimid;
                 buddy->presence_->unserialize(bd);
 
-                if (buddy->aimid_.length() > chat_domain.length() && aimid.substr(aimid.length() - chat_domain.length(), chat_domain.length()) == chat_domain)
+                if (is_chat_aimid(aimid))
                     buddy->presence_->is_chat_ = true;
 
                 add_to_persons(buddy);
@@ -1132,12 +1375,14 @@ void contactlist::merge_from_diff(const std::string& _type, const std::shared_pt
     changed_status status = changed_status::none;
     if (_type == "created")
     {
-        status = changed_status::full;
+        status = changed_status::presence;
         for (const auto& diff_group : _diff->groups_)
         {
             const auto diff_group_id = diff_group->id_;
             if (diff_group->added_)
             {
+                status = changed_status::full;
+
                 auto group = std::make_shared<cl_group>();
                 group->id_ = diff_group_id;
                 group->name_ = diff_group->name_;
@@ -1157,6 +1402,7 @@ void contactlist::merge_from_diff(const std::string& _type, const std::shared_pt
                     add_to_persons(diff_buddy);
                     group->buddies_.push_back(diff_buddy);
                     contacts_index_[diff_buddy->aimid_] = diff_buddy;
+                    add_to_journal(cl_journal_record::type::add, diff_buddy->aimid_, diff_group_id);
                 }
             }
         }
@@ -1175,7 +1421,7 @@ void contactlist::merge_from_diff(const std::string& _type, const std::shared_pt
     }
     else if (_type == "deleted")
     {
-        status = changed_status::full;
+        status = changed_status::presence;
         std::map<std::string, int_count> contacts;
 
         for (const auto& diff_group : _diff->groups_)
@@ -1201,6 +1447,8 @@ void contactlist::merge_from_diff(const std::string& _type, const std::shared_pt
                 for (const auto& diff_buddy : diff_group->buddies_)
                 {
                     const auto& aimId = diff_buddy->aimid_;
+                    add_to_journal(cl_journal_record::type::remove, aimId, diff_group_id);
+
                     auto& group_buddies = (*group_iter)->buddies_;
                     const auto end = group_buddies.end();
                     group_buddies.erase(std::remove_if(group_buddies.begin(), end,
@@ -1217,7 +1465,10 @@ void contactlist::merge_from_diff(const std::string& _type, const std::shared_pt
                 }
 
                 if (diff_group->removed_)
+                {
+                    status = changed_status::full;
                     group_iter = groups_.erase(group_iter);
+                }
                 else
                     ++group_iter;
             }
@@ -1297,7 +1548,7 @@ void contactlist::set_outgoing_msg_count(const std::string& _contact, int32_t _c
         if (presence)
         {
             presence->outgoing_msg_count_ = _count;
-            set_changed_status(changed_status::presence);
+            set_presence_changed(_contact);
         }
     }
 }
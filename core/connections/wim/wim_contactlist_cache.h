@@ -9,6 +9,11 @@ namespace core
     class async_executer;
     struct icollection;
 
+    namespace archive
+    {
+        class data_block_batch;
+    }
+
     namespace wim
     {
         class im;
@@ -117,6 +122,22 @@ namespace core
 
         using cl_search_resut_v = std::vector<cl_search_resut>;
 
+        // a change of the list made since the last snapshot; the state of the contact
+        // is taken when the record is written to the journal
+        struct cl_journal_record
+        {
+            enum class type : uint32_t
+            {
+                presence = 1,
+                add = 2,
+                remove = 3
+            };
+
+            type type_ = type::presence;
+            std::string aimid_;
+            uint32_t group_id_ = 0;
+        };
+
 
         class contactlist
         {
@@ -132,6 +153,19 @@ namespace core
 
         private:
             changed_status changed_status_ = changed_status::none;
+
+            // the snapshot is saved with the generation of the journal, records of another generation are ignored
+            uint32_t journal_generation_ = 0;
+            // the generation written to a snapshot, ahead of journal_generation_ until the snapshot is saved
+            uint32_t snapshot_generation_ = 0;
+            // the journal file has the header of the current generation
+            bool journal_started_ = false;
+            size_t journal_size_ = 0;
+            std::vector<cl_journal_record> journal_;
+            std::unordered_set<std::string> journal_presence_;
+
+            void add_to_journal(cl_journal_record::type _type, const std::string& _aimid, uint32_t _group_id = 0);
+            bool apply_journal_record(std::string_view _record);
             bool need_update_search_cache_ = false;
             bool need_update_avatar_ = false;
             void set_need_update_cache(bool _need_update_search_cache);
@@ -168,6 +202,18 @@ namespace core
             void set_changed_status(changed_status _status) noexcept;
             changed_status get_changed_status() const noexcept;
 
+            // full changes and a journal grown to half of the list are saved as a new snapshot
+            bool need_snapshot() const noexcept;
+            // starts a new journal generation, returns it and its header block;
+            // the journal is used again after commit_snapshot with that generation
+            uint32_t start_snapshot(archive::data_block_batch& _journal_header);
+            // the snapshot and the journal header of the generation have been saved
+            void commit_snapshot(uint32_t _generation) noexcept;
+            // moves the pending records to the batch
+            void serialize_journal(archive::data_block_batch& _batch);
+            // applies the journal of the loaded snapshot
+            void replay_journal(const std::wstring& _file_name);
+
             bool get_need_update_search_cache() const noexcept { return need_update_search_cache_; }
             bool get_need_update_avatar(bool reset) noexcept
             {
@@ -196,6 +242,8 @@ namespace core
             void set_last_search_pattern(const std::string_view _pattern);
 
             void update_presence(const std::string& _aimid, const std::shared_ptr<cl_presence>& _presence);
+            // for changes made to the presence directly
+            void set_presence_changed(const std::string& _aimid);
             void merge_from_diff(const std::string& _type, const std::shared_ptr<contactlist>& _diff, const std::shared_ptr<std::list<std::string>>& removedContacts);
 
             int32_t get_contacts_count() const;
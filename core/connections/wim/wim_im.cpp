@@ -4,6 +4,7 @@
 #include "wim_send_thread.h"
 #include "../contact_profile.h"
 #include "../../archive/history_patch.h"
+#include "../../archive/storage.h"
 
 // packets
 #include "packets/packets.h"
@@ -85,6 +86,7 @@
 
 #include "../../search_pattern_history.h"
 #include "stats/memory/memory_stats_collector.h"
+#include "memory_usage/archives_memory_consumption_reporter.h"
 
 #include "utils.h"
 #include "log_helpers.h"
@@ -131,13 +133,18 @@ namespace
     constexpr size_t contacts_per_search_thread = 100;
     constexpr std::string_view default_patch_version("none");
     constexpr int64_t initial_request_avatar_seq = -1;
-    constexpr size_t search_threads_count = 3;
     constexpr auto sending_search_results_interval = std::chrono::milliseconds(500);
     constexpr size_t max_support_screenshots_count = 32;
     constexpr auto pending_drafts_interval = std::chrono::seconds(1);
 
     constexpr std::string_view pinned_cache_name() { return "favorites"; }
 
+    size_t search_threads_count()
+    {
+        static const size_t count = std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 8);
+        return count;
+    }
+
     void stop_timer(int32_t& _timer_id)
     {
         if (core::g_core && _timer_id != empty_timer_id)
@@ -198,6 +205,19 @@ namespace
         save_json_to_disk(std::move(json_string), std::move(_filename), _executer);
     }
 
+    // the executer runs its tasks in order, so the writes queued before the call are done when it returns
+    void wait_for_disk_writes(const std::shared_ptr<core::async_executer>& _executer)
+    {
+        auto written = std::make_shared<std::promise<void>>();
+        auto future = written->get_future();
+        _executer->run_async_function([written]
+        {
+            written->set_value();
+            return 0;
+        });
+        future.wait();
+    }
+
     void update_friendly(const friendly_container::friendly_updates& _updates)
     {
         if (_updates.empty())
@@ -891,14 +911,14 @@ void im::store_fetch_parameters()
     });
 }
 
-std::shared_ptr<async_task_handlers> im::load_active_dialogs()
+std::shared_ptr<async_task_handlers> im::load_active_dialogs(async_executer* _tasks)
 {
     auto handler = std::make_shared<async_task_handlers>();
 
     std::wstring active_dialogs_file = get_active_dialogs_file_name();
     auto active_dlgs = std::make_shared<active_dialogs>();
 
-    async_tasks_->run_async_function([active_dialogs_file = std::move(active_dialogs_file), active_dlgs]
+    (_tasks ? _tasks : async_tasks_.get())->run_async_function([active_dialogs_file = std::move(active_dialogs_file), active_dlgs]
     {
         core::tools::binary_stream bstream;
         if (!bstream.load_from_file(active_dialogs_file))
@@ -934,12 +954,12 @@ std::shared_ptr<async_task_handlers> im::load_active_dialogs()
     return handler;
 }
 
-std::shared_ptr<async_task_handlers> im::load_contact_list()
+std::shared_ptr<async_task_handlers> im::load_contact_list(async_executer* _tasks)
 {
     auto handler = std::make_shared<async_task_handlers>();
     auto contact_list = std::make_shared<contactlist>();
 
-    async_tasks_->run_async_function([contact_list_file = get_contactlist_file_name(), contact_list]
+    (_tasks ? _tasks : async_tasks_.get())->run_async_function([contact_list_file = get_contactlist_file_name(), contact_list_journal_file = get_contactlist_journal_file_name(), contact_list]
     {
         core::tools::binary_stream bstream;
 
@@ -952,7 +972,11 @@ std::shared_ptr<async_task_handlers> im::load_contact_list()
         if (doc.ParseInsitu(bstream.read(bstream.available())).HasParseError())
             return -1;
 
-        return contact_list->unserialize(doc);
+        const auto res = contact_list->unserialize(doc);
+        if (res == 0)
+            contact_list->replay_journal(contact_list_journal_file);
+
+        return res;
 
     })->on_result_ = [wr_this = weak_from_this(), contact_list, handler](int32_t _error)
     {
@@ -976,14 +1000,14 @@ std::shared_ptr<async_task_handlers> im::load_contact_list()
     return handler;
 }
 
-std::shared_ptr<async_task_handlers> im::load_pinned()
+std::shared_ptr<async_task_handlers> im::load_pinned(async_executer* _tasks)
 {
-    return load_pinned_impl(pinned_type::pinned);
+    return load_pinned_impl(pinned_type::pinned, _tasks);
 }
 
-std::shared_ptr<async_task_handlers> im::load_unimportant()
+std::shared_ptr<async_task_handlers> im::load_unimportant(async_executer* _tasks)
 {
-    return load_pinned_impl(pinned_type::unimportant);
+    return load_pinned_impl(pinned_type::unimportant, _tasks);
 }
 
 std::shared_ptr<async_task_handlers> core::wim::im::load_inviters_blacklist()
@@ -1065,7 +1089,7 @@ std::shared_ptr<async_task_handlers> im::load_group_members_cache(std::string_vi
     return handler;
 }
 
-std::shared_ptr<async_task_handlers> im::load_pinned_impl(pinned_type _type)
+std::shared_ptr<async_task_handlers> im::load_pinned_impl(pinned_type _type, async_executer* _tasks)
 {
     auto handler = std::make_shared<async_task_handlers>();
     auto result = std::make_shared<contacts_cache>(pinned_cache_name());
@@ -1077,7 +1101,7 @@ std::shared_ptr<async_task_handlers> im::load_pinned_impl(pinned_type _type)
         return get_unimportant_file_name();
     };
 
-    async_tasks_->run_async_function([file_name = get_file_name(_type), result]
+    (_tasks ? _tasks : async_tasks_.get())->run_async_function([file_name = get_file_name(_type), result]
         {
             core::tools::binary_stream bstream;
             if (!bstream.load_from_file(file_name))
@@ -1122,12 +1146,12 @@ std::shared_ptr<async_task_handlers> im::load_pinned_impl(pinned_type _type)
 }
 
 
-std::shared_ptr<async_task_handlers> im::load_mailboxes()
+std::shared_ptr<async_task_handlers> im::load_mailboxes(async_executer* _tasks)
 {
     auto handler = std::make_shared<async_task_handlers>();
     auto mailboxes = std::make_shared<mailbox_storage>();
 
-    async_tasks_->run_async_function([mailboxes_file = get_mailboxes_file_name(), mailboxes]
+    (_tasks ? _tasks : async_tasks_.get())->run_async_function([mailboxes_file = get_mailboxes_file_name(), mailboxes]
     {
         return mailboxes->load(mailboxes_file);
     })->on_result_ = [wr_this = weak_from_this(), mailboxes, handler](int32_t _error)
@@ -1152,12 +1176,12 @@ std::shared_ptr<async_task_handlers> im::load_mailboxes()
     return handler;
 }
 
-std::shared_ptr<async_task_handlers> im::load_call_log()
+std::shared_ptr<async_task_handlers> im::load_call_log(async_executer* _tasks)
 {
     auto handler = std::make_shared<async_task_handlers>();
     auto call_log = std::make_shared<core::archive::call_log_cache>(get_call_log_file_name());
 
-    async_tasks_->run_async_function([call_log]
+    (_tasks ? _tasks : async_tasks_.get())->run_async_function([call_log]
         {
             return call_log->load();
         })->on_result_ = [wr_this = weak_from_this(), call_log, handler](int32_t _error)
@@ -1254,18 +1278,24 @@ std::shared_ptr<async_task_handlers> im::load_chats_threads_cache()
     return handler;
 }
 
-std::shared_ptr<async_task_handlers> core::wim::im::load_tasks()
+std::shared_ptr<async_task_handlers> core::wim::im::load_tasks(async_executer* _tasks)
 {
     auto handler = std::make_shared<async_task_handlers>();
 
-    async_tasks_->run_async_function([tasks_file = get_tasks_file_name(), wr_this = weak_from_this()]
+    auto tasks = std::make_shared<core::tasks::task_storage>();
+
+    (_tasks ? _tasks : async_tasks_.get())->run_async_function([tasks_file = get_tasks_file_name(), tasks]
+    {
+        return tasks->load(tasks_file);
+    })->on_result_ = [wr_this = weak_from_this(), tasks, handler](int32_t _error)
     {
         auto ptr_this = wr_this.lock();
         if (!ptr_this)
-            return 1;
-        return ptr_this->tasks_storage_->load(tasks_file);
-    })->on_result_ = [handler](int32_t _error)
-    {
+            return;
+
+        if (_error == 0)
+            ptr_this->tasks_storage_->merge(std::move(*tasks));
+
         if (handler->on_result_)
             handler->on_result_(_error);
     };
@@ -1273,20 +1303,18 @@ std::shared_ptr<async_task_handlers> core::wim::im::load_tasks()
     return handler;
 }
 
-std::shared_ptr<async_task_handlers> im::load_my_info()
+std::shared_ptr<async_task_handlers> im::load_my_info(async_executer* _tasks)
 {
     auto handler = std::make_shared<async_task_handlers>();
     auto wr_this = weak_from_this();
 
-    async_tasks_->run_async_function([wr_this, file_name = get_my_info_file_name()] () mutable
-    {
-        auto ptr_this = wr_this.lock();
-        if (!ptr_this)
-            return 1;
+    auto loaded = std::make_shared<my_info_cache>();
 
-        return ptr_this->my_info_cache_->load(file_name);
+    (_tasks ? _tasks : async_tasks_.get())->run_async_function([loaded, file_name = get_my_info_file_name()]
+    {
+        return loaded->load(file_name);
 
-    })->on_result_ = [wr_this, handler](int32_t _error)
+    })->on_result_ = [wr_this, loaded, handler](int32_t _error)
     {
         auto ptr_this = wr_this.lock();
         if (!ptr_this)
@@ -1294,6 +1322,8 @@ std::shared_ptr<async_task_handlers> im::load_my_info()
 
         if (_error == 0)
         {
+            ptr_this->my_info_cache_->assign_loaded(*loaded);
+
             if (const auto my_info = ptr_this->my_info_cache_->get_info())
                 ptr_this->insert_friendly(my_info->get_aimid(), my_info->get_friendly(), my_info->get_nick(), my_info->official(), core::friendly_source::local);
             ptr_this->post_my_info_to_gui();
@@ -1460,114 +1490,91 @@ void im::load_cached_objects()
     if (is_version_empty || is_new_version || is_locale_changed)
         return;
 
-    load_contact_list()->on_result_ = [wr_this, call_on_exit](int32_t _error)
-    {
-        auto ptr_this = wr_this.lock();
-        if (!ptr_this)
-            return;
+    // the caches are read and parsed on a pool, a cache is applied only after the caches it depends on
+    cached_objects_tasks_ = std::make_shared<async_executer>("im cached objects", std::clamp(std::thread::hardware_concurrency(), 2u, 4u));
+    auto tasks = cached_objects_tasks_.get();
 
-        if (_error != 0)
-            return;
+    auto graph = std::make_shared<async_task_graph>();
 
-        ptr_this->load_mailboxes()->on_result_ = [wr_this, call_on_exit](int32_t /*_error*/)
+    const auto load = [wr_this, tasks](auto _load)
+    {
+        return [wr_this, tasks, _load]()
         {
-            auto ptr_this = wr_this.lock();
-            if (!ptr_this)
-                return;
+            if (auto ptr_this = wr_this.lock())
+                return (ptr_this.get()->*_load)(tasks);
 
-            ptr_this->load_my_info()->on_result_ = [wr_this, call_on_exit](int32_t _error)
-            {
-                auto ptr_this = wr_this.lock();
-                if (!ptr_this)
-                    return;
+            return std::make_shared<async_task_handlers>();
+        };
+    };
 
-                if (_error != 0)
-                    return;
+    constexpr bool required = true;
 
-                ptr_this->load_pinned()->on_result_ = [wr_this, call_on_exit](int32_t /*_error*/)
-                {
-                    auto ptr_this = wr_this.lock();
-                    if (!ptr_this)
-                        return;
+    const auto contact_list = graph->add("contact_list", load(&im::load_contact_list), {}, required);
+    graph->add("mailboxes", load(&im::load_mailboxes));
+    const auto my_info = graph->add("my_info", load(&im::load_my_info), {}, required);
+    graph->add("pinned", load(&im::load_pinned), { contact_list, my_info });
+    graph->add("unimportant", load(&im::load_unimportant), { contact_list, my_info });
+    graph->add("smartreply_suggests", load(&im::load_smartreply_suggests));
+    graph->add("active_dialogs", load(&im::load_active_dialogs), { contact_list, my_info });
+    graph->add("call_log", load(&im::load_call_log), { contact_list, my_info });
+    graph->add("tasks", load(&im::load_tasks));
 
-                    ptr_this->load_unimportant()->on_result_ = [wr_this, call_on_exit](int32_t /*_error*/)
-                    {
-                        auto ptr_this = wr_this.lock();
-                        if (!ptr_this)
-                            return;
+    graph->run([wr_this, call_on_exit, graph = graph.get()](bool _success)
+    {
+        auto ptr_this = wr_this.lock();
+        if (!ptr_this)
+            return;
 
-                        ptr_this->load_smartreply_suggests()->on_result_ = [wr_this, call_on_exit](int32_t /*_error*/)
-                        {
-                            auto ptr_this = wr_this.lock();
-                            if (!ptr_this)
-                                return;
+        ptr_this->cached_objects_tasks_.reset();
 
-                            ptr_this->load_active_dialogs()->on_result_ = [wr_this, call_on_exit](int32_t /*_error*/)
-                            {
-                                auto ptr_this = wr_this.lock();
-                                if (!ptr_this)
-                                    return;
+        g_core->write_string_to_network_log(su::concat("im cached objects load:\r\n", graph->get_timings_for_log()));
 
-                                ptr_this->load_call_log()->on_result_ = [wr_this, call_on_exit](int32_t _error)
-                                {
-                                    auto ptr_this = wr_this.lock();
-                                    if (!ptr_this)
-                                        return;
+        if (!_success)
+            return;
 
-                                    ptr_this->load_tasks()->on_result_ = [wr_this, call_on_exit](int32_t _error)
-                                    {
-                                        auto ptr_this = wr_this.lock();
-                                        if (!ptr_this)
-                                            return;
+        call_on_exit->set_success();
 
-                                        call_on_exit->set_success();
+        // the dialogs which were never opened get their search index in background, the search scans them until then
+        ptr_this->get_archive()->backfill_search_index(std::make_shared<std::vector<std::string>>(ptr_this->contact_list_->get_aimids()));
 
-                                        const auto avatar_size = g_core->get_core_gui_settings().recents_avatars_size_;
+        const auto avatar_size = g_core->get_core_gui_settings().recents_avatars_size_;
 
-                                        ptr_this->active_dialogs_->enumerate(
-                                            [wr_this, avatar_size](const active_dialog& _dlg)
-                                            {
-                                                auto ptr_this = wr_this.lock();
-                                                if (!ptr_this)
-                                                    return;
+        ptr_this->active_dialogs_->enumerate(
+            [wr_this, avatar_size](const active_dialog& _dlg)
+            {
+                auto ptr_this = wr_this.lock();
+                if (!ptr_this)
+                    return;
 
-                                                const auto& dlg_aimid = _dlg.get_aimid();
+                const auto& dlg_aimid = _dlg.get_aimid();
 
-                                                if (avatar_size > 0)
-                                                    ptr_this->get_contact_avatar(initial_request_avatar_seq,
-                                                        _dlg.get_aimid(), avatar_size,
-                                                        false);
+                if (avatar_size > 0)
+                    ptr_this->get_contact_avatar(initial_request_avatar_seq,
+                        _dlg.get_aimid(), avatar_size,
+                        false);
 
-                                                ptr_this->post_dlg_state_to_gui(dlg_aimid, false, true, false,
-                                                    true);
+                ptr_this->post_dlg_state_to_gui(dlg_aimid, false, true, false,
+                    true);
 
-                                                ptr_this->get_archive()->get_gallery_state(
-                                                    dlg_aimid)->on_result = [wr_this, dlg_aimid](
-                                                        const archive::gallery_state& _state)
-                                                {
-                                                    auto ptr_this = wr_this.lock();
-                                                    if (!ptr_this)
-                                                        return;
+                ptr_this->get_archive()->get_gallery_state(
+                    dlg_aimid)->on_result = [wr_this, dlg_aimid](
+                        const archive::gallery_state& _state)
+                {
+                    auto ptr_this = wr_this.lock();
+                    if (!ptr_this)
+                        return;
 
-                                                    ptr_this->post_gallery_state_to_gui(dlg_aimid, _state);
-                                                };
-                                            });
+                    ptr_this->post_gallery_state_to_gui(dlg_aimid, _state);
+                };
+            });
 
-                                        ptr_this->post_ignorelist_to_gui(0);
+        ptr_this->post_ignorelist_to_gui(0);
 
-                                        g_core->post_message_to_gui("cachedobjects/loaded", 0, nullptr);
+        g_core->post_message_to_gui("cachedobjects/loaded", 0, nullptr);
 
-                                        ptr_this->load_threads_unread_count();
-                                        ptr_this->load_chats_threads_cache();
-                                    };
-                                };
-                            };
-                        };
-                    };
-                };
-            };
-        };
-    };
+        ptr_this->load_threads_unread_count();
+        ptr_this->load_chats_threads_cache();
+    });
 }
 
 void im::download_stickers_metafile(int64_t _seq, std::string_view _size, std::string_view _etag)
@@ -2812,20 +2819,43 @@ void im::save_my_info()
     save_to_disk(my_info_cache_, get_my_info_file_name(), async_tasks_);
 }
 
-void im::save_contact_list(force_save _force)
+void im::save_contact_list()
 {
-    static int counter = 0;
     const auto changed_status = contact_list_->get_changed_status();
     if (changed_status == core::wim::contactlist::changed_status::none)
         return;
 
-    if (changed_status == core::wim::contactlist::changed_status::presence && _force != force_save::yes)
+    // changes are appended to the journal, its size is proportional to the number of changes
+    if (!contact_list_->need_snapshot())
     {
-        constexpr int presence_interval = 6 * 10;
-        if (++counter < presence_interval)
+        auto batch = std::make_shared<archive::data_block_batch>();
+        contact_list_->serialize_journal(*batch);
+        contact_list_->set_changed_status(core::wim::contactlist::changed_status::none);
+
+        if (batch->empty())
             return;
+
+        async_tasks_->run_async_function([batch, file_name = get_contactlist_journal_file_name()]
+        {
+            archive::storage journal(file_name);
+
+            archive::storage_mode mode;
+            mode.flags_.write_ = mode.flags_.append_ = true;
+            if (!journal.open(mode))
+                return -1;
+
+            int64_t offset = 0;
+            const auto res = journal.write_data_blocks(*batch, offset);
+            journal.close();
+
+            return res ? 0 : -1;
+        });
+
+        return;
     }
-    counter = 0;
+
+    auto journal_header = std::make_shared<archive::data_block_batch>();
+    const auto generation = contact_list_->start_snapshot(*journal_header);
 
     auto json_string = serialize_to_json(contact_list_);
     if (json_string.empty())
@@ -2841,7 +2871,33 @@ void im::save_contact_list(force_save _force)
     g_core->write_string_to_network_log(su::concat("contact-list-debug",
         " save_contact_list async save_json_to_disk\r\n"));
 
-    save_json_to_disk(std::move(json_string), get_contactlist_file_name(), async_tasks_);
+    // the journal of the previous generation is dropped only after the snapshot has been saved,
+    // if it is left behind its generation doesn't match the snapshot and it is ignored
+    async_tasks_->run_async_function([json_string = std::move(json_string), journal_header, file_name = get_contactlist_file_name(), journal_file_name = get_contactlist_journal_file_name()]
+    {
+        if (!core::tools::binary_stream::save_2_file(json_string, file_name))
+            return -1;
+
+        archive::storage journal(journal_file_name);
+
+        archive::storage_mode mode;
+        mode.flags_.write_ = mode.flags_.truncate_ = true;
+        if (!journal.open(mode))
+            return -1;
+
+        int64_t offset = 0;
+        const auto res = journal.write_data_blocks(*journal_header, offset);
+        journal.close();
+
+        return res ? 0 : -1;
+    })->on_result_ = [contact_list = contact_list_, generation](int32_t _error)
+    {
+        // the next save writes the snapshot again, the journal is unused until then
+        if (_error != 0)
+            contact_list->set_changed_status(core::wim::contactlist::changed_status::full);
+        else
+            contact_list->commit_snapshot(generation);
+    };
 }
 
 void im::save_active_dialogs()
@@ -2876,7 +2932,7 @@ void im::save_cached_objects(force_save _force)
         " save_cached_objects force=", (_force == force_save::yes ? "yes" : "no"), "\r\n"));
 
     save_my_info();
-    save_contact_list(_force);
+    save_contact_list();
     save_active_dialogs();
     save_pinned();
     save_unimportant();
@@ -2888,6 +2944,10 @@ void im::save_cached_objects(force_save _force)
     save_tasks();
     save_threads_unread_count();
     save_chats_threads_cache();
+
+    // a forced save returns once everything is on disk, the im destructor relies on it
+    if (_force == force_save::yes)
+        wait_for_disk_writes(async_tasks_);
 }
 
 void im::start_session(is_ping _is_ping, is_login _is_login)
@@ -4043,7 +4103,7 @@ void im::on_event_diff(fetch_event_diff* _event, const std::shared_ptr<auto_call
         }
 
         if (contactlist::changed_status::full == ptr_this->contact_list_->get_changed_status())
-            ptr_this->save_contact_list(force_save::yes);
+            ptr_this->save_contact_list();
 
         on_created_groupchat(diff);
 
@@ -6131,7 +6191,7 @@ void im::on_event_dlg_state_local_state_updated(
                     if (const int64_t msg_ts = last_msg.get_time(); presence_time > 0 && presence_time < msg_ts)
                     {
                         *presence->lastseen_.time_ = msg_ts;
-                        contact_list_->set_changed_status(contactlist::changed_status::presence);
+                        contact_list_->set_presence_changed(_aimid);
                         post_presence_to_gui(_aimid);
                     }
                 }
@@ -6408,8 +6468,7 @@ void im::login_normalize_phone(int64_t _seq, const std::string& _country, const
 }
 
 void im::history_search_one_batch(std::shared_ptr<archive::coded_term> _cterm, std::shared_ptr<archive::contact_and_msgs> _thread_archive
-                                  , std::shared_ptr<tools::binary_stream> data, int64_t _seq
-                                  , int64_t _min_id, bool _in_thread)
+                                  , std::shared_ptr<tools::binary_stream> _data, int64_t _seq, bool _in_thread)
 {
     auto& search_data = _in_thread ? thread_search_data_ : search_data_;
     if (!search_data->check_req(_seq))
@@ -6431,192 +6490,186 @@ void im::history_search_one_batch(std::shared_ptr<archive::coded_term> _cterm, s
         return !search->check_req(_seq);
     };
 
-    get_archive()->get_history_block(contact_and_offsets, _thread_archive, data, cancel_search)->on_result =
-        [_cterm, contact_and_offsets, wr_this = weak_from_this(), _seq, _min_id, _in_thread]
-            (std::shared_ptr<archive::contact_and_msgs> _archive, std::shared_ptr<archive::contact_and_offsets_v> _remaining, std::shared_ptr<tools::binary_stream> _data)
-            {
-                auto ptr_this = wr_this.lock();
-                if (!ptr_this)
-                    return;
+    if (!history_searcher_)
+        history_searcher_ = std::make_unique<async_executer>("histSearch", search_threads_count(), false, tools::threadpool_mode::work_stealing);
 
-                auto& search_data = _in_thread ? ptr_this->thread_search_data_ : ptr_this->search_data_;
-                if (!search_data->check_req(_seq))
-                    return;
+    auto remaining = std::make_shared<archive::contact_and_offsets_v>();
 
-                if (_remaining)
-                {
-                    for (const auto& item : *_remaining)
-                        search_data->contact_and_offsets_.push_back(item);
-                }
+    static constexpr char task_name[] = "im::history_search_one_batch";
 
-                if (!ptr_this->history_searcher_)
-                    ptr_this->history_searcher_ = std::make_unique<async_executer>("histSearch", search_threads_count);
+    // both reading and matching run on the worker, so every batch in flight occupies its own core
+    history_searcher_->run_t_async_function<search::found_messages>(
+        [_cterm, _thread_archive, contact_and_offsets, remaining, _data, search_data, cancel_search, archive_path = get_archive()->get_archive_path()]() -> search::found_messages
+        {
+            search::found_messages found_messages;
 
-                ptr_this->history_searcher_->run_t_async_function<search::found_messages>(
-                    [_cterm, _archive, contact_and_offsets, _min_id, _data]() -> search::found_messages
-                        {
-                            search::found_messages found_messages;
+            archive::local_history::get_history_block(archive_path, *contact_and_offsets, *_thread_archive, *_data, *remaining, cancel_search);
 
-                            if (_archive->size() > 1)
-                                 archive::messages_data::search_in_archive(contact_and_offsets, _cterm, _archive, _data, found_messages, _min_id);
+            if (_thread_archive->size() > 1)
+                archive::messages_data::search_in_archive(contact_and_offsets, _cterm, _thread_archive, _data, found_messages, search_data->min_found_id_, cancel_search);
 
-                            return found_messages;
+            return found_messages;
 
-                        })->on_result_ = [wr_this, contact_and_offsets, _archive, _seq, _data, _cterm, _in_thread]
-                        (search::found_messages _found_messages)
-                        {
-                            auto ptr_this = wr_this.lock();
-                            if (!ptr_this)
-                                return;
+        }, task_name, cancel_search)->on_result_ = [wr_this = weak_from_this(), contact_and_offsets, remaining, _thread_archive, _seq, _data, _cterm, _in_thread]
+        (search::found_messages _found_messages)
+        {
+            auto ptr_this = wr_this.lock();
+            if (!ptr_this)
+                return;
 
-                            auto& search_data = _in_thread ? ptr_this->thread_search_data_ : ptr_this->search_data_;
-                            if (!search_data->check_req(_seq))
-                                return;
+            auto& search_data = _in_thread ? ptr_this->thread_search_data_ : ptr_this->search_data_;
+            if (!search_data->check_req(_seq))
+                return;
 
-                            for (auto [contact, mode, offset] : *contact_and_offsets)
-                            {
-                                if (*mode == 0)
-                                    search_data->contact_and_offsets_.push_front({ contact, std::make_shared<int64_t>(2), std::make_shared<int64_t>(0) });
+            for (const auto& item : *remaining)
+                search_data->contact_and_offsets_.push_back(item);
 
-                                *mode = 1;
+            for (auto [contact, mode, offset] : *contact_and_offsets)
+            {
+                if (*mode == 0)
+                    search_data->contact_and_offsets_.push_front({ contact, std::make_shared<int64_t>(2), std::make_shared<int64_t>(0) });
 
-                                if (*offset > 0)
-                                    search_data->contact_and_offsets_.push_back({ contact, mode, offset });
-                            }
+                *mode = 1;
 
-                            if (!search_data->contact_and_offsets_.empty())
-                            {
-                                int64_t last_id = -1;
-                                if (search_data->top_messages_.size() >= ::common::get_limit_search_results())
-                                    last_id = search_data->top_messages_ids_.rbegin()->first;
+                if (*offset > 0)
+                    search_data->contact_and_offsets_.push_back({ contact, mode, offset });
+            }
 
-                                ptr_this->history_search_one_batch(_cterm, _archive, _data, search_data->req_id_, last_id, _in_thread);
-                            }
-                            else
-                            {
-                                ++search_data->free_threads_count_;
-                            }
+            if (!search_data->contact_and_offsets_.empty())
+                ptr_this->history_search_one_batch(_cterm, _thread_archive, _data, search_data->req_id_, _in_thread);
+            else
+                ++search_data->free_threads_count_;
 
-                            auto call_on_exit = std::make_shared<tools::auto_scope_main>([wr_this, _seq, _cterm, _in_thread]()
-                            {
-                                auto ptr_this = wr_this.lock();
-                                if (!ptr_this)
-                                    return;
+            ptr_this->add_history_search_results(std::move(_found_messages), ptr_this->make_search_results_poster(_seq, _cterm, _in_thread), _seq, _in_thread);
+        };
+}
 
-                                im_assert(g_core->is_core_thread());
+std::shared_ptr<tools::auto_scope_main> im::make_search_results_poster(int64_t _seq, std::shared_ptr<archive::coded_term> _cterm, bool _in_thread)
+{
+    return std::make_shared<tools::auto_scope_main>([wr_this = weak_from_this(), _seq, _cterm, _in_thread]()
+    {
+        auto ptr_this = wr_this.lock();
+        if (!ptr_this)
+            return;
 
-                                auto& search_data = _in_thread ? ptr_this->thread_search_data_ : ptr_this->search_data_;
-                                if (search_data->free_threads_count_ == search_threads_count ||
-                                    (std::chrono::steady_clock::now() > search_data->last_send_time_ + sending_search_results_interval))
-                                {
-                                    search_data->not_sent_msgs_count_ = search_data->top_messages_.size();
+        im_assert(g_core->is_core_thread());
 
-                                    core::archive::persons_map local_persons;
-                                    for (const auto& [_, val] : search_data->top_messages_)
-                                        get_persons_from_message(*val, local_persons);
-                                    if (!local_persons.empty())
-                                        ptr_this->insert_friendly(local_persons, core::friendly_source::local, core::friendly_add_mode::insert);
+        auto& search_data = _in_thread ? ptr_this->thread_search_data_ : ptr_this->search_data_;
+        if (search_data->free_threads_count_ == search_threads_count() ||
+            (std::chrono::steady_clock::now() > search_data->last_send_time_ + sending_search_results_interval))
+        {
+            search_data->not_sent_msgs_count_ = search_data->top_messages_.size();
 
-                                    for (const auto& [contact, item] : search_data->top_messages_)
-                                    {
-                                        --search_data->not_sent_msgs_count_;
+            core::archive::persons_map local_persons;
+            for (const auto& [_, val] : search_data->top_messages_)
+                get_persons_from_message(*val, local_persons);
+            if (!local_persons.empty())
+                ptr_this->insert_friendly(local_persons, core::friendly_source::local, core::friendly_add_mode::insert);
 
-                                        if (!search_data->check_req(_seq)
-                                            || item->is_chat_event_deleted()
-                                            || item->is_deleted())
-                                        {
-                                            search_data->top_messages_ids_.erase(item->get_msgid());
-
-                                            if (search_data->free_threads_count_ == search_threads_count
-                                                && search_data->not_sent_msgs_count_ == 0
-                                                && search_data->sent_msgs_count_ == 0)
-                                            {
-                                                ptr_this->post_history_search_result_empty(_in_thread);
-                                            }
-                                        }
-                                        else
-                                        {
-                                            ++search_data->sent_msgs_count_;
-                                            ptr_this->post_history_search_result_msg_to_gui(contact, item, _cterm->lower_term, _in_thread);
-                                        }
+            for (const auto& [contact, item] : search_data->top_messages_)
+            {
+                --search_data->not_sent_msgs_count_;
 
-                                        search_data->top_messages_ids_[item->get_msgid()] = -1;
-                                    }
+                if (!search_data->check_req(_seq)
+                    || item->is_chat_event_deleted()
+                    || item->is_deleted())
+                {
+                    search_data->top_messages_ids_.erase(item->get_msgid());
 
-                                    search_data->top_messages_.clear();
-                                    search_data->last_send_time_ = std::chrono::steady_clock::now();
-                                }
+                    if (search_data->free_threads_count_ == search_threads_count()
+                        && search_data->not_sent_msgs_count_ == 0
+                        && search_data->sent_msgs_count_ == 0)
+                    {
+                        ptr_this->post_history_search_result_empty(_in_thread);
+                    }
+                }
+                else
+                {
+                    ++search_data->sent_msgs_count_;
+                    ptr_this->post_history_search_result_msg_to_gui(contact, item, _cterm->lower_term, _in_thread);
+                }
 
-                                if (search_data->free_threads_count_ == search_threads_count && search_data->top_messages_ids_.empty())
-                                    ptr_this->post_history_search_result_empty(_in_thread);
-                            });
+                search_data->top_messages_ids_[item->get_msgid()] = -1;
+            }
 
-                            for (auto& [contact, messages] : _found_messages)
-                            {
-                                if (messages.empty())
-                                    continue;
-                                std::vector<int64_t> ids;
-                                ids.reserve(messages.size());
-                                for (const auto& x : messages)
-                                    ids.push_back(x->get_msgid());
-                                ptr_this->get_archive()->filter_deleted_messages(contact, std::move(ids))->on_result = [call_on_exit, messages = std::move(messages), contact = contact, wr_this, _seq, _in_thread](const std::vector<int64_t>& _ids, archive::first_load _first_load) mutable
-                                {
-                                    auto ptr_this = wr_this.lock();
-                                    if (!ptr_this)
-                                        return;
+            search_data->top_messages_.clear();
+            search_data->last_send_time_ = std::chrono::steady_clock::now();
+        }
 
-                                    if (!ptr_this->has_opened_dialogs(contact))
-                                        ptr_this->remove_opened_dialog(contact);
-                                    else if (_first_load == archive::first_load::yes)
-                                        ptr_this->get_messages_for_update(contact);
+        if (search_data->free_threads_count_ == search_threads_count() && search_data->top_messages_ids_.empty())
+            ptr_this->post_history_search_result_empty(_in_thread);
+    });
+}
 
-                                    auto& search_data = _in_thread ? ptr_this->thread_search_data_ : ptr_this->search_data_;
-                                    if (!search_data->check_req(_seq))
-                                        return;
-                                    auto pred = [&_ids](const auto& _msg)
-                                    {
-                                        return std::none_of(_ids.begin(), _ids.end(), [id = _msg->get_msgid()](auto x){ return x == id; });
-                                    };
-                                    messages.erase(std::remove_if(messages.begin(), messages.end(), pred), messages.end());
-                                    for (const auto& msg : messages)
-                                    {
-                                        const auto msgid = msg->get_msgid();
-                                        if (search_data->top_messages_ids_.count(msgid) != 0)
-                                            continue;
+void im::add_history_search_results(search::found_messages _found_messages, std::shared_ptr<tools::auto_scope_main> _call_on_exit, int64_t _seq, bool _in_thread)
+{
+    for (auto& [contact, messages] : _found_messages)
+    {
+        if (messages.empty())
+            continue;
+        std::vector<int64_t> ids;
+        ids.reserve(messages.size());
+        for (const auto& x : messages)
+            ids.push_back(x->get_msgid());
+        get_archive()->filter_deleted_messages(contact, std::move(ids))->on_result = [_call_on_exit, messages = std::move(messages), contact = contact, wr_this = weak_from_this(), _seq, _in_thread](const std::vector<int64_t>& _ids, archive::first_load _first_load) mutable
+        {
+            auto ptr_this = wr_this.lock();
+            if (!ptr_this)
+                return;
 
-                                        if (search_data->top_messages_ids_.size() < ::common::get_limit_search_results())
-                                        {
-                                            search_data->top_messages_.push_back({ contact, msg });
-                                            search_data->top_messages_ids_.emplace(msgid, search_data->top_messages_.size() - 1);
-                                        }
-                                        else
-                                        {
-                                            auto greater = search_data->top_messages_ids_.upper_bound(msgid);
-
-                                            if (greater != search_data->top_messages_ids_.end())
-                                            {
-                                                auto index = search_data->top_messages_ids_.rbegin()->second;
-                                                const auto min_id = search_data->top_messages_ids_.rbegin()->first;
-
-                                                if (index == -1)
-                                                {
-                                                    search_data->top_messages_.push_back({ contact, msg });
-                                                    index = search_data->top_messages_.size() - 1;
-                                                }
-                                                else
-                                                {
-                                                    search_data->top_messages_[index] = { contact, msg };
-                                                }
-
-                                                search_data->top_messages_ids_.erase(min_id);
-                                                search_data->top_messages_ids_.emplace(msgid, index);
-                                            }
-                                        }
-                                    }
-                                };
-                            }
-                        };
+            if (!ptr_this->has_opened_dialogs(contact))
+                ptr_this->remove_opened_dialog(contact);
+            else if (_first_load == archive::first_load::yes)
+                ptr_this->get_messages_for_update(contact);
+
+            auto& search_data = _in_thread ? ptr_this->thread_search_data_ : ptr_this->search_data_;
+            if (!search_data->check_req(_seq))
+                return;
+            auto pred = [&_ids](const auto& _msg)
+            {
+                return std::none_of(_ids.begin(), _ids.end(), [id = _msg->get_msgid()](auto x){ return x == id; });
             };
+            messages.erase(std::remove_if(messages.begin(), messages.end(), pred), messages.end());
+            for (const auto& msg : messages)
+            {
+                const auto msgid = msg->get_msgid();
+                if (search_data->top_messages_ids_.count(msgid) != 0)
+                    continue;
+
+                if (search_data->top_messages_ids_.size() < ::common::get_limit_search_results())
+                {
+                    search_data->top_messages_.push_back({ contact, msg });
+                    search_data->top_messages_ids_.emplace(msgid, search_data->top_messages_.size() - 1);
+                }
+                else
+                {
+                    auto greater = search_data->top_messages_ids_.upper_bound(msgid);
+
+                    if (greater != search_data->top_messages_ids_.end())
+                    {
+                        auto index = search_data->top_messages_ids_.rbegin()->second;
+                        const auto min_id = search_data->top_messages_ids_.rbegin()->first;
+
+                        if (index == -1)
+                        {
+                            search_data->top_messages_.push_back({ contact, msg });
+                            index = search_data->top_messages_.size() - 1;
+                        }
+                        else
+                        {
+                            search_data->top_messages_[index] = { contact, msg };
+                        }
+
+                        search_data->top_messages_ids_.erase(min_id);
+                        search_data->top_messages_ids_.emplace(msgid, index);
+                    }
+                }
+            }
+
+            if (search_data->top_messages_ids_.size() >= ::common::get_limit_search_results())
+                search_data->min_found_id_ = search_data->top_messages_ids_.rbegin()->first;
+        };
+    }
 }
 
 void im::setup_search_dialogs_params(int64_t _req_id, bool _in_threads)
@@ -6624,12 +6677,13 @@ void im::setup_search_dialogs_params(int64_t _req_id, bool _in_threads)
     auto& data = _in_threads ? thread_search_data_ : search_data_;
     data->last_send_time_ = std::chrono::steady_clock::now() - 2 * sending_search_results_interval;
     data->req_id_ = _req_id;
+    data->min_found_id_ = -1;
     data->top_messages_.clear();
     data->not_sent_msgs_count_ = 0;
     data->sent_msgs_count_ = 0;
     data->top_messages_ids_.clear();
     data->contact_and_offsets_.clear();
-    data->free_threads_count_ = search_threads_count;
+    data->free_threads_count_ = search_threads_count();
 
     if (_req_id != -1)
         data->search_results_ = std::make_shared<search::search_dialog_results>();
@@ -6692,9 +6746,46 @@ void im::local_search_impl(const std::string& _term, std::shared_ptr<search::sea
     cterm->coded_string = tools::convert_string_to_vector(_term, last_symb_id, cterm->symbs, cterm->symb_indexes, cterm->symb_table);
     cterm->prefix = std::vector<int32_t>(tools::build_prefix(cterm->coded_string));
 
+    auto contacts = std::make_shared<std::vector<std::string>>();
+    contacts->reserve(_search_data->contact_and_offsets_.size());
+    for (const auto& [contact, mode, offset] : _search_data->contact_and_offsets_)
+        contacts->push_back(contact);
+
+    const int64_t seq = _search_data->req_id_;
+    auto cancel_search = [seq, search = _search_data]() -> bool
+    {
+        return !search->check_req(seq);
+    };
+
+    // indexed archives are answered right away, only the rest is scanned
+    get_archive()->search_in_index(contacts, cterm, cancel_search)->on_result = [wr_this = weak_from_this(), cterm, seq, _in_threads]
+        (std::shared_ptr<search::found_messages> _found_messages, std::shared_ptr<std::vector<std::string>> _unindexed)
+    {
+        auto ptr_this = wr_this.lock();
+        if (!ptr_this)
+            return;
+
+        auto& search_data = _in_threads ? ptr_this->thread_search_data_ : ptr_this->search_data_;
+        if (!search_data->check_req(seq))
+            return;
+
+        const std::unordered_set<std::string> unindexed(_unindexed->begin(), _unindexed->end());
+        search_data->contact_and_offsets_.remove_if([&unindexed](const auto& _item) { return unindexed.count(std::get<0>(_item)) == 0; });
+
+        const auto started_thread_count = ptr_this->start_history_search(cterm, search_data, _in_threads);
+
+        if (!_found_messages->empty())
+            ptr_this->add_history_search_results(std::move(*_found_messages), ptr_this->make_search_results_poster(seq, cterm, _in_threads), seq, _in_threads);
+        else if (started_thread_count == 0)
+            ptr_this->post_history_search_result_empty(_in_threads);
+    };
+}
+
+size_t im::start_history_search(std::shared_ptr<archive::coded_term> _cterm, std::shared_ptr<search::search_data> _search_data, bool _in_threads)
+{
     const auto cof_size = _search_data->contact_and_offsets_.size();
     const auto batch_count = cof_size / contacts_per_search_thread + (cof_size % contacts_per_search_thread ? 1 : 0);
-    const auto started_thread_count = std::min(search_threads_count, batch_count);
+    const auto started_thread_count = std::min(search_threads_count(), batch_count);
     for (size_t i = 0; i < started_thread_count; ++i)
     {
         if (_search_data->contact_and_offsets_.empty())
@@ -6707,11 +6798,10 @@ void im::local_search_impl(const std::string& _term, std::shared_ptr<search::sea
 
         --_search_data->free_threads_count_;
 
-        history_search_one_batch(cterm, thread_archive, data, _search_data->req_id_, -1 /* _min_id */, _in_threads);
+        history_search_one_batch(_cterm, thread_archive, data, _search_data->req_id_, _in_threads);
     }
 
-    if (started_thread_count == 0)
-        post_history_search_result_empty(_in_threads);
+    return started_thread_count;
 }
 
 void im::search_dialogs_local(const std::string& _term, const std::vector<std::string>& _aimids)
@@ -11388,6 +11478,7 @@ void im::request_memory_usage(const int64_t _seq)
            memory_stats::stat_type::cached_stickers,
            memory_stats::stat_type::voip_initialization,
            memory_stats::stat_type::video_player_initialization,
+           memory_stats::stat_type::cached_archives,
     };
 
     auto request_handle = memory_stats_collector_->request_memory_usage(required_stat_types);
@@ -11417,9 +11508,24 @@ void im::report_memory_usage(const int64_t _seq,
     g_core->post_message_to_gui("memory_usage_report_ready", _seq, cl_coll.get());
 }
 
+void im::report_archives_memory_usage(core::memory_stats::request_id _req_id)
+{
+    get_archive()->get_memory_usage()->on_result = [wr_this = weak_from_this(), _req_id](const int64_t _index_memory_usage, const int64_t _gallery_memory_usage, const archive::archives_cache_stats& _cache_stats)
+    {
+        auto ptr_this = wr_this.lock();
+        if (!ptr_this)
+            return;
+
+        memory_stats::partial_response part_response;
+        part_response.reports_.push_back(archives_memory_consumption_reporter::make_report(_index_memory_usage, _gallery_memory_usage, _cache_stats));
+
+        ptr_this->report_memory_usage(0, _req_id, part_response);
+    };
+}
+
 void im::get_ram_usage(const int64_t _seq)
 {
-    get_archive()->get_memory_usage()->on_result = [_seq](const int64_t _index_memory_usage, const int64_t _gallery_memory_usage)
+    get_archive()->get_memory_usage()->on_result = [_seq](const int64_t _index_memory_usage, const int64_t _gallery_memory_usage, const archive::archives_cache_stats& _cache_stats)
     {
         coll_helper cl_coll(g_core->create_collection(), true);
 
@@ -11427,6 +11533,10 @@ void im::get_ram_usage(const int64_t _seq)
         cl_coll.set_value_as_int64("real_mem", core::utils::get_current_process_real_mem_usage());
         cl_coll.set_value_as_int64("archive_index", _index_memory_usage);
         cl_coll.set_value_as_int64("archive_gallery", _gallery_memory_usage);
+        cl_coll.set_value_as_int64("archive_loaded", _cache_stats.loaded_count_);
+        cl_coll.set_value_as_int64("archive_budget", _cache_stats.memory_budget_);
+        cl_coll.set_value_as_int64("archive_evicted", _cache_stats.evicted_count_);
+        cl_coll.set_value_as_int64("archive_reloaded", _cache_stats.reloaded_count_);
         cl_coll.set_value_as_int64("voip_initialization", g_core->get_voip_init_memory_usage());
 
         g_core->post_message_to_gui("ram_usage_response", _seq, cl_coll.get());
@@ -12087,13 +12197,13 @@ void im::save_chats_threads_cache()
         save_to_disk(chats_threads_cache_, get_chats_threads_cache_filename(), async_tasks_);
 }
 
-std::shared_ptr<async_task_handlers> im::load_smartreply_suggests()
+std::shared_ptr<async_task_handlers> im::load_smartreply_suggests(async_executer* _tasks)
 {
     auto handler = std::make_shared<async_task_handlers>();
 
     auto sr_storage = std::make_shared<smartreply::suggest_storage>();
 
-    async_tasks_->run_async_function([suggests_file = get_last_suggest_file_name(), sr_storage]
+    (_tasks ? _tasks : async_tasks_.get())->run_async_function([suggests_file = get_last_suggest_file_name(), sr_storage]
     {
         core::tools::binary_stream bstream;
         if (!bstream.load_from_file(suggests_file))
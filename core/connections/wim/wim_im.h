@@ -114,6 +114,7 @@ namespace core
             archive::contact_and_offsets_l contact_and_offsets_;
             std::chrono::time_point<std::chrono::steady_clock> last_send_time_;
             std::atomic_int64_t req_id_ = -1;
+            std::atomic_int64_t min_found_id_ = -1; // the worst of top results once they are full, read by the search workers
             int32_t free_threads_count_ = 0;
             int32_t sent_msgs_count_ = 0;
             int32_t not_sent_msgs_count_ = 0;
@@ -378,6 +379,8 @@ namespace core
             std::shared_ptr<wim_send_thread> wim_send_thread_;
             std::shared_ptr<async_executer> fetch_thread_;
             std::shared_ptr<async_executer> async_tasks_;
+            // reads the cached objects in parallel at startup, released when they are loaded
+            std::shared_ptr<async_executer> cached_objects_tasks_;
 
             // files loader/uploader
             std::shared_ptr<loader> files_loader_;
@@ -519,7 +522,7 @@ namespace core
             std::wstring get_chats_threads_cache_filename() const;
 
             void save_my_info();
-            void save_contact_list(force_save _force);
+            void save_contact_list();
             void save_active_dialogs();
             void save_pinned();
             void save_unimportant();
@@ -532,11 +535,11 @@ namespace core
             void save_threads_unread_count();
             void save_chats_threads_cache();
 
-            std::shared_ptr<async_task_handlers> load_active_dialogs();
-            std::shared_ptr<async_task_handlers> load_contact_list();
-            std::shared_ptr<async_task_handlers> load_my_info();
-            std::shared_ptr<async_task_handlers> load_pinned();
-            std::shared_ptr<async_task_handlers> load_unimportant();
+            std::shared_ptr<async_task_handlers> load_active_dialogs(async_executer* _tasks = nullptr);
+            std::shared_ptr<async_task_handlers> load_contact_list(async_executer* _tasks = nullptr);
+            std::shared_ptr<async_task_handlers> load_my_info(async_executer* _tasks = nullptr);
+            std::shared_ptr<async_task_handlers> load_pinned(async_executer* _tasks = nullptr);
+            std::shared_ptr<async_task_handlers> load_unimportant(async_executer* _tasks = nullptr);
             std::shared_ptr<async_task_handlers> load_inviters_blacklist();
             std::shared_ptr<async_task_handlers> load_group_members_cache(std::string_view _aimid, std::string_view _role);
 
@@ -545,13 +548,13 @@ namespace core
                 pinned,
                 unimportant
             };
-            std::shared_ptr<async_task_handlers> load_pinned_impl(pinned_type);
-            std::shared_ptr<async_task_handlers> load_smartreply_suggests();
+            std::shared_ptr<async_task_handlers> load_pinned_impl(pinned_type, async_executer* _tasks);
+            std::shared_ptr<async_task_handlers> load_smartreply_suggests(async_executer* _tasks = nullptr);
 
-            std::shared_ptr<async_task_handlers> load_mailboxes();
-            std::shared_ptr<async_task_handlers> load_call_log();
+            std::shared_ptr<async_task_handlers> load_mailboxes(async_executer* _tasks = nullptr);
+            std::shared_ptr<async_task_handlers> load_call_log(async_executer* _tasks = nullptr);
 
-            std::shared_ptr<async_task_handlers> load_tasks();
+            std::shared_ptr<async_task_handlers> load_tasks(async_executer* _tasks = nullptr);
 
             std::shared_ptr<async_task_handlers> load_threads_unread_count();
             std::shared_ptr<async_task_handlers> load_chats_threads_cache();
@@ -1019,8 +1022,10 @@ namespace core
             // prefetching
 
             void history_search_one_batch(std::shared_ptr<archive::coded_term> _cterm, std::shared_ptr<archive::contact_and_msgs> _archive
-                , std::shared_ptr<tools::binary_stream> _data, int64_t _seq
-                , int64_t _min_id, bool _in_thread);
+                , std::shared_ptr<tools::binary_stream> _data, int64_t _seq, bool _in_thread);
+            size_t start_history_search(std::shared_ptr<archive::coded_term> _cterm, std::shared_ptr<search::search_data> _search_data, bool _in_threads);
+            std::shared_ptr<tools::auto_scope_main> make_search_results_poster(int64_t _seq, std::shared_ptr<archive::coded_term> _cterm, bool _in_thread);
+            void add_history_search_results(search::found_messages _found_messages, std::shared_ptr<tools::auto_scope_main> _call_on_exit, int64_t _seq, bool _in_thread);
 
             void post_unignored_contact_to_gui(const std::string& _aimid);
 
@@ -1245,6 +1250,7 @@ namespace core
             void report_memory_usage(const int64_t _seq,
                                              core::memory_stats::request_id _req_id,
                                              const core::memory_stats::partial_response& _partial_response) override;
+            void report_archives_memory_usage(core::memory_stats::request_id _req_id) override;
             void get_ram_usage(const int64_t _seq) override;
 
             void make_archive_holes(const int64_t _seq, const std::string& _archive) override;
@@ -7,6 +7,7 @@
 #include "../../../common.shared/json_helper.h"
 #include "../../log/log.h"
 #include "../../utils.h"
+#include "../../profiling/trace.h"
 #include "../common.shared/config/config.h"
 #include "../common.shared/string_utils.h"
 #include "../urls_cache.h"
@@ -47,6 +48,8 @@ bool wim_packet::support_self_resending() const
 
 int32_t wim_packet::execute()
 {
+    PROFILER_ZONE_DETAIL("wim", "packet", get_method());
+
     auto request = std::make_shared<core::http_request_simple>(params_.proxy_, utils::get_user_agent(params_.aimid_), get_priority(), params_.stop_handler_);
 
     ++repeat_count_;
@@ -102,6 +105,8 @@ void wim_packet::execute_async(handler_t _handler)
             return;
         }
 
+        PROFILER_ZONE_DETAIL("wim", "packet response", ptr_this->get_method());
+
         auto response = std::static_pointer_cast<tools::binary_stream>(request->get_response());
         im_assert(response);
         const auto err = ptr_this->parse_response(response);
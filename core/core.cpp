@@ -32,9 +32,11 @@
 #include "utils.h"
 #include "http_request.h"
 #include "scheduler.h"
+#include "gui_batch.h"
 #include "archive/local_history.h"
 #include "log/log.h"
 #include "profiling/profiler.h"
+#include "profiling/trace.h"
 #include "updater/updater.h"
 #include "crash_sender.h"
 #include "statistics.h"
@@ -47,6 +49,7 @@
 #include "tools/strings.h"
 #include "stats/memory/memory_stats_collector.h"
 #include "connections/wim/memory_usage/gui_memory_consumption_reporter.h"
+#include "connections/wim/memory_usage/archives_memory_consumption_reporter.h"
 #include "post_install_action.h"
 
 #include "../libomicron/include/omicron/omicron.h"
@@ -125,6 +128,8 @@ namespace
         return folders;
     }
 
+    constexpr std::string_view coregui_contact_fields[] = { "contact", "aimid", "aimId", "sn", "id", "stamp" };
+
     void write_additional_coregui_message_data(core::tools::binary_stream& bs, core::icollection* _message_data)
     {
         if (!_message_data)
@@ -158,8 +163,7 @@ namespace
             return false;
         };
 
-        constexpr static std::string_view fields[] = { "contact", "aimid", "aimId", "sn", "id", "stamp" };
-        for (auto c : fields)
+        for (auto c : coregui_contact_fields)
             if (write_contact(c))
                 break;
 
@@ -197,6 +201,53 @@ namespace
         }
     }
 
+    // GUI->CORE messages logged with more than write_additional_coregui_message_data writes
+    bool has_extended_gui_log(std::string_view _message, core::icollection* _message_data)
+    {
+        if (_message == "archive/messages/get" || _message == "archive/buddies/get" || _message == "archive/log/model" || _message == "voip_call")
+            return true;
+
+        return _message_data && _message_data->is_value_exist("contacts");
+    }
+
+    // the same line as write_additional_coregui_message_data, but formatted on the log thread
+    void write_gui_message_to_network_log(core::network_log& _log, std::string_view _message, core::icollection* _message_data)
+    {
+        int64_t error = 0;
+        std::string_view contact;
+        int64_t msgid = 0;
+
+        if (_message_data)
+        {
+            if (_message_data->is_value_exist("error"))
+            {
+                if (const auto value = _message_data->get_value("error"))
+                    error = value->get_as_int();
+            }
+
+            for (auto c : coregui_contact_fields)
+            {
+                if (_message_data->is_value_exist(c))
+                {
+                    if (const auto value = _message_data->get_value(c))
+                    {
+                        if (const auto str = value->get_as_string())
+                            contact = str;
+                        break;
+                    }
+                }
+            }
+
+            if (_message_data->is_value_exist("msgid"))
+            {
+                if (const auto value = _message_data->get_value("msgid"))
+                    msgid = value->get_as_int64();
+            }
+        }
+
+        _log.write_gui_message(_message, error, contact, msgid);
+    }
+
     constexpr auto contains_history_messages(std::string_view message_string)
     {
         return message_string == "archive/messages/get/result"
@@ -236,6 +287,56 @@ namespace
         return res;
     }
 
+    void serialize_histogram(core::coll_helper& _coll, std::string_view _name, const core::tools::log2_histogram& _histogram)
+    {
+        const std::string name(_name);
+        _coll.set_value_as_int64(name + "_count", int64_t(_histogram.get_count()));
+        _coll.set_value_as_int64(name + "_p50", int64_t(_histogram.get_percentile(0.5)));
+        _coll.set_value_as_int64(name + "_p99", int64_t(_histogram.get_percentile(0.99)));
+        _coll.set_value_as_int64(name + "_max", int64_t(_histogram.get_max()));
+        _coll.set_value_as_int64(name + "_sum", int64_t(_histogram.get_sum()));
+
+        // trailing empty buckets are cut, bucket i counts values below 2^i
+        const auto& buckets = _histogram.get_buckets();
+        auto used = buckets.size();
+        while (used > 0 && buckets[used - 1] == 0)
+            --used;
+
+        core::ifptr<core::iarray> array(_coll->create_array());
+        array->reserve(int32_t(used));
+        for (size_t i = 0; i < used; ++i)
+        {
+            core::ifptr<core::ivalue> value(_coll->create_value());
+            value->set_as_int64(int64_t(buckets[i]));
+            array->push_back(value.get());
+        }
+        _coll.set_value_as_array(name + "_hist", array.get());
+    }
+
+    void serialize_threadpool_stats(core::coll_helper& _coll, const core::tools::threadpool_stats_snapshot& _stats)
+    {
+        _coll.set_value_as_string("name", _stats.name_);
+        _coll.set_value_as_int("threads", int32_t(_stats.threads_count_));
+        _coll.set_value_as_int64("uptime_ms", _stats.uptime_.count());
+        _coll.set_value_as_double("busy", _stats.get_busy_share());
+        serialize_histogram(_coll, "depth", _stats.queue_depth_);
+
+        core::ifptr<core::iarray> tasks(_coll->create_array());
+        tasks->reserve(int32_t(_stats.tasks_.size()));
+        for (const auto& [name, task] : _stats.tasks_)
+        {
+            core::coll_helper task_coll(_coll->create_collection(), true);
+            task_coll.set_value_as_string("name", name);
+            serialize_histogram(task_coll, "wait_us", task.wait_us_);
+            serialize_histogram(task_coll, "run_us", task.run_us_);
+
+            core::ifptr<core::ivalue> value(_coll->create_value());
+            value->set_as_collection(task_coll.get());
+            tasks->push_back(value.get());
+        }
+        _coll.set_value_as_array("tasks", tasks.get());
+    }
+
     thread_local core::stack_vec current_stack_;
 }
 
@@ -322,6 +423,7 @@ core_dispatcher::core_dispatcher()
     : core_thread_(nullptr)
     , gui_connector_(nullptr)
     , core_factory_(nullptr)
+    , gui_batch_timer_id_(0)
     , delayed_stat_timer_id_(0)
     , omicron_update_timer_id_(0)
 {
@@ -339,6 +441,7 @@ core_dispatcher::core_dispatcher()
 
 core_dispatcher::~core_dispatcher()
 {
+    profiler::trace::stop();
     profiler::flush_logs();
 
     log::shutdown();
@@ -411,7 +514,7 @@ void core::core_dispatcher::on_omicron_updated(const std::string& _data)
 void core::core_dispatcher::write_data_to_network_log(tools::binary_stream _data)
 {
     if (is_network_log_valid())
-        get_network_log().write_data(std::move(_data));
+        get_network_log().write_data(_data);
 }
 
 void core::core_dispatcher::write_string_to_network_log(std::string_view _text)
@@ -429,6 +532,12 @@ std::stack<std::wstring> core::core_dispatcher::network_log_file_names_history_c
     return result;
 }
 
+void core::core_dispatcher::flush_network_log()
+{
+    if (is_network_log_valid())
+        get_network_log().flush();
+}
+
 std::shared_ptr<base_im> core::core_dispatcher::find_im_by_id(unsigned id) const
 {
     im_assert(!!im_container_);
@@ -525,6 +634,7 @@ void core::core_dispatcher::start(const common::core_gui_settings& _settings)
 
     async_executer_ = std::make_unique<async_executer>("core_async_executer");
     scheduler_ = std::make_unique<scheduler>();
+    gui_batch_ = std::make_unique<gui_batch>();
 
 #ifndef STRIP_VOIP
     voip_manager_.reset(voip_manager::createVoipManager(*this));
@@ -619,6 +729,7 @@ void core::core_dispatcher::unlink_gui()
             gui_settings_->clear_personal_values(aimid);
 
         gui_settings_.reset();
+        gui_batch_.reset();
         scheduler_.reset();
         statistics_.reset();
         im_stats_.reset();
@@ -650,6 +761,81 @@ void core::core_dispatcher::unlink_gui()
 
 
 void core::core_dispatcher::post_message_to_gui(std::string_view _message, int64_t _seq, icollection* _message_data)
+{
+    PROFILER_ZONE_DETAIL("core", "to gui", _message);
+
+    // anything else going to gui flushes the batch first, so no message overtakes a notification posted before it
+    if (gui_batch_ && core_thread_ && is_core_thread())
+    {
+        if (_seq == 0 && gui_batch_->add(_message, _message_data))
+        {
+            if (gui_batch_->size() >= gui_batch::max_size)
+            {
+                flush_gui_batch();
+            }
+            else if (!gui_batch_timer_id_)
+            {
+                gui_batch_timer_id_ = add_single_shot_timer({ [this]
+                {
+                    gui_batch_timer_id_ = 0;
+                    flush_gui_batch();
+                } }, gui_batch::window);
+            }
+            return;
+        }
+
+        flush_gui_batch();
+    }
+
+    log_message_to_gui(_message, _message_data);
+
+    if (!gui_connector_)
+    {
+        im_assert(!"gui unlinked");
+        return;
+    }
+
+    gui_connector_->receive(_message, _seq, _message_data);
+}
+
+void core::core_dispatcher::flush_gui_batch()
+{
+    if (gui_batch_timer_id_)
+    {
+        stop_timer(gui_batch_timer_id_);
+        gui_batch_timer_id_ = 0;
+    }
+
+    if (!gui_batch_ || gui_batch_->empty())
+        return;
+
+    PROFILER_ZONE("core", "gui batch");
+
+    coll_helper envelope(create_collection(), true);
+    gui_batch_->take(envelope.get());
+
+    if (is_network_log_valid())
+    {
+        log_message_to_gui(gui_batch::envelope_message, envelope.get());
+
+        const auto events = envelope.get_value_as_array("events");
+        for (int32_t i = 0, size = events->size(); i < size; ++i)
+        {
+            coll_helper event(events->get_at(i)->get_as_collection(), false);
+            log_message_to_gui(event.get_value_as_string("message"), event.get_value_as_collection("data"));
+        }
+    }
+
+    if (!gui_connector_)
+    {
+        im_assert(!"gui unlinked");
+        return;
+    }
+
+    gui_connector_->receive(gui_batch::envelope_message, 0, envelope.get());
+}
+
+void core::core_dispatcher::log_message_to_gui(std::string_view _message, icollection* _message_data)
 {
     tools::binary_stream bs;
     bs.write<std::string_view>("CORE->GUI: message=");
@@ -868,14 +1054,6 @@ void core::core_dispatcher::post_message_to_gui(std::string_view _message, int64
     write_data_to_network_log(std::move(bs));
 
     //__LOG(core::log::info("core", boost::format("post message to gui, message=%1%\nparameters: %2%") % _message % (_message_data ? _message_data->log() : ""));)
-
-    if (!gui_connector_)
-    {
-        im_assert(!"gui unlinked");
-        return;
-    }
-
-    gui_connector_->receive(_message, _seq, _message_data);
 }
 
 
@@ -1317,6 +1495,66 @@ void core::core_dispatcher::on_message_profiler_proc_stop(coll_helper _params) c
     profiler::process_stopped(id, ts);
 }
 
+void core::core_dispatcher::on_message_executers_stats(int64_t _seq) const
+{
+    coll_helper cl_coll(g_core->create_collection(), true);
+
+    const auto pools = tools::get_threadpools_stats();
+
+    ifptr<iarray> array(cl_coll->create_array());
+    array->reserve(int32_t(pools.size()));
+    for (const auto& pool : pools)
+    {
+        coll_helper pool_coll(cl_coll->create_collection(), true);
+        serialize_threadpool_stats(pool_coll, pool);
+
+        ifptr<ivalue> value(cl_coll->create_value());
+        value->set_as_collection(pool_coll.get());
+        array->push_back(value.get());
+    }
+    cl_coll.set_value_as_array("executers", array.get());
+
+    if (gui_batch_)
+    {
+        const auto counters = gui_batch_->get_counters();
+
+        ifptr<iarray> batched(cl_coll->create_array());
+        batched->reserve(int32_t(counters.size()));
+        for (const auto& c : counters)
+        {
+            coll_helper message_coll(cl_coll->create_collection(), true);
+            message_coll.set_value_as_string("message", c.message_);
+            message_coll.set_value_as_int64("posted", int64_t(c.posted_));
+            message_coll.set_value_as_int64("merged", int64_t(c.merged_));
+
+            ifptr<ivalue> value(cl_coll->create_value());
+            value->set_as_collection(message_coll.get());
+            batched->push_back(value.get());
+        }
+        cl_coll.set_value_as_array("gui_batch", batched.get());
+    }
+
+    g_core->post_message_to_gui("core/executers/stats/result", _seq, cl_coll.get());
+}
+
+void core::core_dispatcher::on_message_profiler_trace_start() const
+{
+    const auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    const auto file_name = utils::get_logs_path() / (L"trace_" + std::to_wstring(now) + L".json");
+
+    if (profiler::trace::start(file_name))
+        log::info("profiler", "trace started: " + file_name.string());
+    else
+        log::warn("profiler", "trace not started: " + file_name.string());
+}
+
+void core::core_dispatcher::on_message_profiler_trace_stop() const
+{
+    profiler::trace::stop();
+
+    log::info("profiler", "trace stopped, dropped zones: " + std::to_string(profiler::trace::get_dropped_count()));
+}
+
 void core::core_dispatcher::receive_message_from_gui(std::string_view _message, int64_t _seq, icollection* _message_data)
 {
     // called from main thread
@@ -1330,11 +1568,23 @@ void core::core_dispatcher::receive_message_from_gui(std::string_view _message,
         return;
     }
 
-    execute_core_context({ [this, message_string = std::string(_message), _seq, _message_data]
+    // the names of im_container messages live in its table, only the other ones are copied
+    const auto message_id = im_messages.find(_message);
+    auto unknown_message = message_id == im_messages.npos ? std::string(_message) : std::string();
+
+    execute_core_context({ [this, message_id, unknown_message = std::move(unknown_message), _seq, _message_data]
     {
         coll_helper params(_message_data, true);
 
-        if (message_string.front() != '_')
+        const std::string_view message_string = message_id == im_messages.npos ? std::string_view(unknown_message) : im_messages.name(message_id);
+
+        PROFILER_ZONE_DETAIL("core", "from gui", message_string);
+
+        if (message_string.front() != '_' && is_network_log_valid() && !has_extended_gui_log(message_string, _message_data))
+        {
+            write_gui_message_to_network_log(get_network_log(), message_string, _message_data);
+        }
+        else if (message_string.front() != '_')
         {
             tools::binary_stream bs;
             bs.write<std::string_view>("GUI->CORE: message=");
@@ -1409,7 +1659,11 @@ void core::core_dispatcher::receive_message_from_gui(std::string_view _message,
             write_data_to_network_log(std::move(bs));
         }
 
-        if (message_string == "settings/value/set")
+        if (message_id != im_messages.npos)
+        {
+            im_container_->on_message_from_gui(message_id, _seq, params);
+        }
+        else if (message_string == "settings/value/set")
         {
             on_message_update_gui_settings_value(_seq, params);
         }
@@ -1429,6 +1683,18 @@ void core::core_dispatcher::receive_message_from_gui(std::string_view _message,
         {
             on_message_profiler_proc_stop(params);
         }
+        else if (message_string == "core/executers/stats")
+        {
+            on_message_executers_stats(_seq);
+        }
+        else if (message_string == "profiler/trace/start")
+        {
+            on_message_profiler_trace_start();
+        }
+        else if (message_string == "profiler/trace/stop")
+        {
+            on_message_profiler_trace_stop();
+        }
         else if (message_string == "themes/settings/set")
         {
             on_message_update_theme_settings_value(_seq, params);
@@ -1477,7 +1743,7 @@ void core::core_dispatcher::receive_message_from_gui(std::string_view _message,
         }
         else
         {
-            im_container_->on_message_from_gui(message_string, _seq, params);
+            im_assert(!"unknown message type");
         }
     } });
 }
@@ -1710,6 +1976,7 @@ std::string core_dispatcher::get_locale() const
 void core_dispatcher::setup_memory_stats_collector()
 {
     memory_stats_collector_->register_async_consumption_reporter(std::make_unique<gui_memory_consumption_reporter>());
+    memory_stats_collector_->register_async_consumption_reporter(std::make_unique<archives_memory_consumption_reporter>());
 }
 
 std::thread::id core_dispatcher::get_core_thread_id() const
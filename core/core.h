@@ -36,6 +36,7 @@ namespace core
     struct async_task_handlers;
     class im_login_id;
     class network_log;
+    class gui_batch;
     struct proxy_settings;
     class proxy_settings_manager;
     class hosts_config;
@@ -131,6 +132,10 @@ namespace core
         icore_factory* core_factory_;
         std::unique_ptr<async_executer> async_executer_;
 
+        // state notifications waiting for the next frame
+        std::unique_ptr<gui_batch> gui_batch_;
+        uint32_t gui_batch_timer_id_;
+
         // updater
         std::unique_ptr<update::updater> updater_;
 
@@ -151,6 +156,9 @@ namespace core
         void on_message_network_log(coll_helper _params);
         void on_message_profiler_proc_start(coll_helper _params) const;
         void on_message_profiler_proc_stop(coll_helper _params) const;
+        void on_message_executers_stats(int64_t _seq) const;
+        void on_message_profiler_trace_start() const;
+        void on_message_profiler_trace_stop() const;
 
         void load_theme_settings();
         void post_theme_settings_and_meta();
@@ -177,6 +185,9 @@ namespace core
         bool is_network_log_valid() const;
         network_log& get_network_log();
 
+        void log_message_to_gui(std::string_view _message, icollection* _message_data);
+        void flush_gui_batch();
+
         bool get_gui_settings_bool_value(std::string_view _name, const bool _default) const;
 
     public:
@@ -193,6 +204,7 @@ namespace core
         void write_data_to_network_log(tools::binary_stream _data);
         void write_string_to_network_log(std::string_view _text);
         std::stack<std::wstring> network_log_file_names_history_copy();
+        void flush_network_log();
 
         uint32_t add_timer(stacked_task _func, std::chrono::milliseconds _timeout);
         uint32_t add_single_shot_timer(stacked_task _func, std::chrono::milliseconds _timeout);
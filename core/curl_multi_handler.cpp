@@ -12,6 +12,10 @@
 #include <winsock2.h>
 #endif //_WIN32
 
+#ifdef __linux__
+#include "linux/curl_multi_epoll.h"
+#endif //__linux__
+
 namespace
 {
     struct GlobalInfo
@@ -264,7 +268,7 @@ namespace
                     curl_easy_getinfo(easy, CURLINFO_ACTIVESOCKET, &sockfd);
                     if (sockfd == s)
                     {
-                        task->finish_multi(&global, easy, CURLE_ABORTED_BY_CALLBACK);
+                        task->finish_multi(global.multi, easy, CURLE_ABORTED_BY_CALLBACK);
                         iter = tasks.erase(iter);
                         continue;
                     }
@@ -321,7 +325,7 @@ namespace
                     {
                         curl_socket_t sockfd;
                         curl_easy_getinfo(easy, CURLINFO_ACTIVESOCKET, &sockfd);
-                        shared_task_node.mapped()->finish_multi(&global, easy, res);
+                        shared_task_node.mapped()->finish_multi(global.multi, easy, res);
 
                         if (sockfd != CURL_SOCKET_BAD)
                         {
@@ -419,6 +423,8 @@ namespace core
     {
     }
 
+    curl_multi_handler::~curl_multi_handler() = default;
+
     curl_easy::future_t curl_multi_handler::perform(const std::shared_ptr<curl_context>& _context)
     {
         auto promise = curl_easy::promise_t();
@@ -473,15 +479,34 @@ namespace core
             tasks_queue.push_back(task_ptr);
     }
 
+    void curl_multi_handler::init_multi()
+    {
+        global.multi = curl_multi_init();
+
+        curl_multi_setopt(global.multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+#ifdef __linux__
+        if (epoll_)
+            epoll_->attach(global.multi);
+#endif //__linux__
+    }
+
     void curl_multi_handler::init()
     {
+#ifdef __linux__
+        epoll_ = std::make_unique<curl_multi_epoll>();
+        if (!epoll_->init())
+        {
+            write_log("multi_handle: epoll is unavailable, falling back to select");
+            epoll_.reset();
+        }
+#endif //__linux__
+
         service_thread_ = std::thread([this]()
         {
             utils::set_this_thread_name("curl multi thread");
 
-            global.multi = curl_multi_init();
-
-            curl_multi_setopt(global.multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+            init_multi();
 
             auto tasks_stuff = [this]()
             {
@@ -500,9 +525,7 @@ namespace core
                 if (reset_multi.load())
                 {
                     curl_multi_cleanup(global.multi);
-                    global.multi = curl_multi_init();
-
-                    curl_multi_setopt(global.multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+                    init_multi();
                     reset_multi = false;
                 }
 
@@ -521,6 +544,21 @@ namespace core
             {
                 while (!tasks.empty())
                 {
+#ifdef __linux__
+                    if (epoll_)
+                    {
+                        if (!epoll_->wait(std::chrono::seconds(1), global.still_running))
+                            perform_sleep(std::chrono::milliseconds(100));
+
+                        check_multi_info(&global);
+
+                        if (!tasks_stuff())
+                            break;
+
+                        continue;
+                    }
+#endif //__linux__
+
                     struct timeval timeout;
                     timeout.tv_sec = 1;
                     timeout.tv_usec = 0;
@@ -691,7 +729,7 @@ namespace core
         if (!inserted)
             tasks_queue.push_back(std::move(_task));
 
-        emit_signal();
+        wake_up();
         condition.notify_one();
     }
 
@@ -702,13 +740,13 @@ namespace core
             for (auto& task : std::exchange(tasks_queue, {}))
                 task->cancel();
 
-            emit_signal();
+            wake_up();
             condition.notify_one();
         }
 
         for (auto& [easy, task] : std::exchange(tasks, {}))
             if (task)
-                task->finish_multi(&global, easy, CURLE_ABORTED_BY_CALLBACK);
+                task->finish_multi(global.multi, easy, CURLE_ABORTED_BY_CALLBACK);
 
         for (auto [s, _] : std::exchange(socket_map, {}))
             close_socket_internal(s);
@@ -725,7 +763,7 @@ namespace core
             if (!task || task->is_stopped())
             {
                 if (task)
-                    task->finish_multi(&global, easy, CURLE_ABORTED_BY_CALLBACK);
+                    task->finish_multi(global.multi, easy, CURLE_ABORTED_BY_CALLBACK);
 
                 it = tasks.erase(it);
             }
@@ -750,7 +788,7 @@ namespace core
                 auto count = socket_map.count(sockfd);
                 if (count != 0)
                 {
-                    task->finish_multi(&global, easy, network_is_down.load() ? CURLE_COULDNT_CONNECT : CURLE_ABORTED_BY_CALLBACK);
+                    task->finish_multi(global.multi, easy, network_is_down.load() ? CURLE_COULDNT_CONNECT : CURLE_ABORTED_BY_CALLBACK);
                     iter = tasks.erase(iter);
                     continue;
                 }
@@ -761,9 +799,22 @@ namespace core
             close_socket_internal(s);
     }
 
-    void curl_multi_handler::notify()
+    void curl_multi_handler::wake_up()
     {
+#ifdef __linux__
+        if (epoll_)
+        {
+            epoll_->notify();
+            return;
+        }
+#endif //__linux__
+
         emit_signal();
+    }
+
+    void curl_multi_handler::notify()
+    {
+        wake_up();
         std::lock_guard<std::mutex> guard(tasks_queue_mutex);
         condition.notify_one();
     }
@@ -3,10 +3,15 @@
 #include "async_task.h"
 namespace core
 {
+#ifdef __linux__
+    class curl_multi_epoll;
+#endif
+
     class curl_multi_handler : public curl_base_handler
     {
     public:
         curl_multi_handler();
+        ~curl_multi_handler();
 
         curl_easy::future_t perform(const std::shared_ptr<curl_context>& _context) override;
         void perform_async(const std::shared_ptr<curl_context>& _context, curl_easy::completion_function _completion_func) override;
@@ -26,6 +31,8 @@ namespace core
         void set_max_parallel_packets_count(size_t _count);
 
     private:
+        void init_multi();
+
         void add_task();
         void add_task_to_queue(std::shared_ptr<core::curl_task> _task);
 
@@ -34,11 +41,16 @@ namespace core
 
         void reset_sockets_internal();
 
+        void wake_up();
         void notify();
 
     private:
         std::thread service_thread_;
         std::unique_ptr<async_executer> resolve_hosts_thread_;
         std::atomic_size_t max_parallel_tasks_count_;
+
+#ifdef __linux__
+        std::unique_ptr<curl_multi_epoll> epoll_;
+#endif
     };
 }
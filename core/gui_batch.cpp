@@ -0,0 +1,142 @@
+#include "stdafx.h"
+#include "gui_batch.h"
+
+#include "../corelib/collection_helper.h"
+
+using namespace core;
+
+namespace
+{
+    struct batch_rule
+    {
+        std::string_view message_;
+
+        // the notifications of a group replace each other by the key, none are replaced without a key
+        std::string_view group_;
+        std::string_view key_;
+        std::string_view second_key_;
+    };
+
+    constexpr batch_rule rules[] =
+    {
+        { "contact/presence", "contact/presence", "aimid" },
+        { "status", "status", "aimId" },
+        { "avatars/presence/updated", "avatars/presence/updated", "aimid" },
+        { "typing", "typing", "aimId", "chatterAimId" },
+        { "typing/stop", "typing", "aimId", "chatterAimId" },
+
+        // already collected by im, only the delivery is batched
+        { "dlg_states" },
+        { "messages/received/message_status" },
+    };
+
+    const batch_rule* find_rule(std::string_view _message)
+    {
+        const auto it = std::find_if(std::begin(rules), std::end(rules), [_message](const auto& _rule) { return _rule.message_ == _message; });
+        return it == std::end(rules) ? nullptr : it;
+    }
+
+    std::string_view get_string(icollection* _data, std::string_view _name)
+    {
+        if (!_data->is_value_exist(_name))
+            return {};
+
+        const auto value = _data->get_value(_name);
+        return value ? value->get_as_string() : std::string_view();
+    }
+
+    std::string make_key(const batch_rule& _rule, icollection* _data)
+    {
+        const auto key = get_string(_data, _rule.key_);
+        const auto second_key = _rule.second_key_.empty() ? std::string_view() : get_string(_data, _rule.second_key_);
+
+        std::string result;
+        result.reserve(_rule.group_.size() + key.size() + second_key.size() + 2);
+        result += _rule.group_;
+        result += '\0';
+        result += key;
+        result += '\0';
+        result += second_key;
+        return result;
+    }
+}
+
+gui_batch::gui_batch()
+    : merged_(0)
+{
+    counters_.reserve(std::size(rules));
+    for (const auto& rule : rules)
+        counters_.push_back({ rule.message_ });
+}
+
+gui_batch::~gui_batch() = default;
+
+bool gui_batch::add(std::string_view _message, icollection* _data)
+{
+    const auto rule = find_rule(_message);
+    if (!rule || !_data)
+        return false;
+
+    const auto rule_index = size_t(rule - std::begin(rules));
+    ++counters_[rule_index].posted_;
+
+    _data->addref();
+    pending_event event{ rule_index, ifptr<icollection>(_data) };
+
+    if (!rule->key_.empty())
+    {
+        const auto [it, inserted] = keyed_.try_emplace(make_key(*rule, _data), events_.size());
+        if (!inserted)
+        {
+            events_[it->second] = std::move(event);
+
+            ++counters_[rule_index].merged_;
+            ++merged_;
+            return true;
+        }
+    }
+
+    events_.push_back(std::move(event));
+    return true;
+}
+
+bool gui_batch::empty() const noexcept
+{
+    return events_.empty();
+}
+
+size_t gui_batch::size() const noexcept
+{
+    return events_.size();
+}
+
+void gui_batch::take(icollection* _envelope)
+{
+    coll_helper envelope(_envelope, false);
+
+    ifptr<iarray> array(_envelope->create_array());
+    array->reserve(int32_t(events_.size()));
+
+    for (const auto& event : events_)
+    {
+        coll_helper event_coll(_envelope->create_collection(), true);
+        event_coll.set_value_as_string("message", rules[event.rule_].message_);
+        event_coll.set_value_as_collection("data", event.data_.get());
+
+        ifptr<ivalue> value(_envelope->create_value());
+        value->set_as_collection(event_coll.get());
+        array->push_back(value.get());
+    }
+
+    envelope.set_value_as_array("events", array.get());
+    envelope.set_value_as_int64("merged", int64_t(merged_));
+
+    events_.clear();
+    keyed_.clear();
+    merged_ = 0;
+}
+
+std::vector<gui_batch::counters> gui_batch::get_counters() const
+{
+    return counters_;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../corelib/core_face.h"
+#include "../corelib/ifptr.h"
+
+namespace core
+{
+    // state notifications posted to gui within a frame, delivered in one envelope message.
+    //
+    // a notification replaces the pending one of the same group and key, like the latest
+    // presence of a contact, the ones without a key are kept as they are. the order of the
+    // first posting is preserved. called on the core thread only
+    class gui_batch
+    {
+    public:
+        // "events": array of { "message", "data" }, "merged": notifications dropped from the batch
+        static constexpr std::string_view envelope_message = "core/batch";
+
+        static constexpr auto window = std::chrono::milliseconds(16);
+        static constexpr size_t max_size = 1024;
+
+        struct counters
+        {
+            std::string_view message_;
+            uint64_t posted_ = 0;
+            uint64_t merged_ = 0;
+        };
+
+        gui_batch();
+        ~gui_batch();
+
+        // false if the message isn't batched, the data is held until take
+        bool add(std::string_view _message, icollection* _data);
+
+        bool empty() const noexcept;
+        size_t size() const noexcept;
+
+        // moves the pending notifications into _envelope
+        void take(icollection* _envelope);
+
+        // since the start, for every batched message
+        std::vector<counters> get_counters() const;
+
+    private:
+        struct pending_event
+        {
+            size_t rule_;
+            ifptr<icollection> data_;
+        };
+
+        std::vector<pending_event> events_;
+
+        // group and key of the replaceable notifications to their position in events_
+        std::unordered_map<std::string, size_t> keyed_;
+
+        uint64_t merged_;
+
+        std::vector<counters> counters_;
+    };
+}
@@ -0,0 +1,192 @@
+#include "stdafx.h"
+#include "curl_multi_epoll.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr int max_events = 256;
+
+    uint32_t to_epoll_events(int _what)
+    {
+        switch (_what)
+        {
+        case CURL_POLL_IN:
+            return EPOLLIN;
+        case CURL_POLL_OUT:
+            return EPOLLOUT;
+        case CURL_POLL_INOUT:
+            return EPOLLIN | EPOLLOUT;
+        default:
+            return 0;
+        }
+    }
+
+    int to_curl_events(uint32_t _events)
+    {
+        int result = 0;
+        if (_events & EPOLLIN)
+            result |= CURL_CSELECT_IN;
+        if (_events & EPOLLOUT)
+            result |= CURL_CSELECT_OUT;
+        if (_events & (EPOLLERR | EPOLLHUP))
+            result |= CURL_CSELECT_ERR;
+        return result;
+    }
+
+    void drain(int _fd)
+    {
+        uint64_t value = 0;
+        while (::read(_fd, &value, sizeof(value)) > 0);
+    }
+}
+
+namespace core
+{
+    curl_multi_epoll::curl_multi_epoll() = default;
+
+    curl_multi_epoll::~curl_multi_epoll()
+    {
+        close();
+    }
+
+    bool curl_multi_epoll::init()
+    {
+        epoll_ = ::epoll_create1(EPOLL_CLOEXEC);
+        timer_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        event_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        if (epoll_ == -1 || timer_ == -1 || event_ == -1)
+        {
+            close();
+            return false;
+        }
+
+        for (auto fd : { timer_, event_ })
+        {
+            epoll_event ev = {};
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            if (::epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &ev) != 0)
+            {
+                close();
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void curl_multi_epoll::close() noexcept
+    {
+        for (auto fd : { &epoll_, &timer_, &event_ })
+        {
+            if (*fd != -1)
+            {
+                ::close(*fd);
+                *fd = -1;
+            }
+        }
+    }
+
+    void curl_multi_epoll::attach(CURLM* _multi)
+    {
+        multi_ = _multi;
+        set_timer(-1);
+
+        curl_multi_setopt(_multi, CURLMOPT_SOCKETFUNCTION, on_socket);
+        curl_multi_setopt(_multi, CURLMOPT_SOCKETDATA, this);
+        curl_multi_setopt(_multi, CURLMOPT_TIMERFUNCTION, on_timer);
+        curl_multi_setopt(_multi, CURLMOPT_TIMERDATA, this);
+    }
+
+    void curl_multi_epoll::notify()
+    {
+        const uint64_t value = 1;
+        [[maybe_unused]] const auto res = ::write(event_, &value, sizeof(value));
+    }
+
+    bool curl_multi_epoll::wait(std::chrono::milliseconds _timeout, int& _still_running)
+    {
+        epoll_event events[max_events];
+
+        const auto count = ::epoll_wait(epoll_, events, max_events, int(_timeout.count()));
+        if (count < 0)
+            return errno == EINTR;
+
+        auto timer_expired = false;
+        for (auto i = 0; i < count; ++i)
+        {
+            const auto fd = events[i].data.fd;
+            if (fd == event_)
+            {
+                drain(event_);
+            }
+            else if (fd == timer_)
+            {
+                drain(timer_);
+                timer_expired = true;
+            }
+            else
+            {
+                curl_multi_socket_action(multi_, fd, to_curl_events(events[i].events), &_still_running);
+            }
+        }
+
+        if (timer_expired)
+            curl_multi_socket_action(multi_, CURL_SOCKET_TIMEOUT, 0, &_still_running);
+
+        return true;
+    }
+
+    int curl_multi_epoll::on_socket(CURL*, curl_socket_t _socket, int _what, void* _userp, void*)
+    {
+        static_cast<curl_multi_epoll*>(_userp)->watch(_socket, _what);
+        return 0;
+    }
+
+    int curl_multi_epoll::on_timer(CURLM*, long _timeout_ms, void* _userp)
+    {
+        static_cast<curl_multi_epoll*>(_userp)->set_timer(_timeout_ms);
+        return 0;
+    }
+
+    void curl_multi_epoll::watch(curl_socket_t _socket, int _what)
+    {
+        if (_what == CURL_POLL_REMOVE)
+        {
+            // the socket may be already closed by close_socket, the kernel has dropped it then
+            ::epoll_ctl(epoll_, EPOLL_CTL_DEL, _socket, nullptr);
+            return;
+        }
+
+        epoll_event ev = {};
+        ev.events = to_epoll_events(_what);
+        ev.data.fd = _socket;
+
+        // descriptors get reused after close_socket, so don't trust the add/modify bookkeeping
+        if (::epoll_ctl(epoll_, EPOLL_CTL_MOD, _socket, &ev) != 0 && errno == ENOENT)
+            ::epoll_ctl(epoll_, EPOLL_CTL_ADD, _socket, &ev);
+    }
+
+    void curl_multi_epoll::set_timer(long _timeout_ms)
+    {
+        itimerspec spec = {};
+
+        if (_timeout_ms == 0)
+        {
+            // a zero itimerspec disarms the timer, so fire it as soon as possible instead
+            spec.it_value.tv_nsec = 1;
+        }
+        else if (_timeout_ms > 0)
+        {
+            spec.it_value.tv_sec = _timeout_ms / 1000;
+            spec.it_value.tv_nsec = (_timeout_ms % 1000) * 1000000;
+        }
+
+        ::timerfd_settime(timer_, 0, &spec, nullptr);
+    }
+}
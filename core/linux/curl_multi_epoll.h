@@ -0,0 +1,45 @@
+#pragma once
+
+#include <curl.h>
+
+namespace core
+{
+    // drives a curl multi handle through curl_multi_socket_action:
+    // epoll watches only the sockets curl asked for, a timerfd carries curl's timeout
+    // and an eventfd wakes the loop up from other threads.
+    // unlike select() there is no FD_SETSIZE limit and a wakeup costs O(ready sockets)
+    class curl_multi_epoll
+    {
+    public:
+        curl_multi_epoll();
+        ~curl_multi_epoll();
+
+        curl_multi_epoll(const curl_multi_epoll&) = delete;
+        curl_multi_epoll& operator=(const curl_multi_epoll&) = delete;
+
+        bool init();
+
+        // installs the socket and timer callbacks, has to be called for every new multi handle
+        void attach(CURLM* _multi);
+
+        // thread safe
+        void notify();
+
+        // waits up to _timeout and passes the ready sockets and the expired timer to curl
+        bool wait(std::chrono::milliseconds _timeout, int& _still_running);
+
+    private:
+        static int on_socket(CURL* _easy, curl_socket_t _socket, int _what, void* _userp, void* _socketp);
+        static int on_timer(CURLM* _multi, long _timeout_ms, void* _userp);
+
+        void watch(curl_socket_t _socket, int _what);
+        void set_timer(long _timeout_ms);
+        void close() noexcept;
+
+        CURLM* multi_ = nullptr;
+
+        int epoll_ = -1;
+        int timer_ = -1;
+        int event_ = -1;
+    };
+}
@@ -0,0 +1,303 @@
+#include "stdafx.h"
+
+#include "../utils.h"
+#include "ring_log.h"
+
+namespace
+{
+    constexpr char int_tag = 'i';
+    constexpr char string_tag = 's';
+}
+
+namespace core
+{
+    namespace log
+    {
+        int64_t ring_args::next_int() noexcept
+        {
+            int64_t value = 0;
+            if (data_.size() < sizeof(value) + 1 || data_.front() != int_tag)
+            {
+                im_assert(!"ring_log: int argument expected");
+                data_ = {};
+                return value;
+            }
+
+            memcpy(&value, data_.data() + 1, sizeof(value));
+            data_.remove_prefix(sizeof(value) + 1);
+            return value;
+        }
+
+        std::string_view ring_args::next_string() noexcept
+        {
+            uint32_t size = 0;
+            if (data_.size() < sizeof(size) + 1 || data_.front() != string_tag)
+            {
+                im_assert(!"ring_log: string argument expected");
+                data_ = {};
+                return {};
+            }
+
+            memcpy(&size, data_.data() + 1, sizeof(size));
+            data_.remove_prefix(sizeof(size) + 1);
+
+            const auto value = data_.substr(0, size);
+            data_.remove_prefix(value.size());
+            return value;
+        }
+
+        struct ring_log::record
+        {
+            int64_t time_;
+            uint32_t size_;
+            uint16_t format_;
+            uint16_t count_;
+            char payload_[112];
+
+            // continuation records of an entry are payload as a whole
+            static constexpr size_t first_payload = sizeof(payload_);
+            static constexpr size_t next_payload = 128;
+
+            static constexpr size_t count_for(size_t _size) noexcept
+            {
+                return _size <= first_payload ? 1 : 1 + (_size - first_payload + next_payload - 1) / next_payload;
+            }
+        };
+
+        // written by its thread only, read by the drainer only
+        struct ring_log::ring : tools::spsc_ring<record, 1024>
+        {
+            static constexpr uint64_t max_entry = capacity / 4;
+
+            explicit ring(std::thread::id _thread)
+                : thread_(_thread)
+            {
+            }
+
+            const std::thread::id thread_;
+        };
+
+        ring_log::ring_log(std::string_view _thread_name, formatter _formatter, sink _sink, std::chrono::milliseconds _interval)
+            : formatter_(std::move(_formatter))
+            , sink_(std::move(_sink))
+            , interval_(_interval)
+        {
+            im_assert(formatter_);
+            im_assert(sink_);
+
+            drain_thread_ = std::thread([this, name = std::string(_thread_name)]()
+            {
+                utils::set_this_thread_name(name);
+                drain_proc();
+            });
+        }
+
+        ring_log::~ring_log()
+        {
+            {
+                std::scoped_lock lock(drain_mutex_);
+                stop_ = true;
+            }
+            drain_condition_.notify_one();
+
+            if (drain_thread_.joinable())
+                drain_thread_.join();
+        }
+
+        void ring_log::write_text(std::string_view _text)
+        {
+            push(text_format, _text);
+        }
+
+        void ring_log::flush()
+        {
+            std::unique_lock lock(drain_mutex_);
+            const auto request = ++flush_requested_;
+            drain_condition_.notify_one();
+            flushed_condition_.wait(lock, [this, request]() { return flush_done_ >= request; });
+        }
+
+        void ring_log::append_arg(std::string& _buffer, int64_t _value)
+        {
+            _buffer += int_tag;
+            _buffer.append(reinterpret_cast<const char*>(&_value), sizeof(_value));
+        }
+
+        void ring_log::append_arg(std::string& _buffer, std::string_view _value)
+        {
+            const auto size = uint32_t(_value.size());
+            _buffer += string_tag;
+            _buffer.append(reinterpret_cast<const char*>(&size), sizeof(size));
+            _buffer.append(_value);
+        }
+
+        std::string& ring_log::args_buffer()
+        {
+            static thread_local std::string buffer;
+            return buffer;
+        }
+
+        void ring_log::push(uint16_t _format, std::string_view _payload)
+        {
+            static_assert(sizeof(record) == record::next_payload);
+            static_assert(std::is_trivially_copyable_v<record>);
+
+            const auto now = std::chrono::system_clock::now();
+            const auto count = record::count_for(_payload.size());
+
+            if (count > ring::max_entry)
+            {
+                std::scoped_lock lock(oversized_mutex_);
+                oversized_.push_back({ now, std::this_thread::get_id(), _format, std::string(_payload) });
+                return;
+            }
+
+            auto thread_ring = get_thread_ring();
+
+            uint64_t head = 0;
+            if (!thread_ring->begin_write(count, head))
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            auto& first = thread_ring->at(head);
+            first.time_ = now.time_since_epoch().count();
+            first.size_ = uint32_t(_payload.size());
+            first.format_ = _format;
+            first.count_ = uint16_t(count);
+
+            auto chunk = std::min(_payload.size(), record::first_payload);
+            memcpy(first.payload_, _payload.data(), chunk);
+            _payload.remove_prefix(chunk);
+
+            for (uint64_t i = 1; i < count; ++i)
+            {
+                chunk = std::min(_payload.size(), record::next_payload);
+                memcpy(&thread_ring->at(head + i), _payload.data(), chunk);
+                _payload.remove_prefix(chunk);
+            }
+
+            thread_ring->end_write(head + count);
+        }
+
+        ring_log::ring* ring_log::get_thread_ring()
+        {
+            return rings_.get_thread_ring([]() { return std::make_shared<ring>(std::this_thread::get_id()); });
+        }
+
+        void ring_log::drain_proc()
+        {
+            for (;;)
+            {
+                uint64_t request = 0;
+                bool stop = false;
+                {
+                    std::unique_lock lock(drain_mutex_);
+                    drain_condition_.wait_for(lock, interval_, [this]() { return stop_ || flush_requested_ != flush_done_; });
+                    request = flush_requested_;
+                    stop = stop_;
+                }
+
+                drain();
+
+                {
+                    std::scoped_lock lock(drain_mutex_);
+                    flush_done_ = request;
+                }
+                flushed_condition_.notify_all();
+
+                if (stop)
+                    return;
+            }
+        }
+
+        void ring_log::drain()
+        {
+            const auto rings = rings_.collect();
+
+            struct formatted
+            {
+                int64_t time_;
+                std::thread::id thread_;
+                size_t offset_;
+                size_t size_;
+            };
+
+            std::vector<formatted> records;
+            std::string text;
+            std::string payload;
+
+            const auto format = [this, &records, &text](int64_t _time, std::thread::id _thread, uint16_t _format, std::string_view _payload)
+            {
+                const auto offset = text.size();
+                if (_format == text_format)
+                {
+                    text.append(_payload);
+                }
+                else
+                {
+                    ring_args args(_payload);
+                    formatter_(_format, args, text);
+                }
+                records.push_back({ _time, _thread, offset, text.size() - offset });
+            };
+
+            for (const auto& ring : rings)
+            {
+                uint64_t tail = 0;
+                uint64_t head = 0;
+                ring->begin_read(tail, head);
+
+                while (tail < head)
+                {
+                    const auto& first = ring->at(tail);
+                    im_assert(first.count_ > 0 && tail + first.count_ <= head);
+
+                    size_t left = first.size_;
+                    auto chunk = std::min(left, record::first_payload);
+                    payload.assign(first.payload_, chunk);
+                    left -= chunk;
+
+                    for (uint64_t i = 1; i < first.count_; ++i)
+                    {
+                        chunk = std::min(left, record::next_payload);
+                        payload.append(reinterpret_cast<const char*>(&ring->at(tail + i)), chunk);
+                        left -= chunk;
+                    }
+
+                    format(first.time_, ring->thread_, first.format_, payload);
+                    tail += first.count_;
+                }
+
+                ring->end_read(tail);
+            }
+
+            std::vector<oversized> big;
+            {
+                std::scoped_lock lock(oversized_mutex_);
+                big.swap(oversized_);
+            }
+
+            for (const auto& item : big)
+                format(item.time_.time_since_epoch().count(), item.thread_, item.format_, item.payload_);
+
+            std::stable_sort(records.begin(), records.end(), [](const formatted& _l, const formatted& _r) { return _l.time_ < _r.time_; });
+
+            entries batch;
+            batch.reserve(records.size());
+            for (const auto& record : records)
+            {
+                const auto time = std::chrono::system_clock::time_point(std::chrono::system_clock::duration(record.time_));
+                batch.push_back({ time, record.thread_, std::string_view(text).substr(record.offset_, record.size_) });
+            }
+
+            const auto dropped = dropped_.load(std::memory_order_relaxed);
+            const auto dropped_now = dropped - reported_dropped_;
+            reported_dropped_ = dropped;
+
+            if (!batch.empty() || dropped_now > 0)
+                sink_(batch, dropped_now);
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "../tools/spsc_ring.h"
+
+namespace core
+{
+    namespace log
+    {
+        // arguments of a structured record, read in the order they were written
+        class ring_args
+        {
+        public:
+            explicit ring_args(std::string_view _data) noexcept : data_(_data) {}
+
+            bool empty() const noexcept { return data_.empty(); }
+
+            int64_t next_int() noexcept;
+            std::string_view next_string() noexcept;
+
+        private:
+            std::string_view data_;
+        };
+
+        // binary log with a lock-free ring buffer per writing thread
+        //
+        // a write copies a format id and its arguments into fixed-size records of the
+        // calling thread's ring, nothing is formatted or allocated there. a single drainer
+        // thread collects the rings, formats the records and passes them to the sink in
+        // batches ordered by time. a record that doesn't fit into a full ring is dropped
+        // and counted, the writer never waits for the drainer
+        class ring_log
+        {
+        public:
+            struct entry
+            {
+                std::chrono::system_clock::time_point time_;
+                std::thread::id thread_;
+                std::string_view text_;
+            };
+
+            using entries = std::vector<entry>;
+
+            // _args are the ones passed to write(), text records have no formatter call
+            using formatter = std::function<void(uint16_t _format, ring_args& _args, std::string& _out)>;
+            // called on the drainer thread, _dropped is the count since the previous call
+            using sink = std::function<void(const entries& _entries, int64_t _dropped)>;
+
+            static constexpr uint16_t text_format = 0;
+
+            ring_log(std::string_view _thread_name, formatter _formatter, sink _sink, std::chrono::milliseconds _interval = std::chrono::milliseconds(50));
+            ~ring_log();
+
+            ring_log(const ring_log&) = delete;
+            ring_log& operator=(const ring_log&) = delete;
+
+            void write_text(std::string_view _text);
+
+            template <typename ...Args>
+            void write(uint16_t _format, const Args&... _args);
+
+            // returns after everything written before the call has been passed to the sink
+            void flush();
+
+            int64_t get_dropped_count() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+        private:
+            struct record;
+            struct ring;
+
+            static void append_arg(std::string& _buffer, int64_t _value);
+            static void append_arg(std::string& _buffer, std::string_view _value);
+
+            static std::string& args_buffer();
+
+            void push(uint16_t _format, std::string_view _payload);
+            ring* get_thread_ring();
+
+            void drain_proc();
+            void drain();
+
+            const formatter formatter_;
+            const sink sink_;
+            const std::chrono::milliseconds interval_;
+
+            tools::thread_rings<ring> rings_;
+
+            // payloads too big for a ring, rare enough for a lock
+            struct oversized
+            {
+                std::chrono::system_clock::time_point time_;
+                std::thread::id thread_;
+                uint16_t format_;
+                std::string payload_;
+            };
+            std::mutex oversized_mutex_;
+            std::vector<oversized> oversized_;
+
+            std::atomic<int64_t> dropped_ = 0;
+            int64_t reported_dropped_ = 0;
+
+            std::mutex drain_mutex_;
+            std::condition_variable drain_condition_;
+            std::condition_variable flushed_condition_;
+            uint64_t flush_requested_ = 0;
+            uint64_t flush_done_ = 0;
+            bool stop_ = false;
+
+            std::thread drain_thread_;
+        };
+
+        template <typename ...Args>
+        void ring_log::write(uint16_t _format, const Args&... _args)
+        {
+            static_assert(sizeof...(_args) > 0);
+            im_assert(_format != text_format);
+
+            auto& buffer = args_buffer();
+            buffer.clear();
+
+            const auto append = [&buffer](const auto& _arg)
+            {
+                using arg_type = std::decay_t<decltype(_arg)>;
+                if constexpr (std::is_integral_v<arg_type> || std::is_enum_v<arg_type>)
+                    append_arg(buffer, int64_t(_arg));
+                else
+                    append_arg(buffer, std::string_view(_arg));
+            };
+            (append(_args), ...);
+
+            push(_format, buffer);
+        }
+    }
+}
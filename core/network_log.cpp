@@ -1,10 +1,10 @@
 #include "stdafx.h"
 #include "network_log.h"
-#include "async_task.h"
 #include "utils.h"
 #include "tools/system.h"
 #include "tools/coretime.h"
 #include "configuration/app_config.h"
+#include "../common.shared/string_utils.h"
 
 namespace core
 {
@@ -12,16 +12,58 @@ namespace core
     constexpr int64_t max_logs_size = max_file_size * 5;
     constexpr int64_t max_logs_size_full = max_file_size * 50;
 
+    void format_network_log_record(uint16_t _format, log::ring_args& _args, std::string& _out)
+    {
+        switch (net_log_format(_format))
+        {
+        case net_log_format::gui_message:
+        {
+            const auto message = _args.next_string();
+            const auto error = _args.next_int();
+            const auto contact = _args.next_string();
+            const auto msgid = _args.next_int();
+
+            _out += "GUI->CORE: message=";
+            _out += message;
+            if (error)
+            {
+                _out += " [";
+                _out += std::to_string(error);
+                _out += ']';
+            }
+            if (!contact.empty())
+            {
+                _out += " <";
+                _out += contact;
+                _out += '>';
+            }
+            if (msgid)
+            {
+                _out += ' ';
+                _out += std::to_string(msgid);
+            }
+            _out += "\r\n";
+            break;
+        }
+        default:
+            im_assert(!"unknown network log format");
+        }
+    }
+
     network_log::network_log(const boost::filesystem::wpath& _logs_directory)
-        :   write_thread_(std::make_unique<async_executer>("log")),
-            file_context_(std::make_shared<log_file_context>(_logs_directory))
+        :   file_context_(std::make_shared<log_file_context>(_logs_directory))
     {
         max_size_ = core::configuration::get_app_config().is_full_log_enabled() ? max_logs_size_full : max_logs_size;
+
+        ring_log_ = std::make_unique<log::ring_log>("log", format_network_log_record, [this](const log::ring_log::entries& _entries, int64_t _dropped)
+        {
+            write_entries(_entries, _dropped);
+        });
     }
 
     network_log::~network_log()
     {
-        write_thread_.reset();
+        ring_log_.reset();
     }
 
     bool create_logs_directory(const boost::filesystem::wpath& _logs_directory)
@@ -171,89 +213,113 @@ namespace core
         }
     }
 
-    void network_log::write_data(tools::binary_stream _data)
+    bool network_log::open_file()
     {
-        if (!_data.available())
+        if (file_context_->file_stream_)
+            return true;
+
+        if (file_context_->file_index_ < 0)
         {
-            im_assert(false);
-            return;
+            if (!create_logs_directory(file_context_->logs_directory_))
+                return false;
+
+            file_context_->file_index_ = get_log_index(file_context_->logs_directory_);
+        }
+        else
+        {
+            ++file_context_->file_index_;
         }
 
-        const auto current_time = std::chrono::time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now());
-        const auto current_thread_id = std::this_thread::get_id();
+        std::ios_base::openmode open_mode = std::fstream::binary | std::fstream::out | std::fstream::app;
 
-        auto file_context = file_context_;
-        auto file_names_history = &file_names_history_;
+        const auto file_path = get_file_path(file_context_->file_index_, file_context_->logs_directory_);
 
-        auto max_size = max_size_;
-        write_thread_->run_async_function([current_time, current_thread_id, bs_data = std::make_shared<tools::binary_stream>(std::move(_data)), file_context, file_names_history, max_size]()->int32_t
+        file_context_->file_stream_ = std::make_unique<boost::filesystem::ofstream>(file_path, open_mode);
+        if (!file_context_->file_stream_->good())
         {
-            if (!file_context->file_stream_)
-            {
-                if (file_context->file_index_ < 0)
-                {
-                    if (!create_logs_directory(file_context->logs_directory_))
-                        return -1;
+            file_context_->file_stream_.reset();
+            return false;
+        }
 
-                    file_context->file_index_ = get_log_index(file_context->logs_directory_);
-                }
-                else
-                {
-                    ++file_context->file_index_;
-                }
+        file_names_history_.push(file_path.wstring());
+        return true;
+    }
 
-                std::ios_base::openmode open_mode = std::fstream::binary | std::fstream::out | std::fstream::app;
+    // called on the ring_log thread with a batch of records, the file is flushed once per batch
+    void network_log::write_entries(const log::ring_log::entries& _entries, int64_t _dropped)
+    {
+        if (_dropped > 0 && open_file())
+        {
+            const auto line = su::concat("[network_log] ", std::to_string(_dropped), " records dropped\n");
+            file_context_->file_stream_->write(line.c_str(), line.length());
+        }
 
-                const auto file_path = get_file_path(file_context->file_index_, file_context->logs_directory_);
+        std::stringstream ss_header;
+        for (const auto& entry : _entries)
+        {
+            if (!open_file())
+                return;
 
-                file_context->file_stream_ = std::make_unique<boost::filesystem::ofstream>(file_path, open_mode);
-                if (!file_context->file_stream_->good())
-                {
-                    file_context->file_stream_.reset();
-                    return -1;
-                }
-                else
-                {
-                    file_names_history->push(file_path.wstring());
-                }
-            }
+            auto& stream = *file_context_->file_stream_;
 
-            std::stringstream ss_header;
-            const auto now_c = std::chrono::system_clock::to_time_t(current_time);
+            const auto time = std::chrono::time_point_cast<std::chrono::milliseconds>(entry.time_);
+            const auto now_c = std::chrono::system_clock::to_time_t(time);
 
             tm now_tm = { 0 };
             tools::time::localtime(&now_c, &now_tm);
 
-            const auto fraction = (current_time.time_since_epoch().count() % 1000);
-            ss_header << '[' << std::put_time<char>(&now_tm, "%c") << '.' << fraction << "].[" << current_thread_id << "]\n";
+            const auto fraction = (time.time_since_epoch().count() % 1000);
 
-            uint32_t data_size = bs_data->available();
+            ss_header.str(std::string());
+            ss_header << '[' << std::put_time<char>(&now_tm, "%c") << '.' << fraction << "].[" << entry.thread_ << "]\n";
 
             const auto header_string = ss_header.str();
-            file_context->file_stream_->write(header_string.c_str(), header_string.length());
-            file_context->file_stream_->write((const char*) bs_data->read(data_size), data_size);
-            file_context->file_stream_->put('\n');
-
-            file_context->file_stream_->flush();
+            stream.write(header_string.c_str(), header_string.length());
+            stream.write(entry.text_.data(), entry.text_.size());
+            stream.put('\n');
 
-            auto file_size = file_context->file_stream_->tellp();
-            if (file_size > max_file_size)
+            if (stream.tellp() > max_file_size)
             {
-                file_context->file_stream_->close();
-                file_context->file_stream_.reset();
+                stream.close();
+                file_context_->file_stream_.reset();
 
-                clean_logs(file_context->logs_directory_, max_size, true);
-                clean_logs(file_context->logs_directory_, max_size, false);
+                clean_logs(file_context_->logs_directory_, max_size_, true);
+                clean_logs(file_context_->logs_directory_, max_size_, false);
             }
+        }
 
-            return 0;
-        });
+        if (file_context_->file_stream_)
+            file_context_->file_stream_->flush();
+    }
+
+    void network_log::write_data(const tools::binary_stream& _data)
+    {
+        if (!_data.available())
+        {
+            im_assert(false);
+            return;
+        }
+
+        ring_log_->write_text(std::string_view(_data.get_data_for_log(), size_t(_data.available())));
     }
 
     void network_log::write_string(std::string_view _text)
     {
-        tools::binary_stream stream;
-        stream.write(_text);
-        write_data(std::move(stream));
+        ring_log_->write_text(_text);
+    }
+
+    void network_log::write_gui_message(std::string_view _message, int64_t _error, std::string_view _contact, int64_t _msgid)
+    {
+        ring_log_->write(uint16_t(net_log_format::gui_message), _message, _error, _contact, _msgid);
+    }
+
+    int64_t network_log::get_dropped_count() const
+    {
+        return ring_log_->get_dropped_count();
+    }
+
+    void network_log::flush()
+    {
+        ring_log_->flush();
     }
 }
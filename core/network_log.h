@@ -3,9 +3,15 @@
 
 #pragma once
 
+#include "log/ring_log.h"
+
 namespace core
 {
-    class async_executer;
+    // format ids of the structured network log records, log::ring_log::text_format is 0
+    enum class net_log_format : uint16_t
+    {
+        gui_message = 1, // message, error, contact, msgid
+    };
 
     struct log_file_context
     {
@@ -29,23 +35,34 @@ namespace core
 
     class network_log
     {
-        std::unique_ptr<async_executer> write_thread_;
-
         std::shared_ptr<log_file_context> file_context_;
 
         std::stack<std::wstring> file_names_history_;
 
+        std::unique_ptr<log::ring_log> ring_log_;
+
     public:
 
         network_log(const boost::filesystem::wpath& _logs_directory);
         virtual ~network_log();
 
-        void write_data(tools::binary_stream _data);
+        void write_data(const tools::binary_stream& _data);
         void write_string(std::string_view _text);
 
+        // GUI->CORE line without building it on the calling thread
+        void write_gui_message(std::string_view _message, int64_t _error, std::string_view _contact, int64_t _msgid);
+
+        int64_t get_dropped_count() const;
+
+        // writes the lines still in the rings to the file, returns when they are there
+        void flush();
+
         std::stack<std::wstring> file_names_history_copy() const { return file_names_history_; }
 
     private:
+        void write_entries(const log::ring_log::entries& _entries, int64_t _dropped);
+        bool open_file();
+
         int max_size_;
     };
 
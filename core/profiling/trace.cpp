@@ -0,0 +1,356 @@
+#include "stdafx.h"
+
+#include "../utils.h"
+#include "../tools/spsc_ring.h"
+#include "trace.h"
+
+namespace
+{
+    constexpr auto drain_interval = std::chrono::milliseconds(100);
+
+    struct event
+    {
+        const char* category_;
+        const char* name_;
+        int64_t start_;
+        int64_t duration_;
+        char detail_[32]; // zero terminated
+    };
+
+    // written by its thread only, read by the trace thread only
+    struct ring : core::tools::spsc_ring<event, 8192>
+    {
+        ring(uint64_t _tid, std::string _thread_name)
+            : tid_(_tid)
+            , thread_name_(std::move(_thread_name))
+        {
+        }
+
+        const uint64_t tid_;
+        const std::string thread_name_;
+
+        // the trace the thread name was written to, touched by the trace thread only
+        uint64_t named_in_ = 0;
+    };
+
+    thread_local std::string current_thread_name;
+
+    void append_escaped(std::string& _out, std::string_view _text)
+    {
+        for (const auto c : _text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                _out += '\\';
+                _out += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char code[8];
+                snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+                _out += code;
+            }
+            else
+            {
+                _out += c;
+            }
+        }
+    }
+
+    int64_t steady_now() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // trace timestamps are microseconds, keep the nanoseconds as the fraction
+    void append_us(std::string& _out, int64_t _ns)
+    {
+        char value[32];
+        snprintf(value, sizeof(value), "%lld.%03lld", static_cast<long long>(_ns / 1000), static_cast<long long>(_ns % 1000));
+        _out += value;
+    }
+
+    class tracer
+    {
+    public:
+        ~tracer()
+        {
+            stop();
+        }
+
+        bool start(const boost::filesystem::wpath& _file_name)
+        {
+            std::scoped_lock control_lock(control_mutex_);
+            if (thread_.joinable())
+                return false;
+
+            boost::system::error_code error;
+            if (_file_name.has_parent_path())
+                boost::filesystem::create_directories(_file_name.parent_path(), error);
+
+            auto file = std::make_unique<boost::filesystem::ofstream>(_file_name, std::ios::binary | std::ios::out | std::ios::trunc);
+            if (!file->is_open())
+                return false;
+
+            constexpr std::string_view header = "{\"traceEvents\":[";
+            file->write(header.data(), header.size());
+
+            file_ = std::move(file);
+            first_event_ = true;
+            ++trace_id_;
+            dropped_at_start_ = get_dropped_count();
+
+            // zones that began before the start are left out, as are the ones late for the previous trace
+            trace_start_ = core::profiler::trace::details::now();
+            steady_start_ = steady_now();
+            stop_ = false;
+
+            core::profiler::trace::details::enabled.store(true, std::memory_order_release);
+
+            thread_ = std::thread([this]()
+            {
+                core::utils::set_this_thread_name("trace");
+                write_proc();
+            });
+
+            return true;
+        }
+
+        void stop()
+        {
+            std::scoped_lock control_lock(control_mutex_);
+            if (!thread_.joinable())
+                return;
+
+            core::profiler::trace::details::enabled.store(false, std::memory_order_release);
+
+            {
+                std::scoped_lock lock(write_mutex_);
+                stop_ = true;
+            }
+            write_condition_.notify_one();
+
+            thread_.join();
+        }
+
+        ring* get_thread_ring()
+        {
+            return rings_.get_thread_ring([this]()
+            {
+                return std::make_shared<ring>(next_tid_.fetch_add(1, std::memory_order_relaxed), current_thread_name);
+            });
+        }
+
+        void add_dropped() noexcept
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        int64_t get_dropped_count() const noexcept
+        {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        void write_proc()
+        {
+            for (;;)
+            {
+                bool stop = false;
+                {
+                    std::unique_lock lock(write_mutex_);
+                    write_condition_.wait_for(lock, drain_interval, [this]() { return stop_; });
+                    stop = stop_;
+                }
+
+                drain();
+
+                if (stop)
+                {
+                    finish();
+                    return;
+                }
+            }
+        }
+
+        void drain()
+        {
+            const auto rings = rings_.collect();
+
+            // the counter rate is measured over the whole trace, it gets more precise with time
+            const auto ticks = core::profiler::trace::details::now() - trace_start_;
+            const auto elapsed = steady_now() - steady_start_;
+            const auto ns_per_tick = ticks > 0 && elapsed > 0 ? double(elapsed) / double(ticks) : 1.0;
+
+            std::string text;
+            for (const auto& ring : rings)
+            {
+                uint64_t tail = 0;
+                uint64_t head = 0;
+                ring->begin_read(tail, head);
+
+                for (; tail < head; ++tail)
+                {
+                    const auto& e = ring->at(tail);
+                    if (e.start_ < trace_start_)
+                        continue;
+
+                    if (ring->named_in_ != trace_id_)
+                    {
+                        ring->named_in_ = trace_id_;
+                        write_thread_name(text, *ring);
+                    }
+
+                    begin_event(text);
+                    text += "{\"name\":\"";
+                    text += e.name_;
+                    text += "\",\"cat\":\"";
+                    text += e.category_;
+                    text += "\",\"ph\":\"X\",\"ts\":";
+                    append_us(text, int64_t(double(e.start_ - trace_start_) * ns_per_tick));
+                    text += ",\"dur\":";
+                    append_us(text, int64_t(double(e.duration_) * ns_per_tick));
+                    text += ",\"pid\":1,\"tid\":";
+                    text += std::to_string(ring->tid_);
+                    if (e.detail_[0] != 0)
+                    {
+                        text += ",\"args\":{\"detail\":\"";
+                        append_escaped(text, e.detail_);
+                        text += "\"}";
+                    }
+                    text += '}';
+                }
+
+                ring->end_read(tail);
+            }
+
+            if (!text.empty())
+            {
+                file_->write(text.data(), text.size());
+                file_->flush();
+            }
+        }
+
+        void finish()
+        {
+            std::string text = "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_zones\":\"";
+            text += std::to_string(get_dropped_count() - dropped_at_start_);
+            text += "\"}}\n";
+
+            file_->write(text.data(), text.size());
+            file_.reset();
+        }
+
+        void begin_event(std::string& _text)
+        {
+            _text += first_event_ ? "\n" : ",\n";
+            first_event_ = false;
+        }
+
+        void write_thread_name(std::string& _text, const ring& _ring)
+        {
+            begin_event(_text);
+            _text += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+            _text += std::to_string(_ring.tid_);
+            _text += ",\"args\":{\"name\":\"";
+            if (_ring.thread_name_.empty())
+                _text += "thread " + std::to_string(_ring.tid_);
+            else
+                append_escaped(_text, _ring.thread_name_);
+            _text += "\"}}";
+        }
+
+        std::mutex control_mutex_;
+
+        core::tools::thread_rings<ring> rings_;
+        std::atomic<uint64_t> next_tid_ = 1;
+
+        std::atomic<int64_t> dropped_ = 0;
+        int64_t dropped_at_start_ = 0;
+
+        std::mutex write_mutex_;
+        std::condition_variable write_condition_;
+        bool stop_ = false;
+        std::thread thread_;
+
+        // used by the trace thread while it runs
+        std::unique_ptr<boost::filesystem::ofstream> file_;
+        bool first_event_ = true;
+        uint64_t trace_id_ = 0;
+        int64_t trace_start_ = 0;
+        int64_t steady_start_ = 0;
+    };
+
+    tracer& get_tracer()
+    {
+        static tracer instance;
+        return instance;
+    }
+}
+
+namespace core
+{
+    namespace profiler
+    {
+        namespace trace
+        {
+            bool start(const boost::filesystem::wpath& _file_name)
+            {
+                return get_tracer().start(_file_name);
+            }
+
+            void stop()
+            {
+                get_tracer().stop();
+            }
+
+            int64_t get_dropped_count() noexcept
+            {
+                return get_tracer().get_dropped_count();
+            }
+
+            void set_thread_name(std::string_view _name)
+            {
+                current_thread_name = _name;
+            }
+
+            namespace details
+            {
+                std::atomic<bool> enabled = false;
+
+                void record(const char* _category, const char* _name, std::string_view _detail, int64_t _start, int64_t _end) noexcept
+                {
+                    static_assert(sizeof(event) == 64);
+                    static_assert(std::is_trivially_copyable_v<event>);
+
+                    // the trace has been stopped while the zone was open
+                    if (!is_enabled())
+                        return;
+
+                    auto& tracer = get_tracer();
+                    auto thread_ring = tracer.get_thread_ring();
+
+                    uint64_t head = 0;
+                    if (!thread_ring->begin_write(1, head))
+                    {
+                        tracer.add_dropped();
+                        return;
+                    }
+
+                    auto& e = thread_ring->at(head);
+                    e.category_ = _category;
+                    e.name_ = _name;
+                    e.start_ = _start;
+                    e.duration_ = _end - _start;
+
+                    const auto size = std::min(_detail.size(), sizeof(e.detail_) - 1);
+                    if (size > 0)
+                        memcpy(e.detail_, _detail.data(), size);
+                    e.detail_[size] = 0;
+
+                    thread_ring->end_write(head + 1);
+                }
+            }
+        }
+    }
+}
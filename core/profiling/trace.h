@@ -0,0 +1,89 @@
+#pragma once
+
+#if defined(_M_X64) || defined(__x86_64__)
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #else
+        #include <x86intrin.h>
+    #endif
+#endif
+
+namespace core
+{
+    namespace profiler
+    {
+        // zones of work in the Chrome trace event format, open the file in chrome://tracing or ui.perfetto.dev
+        //
+        // a zone that ends while tracing is on is copied into the lock-free ring of its thread,
+        // nothing is locked, allocated or formatted there. the trace thread drains the rings into
+        // the file. a zone that finds its ring full is dropped and counted. _category and _name
+        // must be string literals, the changing part goes to _detail, it's cut to 31 bytes
+        namespace trace
+        {
+            // false if a trace is already being written or the file can't be created
+            bool start(const boost::filesystem::wpath& _file_name);
+
+            // writes the rest of the zones and closes the file
+            void stop();
+
+            int64_t get_dropped_count() noexcept;
+
+            // called by utils::set_this_thread_name, names the thread in the trace
+            void set_thread_name(std::string_view _name);
+
+            namespace details
+            {
+                extern std::atomic<bool> enabled;
+
+                // the time stamp counter is read in a few cycles, the trace thread converts it to nanoseconds.
+                // a steady clock read costs as much as the rest of the zone
+                inline int64_t now() noexcept
+                {
+#if defined(_M_X64) || defined(__x86_64__)
+                    return int64_t(__rdtsc());
+#else
+                    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+                }
+
+                void record(const char* _category, const char* _name, std::string_view _detail, int64_t _start, int64_t _end) noexcept;
+            }
+
+            inline bool is_enabled() noexcept { return details::enabled.load(std::memory_order_relaxed); }
+
+            class zone
+            {
+            public:
+                // _detail must outlive the zone
+                zone(const char* _category, const char* _name, std::string_view _detail = {}) noexcept
+                    : category_(_category)
+                    , name_(_name)
+                    , detail_(_detail)
+                    , start_(is_enabled() ? details::now() : -1)
+                {
+                }
+
+                ~zone()
+                {
+                    if (start_ >= 0)
+                        details::record(category_, name_, detail_, start_, details::now());
+                }
+
+                zone(const zone&) = delete;
+                zone& operator=(const zone&) = delete;
+
+            private:
+                const char* category_;
+                const char* name_;
+                std::string_view detail_;
+                int64_t start_;
+            };
+        }
+    }
+}
+
+#define PROFILER_CONCAT_IMPL(_a, _b) _a##_b
+#define PROFILER_CONCAT(_a, _b) PROFILER_CONCAT_IMPL(_a, _b)
+
+#define PROFILER_ZONE(_category, _name) core::profiler::trace::zone PROFILER_CONCAT(profiler_zone_, __LINE__)(_category, _name)
+#define PROFILER_ZONE_DETAIL(_category, _name, _detail) core::profiler::trace::zone PROFILER_CONCAT(profiler_zone_, __LINE__)(_category, _name, _detail)
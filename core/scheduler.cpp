@@ -3,50 +3,42 @@
 #include "async_task.h"
 #include "core.h"
 #include "utils.h"
+#include "profiling/trace.h"
 
 using namespace core;
 
+namespace
+{
+    // a periodic timer with zero timeout would spin the thread
+    constexpr auto min_periodic_timeout = std::chrono::milliseconds(1);
+
+    // the callback runs on the executor's thread, the zone goes with it
+    stacked_task traced(stacked_task _function)
+    {
+        if (!profiler::trace::is_enabled())
+            return _function;
+
+        return { [function = std::move(_function)]() mutable
+        {
+            PROFILER_ZONE("scheduler", "timer");
+            function.execute();
+        } };
+    }
+}
 
 scheduler::scheduler()
-    : is_stop_(false)
+    : scheduler([](stacked_task _task) { g_core->execute_core_context(std::move(_task)); })
+{
+}
+
+scheduler::scheduler(std::function<void(stacked_task)> _executor)
+    : executor_(std::move(_executor))
+    , is_stop_(false)
 {
     thread_ = std::make_unique<std::thread>([this]
     {
         utils::set_this_thread_name("scheduler");
-
-        constexpr auto tick_timeout = std::chrono::milliseconds(100);
-
-        for(;;)
-        {
-            decltype(timed_tasks_) tmp_list;
-            {
-                std::unique_lock<std::mutex> lock(mutex_);
-                const auto res = condition_.wait_for(lock, tick_timeout);
-                if (is_stop_)
-                    return;
-
-                if (res == std::cv_status::timeout)
-                {
-                    const auto current_time = std::chrono::steady_clock::now();
-
-                    for (auto timer_task = timed_tasks_.begin(); timer_task != timed_tasks_.end();)
-                    {
-                        if (current_time - timer_task->last_execute_time_ >= timer_task->timeout_)
-                        {
-                            timer_task->last_execute_time_ = current_time;
-                            g_core->execute_core_context(timer_task->function_);
-                            if (timer_task->single_shot_)
-                            {
-                                auto splice_it = timer_task++;
-                                tmp_list.splice(tmp_list.begin(), timed_tasks_, splice_it);
-                                continue;
-                            }
-                        }
-                        ++timer_task;
-                    }
-                }
-            }
-        }
+        run();
     });
 }
 
@@ -61,6 +53,77 @@ scheduler::~scheduler()
     thread_->join();
 }
 
+void scheduler::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    for (;;)
+    {
+        if (is_stop_)
+            return;
+
+        while (!deadlines_.empty() && timed_tasks_.count(deadlines_.front().id_) == 0)
+            pop_deadline();
+
+        if (deadlines_.empty())
+        {
+            condition_.wait(lock);
+            continue;
+        }
+
+        // sleep exactly until the nearest deadline, push_timer wakes us up if a nearer one comes
+        if (condition_.wait_until(lock, deadlines_.front().time_) == std::cv_status::no_timeout)
+            continue;
+
+        const auto current_time = clock::now();
+
+        while (!deadlines_.empty() && deadlines_.front().time_ <= current_time)
+        {
+            const auto deadline = deadlines_.front();
+            pop_deadline();
+
+            const auto it = timed_tasks_.find(deadline.id_);
+            if (it == timed_tasks_.end())
+                continue;
+
+            auto& timer_task = it->second;
+            if (timer_task.single_shot_)
+            {
+                executor_(traced(std::move(timer_task.function_)));
+                timed_tasks_.erase(it);
+                continue;
+            }
+
+            executor_(traced(timer_task.function_));
+
+            // keep the period without drift, but don't try to catch up after the process was suspended
+            auto next_time = deadline.time_ + timer_task.timeout_;
+            if (next_time <= current_time)
+                next_time = current_time + std::max(timer_task.timeout_, min_periodic_timeout);
+
+            push_deadline(next_time, deadline.id_);
+        }
+    }
+}
+
+void scheduler::push_deadline(clock::time_point _time, uint32_t _id)
+{
+    deadlines_.push_back({ _time, _id });
+    std::push_heap(deadlines_.begin(), deadlines_.end(), std::greater<>());
+}
+
+void scheduler::pop_deadline()
+{
+    std::pop_heap(deadlines_.begin(), deadlines_.end(), std::greater<>());
+    deadlines_.pop_back();
+}
+
+void scheduler::compact_deadlines()
+{
+    deadlines_.erase(std::remove_if(deadlines_.begin(), deadlines_.end(), [this](const auto& _deadline) { return timed_tasks_.count(_deadline.id_) == 0; }), deadlines_.end());
+    std::make_heap(deadlines_.begin(), deadlines_.end(), std::greater<>());
+}
+
 static uint32_t get_id()
 {
     static std::atomic<uint32_t> id(0);
@@ -74,18 +137,21 @@ uint32_t core::scheduler::push_timer(stacked_task _function, std::chrono::millis
     scheduler_timer_task timer_task;
     timer_task.function_ = std::move(_function);
     timer_task.timeout_ = _timeout;
-    timer_task.id_ = currentId;
-    timer_task.last_execute_time_ = std::chrono::steady_clock::now();
     timer_task.single_shot_ = _single_shot;
 
-    decltype(timed_tasks_) tmp_list;
-    tmp_list.push_back(std::move(timer_task));
+    const auto time = clock::now() + _timeout;
 
+    bool is_nearest = false;
     {
         std::scoped_lock lock(mutex_);
-        timed_tasks_.splice(timed_tasks_.end(), tmp_list, tmp_list.begin());
+        timed_tasks_.emplace(currentId, std::move(timer_task));
+        push_deadline(time, currentId);
+        is_nearest = deadlines_.front().id_ == currentId;
     }
 
+    if (is_nearest)
+        condition_.notify_one();
+
     return currentId;
 }
 
@@ -101,11 +167,14 @@ uint32_t core::scheduler::push_single_shot_timer(stacked_task _function, std::ch
 
 void core::scheduler::stop_timer(uint32_t _id)
 {
-    decltype(timed_tasks_) tmp_list;
+    // the task is destroyed out of the lock
+    decltype(timed_tasks_)::node_type node;
     {
         std::scoped_lock lock(mutex_);
-        const auto end = timed_tasks_.end();
-        if (const auto it = std::find_if(timed_tasks_.begin(), end, [_id](const auto& x) { return x.id_ == _id; }); it != end)
-            tmp_list.splice(tmp_list.begin(), timed_tasks_, it);
+        node = timed_tasks_.extract(_id);
+
+        // the deadline stays in the heap until it surfaces, don't let long stopped timers pile up
+        if (!node.empty() && deadlines_.size() > 2 * timed_tasks_.size() + 64)
+            compact_deadlines();
     }
 }
\ No newline at end of file
@@ -10,17 +10,33 @@ namespace core
 
     class scheduler
     {
+        using clock = std::chrono::steady_clock;
+
         struct scheduler_timer_task
         {
-            std::chrono::steady_clock::time_point last_execute_time_;
-            uint32_t id_ = 0;
             std::chrono::milliseconds timeout_ = std::chrono::milliseconds(0);
             stacked_task function_;
             bool single_shot_ = false;
         };
 
+        struct timer_deadline
+        {
+            clock::time_point time_;
+            uint32_t id_ = 0;
+
+            bool operator>(const timer_deadline& _other) const noexcept
+            {
+                return std::tie(time_, id_) > std::tie(_other.time_, _other.id_);
+            }
+        };
+
         std::unique_ptr<std::thread> thread_;
-        std::list<scheduler_timer_task> timed_tasks_;
+        std::unordered_map<uint32_t, scheduler_timer_task> timed_tasks_;
+
+        // min-heap on the deadline, entries of stopped timers are skipped when they surface
+        std::vector<timer_deadline> deadlines_;
+
+        std::function<void(stacked_task)> executor_;
 
         std::mutex mutex_;
         std::condition_variable condition_;
@@ -28,6 +44,11 @@ namespace core
 
         uint32_t push_timer(stacked_task _function, std::chrono::milliseconds _timeout, bool _single_shot);
 
+        void run();
+        void push_deadline(clock::time_point _time, uint32_t _id);
+        void pop_deadline();
+        void compact_deadlines();
+
     public:
 
         uint32_t push_timer(stacked_task _function, std::chrono::milliseconds _timeout);
@@ -36,6 +57,9 @@ namespace core
         void stop_timer(uint32_t _id);
 
         scheduler();
+
+        // _executor gets the fired tasks on the scheduler thread, the default one posts them to the core thread
+        explicit scheduler(std::function<void(stacked_task)> _executor);
         virtual ~scheduler();
     };
 
@@ -16,6 +16,7 @@ enum class stat_type
     cached_emojis,
     cached_stickers,
     video_player_initialization,
+    cached_archives,
     invalid
 };
 
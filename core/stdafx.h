@@ -100,6 +100,7 @@ do { if(!(condition)){ std::cerr << "ASSERT FAILED: " << #condition << " " << __
 #include "../common.shared/typedefs.h"
 
 #include "tools/tlv.h"
+#include "tools/tlv_view.h"
 #include "tools/binary_stream.h"
 #include "tools/binary_stream_reader.h"
 #include "tools/scope.h"
@@ -117,19 +117,30 @@ namespace core::tasks
             task_data parsed_task;
             parsed_task.unserialize(task_json);
 
-            const auto& id = parsed_task.id_;
-            im_assert(!id.empty());
-            if (id.empty())
+            im_assert(!parsed_task.id_.empty());
+            if (parsed_task.id_.empty())
                 continue;
 
-            auto& task = tasks_[id];
-            if (task.is_empty() || task.params_.last_change_ < parsed_task.params_.last_change_)
-                task = std::move(parsed_task);
+            merge_task(std::move(parsed_task));
         }
 
         return 0;
     }
 
+    void task_storage::merge(task_storage&& _other)
+    {
+        for (auto& [_, task] : _other.tasks_)
+            merge_task(std::move(task));
+        _other.tasks_.clear();
+    }
+
+    void task_storage::merge_task(task_data&& _task)
+    {
+        auto& task = tasks_[_task.id_];
+        if (task.is_empty() || task.params_.last_change_ < _task.params_.last_change_)
+            task = std::move(_task);
+    }
+
     void task_storage::erase_old_tasks()
     {
         const auto threshold_time = std::chrono::system_clock::now() - features::task_cache_lifetime();
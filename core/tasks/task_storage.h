@@ -28,6 +28,9 @@ namespace core
             bool apply_thread_update(const core::archive::thread_update& _thread_update);
 
             int32_t load(std::wstring_view _filename);
+
+            // keeps the newer of the tasks present in both
+            void merge(task_storage&& _other);
             void serialize(rapidjson::Value& _node, rapidjson_allocator& _a) const;
 
             void serialize(icollection* _collection) const;
@@ -36,6 +39,8 @@ namespace core
             void set_changed(bool _changed);
 
         private:
+            void merge_task(task_data&& _task);
+
             std::unordered_map<std::string, task_data> tasks_;
             bool changed_ = false;
         };
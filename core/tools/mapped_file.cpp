@@ -0,0 +1,159 @@
+#include "stdafx.h"
+#include "mapped_file.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace core;
+using namespace tools;
+
+mapped_file::mapped_file(std::wstring _file_name)
+    : file_name_(std::move(_file_name))
+{
+}
+
+mapped_file::~mapped_file()
+{
+    close();
+}
+
+bool mapped_file::open()
+{
+    if (is_open())
+        return true;
+
+#ifdef _WIN32
+    file_ = ::CreateFileW(file_name_.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE)
+        return false;
+#else
+    file_ = ::open(tools::from_utf16(file_name_).c_str(), O_RDONLY | O_CLOEXEC);
+    if (file_ == -1)
+        return false;
+#endif
+
+    if (!remap())
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void mapped_file::close() noexcept
+{
+    unmap();
+
+#ifdef _WIN32
+    if (file_ != INVALID_HANDLE_VALUE)
+    {
+        ::CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (file_ != -1)
+    {
+        ::close(file_);
+        file_ = -1;
+    }
+#endif
+}
+
+bool mapped_file::is_open() const noexcept
+{
+#ifdef _WIN32
+    return file_ != INVALID_HANDLE_VALUE;
+#else
+    return file_ != -1;
+#endif
+}
+
+int64_t mapped_file::get_file_size() const noexcept
+{
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(file_, &size))
+        return -1;
+    return size.QuadPart;
+#else
+    struct stat st;
+    if (::fstat(file_, &st) != 0)
+        return -1;
+    return st.st_size;
+#endif
+}
+
+void mapped_file::unmap() noexcept
+{
+#ifdef _WIN32
+    if (data_)
+        ::UnmapViewOfFile(data_);
+
+    if (mapping_)
+    {
+        ::CloseHandle(mapping_);
+        mapping_ = nullptr;
+    }
+#else
+    if (data_)
+        ::munmap(const_cast<char*>(data_), size_);
+#endif
+
+    data_ = nullptr;
+    size_ = 0;
+}
+
+bool mapped_file::remap()
+{
+    if (!is_open())
+        return false;
+
+    const auto file_size = get_file_size();
+    if (file_size < 0)
+        return false;
+
+    if (file_size == size_ && (data_ || file_size == 0))
+        return true;
+
+    unmap();
+
+    // an empty file can't be mapped, keep it open and map it once it grows
+    if (file_size == 0)
+        return true;
+
+#ifdef _WIN32
+    mapping_ = ::CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_)
+        return false;
+
+    auto data = ::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        ::CloseHandle(mapping_);
+        mapping_ = nullptr;
+        return false;
+    }
+#else
+    auto data = ::mmap(nullptr, file_size, PROT_READ, MAP_SHARED, file_, 0);
+    if (data == MAP_FAILED)
+        return false;
+#endif
+
+    data_ = static_cast<const char*>(data);
+    size_ = file_size;
+
+    return true;
+}
+
+std::string_view mapped_file::view(int64_t _offset, int64_t _size) const noexcept
+{
+    if (!data_ || _offset < 0 || _size < 0 || _offset + _size > size_)
+        return {};
+
+    return std::string_view(data_ + _offset, _size);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+namespace core
+{
+    namespace tools
+    {
+        // read-only memory mapping of a whole file
+        // the file may be appended by another writer; call remap() to pick up the new tail
+        class mapped_file : boost::noncopyable
+        {
+            const std::wstring file_name_;
+
+            const char* data_ = nullptr;
+            int64_t size_ = 0;
+
+#ifdef _WIN32
+            HANDLE file_ = INVALID_HANDLE_VALUE;
+            HANDLE mapping_ = nullptr;
+#else
+            int file_ = -1;
+#endif
+
+            void unmap() noexcept;
+            int64_t get_file_size() const noexcept;
+
+        public:
+
+            explicit mapped_file(std::wstring _file_name);
+            ~mapped_file();
+
+            bool open();
+            void close() noexcept;
+            bool remap();
+
+            bool is_open() const noexcept;
+
+            const char* data() const noexcept { return data_; }
+            int64_t size() const noexcept { return size_; }
+
+            std::string_view view(int64_t _offset, int64_t _size) const noexcept;
+        };
+    }
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+namespace core
+{
+    namespace tools
+    {
+        // single producer single consumer ring of trivially copyable items
+        //
+        // the writing thread reserves room with begin_write, fills the items and publishes
+        // them with end_write. the reading thread gets the published range with begin_read
+        // and frees it with end_read. neither side locks or waits for the other
+        template <typename T, uint64_t Capacity>
+        class spsc_ring
+        {
+            static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+            static_assert(std::is_trivially_copyable_v<T>);
+
+        public:
+            static constexpr uint64_t capacity = Capacity;
+
+            spsc_ring()
+                : items_(std::make_unique<T[]>(Capacity))
+            {
+            }
+
+            spsc_ring(const spsc_ring&) = delete;
+            spsc_ring& operator=(const spsc_ring&) = delete;
+
+            T& at(uint64_t _position) noexcept { return items_[_position & (Capacity - 1)]; }
+            const T& at(uint64_t _position) const noexcept { return items_[_position & (Capacity - 1)]; }
+
+            // writer: false if _count items don't fit, otherwise _head is the position of the first one
+            bool begin_write(uint64_t _count, uint64_t& _head) const noexcept
+            {
+                _head = head_.load(std::memory_order_relaxed);
+                const auto tail = tail_.load(std::memory_order_acquire);
+                return _head + _count - tail <= Capacity;
+            }
+
+            void end_write(uint64_t _head) noexcept { head_.store(_head, std::memory_order_release); }
+
+            // reader: the items in [_tail, _head) are published
+            void begin_read(uint64_t& _tail, uint64_t& _head) const noexcept
+            {
+                _tail = tail_.load(std::memory_order_relaxed);
+                _head = head_.load(std::memory_order_acquire);
+            }
+
+            void end_read(uint64_t _tail) noexcept { tail_.store(_tail, std::memory_order_release); }
+
+            // the writing thread has exited and everything it wrote has been read
+            bool is_abandoned() const noexcept
+            {
+                return orphaned_.load(std::memory_order_acquire) && head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_relaxed);
+            }
+
+            void set_orphaned() noexcept { orphaned_.store(true, std::memory_order_release); }
+
+        private:
+            const std::unique_ptr<T[]> items_;
+
+            alignas(64) std::atomic<uint64_t> head_ = 0;
+            alignas(64) std::atomic<uint64_t> tail_ = 0;
+            std::atomic<bool> orphaned_ = false;
+        };
+
+        // the rings of the writing threads of one reader, Ring is an spsc_ring or derives from it
+        //
+        // a thread gets its ring created on the first get_thread_ring, the ring is marked orphaned
+        // when the thread exits and is dropped by collect once it is read to the end
+        template <typename Ring>
+        class thread_rings
+        {
+        public:
+            thread_rings()
+                : id_(next_id().fetch_add(1, std::memory_order_relaxed))
+            {
+            }
+
+            thread_rings(const thread_rings&) = delete;
+            thread_rings& operator=(const thread_rings&) = delete;
+
+            // _make is called on the first use by the thread and returns std::shared_ptr<Ring>
+            template <typename Maker>
+            Ring* get_thread_ring(Maker&& _make)
+            {
+                static thread_local local_rings local;
+                if (auto existing = local.find(id_))
+                    return existing;
+
+                std::shared_ptr<Ring> created = _make();
+                {
+                    std::scoped_lock lock(mutex_);
+                    rings_.push_back(created);
+                }
+
+                local.add(id_, created);
+                return created.get();
+            }
+
+            // for the reader, the rings of the exited threads read to the end are dropped
+            std::vector<std::shared_ptr<Ring>> collect()
+            {
+                std::scoped_lock lock(mutex_);
+                rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const auto& _ring) { return _ring->is_abandoned(); }), rings_.end());
+                return rings_;
+            }
+
+        private:
+            // rings of the current thread by owner, marked orphaned when the thread exits
+            class local_rings
+            {
+            public:
+                ~local_rings()
+                {
+                    for (auto& [_, ring] : rings_)
+                        ring->set_orphaned();
+                }
+
+                Ring* find(uint64_t _owner_id) const noexcept
+                {
+                    for (const auto& [id, ring] : rings_)
+                    {
+                        if (id == _owner_id)
+                            return ring.get();
+                    }
+                    return nullptr;
+                }
+
+                void add(uint64_t _owner_id, std::shared_ptr<Ring> _ring)
+                {
+                    // the rings of destroyed owners aren't held by anyone else
+                    rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const auto& _item) { return _item.second.use_count() == 1; }), rings_.end());
+                    rings_.emplace_back(_owner_id, std::move(_ring));
+                }
+
+            private:
+                std::vector<std::pair<uint64_t, std::shared_ptr<Ring>>> rings_;
+            };
+
+            static std::atomic<uint64_t>& next_id() noexcept
+            {
+                static std::atomic<uint64_t> id = 1;
+                return id;
+            }
+
+            const uint64_t id_;
+
+            std::mutex mutex_;
+            std::vector<std::shared_ptr<Ring>> rings_;
+        };
+    }
+}
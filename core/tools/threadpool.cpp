@@ -5,6 +5,7 @@
 
 #include "../core.h"
 #include "../network_log.h"
+#include "../profiling/trace.h"
 
 #ifndef STRIP_CRASH_HANDLER
 #include "../common.shared/crash_report/crash_reporter.h"
@@ -13,6 +14,13 @@
 using namespace core;
 using namespace tools;
 
+namespace
+{
+    // lets a task pushed from a worker land in that worker's own queue
+    thread_local const threadpool* current_pool = nullptr;
+    thread_local size_t current_worker = 0;
+}
+
 task::task()
     : id_(-1)
     , time_stamp_(std::chrono::steady_clock::now())
@@ -63,20 +71,37 @@ threadpool::threadpool(
     const std::string_view _name,
     const size_t count,
     std::function<void()> _on_thread_exit,
-    bool _task_trace)
+    bool _task_trace,
+    threadpool_mode _mode)
 
     : on_task_finish_([](std::chrono::milliseconds, const stack_vec&, std::string_view) {})
+    , mode_(_mode)
+    , next_queue_(0)
+    , pending_count_(0)
+    , front_count_(0)
+    , sleeping_count_(0)
     , stop_(false)
     , task_trace_(_task_trace)
+    , stats_(_name, count)
 {
     creator_thread_id_ = std::this_thread::get_id();
 
     threads_.reserve(count);
     threads_ids_.reserve(count);
 
-    const auto worker = [this, _on_thread_exit, name = std::string(_name)]
+    if (mode_ == threadpool_mode::work_stealing)
+    {
+        worker_queues_.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+            worker_queues_.push_back(std::make_unique<worker_queue>());
+    }
+
+    const auto worker = [this, _on_thread_exit, name = std::string(_name)](size_t _worker)
     {
         utils::set_this_thread_name(name);
+
+        current_pool = this;
+        current_worker = _worker;
 #ifndef STRIP_CRASH_HANDLER
 #ifdef _WIN32
     crash_system::reporter::instance().set_thread_exception_handlers();
@@ -85,7 +110,7 @@ threadpool::threadpool(
 
         for(;;)
         {
-            if (!run_task())
+            if (!run_task(_worker))
                 break;
         }
 
@@ -95,31 +120,134 @@ threadpool::threadpool(
 
     for (size_t i = 0; i < count; ++i)
     {
-        threads_.emplace_back(worker);
+        threads_.emplace_back(worker, i);
         threads_ids_.emplace_back(threads_[i].get_id());
     }
 }
 
-bool threadpool::run_task_impl()
+bool threadpool::take_task(size_t _worker, task& _task, size_t& _queue_depth)
 {
-    task next_task;
+    if (mode_ == threadpool_mode::work_stealing)
+        return take_stealing_task(_worker, _task, _queue_depth);
+
+    return take_shared_task(_task, _queue_depth);
+}
+
+bool threadpool::take_shared_task(task& _task, size_t& _queue_depth)
+{
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+
+    while (!(stop_ || !tasks_.empty()))
     {
-        std::unique_lock<std::mutex> lock(queue_mutex_);
+       condition_.wait(lock);
+    }
+
+    if (stop_ && tasks_.empty())
+    {
+        return false;
+    }
+
+    _task = std::move(tasks_.front());
+
+    tasks_.pop_front();
+    _queue_depth = tasks_.size();
+
+    return true;
+}
 
-        while (!(stop_ || !tasks_.empty()))
+bool threadpool::try_take_stealing_task(size_t _worker, task& _task)
+{
+    if (front_count_ > 0)
+    {
+        std::scoped_lock lock(queue_mutex_);
+        if (!tasks_.empty())
         {
-           condition_.wait(lock);
+            _task = std::move(tasks_.front());
+            tasks_.pop_front();
+            --front_count_;
+            return true;
         }
+    }
 
-        if (stop_ && tasks_.empty())
+    // own queue first, then the neighbours starting from the next one
+    const auto count = worker_queues_.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto& queue = *worker_queues_[(_worker + i) % count];
+
+        std::scoped_lock lock(queue.mutex_);
+        if (!queue.tasks_.empty())
         {
-            return false;
+            _task = std::move(queue.tasks_.front());
+            queue.tasks_.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool threadpool::take_stealing_task(size_t _worker, task& _task, size_t& _queue_depth)
+{
+    for (;;)
+    {
+        if (pending_count_ > 0 && try_take_stealing_task(_worker, _task))
+        {
+            _queue_depth = --pending_count_;
+            return true;
         }
 
-        next_task = std::move(tasks_.front());
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+
+        // pushers only take the mutex when somebody sleeps, see wake_up_worker
+        ++sleeping_count_;
+        condition_.wait(lock, [this]() { return stop_ || pending_count_ > 0; });
+        --sleeping_count_;
+
+        if (stop_ && pending_count_ == 0)
+            return false;
+    }
+}
+
+void threadpool::wake_up_worker()
+{
+    if (sleeping_count_ == 0)
+        return;
+
+    {
+        std::scoped_lock lock(queue_mutex_);
+    }
+
+    condition_.notify_one();
+}
+
+bool threadpool::push_to_worker_queue(task _task)
+{
+    const auto count = worker_queues_.size();
+    const auto index = (current_pool == this) ? current_worker : (next_queue_++ % count);
+
+    auto& queue = *worker_queues_[index];
 
-        tasks_.pop_front();
+    // counted before it is published: a worker may take the task as soon as the lock is released
+    // and pending_count_ must not go below zero
+    ++pending_count_;
+    {
+        std::scoped_lock lock(queue.mutex_);
+        queue.tasks_.push_back(std::move(_task));
     }
+
+    wake_up_worker();
+
+    return true;
+}
+
+bool threadpool::run_task_impl(size_t _worker)
+{
+    task next_task;
+    size_t queue_depth = 0;
+    if (!take_task(_worker, next_task, queue_depth))
+        return false;
+
     if (next_task)
     {
         const auto start_time = std::chrono::steady_clock::now();
@@ -133,10 +261,18 @@ bool threadpool::run_task_impl()
             g_core->write_string_to_network_log(ss.str());
         }
 
-        next_task.execute();
+        {
+            PROFILER_ZONE_DETAIL("threadpool", "task", next_task.get_name());
+            next_task.execute();
+        }
 
         const auto finish_time = std::chrono::steady_clock::now();
 
+        stats_.on_task(
+            _worker, next_task.get_name(), queue_depth,
+            std::chrono::duration_cast<std::chrono::microseconds>(start_time - next_task.get_time_stamp()),
+            std::chrono::duration_cast<std::chrono::microseconds>(finish_time - start_time));
+
         on_task_finish_(
             std::chrono::duration_cast<std::chrono::milliseconds>(finish_time - start_time),
             next_task.get_stack_trace(), next_task.get_name());
@@ -157,15 +293,15 @@ bool threadpool::run_task_impl()
     return true;
 }
 
-bool threadpool::run_task()
+bool threadpool::run_task(size_t _worker)
 {
     if constexpr (!core::dump::is_crash_handle_enabled() || !platform::is_windows())
-        return run_task_impl();
+        return run_task_impl(_worker);
 #ifndef STRIP_CRASH_HANDLER
 #ifdef _WIN32
     __try
     {
-        return run_task_impl();
+        return run_task_impl(_worker);
     }
     __except (crash_system::reporter::seh_handler(GetExceptionInformation()))
     {
@@ -173,7 +309,7 @@ bool threadpool::run_task()
 #endif // _WIN32
     return true;
 #else
-    return run_task_impl();
+    return run_task_impl(_worker);
 #endif // !STRIP_CRASH_HANDLER
 }
 
@@ -186,6 +322,10 @@ threadpool::~threadpool()
 
     stop_ = true;
 
+    {
+        std::scoped_lock lock(queue_mutex_);
+    }
+
     condition_.notify_all();
 
     for (auto &worker: threads_)
@@ -197,6 +337,14 @@ threadpool::~threadpool()
 
 bool threadpool::push_back(stacked_task _task, int64_t _id, std::string_view _name, std::function<bool()> _cancel)
 {
+    if (mode_ == threadpool_mode::work_stealing)
+    {
+        if (stop_)
+            return false;
+
+        return push_to_worker_queue(task(std::move(_task), _id, _name, std::chrono::steady_clock::now(), std::move(_cancel)));
+    }
+
     {
         std::unique_lock<std::mutex> lock(queue_mutex_);
         if (stop_)
@@ -216,6 +364,24 @@ void threadpool::raise_task(int64_t _id)
         return;
 
     std::unique_lock<std::mutex> lock(queue_mutex_);
+
+    if (mode_ == threadpool_mode::work_stealing)
+    {
+        for (auto& queue : worker_queues_)
+        {
+            std::scoped_lock queue_lock(queue->mutex_);
+
+            const auto it = std::find_if(queue->tasks_.begin(), queue->tasks_.end(), [_id](const auto& _task) { return _task.get_id() == _id; });
+            if (it != queue->tasks_.end())
+            {
+                tasks_.push_front(std::move(*it));
+                queue->tasks_.erase(it);
+                ++front_count_;
+                return;
+            }
+        }
+    }
+
     if (tasks_.size() <= 1)
         return;
 
@@ -245,6 +411,12 @@ bool threadpool::push_front(stacked_task _task, int64_t _id, std::string_view _n
             return false;
 
         tasks_.emplace_front(std::move(_task), _id, std::move(_name), std::chrono::steady_clock::now(), std::move(_cancel));
+
+        if (mode_ == threadpool_mode::work_stealing)
+        {
+            ++front_count_;
+            ++pending_count_;
+        }
     }
 
     condition_.notify_one();
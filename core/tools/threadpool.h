@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../core.h"
+#include "threadpool_stats.h"
 namespace core
 {
     namespace tools
@@ -38,6 +39,16 @@ namespace core
 
         using finish_action = std::function<void(std::chrono::milliseconds, const stack_vec&, std::string_view _name)>;
 
+        enum class threadpool_mode
+        {
+            // all the workers share one queue under one mutex
+            shared_queue,
+
+            // every worker has its own queue and steals from the others when it runs dry,
+            // push_front and raised tasks go to the shared queue which is always checked first
+            work_stealing
+        };
+
         class threadpool : boost::noncopyable
         {
             std::thread::id creator_thread_id_;
@@ -50,7 +61,8 @@ namespace core
                 const std::string_view _name,
                 const size_t _count,
                 std::function<void()> _on_thread_exit = std::function<void()>(),
-                bool _task_trace = false);
+                bool _task_trace = false,
+                threadpool_mode _mode = threadpool_mode::shared_queue);
 
             virtual ~threadpool();
 
@@ -61,20 +73,48 @@ namespace core
 
             const std::vector<std::thread::id>& get_threads_ids() const;
 
+            const threadpool_stats& get_stats() const noexcept { return stats_; }
+
         protected:
 
+            struct worker_queue
+            {
+                std::mutex mutex_;
+                std::deque<task> tasks_;
+            };
+
             std::vector<std::thread> threads_;
             std::vector<std::thread::id> threads_ids_;
             std::mutex queue_mutex_;
             std::condition_variable condition_;
             std::deque<task> tasks_;
 
+            const threadpool_mode mode_;
+
+            // work_stealing only
+            std::vector<std::unique_ptr<worker_queue>> worker_queues_;
+            std::atomic<size_t> next_queue_;
+            std::atomic<size_t> pending_count_;
+            std::atomic<size_t> front_count_;
+            std::atomic<size_t> sleeping_count_;
+
             std::atomic<bool> stop_;
 
             bool task_trace_;
 
-            bool run_task_impl();
-            bool run_task();
+            threadpool_stats stats_;
+
+            // _queue_depth is the count of tasks left in the queues
+            bool take_task(size_t _worker, task& _task, size_t& _queue_depth);
+            bool take_shared_task(task& _task, size_t& _queue_depth);
+            bool take_stealing_task(size_t _worker, task& _task, size_t& _queue_depth);
+            bool try_take_stealing_task(size_t _worker, task& _task);
+
+            bool push_to_worker_queue(task _task);
+            void wake_up_worker();
+
+            bool run_task_impl(size_t _worker);
+            bool run_task(size_t _worker);
 
             void set_task_finish_callback(finish_action _on_task_finish);
         };
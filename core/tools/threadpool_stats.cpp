@@ -0,0 +1,172 @@
+#include "stdafx.h"
+
+#include "threadpool_stats.h"
+
+namespace
+{
+    constexpr std::string_view unnamed_task = "unnamed";
+
+    std::mutex& registry_mutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    std::vector<const core::tools::threadpool_stats*>& registry()
+    {
+        static std::vector<const core::tools::threadpool_stats*> pools;
+        return pools;
+    }
+}
+
+namespace core
+{
+    namespace tools
+    {
+        void log2_histogram::add(uint64_t _value) noexcept
+        {
+            ++buckets_[bucket_of(_value)];
+            ++count_;
+            sum_ += _value;
+            max_ = std::max(max_, _value);
+        }
+
+        void log2_histogram::merge(const log2_histogram& _other) noexcept
+        {
+            for (size_t i = 0; i < buckets_count; ++i)
+                buckets_[i] += _other.buckets_[i];
+
+            count_ += _other.count_;
+            sum_ += _other.sum_;
+            max_ = std::max(max_, _other.max_);
+        }
+
+        uint64_t log2_histogram::get_percentile(double _share) const noexcept
+        {
+            if (count_ == 0)
+                return 0;
+
+            const auto rank = std::max<uint64_t>(1, uint64_t(std::ceil(std::clamp(_share, 0.0, 1.0) * double(count_))));
+
+            uint64_t seen = 0;
+            for (size_t i = 0; i < buckets_count; ++i)
+            {
+                seen += buckets_[i];
+                if (seen >= rank)
+                    return std::min(bucket_limit(i), max_);
+            }
+
+            return max_;
+        }
+
+        size_t log2_histogram::bucket_of(uint64_t _value) noexcept
+        {
+            size_t bucket = 0;
+            while (_value != 0 && bucket < buckets_count - 1)
+            {
+                _value >>= 1;
+                ++bucket;
+            }
+            return bucket;
+        }
+
+        uint64_t log2_histogram::bucket_limit(size_t _bucket) noexcept
+        {
+            if (_bucket >= buckets_count - 1)
+                return std::numeric_limits<uint64_t>::max();
+
+            return uint64_t(1) << _bucket;
+        }
+
+        double threadpool_stats_snapshot::get_busy_share() const noexcept
+        {
+            const auto available_us = double(std::chrono::duration_cast<std::chrono::microseconds>(uptime_).count()) * double(threads_count_);
+            if (available_us <= 0)
+                return 0;
+
+            uint64_t busy_us = 0;
+            for (const auto& [_, stats] : tasks_)
+                busy_us += stats.run_us_.get_sum();
+
+            return std::min(1.0, double(busy_us) / available_us);
+        }
+
+        threadpool_stats::threadpool_stats(std::string_view _name, size_t _threads_count)
+            : name_(_name)
+            , created_(std::chrono::steady_clock::now())
+        {
+            workers_.reserve(_threads_count);
+            for (size_t i = 0; i < _threads_count; ++i)
+                workers_.push_back(std::make_unique<worker>());
+
+            std::scoped_lock lock(registry_mutex());
+            registry().push_back(this);
+        }
+
+        threadpool_stats::~threadpool_stats()
+        {
+            std::scoped_lock lock(registry_mutex());
+            auto& pools = registry();
+            pools.erase(std::remove(pools.begin(), pools.end(), this), pools.end());
+        }
+
+        void threadpool_stats::on_task(size_t _worker, std::string_view _name, size_t _queue_depth, std::chrono::microseconds _wait, std::chrono::microseconds _run)
+        {
+            im_assert(_worker < workers_.size());
+            if (_worker >= workers_.size())
+                return;
+
+            if (_name.empty())
+                _name = unnamed_task;
+
+            auto& stats = *workers_[_worker];
+
+            std::scoped_lock lock(stats.mutex_);
+            stats.queue_depth_.add(_queue_depth);
+
+            auto it = stats.tasks_.find(_name);
+            if (it == stats.tasks_.end())
+                it = stats.tasks_.emplace(std::string(_name), task_stats()).first;
+
+            it->second.wait_us_.add(uint64_t(std::max<int64_t>(0, _wait.count())));
+            it->second.run_us_.add(uint64_t(std::max<int64_t>(0, _run.count())));
+        }
+
+        threadpool_stats_snapshot threadpool_stats::get_snapshot() const
+        {
+            threadpool_stats_snapshot snapshot;
+            snapshot.name_ = name_;
+            snapshot.threads_count_ = workers_.size();
+            snapshot.uptime_ = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - created_);
+
+            for (const auto& stats : workers_)
+            {
+                std::scoped_lock lock(stats->mutex_);
+                snapshot.queue_depth_.merge(stats->queue_depth_);
+
+                for (const auto& [name, task] : stats->tasks_)
+                {
+                    auto& merged = snapshot.tasks_[name];
+                    merged.wait_us_.merge(task.wait_us_);
+                    merged.run_us_.merge(task.run_us_);
+                }
+            }
+
+            return snapshot;
+        }
+
+        std::vector<threadpool_stats_snapshot> get_threadpools_stats()
+        {
+            std::vector<threadpool_stats_snapshot> result;
+            {
+                std::scoped_lock lock(registry_mutex());
+                result.reserve(registry().size());
+                for (const auto pool : registry())
+                    result.push_back(pool->get_snapshot());
+            }
+
+            std::stable_sort(result.begin(), result.end(), [](const auto& _l, const auto& _r) { return _l.name_ < _r.name_; });
+            return result;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+namespace core
+{
+    namespace tools
+    {
+        // counts of values by powers of two: bucket 0 holds 0, bucket i holds [2^(i-1), 2^i),
+        // the last one holds everything above
+        class log2_histogram
+        {
+        public:
+            static constexpr size_t buckets_count = 32;
+
+            void add(uint64_t _value) noexcept;
+            void merge(const log2_histogram& _other) noexcept;
+
+            uint64_t get_count() const noexcept { return count_; }
+            uint64_t get_sum() const noexcept { return sum_; }
+            uint64_t get_max() const noexcept { return max_; }
+
+            // the upper bound of the bucket the _share of values fits in, never above the max
+            uint64_t get_percentile(double _share) const noexcept;
+
+            const std::array<uint64_t, buckets_count>& get_buckets() const noexcept { return buckets_; }
+
+            static size_t bucket_of(uint64_t _value) noexcept;
+
+            // values of the bucket are below it
+            static uint64_t bucket_limit(size_t _bucket) noexcept;
+
+        private:
+            std::array<uint64_t, buckets_count> buckets_ = {};
+            uint64_t count_ = 0;
+            uint64_t sum_ = 0;
+            uint64_t max_ = 0;
+        };
+
+        struct task_stats
+        {
+            log2_histogram wait_us_;
+            log2_histogram run_us_;
+        };
+
+        using tasks_stats = std::map<std::string, task_stats, std::less<>>;
+
+        struct threadpool_stats_snapshot
+        {
+            std::string name_;
+            size_t threads_count_ = 0;
+            std::chrono::milliseconds uptime_ = {};
+
+            // tasks still queued when a worker takes one
+            log2_histogram queue_depth_;
+
+            tasks_stats tasks_;
+
+            // share of the workers' time spent in tasks since the pool was created
+            double get_busy_share() const noexcept;
+        };
+
+        // always on statistics of a threadpool
+        //
+        // every worker writes to its own part under its own mutex, which is contended
+        // only by a snapshot. the pool registers its statistics, so get_threadpools_stats
+        // sees all the pools alive
+        class threadpool_stats
+        {
+        public:
+            threadpool_stats(std::string_view _name, size_t _threads_count);
+            ~threadpool_stats();
+
+            threadpool_stats(const threadpool_stats&) = delete;
+            threadpool_stats& operator=(const threadpool_stats&) = delete;
+
+            void on_task(size_t _worker, std::string_view _name, size_t _queue_depth, std::chrono::microseconds _wait, std::chrono::microseconds _run);
+
+            threadpool_stats_snapshot get_snapshot() const;
+
+        private:
+            struct worker
+            {
+                mutable std::mutex mutex_;
+                log2_histogram queue_depth_;
+                tasks_stats tasks_;
+            };
+
+            const std::string name_;
+            const std::chrono::steady_clock::time_point created_;
+            std::vector<std::unique_ptr<worker>> workers_;
+        };
+
+        // of all the threadpools alive, ordered by name
+        std::vector<threadpool_stats_snapshot> get_threadpools_stats();
+    }
+}
@@ -7,6 +7,7 @@ namespace core
     namespace tools
     {
         class tlv;
+        class tlv_view;
 
         using tlv_list = std::vector<std::shared_ptr<tlv>>;
 
@@ -68,7 +69,7 @@ namespace core
             virtual ~iserializable_tlv();
             virtual void serialize(tlvpack &_pack) const = 0;
 
-            virtual bool unserialize(const tlvpack &_pack) = 0;
+            virtual bool unserialize(const tlv_view& _pack) = 0;
         };
 
         class tlv
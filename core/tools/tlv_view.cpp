@@ -0,0 +1,110 @@
+#include "stdafx.h"
+#include "tlv_view.h"
+
+using namespace core;
+using namespace tools;
+
+template<> std::string tlv_field::get_value<std::string>(const std::string& _default_value) const
+{
+    if (value_.empty())
+        return _default_value;
+
+    return std::string(value_);
+}
+
+template<> std::string tlv_field::get_value<std::string>() const
+{
+    return std::string(value_);
+}
+
+template<> std::string_view tlv_field::get_value<std::string_view>() const
+{
+    return value_;
+}
+
+template<> tlv_view tlv_field::get_value<tlv_view>() const
+{
+    tlv_view view;
+    view.unserialize(value_);
+
+    return view;
+}
+
+template<> binary_stream tlv_field::get_value<binary_stream>() const
+{
+    binary_stream stream;
+    stream.write(value_.data(), int64_t(value_.size()));
+
+    return stream;
+}
+
+bool tlv_view::unserialize(const binary_stream& _stream)
+{
+    const auto size = _stream.available();
+    if (size <= 0)
+        return true;
+
+    return unserialize(std::string_view(_stream.read(size), size_t(size)));
+}
+
+bool tlv_view::unserialize(std::string_view _data)
+{
+    constexpr size_t header_size = sizeof(uint32_t) * 2;
+
+    fields_.clear();
+    indexed_ = false;
+
+    size_t pos = 0;
+    while (_data.size() - pos >= header_size)
+    {
+        uint32_t type = 0;
+        uint32_t length = 0;
+        memcpy(&type, _data.data() + pos, sizeof(type));
+        memcpy(&length, _data.data() + pos + sizeof(type), sizeof(length));
+        pos += header_size;
+
+        if (_data.size() - pos < length)
+            return false;
+
+        fields_.emplace_back(type, _data.substr(pos, length));
+        pos += length;
+    }
+
+    // tlv::unserialize ignores a truncated header at the end as well
+    return true;
+}
+
+void tlv_view::build_index() const noexcept
+{
+    index_.fill(no_index);
+
+    const auto count = std::min<size_t>(fields_.size(), no_index);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto type = fields_[i].get_type();
+        if (type < indexed_types && index_[type] == no_index)
+            index_[type] = uint8_t(i);
+    }
+
+    indexed_ = true;
+}
+
+const tlv_field* tlv_view::get_item(uint32_t _type) const noexcept
+{
+    if (_type < indexed_types && fields_.size() < no_index)
+    {
+        if (!indexed_)
+            build_index();
+
+        const auto i = index_[_type];
+        return i == no_index ? nullptr : &fields_[i];
+    }
+
+    for (const auto& field : fields_)
+    {
+        if (field.get_type() == _type)
+            return &field;
+    }
+
+    return nullptr;
+}
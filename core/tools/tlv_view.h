@@ -0,0 +1,96 @@
+#pragma once
+
+#include <boost/container/small_vector.hpp>
+
+#include "binary_stream.h"
+
+namespace core
+{
+    namespace tools
+    {
+        class tlv_view;
+
+        // non-owning counterpart of tlv: the value is a view into the buffer the pack was read from
+        class tlv_field
+        {
+            uint32_t type_ = 0;
+            std::string_view value_;
+
+        public:
+            tlv_field() = default;
+            tlv_field(uint32_t _type, std::string_view _value) noexcept : type_(_type), value_(_value) {}
+
+            uint32_t get_type() const noexcept { return type_; }
+            int64_t value_size() const noexcept { return int64_t(value_.size()); }
+
+            template <class T_>
+            T_ get_value(const T_& _default_value) const;
+
+            template <class T_>
+            T_ get_value() const;
+        };
+
+        template<> std::string tlv_field::get_value<std::string>(const std::string& _default_value) const;
+        template<> std::string tlv_field::get_value<std::string>() const;
+        template<> std::string_view tlv_field::get_value<std::string_view>() const;
+        template<> tlv_view tlv_field::get_value<tlv_view>() const;
+        template<> binary_stream tlv_field::get_value<binary_stream>() const;
+
+        // read-only replacement of tlvpack for unserialization: indexes the fields of a buffer in place
+        // without copying them, nested packs are parsed only when they are asked for.
+        // the buffer has to outlive the view and every field taken from it
+        class tlv_view
+        {
+            static constexpr uint32_t indexed_types = 128;
+            static constexpr uint8_t no_index = std::numeric_limits<uint8_t>::max();
+
+            using fields = boost::container::small_vector<tlv_field, 24>;
+
+            fields fields_;
+
+            mutable std::array<uint8_t, indexed_types> index_;
+            mutable bool indexed_ = false;
+
+            void build_index() const noexcept;
+
+        public:
+            using const_iterator = fields::const_iterator;
+
+            // consumes the available data of the stream like tlvpack::unserialize does
+            bool unserialize(const binary_stream& _stream);
+            bool unserialize(std::string_view _data);
+
+            // the first field of the type or nullptr
+            const tlv_field* get_item(uint32_t _type) const noexcept;
+
+            const_iterator begin() const noexcept { return fields_.begin(); }
+            const_iterator end() const noexcept { return fields_.end(); }
+
+            uint32_t size() const noexcept { return uint32_t(fields_.size()); }
+            bool empty() const noexcept { return fields_.empty(); }
+        };
+
+        template <class T_>
+        T_ tlv_field::get_value(const T_& _default_value) const
+        {
+            static_assert(std::is_scalar<T_>::value, "value should be of scalar type");
+
+            typename std::remove_const<T_>::type val = _default_value;
+
+            if (value_.size() < sizeof(T_))
+            {
+                im_assert(!"bad tlv length");
+                return T_();
+            }
+
+            memcpy(&val, value_.data(), sizeof(T_));
+            return val;
+        }
+
+        template <class T_>
+        T_ tlv_field::get_value() const
+        {
+            return get_value<T_>(T_());
+        }
+    }
+}
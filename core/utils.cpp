@@ -5,6 +5,7 @@
 #include "tools/system.h"
 #include "tools/coretime.h"
 #include "tools/hmac_sha_base64.h"
+#include "profiling/trace.h"
 #include "../common.shared/version_info.h"
 #include "../common.shared/common_defs.h"
 #include "../common.shared/config/config.h"
@@ -357,6 +358,8 @@ namespace core
                 set_thread_description_func(GetCurrentThread(), tools::from_utf8(_name).c_str());
         }
 #endif
+
+        profiler::trace::set_thread_name(_name);
         }
 
         uint64_t get_current_process_ram_usage()
@@ -587,6 +590,9 @@ namespace core
 
         boost::filesystem::wpath create_logs_dir_archive(const boost::filesystem::wpath& _path)
         {
+            // the last lines may still be in the rings of the network log
+            g_core->flush_network_log();
+
             boost::filesystem::wpath arch_path;
 
             if (const auto source_zip = zip_up_directory(get_logs_path()); !source_zip.empty())
@@ -615,6 +621,8 @@ namespace core
 
         boost::filesystem::wpath create_feedback_logs_archive(const boost::filesystem::wpath& _path, int64_t _raw_size_limit, replace_old_archive _replace)
         {
+            g_core->flush_network_log();
+
             boost::filesystem::wpath arch_path;
             std::stack<std::vector<char>> log_chunks;
             std::vector<char> full_log;
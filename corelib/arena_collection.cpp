@@ -0,0 +1,705 @@
+#include "stdafx.h"
+#include "arena_collection.h"
+#include "collection.h"
+#define __STDC_FORMAT_MACROS 1
+#include <inttypes.h>
+
+using namespace core;
+
+namespace
+{
+    // a typical message fits into the first chunk, a history page into a couple of them
+    constexpr size_t first_chunk_size = 4 * 1024;
+    constexpr size_t max_chunk_size = 256 * 1024;
+
+    char* align_up(char* _p, size_t _align)
+    {
+        const auto p = reinterpret_cast<uintptr_t>(_p);
+        return reinterpret_cast<char*>((p + _align - 1) & ~uintptr_t(_align - 1));
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// collection_arena
+//////////////////////////////////////////////////////////////////////////
+collection_arena::collection_arena(chunk* _first)
+    : ref_count_(0),
+      chunks_(_first),
+      pos_(_first->begin()),
+      end_(_first->end_),
+      next_chunk_size_(2 * first_chunk_size),
+      objects_(nullptr)
+{
+}
+
+collection_arena* collection_arena::create()
+{
+    // the arena itself is the first allocation of its first chunk
+    auto first = static_cast<chunk*>(malloc(first_chunk_size));
+    if (!first)
+        throw std::bad_alloc();
+
+    first->next_ = nullptr;
+    first->end_ = reinterpret_cast<char*>(first) + first_chunk_size;
+
+    auto arena = new (first->begin()) collection_arena(first);
+    arena->pos_ += sizeof(collection_arena);
+
+    return arena;
+}
+
+int32_t collection_arena::addref()
+{
+    return ++ref_count_;
+}
+
+int32_t collection_arena::release()
+{
+    int32_t r = (--ref_count_);
+    if (0 == r)
+    {
+        destroy();
+        return 0;
+    }
+    return r;
+}
+
+void collection_arena::destroy()
+{
+    // destructors release only the references to other arenas and heap objects
+    for (auto node = objects_; node; node = node->next_)
+        node->object_->~ibase();
+
+    auto chunk = chunks_;
+    this->~collection_arena();
+
+    while (chunk)
+    {
+        auto next = chunk->next_;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+collection_arena::chunk* collection_arena::add_chunk(size_t _size)
+{
+    auto new_chunk = static_cast<chunk*>(malloc(sizeof(chunk) + _size));
+    if (!new_chunk)
+        throw std::bad_alloc();
+
+    new_chunk->end_ = new_chunk->begin() + _size;
+
+    // the first chunk holds the arena and has to be freed last
+    new_chunk->next_ = chunks_->next_;
+    chunks_->next_ = new_chunk;
+
+    return new_chunk;
+}
+
+void* collection_arena::allocate(size_t _size, size_t _align)
+{
+    auto p = align_up(pos_, _align);
+    if (p + _size <= end_)
+    {
+        pos_ = p + _size;
+        return p;
+    }
+
+    const auto required = _size + _align;
+    if (required > next_chunk_size_ / 2)
+    {
+        // big strings and arrays get their own chunk, the current one keeps serving small objects
+        return align_up(add_chunk(required)->begin(), _align);
+    }
+
+    auto new_chunk = add_chunk(next_chunk_size_);
+    next_chunk_size_ = std::min(next_chunk_size_ * 2, max_chunk_size);
+
+    p = align_up(new_chunk->begin(), _align);
+    pos_ = p + _size;
+    end_ = new_chunk->end_;
+
+    return p;
+}
+
+std::string_view collection_arena::copy(std::string_view _str)
+{
+    auto p = static_cast<char*>(allocate(_str.size() + 1, 1));
+    if (!_str.empty())
+        memcpy(p, _str.data(), _str.size());
+    p[_str.size()] = '\0';
+
+    return std::string_view(p, _str.size());
+}
+
+bool collection_arena::contains(const void* _p) const noexcept
+{
+    const auto p = static_cast<const char*>(_p);
+    for (auto c = chunks_; c; c = c->next_)
+    {
+        if (p >= c->begin() && p < c->end_)
+            return true;
+    }
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// arena_value
+//////////////////////////////////////////////////////////////////////////
+arena_value::arena_value(collection_arena* _arena)
+    : arena_(_arena),
+      type_(collection_value_type::vt_empty),
+      log_data_(nullptr)
+{
+}
+
+arena_value::~arena_value()
+{
+    clear();
+}
+
+int32_t arena_value::addref()
+{
+    return arena_->addref();
+}
+
+int32_t arena_value::release()
+{
+    return arena_->release();
+}
+
+void arena_value::hold(ibase* _object)
+{
+    if (!arena_->contains(_object))
+        _object->addref();
+}
+
+void arena_value::clear()
+{
+    free(log_data_);
+    log_data_ = nullptr;
+
+    ibase* held = nullptr;
+
+    switch (type_)
+    {
+    case core::vt_empty:
+        return;
+    case core::vt_collection:
+        held = data__.collection_value_;
+        break;
+    case core::vt_stream:
+        held = data__.istream_value_;
+        break;
+    case core::vt_array:
+        held = data__.array_value_;
+        break;
+    case core::vt_hheaders:
+        held = data__.ihheaders_value_;
+        break;
+    case core::vt_string:
+    case core::vt_int:
+    case core::vt_double:
+    case core::vt_bool:
+    case core::vt_int64:
+    case core::vt_uint:
+        break;
+    default:
+        im_assert(!"clear data for this type");
+        break;
+    }
+
+    if (held && !arena_->contains(held))
+        held->release();
+
+    ::memset(&data__, 0, sizeof(data__));
+    type_ = collection_value_type::vt_empty;
+}
+
+void arena_value::set_as_int(int32_t val)
+{
+    clear();
+    type_ = vt_int;
+    data__.int_value_ = val;
+}
+
+int32_t arena_value::get_as_int() const
+{
+    if (type_ != collection_value_type::vt_int)
+    {
+        im_assert(!"invalid value type");
+        return 0;
+    }
+
+    return data__.int_value_;
+}
+
+void arena_value::set_as_int64(int64_t val)
+{
+    clear();
+    type_ = vt_int64;
+    data__.int64_value_ = val;
+}
+
+int64_t arena_value::get_as_int64() const
+{
+    if (type_ != collection_value_type::vt_int64)
+    {
+        im_assert(!"invalid value type");
+        return 0;
+    }
+
+    return data__.int64_value_;
+}
+
+void arena_value::set_as_string(const char* val, int32_t len)
+{
+    clear();
+    type_ = collection_value_type::vt_string;
+    data__.string_value_ = arena_->copy(std::string_view(val, len)).data();
+}
+
+const char* arena_value::get_as_string() const
+{
+    if (type_ != collection_value_type::vt_string)
+    {
+        im_assert(!"invalid value type");
+        return "";
+    }
+
+    return data__.string_value_;
+}
+
+void arena_value::set_as_double(double val)
+{
+    clear();
+    type_ = collection_value_type::vt_double;
+    data__.double_value_ = val;
+}
+
+double arena_value::get_as_double() const
+{
+    if (type_ != collection_value_type::vt_double)
+    {
+        im_assert(!"invalid value type");
+        return 0.0;
+    }
+
+    return data__.double_value_;
+}
+
+void arena_value::set_as_bool(bool val)
+{
+    clear();
+    type_ = collection_value_type::vt_bool;
+    data__.bool_value_ = val;
+}
+
+bool arena_value::get_as_bool() const
+{
+    if (type_ != collection_value_type::vt_bool)
+    {
+        im_assert(!"invalid value type");
+        return false;
+    }
+
+    return data__.bool_value_;
+}
+
+void arena_value::set_as_collection(icollection* val)
+{
+    hold(val);
+    clear();
+    type_ = collection_value_type::vt_collection;
+    data__.collection_value_ = val;
+}
+
+icollection* arena_value::get_as_collection() const
+{
+    if (type_ != collection_value_type::vt_collection)
+    {
+        im_assert(!"invalid data type");
+        return nullptr;
+    }
+
+    return data__.collection_value_;
+}
+
+void arena_value::set_as_stream(istream* val)
+{
+    hold(val);
+    clear();
+    type_ = collection_value_type::vt_stream;
+    data__.istream_value_ = val;
+}
+
+istream* arena_value::get_as_stream()
+{
+    if (type_ != collection_value_type::vt_stream)
+    {
+        im_assert(!"invalid data type");
+        return nullptr;
+    }
+
+    return data__.istream_value_;
+}
+
+void arena_value::set_as_array(iarray* val)
+{
+    hold(val);
+    clear();
+    type_ = collection_value_type::vt_array;
+    data__.array_value_ = val;
+}
+
+iarray* arena_value::get_as_array()
+{
+    if (type_ != collection_value_type::vt_array)
+    {
+        im_assert(!"invalid data type");
+        return nullptr;
+    }
+
+    return data__.array_value_;
+}
+
+void arena_value::set_as_hheaders(ihheaders_list* _val)
+{
+    hold(_val);
+    clear();
+    type_ = collection_value_type::vt_hheaders;
+    data__.ihheaders_value_ = _val;
+}
+
+ihheaders_list* arena_value::get_as_hheaders()
+{
+    if (type_ != collection_value_type::vt_hheaders)
+    {
+        im_assert(!"invalid data type");
+        return nullptr;
+    }
+
+    return data__.ihheaders_value_;
+}
+
+void arena_value::set_as_uint(uint32_t val)
+{
+    clear();
+    type_ = vt_uint;
+    data__.uint_value_ = val;
+}
+
+uint32_t arena_value::get_as_uint() const
+{
+    if (type_ != collection_value_type::vt_uint)
+    {
+        im_assert(!"invalid data type");
+        return 0;
+    }
+
+    return data__.uint_value_;
+}
+
+const char* arena_value::log() const
+{
+    free(log_data_);
+    log_data_ = nullptr;
+
+    switch (type_)
+    {
+    case core::vt_string:
+        return data__.string_value_;
+    case core::vt_int:
+        log_data_ = (char*) malloc(20);
+        sprintf(log_data_, "%d", data__.int_value_);
+        break;
+    case core::vt_double:
+        log_data_ = (char*) malloc(40);
+        sprintf(log_data_, "%f", data__.double_value_);
+        break;
+    case core::vt_bool:
+        log_data_ = (char*) malloc(20);
+        sprintf(log_data_, "%s", data__.bool_value_ ? "true" : "false");
+        break;
+    case core::vt_int64:
+        log_data_ = (char*) malloc(40);
+        sprintf(log_data_, "%" PRId64, data__.int64_value_);
+        break;
+    case core::vt_uint:
+        log_data_ = (char*) malloc(20);
+        sprintf(log_data_, "%u", data__.uint_value_);
+        break;
+    case core::vt_collection:
+        return "<collection>";
+    case core::vt_stream:
+        log_data_ = (char*) malloc(40);
+        sprintf(log_data_, "<stream size=" "%" PRId64 ">", data__.istream_value_->size());
+        break;
+    case core::vt_array:
+        log_data_ = (char*) malloc(40);
+        sprintf(log_data_, "<array size=%d>", data__.array_value_->size());
+        break;
+    case core::vt_hheaders:
+        return "<headers>";
+    default:
+        return "<unknown>";
+    }
+
+    return log_data_;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// arena_array
+//////////////////////////////////////////////////////////////////////////
+arena_array::arena_array(collection_arena* _arena)
+    : arena_(_arena),
+      values_(nullptr),
+      size_(0),
+      capacity_(0)
+{
+}
+
+arena_array::~arena_array()
+{
+    for (size_type i = 0; i < size_; ++i)
+    {
+        if (!arena_->contains(values_[i]))
+            values_[i]->release();
+    }
+}
+
+int32_t arena_array::addref()
+{
+    return arena_->addref();
+}
+
+int32_t arena_array::release()
+{
+    return arena_->release();
+}
+
+void arena_array::push_back(ivalue* val)
+{
+    if (size_ == capacity_)
+        reserve(std::max<size_type>(8, capacity_ * 2));
+
+    values_[size_++] = val;
+
+    if (!arena_->contains(val))
+        val->addref();
+}
+
+const ivalue* arena_array::get_at(size_type pos) const
+{
+    return values_[pos];
+}
+
+void arena_array::reserve(size_type sz)
+{
+    if (sz <= capacity_)
+        return;
+
+    // the old buffer stays in the arena until the message is released
+    auto values = static_cast<ivalue**>(arena_->allocate(sizeof(ivalue*) * sz, alignof(ivalue*)));
+    if (size_)
+        memcpy(values, values_, sizeof(ivalue*) * size_);
+
+    values_ = values;
+    capacity_ = sz;
+}
+
+iarray::size_type arena_array::size() const
+{
+    return size_;
+}
+
+bool arena_array::empty() const
+{
+    return size_ == 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// arena_collection
+//////////////////////////////////////////////////////////////////////////
+icollection* arena_collection::create()
+{
+    auto arena = collection_arena::create();
+    return arena->make<arena_collection>();
+}
+
+arena_collection::arena_collection(collection_arena* _arena)
+    : arena_(_arena),
+      entries_(inline_entries_),
+      size_(0),
+      capacity_(inline_capacity),
+      cursor_(0),
+      log_data_(nullptr)
+{
+}
+
+arena_collection::~arena_collection()
+{
+    free(log_data_);
+
+    for (uint32_t i = 0; i < size_; ++i)
+    {
+        if (!arena_->contains(entries_[i].value_))
+            entries_[i].value_->release();
+    }
+}
+
+int32_t arena_collection::addref()
+{
+    return arena_->addref();
+}
+
+int32_t arena_collection::release()
+{
+    return arena_->release();
+}
+
+ivalue* arena_collection::create_value()
+{
+    return arena_->make<arena_value>();
+}
+
+icollection* arena_collection::create_collection()
+{
+    return arena_->make<arena_collection>();
+}
+
+iarray* arena_collection::create_array()
+{
+    return arena_->make<arena_array>();
+}
+
+istream* arena_collection::create_stream()
+{
+    return (new core::coll_stream());
+}
+
+ihheaders_list* arena_collection::create_hheaders_list()
+{
+    return (new core::hheaders_list());
+}
+
+const arena_collection::entry* arena_collection::find(std::string_view _name) const
+{
+    const auto end = entries_ + size_;
+    const auto it = std::lower_bound(entries_, end, _name, [](const entry& _e, std::string_view _n) { return _e.name_ < _n; });
+    if (it == end || it->name_ != _name)
+        return nullptr;
+
+    return it;
+}
+
+void arena_collection::set_value(std::string_view name, ivalue* value)
+{
+    if (!arena_->contains(value))
+        value->addref();
+
+    const auto end = entries_ + size_;
+    const auto it = std::lower_bound(entries_, end, name, [](const entry& _e, std::string_view _n) { return _e.name_ < _n; });
+    if (it != end && it->name_ == name)
+    {
+        if (!arena_->contains(it->value_))
+            it->value_->release();
+
+        it->value_ = value;
+        return;
+    }
+
+    const auto index = uint32_t(it - entries_);
+
+    if (size_ == capacity_)
+    {
+        auto entries = static_cast<entry*>(arena_->allocate(sizeof(entry) * capacity_ * 2, alignof(entry)));
+        std::copy(entries_, entries_ + size_, entries);
+
+        entries_ = entries;
+        capacity_ *= 2;
+    }
+
+    std::copy_backward(entries_ + index, entries_ + size_, entries_ + size_ + 1);
+    entries_[index] = { arena_->copy(name), value };
+    ++size_;
+}
+
+ivalue* arena_collection::get_value(std::string_view name) const
+{
+    const auto e = find(name);
+    if (!e)
+    {
+        im_assert(!"value doesn't exist");
+#if defined(DEBUG) || defined(_DEBUG)
+        puts(std::string(name).c_str());
+#endif // defined(DEBUG) || defined(_DEBUG)
+        return nullptr;
+    }
+
+    return e->value_;
+}
+
+ivalue* arena_collection::first()
+{
+    cursor_ = 0;
+    if (size_ == 0)
+        return nullptr;
+
+    return entries_[0].value_;
+}
+
+ivalue* arena_collection::next()
+{
+    if (cursor_ >= size_)
+        return nullptr;
+
+    ++cursor_;
+    if (cursor_ >= size_)
+        return nullptr;
+
+    return entries_[cursor_].value_;
+}
+
+int32_t arena_collection::count() const
+{
+    return int32_t(size_);
+}
+
+bool arena_collection::empty() const
+{
+    return size_ == 0;
+}
+
+bool arena_collection::is_value_exist(std::string_view name) const
+{
+    return find(name) != nullptr;
+}
+
+const char* arena_collection::log() const
+{
+    if (find("not_log"))
+        return "";
+
+    std::string s;
+
+    for (uint32_t i = 0; i < size_; ++i)
+    {
+        s += entries_[i].name_;
+        s += '=';
+        s += entries_[i].value_->log();
+        s += '\n';
+    }
+
+    if (s.empty())
+        return "";
+
+    const auto text_size = s.size();
+    free(log_data_);
+    log_data_ = (char*) malloc(text_size + 1);
+
+    memcpy(log_data_, s.data(), text_size);
+    log_data_[text_size] = 0;
+
+    return log_data_;
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cstddef>
+
+#include "core_face.h"
+
+namespace core
+{
+    // backing storage of one core<->gui message: every value, nested collection, array and string
+    // created through the message lives in a few bump-allocated chunks released with a single free.
+    // objects created from the arena share its reference counter, references between objects
+    // of the same arena aren't counted at all, so a message tree can't keep itself alive.
+    // allocation isn't thread safe: a message is built by one thread and only read afterwards
+    class collection_arena
+    {
+        struct chunk
+        {
+            chunk* next_;
+            char* end_;
+
+            char* begin() { return reinterpret_cast<char*>(this + 1); }
+        };
+
+        struct object_node
+        {
+            object_node* next_;
+            ibase* object_;
+        };
+
+        std::atomic<int32_t> ref_count_;
+
+        chunk* chunks_;
+        char* pos_;
+        char* end_;
+        size_t next_chunk_size_;
+
+        object_node* objects_;
+
+        explicit collection_arena(chunk* _first);
+
+        chunk* add_chunk(size_t _size);
+        void destroy();
+
+    public:
+        static collection_arena* create();
+
+        int32_t addref();
+        int32_t release();
+
+        void* allocate(size_t _size, size_t _align = alignof(std::max_align_t));
+
+        // copies and zero-terminates
+        std::string_view copy(std::string_view _str);
+
+        bool contains(const void* _p) const noexcept;
+
+        // the object is returned referenced once, as if it was created by new
+        template <class T>
+        T* make()
+        {
+            auto node = static_cast<object_node*>(allocate(sizeof(object_node) + sizeof(T)));
+            auto object = new (node + 1) T(this);
+
+            node->object_ = object;
+            node->next_ = objects_;
+            objects_ = node;
+
+            ++ref_count_;
+            return object;
+        }
+    };
+
+    class arena_value : public ivalue
+    {
+        collection_arena* arena_;
+
+        collection_value_type type_;
+        mutable char* log_data_;
+
+        union data
+        {
+            const char*         string_value_;
+            int32_t             int_value_;
+            int64_t             int64_value_;
+            double              double_value_;
+            bool                bool_value_;
+            icollection*        collection_value_;
+            iarray*             array_value_;
+            istream*            istream_value_;
+            ihheaders_list*     ihheaders_value_;
+            uint32_t            uint_value_;
+
+        } data__;
+
+        // ibase interface
+        virtual int32_t addref() override;
+        virtual int32_t release() override;
+
+        // ivalue interface
+        virtual void set_as_int(int32_t) override;
+        virtual int32_t get_as_int() const override;
+
+        virtual void set_as_int64(int64_t) override;
+        virtual int64_t get_as_int64() const override;
+
+        virtual void set_as_string(const char*, int32_t len) override;
+        virtual const char* get_as_string() const override;
+
+        virtual void set_as_double(double) override;
+        virtual double get_as_double() const override;
+
+        virtual void set_as_bool(bool) override;
+        virtual bool get_as_bool() const override;
+
+        virtual void set_as_collection(icollection*) override;
+        virtual icollection* get_as_collection() const override;
+
+        virtual void set_as_stream(istream*) override;
+        virtual istream* get_as_stream() override;
+
+        virtual void set_as_array(iarray*) override;
+        virtual iarray* get_as_array() override;
+
+        virtual void set_as_hheaders(ihheaders_list*) override;
+        virtual ihheaders_list* get_as_hheaders() override;
+
+        virtual void set_as_uint(uint32_t) override;
+        virtual uint32_t get_as_uint() const override;
+
+        virtual const char* log() const override;
+
+        void hold(ibase* _object);
+        void clear();
+
+    public:
+        explicit arena_value(collection_arena* _arena);
+        virtual ~arena_value();
+    };
+
+    class arena_array : public iarray
+    {
+        collection_arena* arena_;
+
+        ivalue** values_;
+        size_type size_;
+        size_type capacity_;
+
+        // ibase interface
+        virtual int32_t addref() override;
+        virtual int32_t release() override;
+
+        virtual void push_back(ivalue*) override;
+        virtual const ivalue* get_at(size_type) const override;
+        virtual void reserve(size_type) override;
+        virtual size_type size() const override;
+        virtual bool empty() const override;
+
+    public:
+        explicit arena_array(collection_arena* _arena);
+        virtual ~arena_array();
+    };
+
+    // flat replacement of core::collection: values are kept in a vector sorted by name,
+    // names and values are allocated from the message arena
+    class arena_collection : public icollection
+    {
+        struct entry
+        {
+            std::string_view name_;
+            ivalue* value_;
+        };
+
+        static constexpr uint32_t inline_capacity = 6;
+
+        collection_arena* arena_;
+
+        entry* entries_;
+        uint32_t size_;
+        uint32_t capacity_;
+        uint32_t cursor_;
+
+        entry inline_entries_[inline_capacity];
+
+        mutable char* log_data_;
+
+        const entry* find(std::string_view _name) const;
+
+        // ibase interface
+        virtual int32_t addref() override;
+        virtual int32_t release() override;
+
+        virtual ivalue* create_value() override;
+        virtual icollection* create_collection() override;
+        virtual iarray* create_array() override;
+        virtual istream* create_stream() override;
+        virtual ihheaders_list* create_hheaders_list() override;
+
+        virtual void set_value(std::string_view name, ivalue* value) override;
+        virtual ivalue* get_value(std::string_view name) const override;
+
+        virtual ivalue* first() override;
+        virtual ivalue* next() override;
+        virtual int32_t count() const override;
+        virtual bool empty() const override;
+        virtual bool is_value_exist(std::string_view name) const override;
+        virtual const char* log() const override;
+
+    public:
+        // creates the root collection of a new arena
+        static icollection* create();
+
+        explicit arena_collection(collection_arena* _arena);
+        virtual ~arena_collection();
+    };
+}
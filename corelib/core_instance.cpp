@@ -4,6 +4,7 @@
 
 #include "../core/core.h"
 #include "collection.h"
+#include "arena_collection.h"
 #include "collection_helper.h"
 
 using namespace core;
@@ -65,7 +66,7 @@ icore_factory* core::core_instance::get_factory()
 
 icollection* core::core_instance::create_collection()
 {
-    return (new core::collection());
+    return core::arena_collection::create();
 }
 
 void core::core_instance::link(iconnector* _connector, const common::core_gui_settings& _settings)
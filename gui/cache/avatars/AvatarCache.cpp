@@ -0,0 +1,85 @@
+#include "stdafx.h"
+#include "AvatarCache.h"
+
+#include "../../utils/memory_utils.h"
+
+namespace
+{
+    qint64 getFootprint(const Logic::AvatarCacheEntry& _entry)
+    {
+        return Utils::getMemoryFootprint<const QImage&>(_entry.source_) + Utils::getMemoryFootprint<const QPixmap&>(_entry.pixmap_);
+    }
+}
+
+namespace Logic
+{
+    AvatarCache::AvatarCache(qint64 _budget)
+        : budget_(_budget)
+    {
+    }
+
+    const AvatarCacheEntry* AvatarCache::find(const AvatarKey& _key)
+    {
+        const auto it = index_.find(_key);
+        if (it == index_.end())
+            return nullptr;
+
+        items_.splice(items_.begin(), items_, it->second);
+        return &it->second->entry_;
+    }
+
+    std::vector<QString> AvatarCache::insert(AvatarKey _key, AvatarCacheEntry _entry)
+    {
+        remove(_key);
+
+        const auto bytes = getFootprint(_entry);
+        bytes_[static_cast<size_t>(_key.shape_)] += bytes;
+
+        items_.push_front({ _key, std::move(_entry), bytes });
+        index_.emplace(std::move(_key), items_.begin());
+
+        std::vector<QString> evictedSources;
+        while (getBytes() > budget_ && items_.size() > 1)
+        {
+            const auto last = std::prev(items_.end());
+            if (last->key_.shape_ == AvatarShape::Source)
+                evictedSources.push_back(last->key_.aimId_);
+
+            erase(last);
+        }
+
+        return evictedSources;
+    }
+
+    void AvatarCache::remove(const AvatarKey& _key)
+    {
+        if (const auto it = index_.find(_key); it != index_.end())
+            erase(it->second);
+    }
+
+    void AvatarCache::remove(const QString& _aimId, bool _withRounded)
+    {
+        // the keys of a contact are next to each other, ordered by shape
+        auto it = index_.lower_bound({ _aimId, std::numeric_limits<int>::min(), AvatarShape::Source });
+        while (it != index_.end() && it->first.aimId_ == _aimId)
+        {
+            if (!_withRounded && it->first.shape_ == AvatarShape::Rounded)
+                break;
+
+            auto item = (it++)->second;
+            erase(item);
+        }
+    }
+
+    qint64 AvatarCache::getBytes() const noexcept
+    {
+        return std::accumulate(bytes_.begin(), bytes_.end(), qint64(0));
+    }
+
+    void AvatarCache::erase(Items::iterator _it)
+    {
+        bytes_[static_cast<size_t>(_it->key_.shape_)] -= _it->bytes_;
+        index_.erase(_it->key_);
+        items_.erase(_it);
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+namespace Logic
+{
+    enum class AvatarShape
+    {
+        Source,     // the picture of the contact all the others are rendered from, size is 0
+        Square,
+        Rounded,
+
+        Count
+    };
+
+    struct AvatarKey
+    {
+        QString aimId_;
+        int size_ = 0;
+        AvatarShape shape_ = AvatarShape::Source;
+
+        bool operator<(const AvatarKey& _other) const
+        {
+            return std::tie(aimId_, shape_, size_) < std::tie(_other.aimId_, _other.shape_, _other.size_);
+        }
+    };
+
+    struct AvatarCacheEntry
+    {
+        QImage source_;     // for AvatarShape::Source
+        QPixmap pixmap_;    // for the rest
+
+        // a quick placeholder while the picture is rendered in the background
+        bool provisional_ = false;
+    };
+
+    // avatars of all the shapes and sizes, the least recently used ones are evicted over the byte budget
+    class AvatarCache
+    {
+    public:
+        explicit AvatarCache(qint64 _budget);
+
+        // makes the entry the most recently used one, the pointer is valid until the cache is changed
+        const AvatarCacheEntry* find(const AvatarKey& _key);
+
+        // the contacts whose sources have been evicted to fit the entry, the rest of their avatars stay
+        [[nodiscard]] std::vector<QString> insert(AvatarKey _key, AvatarCacheEntry _entry);
+
+        void remove(const AvatarKey& _key);
+
+        // all the avatars of the contact, rounded ones are kept unless _withRounded
+        void remove(const QString& _aimId, bool _withRounded = true);
+
+        qint64 getBudget() const noexcept { return budget_; }
+        qint64 getBytes() const noexcept;
+        qint64 getBytes(AvatarShape _shape) const noexcept { return bytes_[static_cast<size_t>(_shape)]; }
+        size_t size() const noexcept { return index_.size(); }
+
+    private:
+        struct Item
+        {
+            AvatarKey key_;
+            AvatarCacheEntry entry_;
+            qint64 bytes_ = 0;
+        };
+
+        using Items = std::list<Item>;
+
+        void erase(Items::iterator _it);
+
+        const qint64 budget_;
+
+        Items items_; // the most recently used first
+        std::map<AvatarKey, Items::iterator> index_;
+        std::array<qint64, static_cast<size_t>(AvatarShape::Count)> bytes_ = {};
+    };
+}
@@ -0,0 +1,117 @@
+#include "stdafx.h"
+#include "AvatarRenderTask.h"
+
+#include "../../utils/utils.h"
+
+namespace
+{
+    // decodes large pictures right at the size needed, jpeg does it without decoding the whole picture
+    QImage decodeImage(const QByteArray& _data, int _sizePx)
+    {
+        QBuffer buffer;
+        buffer.setData(_data);
+        buffer.open(QIODevice::ReadOnly);
+
+        QImageReader reader(&buffer);
+        if (const auto size = reader.size(); _sizePx > 0 && size.isValid() && std::min(size.width(), size.height()) > _sizePx)
+            reader.setScaledSize(size.scaled(_sizePx, _sizePx, Qt::KeepAspectRatioByExpanding));
+
+        return reader.read();
+    }
+
+    QImage cutSquare(const QImage& _image, int _sizePx)
+    {
+        const auto avatarSize = QSize(_sizePx, _sizePx);
+        if (_image.width() == _image.height())
+            return _image.size() == avatarSize ? _image : _image.scaled(avatarSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+        const auto cutAreaSize = avatarSize.scaled(_image.size(), Qt::KeepAspectRatio);
+        auto cutArea = QRect(QPoint(), cutAreaSize);
+        cutArea.moveCenter(_image.rect().center());
+
+        return _image.copy(cutArea).scaled(avatarSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    QImage scaleImage(const QImage& _image, int _sizePx)
+    {
+        if (_image.height() >= _image.width())
+            return _image.width() == _sizePx ? _image : _image.scaledToWidth(_sizePx, Qt::SmoothTransformation);
+
+        return _image.height() == _sizePx ? _image : _image.scaledToHeight(_sizePx, Qt::SmoothTransformation);
+    }
+
+    // Utils::roundImage for the images
+    QImage roundImage(const QImage& _image)
+    {
+        const int scale = std::min(_image.height(), _image.width());
+        QImage imageOut(scale, scale, QImage::Format_ARGB32_Premultiplied);
+        imageOut.fill(Qt::transparent);
+
+        QPainter painter(&imageOut);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(Qt::NoBrush);
+
+        QPainterPath path;
+        path.addEllipse(0, 0, scale, scale);
+        painter.setClipPath(path);
+        painter.drawImage(0, 0, _image);
+        painter.end();
+
+        Utils::check_pixel_ratio(imageOut);
+
+        return imageOut;
+    }
+}
+
+namespace Logic
+{
+    AvatarRenderTask* AvatarRenderTask::decode(QByteArray _data, int _sizePx, bool _withRounded)
+    {
+        return new AvatarRenderTask(std::move(_data), QImage(), _sizePx, _withRounded);
+    }
+
+    AvatarRenderTask* AvatarRenderTask::scale(QImage _source, int _sizePx, bool _rounded)
+    {
+        im_assert(_sizePx > 0);
+        return new AvatarRenderTask(QByteArray(), std::move(_source), _sizePx, _rounded);
+    }
+
+    AvatarRenderTask::AvatarRenderTask(QByteArray _data, QImage _source, int _sizePx, bool _rounded)
+        : data_(std::move(_data))
+        , source_(std::move(_source))
+        , sizePx_(_sizePx)
+        , rounded_(_rounded)
+    {
+    }
+
+    void AvatarRenderTask::run()
+    {
+        if (Q_UNLIKELY(!QCoreApplication::instance()))
+            return;
+
+        QImage square;
+        if (!data_.isEmpty())
+        {
+            source_ = decodeImage(data_, sizePx_);
+            if (!source_.isNull() && sizePx_ > 0)
+                source_ = cutSquare(source_, sizePx_);
+
+            square = source_;
+        }
+        else if (!source_.isNull())
+        {
+            square = scaleImage(source_, sizePx_);
+        }
+
+        QImage rounded;
+        if (rounded_ && !square.isNull())
+            rounded = roundImage(square);
+
+        if (Q_UNLIKELY(!QCoreApplication::instance()))
+            return;
+
+        Q_EMIT rendered(source_, square, rounded);
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+namespace Logic
+{
+    // decodes, scales and rounds an avatar on a thread pool
+    class AvatarRenderTask
+        : public QObject
+        , public QRunnable
+    {
+        Q_OBJECT
+
+    Q_SIGNALS:
+        // _source is the decoded picture, or the one given to scale.
+        // _square is null if the picture can't be decoded, _rounded is null unless asked for
+        void rendered(const QImage& _source, const QImage& _square, const QImage& _rounded);
+
+    public:
+        // the middle square of the picture scaled to _sizePx, the whole picture if _sizePx is 0
+        static AvatarRenderTask* decode(QByteArray _data, int _sizePx, bool _withRounded);
+
+        static AvatarRenderTask* scale(QImage _source, int _sizePx, bool _rounded);
+
+        void run() override;
+
+    private:
+        AvatarRenderTask(QByteArray _data, QImage _source, int _sizePx, bool _rounded);
+
+        QByteArray data_;
+        QImage source_;
+        const int sizePx_;
+        const bool rounded_;
+    };
+}
@@ -1,60 +1,48 @@
 #include "stdafx.h"
 #include "AvatarStorage.h"
+#include "AvatarRenderTask.h"
 
 #include "../../core_dispatcher.h"
-#include "../../main_window/contact_list/ContactListModel.h"
 #include "../../main_window/containers/FriendlyContainer.h"
-#include "../../main_window/history_control/HistoryControlPage.h"
 #include "../../utils/gui_coll_helper.h"
 #include "../../utils/utils.h"
-#include "../../utils/InterConnector.h"
 #include "styles/ThemesContainer.h"
 
 namespace
 {
-    QStringView emptyPrefix() { return u"default"; }
-
-    QString CreateKey(QStringView _aimId, const int _sizePx)
+    Logic::AvatarKey sourceKey(const QString& _aimId)
     {
-        im_assert(_sizePx > 0);
-        const QStringView aimId = _aimId.isEmpty() ? emptyPrefix() : _aimId;
-        return aimId % u'/' % QString::number(_sizePx);
+        return { _aimId, 0, Logic::AvatarShape::Source };
     }
 
-    void eraseUnnamedAvatars(Logic::AvatarStorage::CacheMap& _cacheMap)
+    // the side the source is scaled to the size by
+    int scaledSide(const QImage& _source)
     {
-        for (auto i = _cacheMap.begin(), last = _cacheMap.end(); i != last; )
-        {
-            if (i->first.startsWith(emptyPrefix()))
-                i = _cacheMap.erase(i);
-            else
-                ++i;
-        }
+        return _source.height() >= _source.width() ? _source.width() : _source.height();
     }
 
-    constexpr std::chrono::milliseconds CLEANUP_TIMEOUT = std::chrono::minutes(5);
+    constexpr qint64 CACHE_BUDGET = 64 * 1024 * 1024;
     constexpr int64_t INITIAL_REQUEST_AVATAR_SEQ = -1;
 }
 
 namespace Logic
 {
     AvatarStorage::AvatarStorage()
-        : Timer_(new QTimer(this))
+        : cache_(CACHE_BUDGET)
     {
-        Timer_->setSingleShot(false);
-        Timer_->setInterval(CLEANUP_TIMEOUT);
-        Timer_->start();
+        pool_.setMaxThreadCount(std::clamp(QThread::idealThreadCount() - 1, 1, 2));
 
         connect(Ui::GetDispatcher(), &Ui::core_dispatcher::avatarLoaded, this, &AvatarStorage::avatarLoaded);
         connect(Ui::GetDispatcher(), &Ui::core_dispatcher::avatarUpdated, this, [this](const QString& contact) {
             updateAvatar(contact);
         });
-        connect(Timer_, &QTimer::timeout, this, &AvatarStorage::cleanup);
         connect(&Styling::getThemesContainer(), &Styling::ThemesContainer::globalThemeChanged, this, &AvatarStorage::onThemeChange);
     }
 
     AvatarStorage::~AvatarStorage()
     {
+        pool_.clear();
+        pool_.waitForDone();
     }
 
     QPixmap AvatarStorage::Get(const QString& _aimId, const QString& _displayName, const int _sizePx, bool& _isDefault, bool _regenerate)
@@ -62,19 +50,23 @@ namespace Logic
         if (_sizePx <= 0)
             return QPixmap();
 
-        TimesCache_[_aimId] = QDateTime::currentDateTime();
-
         Out _isDefault = isDefaultAvatar(_aimId);
-        const auto key = CreateKey(_aimId, _sizePx);
+        const AvatarKey key = { _aimId, _sizePx, AvatarShape::Square };
 
-        auto iterByAimIdAndSize = AvatarsByAimIdAndSize_.find(key);
-        if (iterByAimIdAndSize != AvatarsByAimIdAndSize_.end())
+        if (const auto entry = cache_.find(key))
         {
-            return iterByAimIdAndSize->second;
+            auto avatar = entry->pixmap_;
+
+            // the source is evicted after the avatars rendered from it
+            cache_.find(sourceKey(_aimId));
+            return avatar;
         }
 
-        auto iterByAimId = AvatarsByAimId_.find(_aimId);
-        if (iterByAimId == AvatarsByAimId_.end())
+        QImage source;
+        if (const auto entry = cache_.find(sourceKey(_aimId)))
+            source = entry->source_;
+
+        if (source.isNull())
         {
             auto drawDisplayName = _displayName.trimmed();
             if (drawDisplayName.isEmpty() && !_aimId.isEmpty())
@@ -82,42 +74,35 @@ namespace Logic
                 drawDisplayName = Logic::GetFriendlyContainer()->getFriendly(_aimId);
             }
 
-            auto defaultAvatar = Utils::getDefaultAvatar(_aimId, drawDisplayName, _sizePx);
-            im_assert(!defaultAvatar.isNull());
-
-            const auto result = AvatarsByAimId_.emplace(_aimId, std::move(defaultAvatar));
-            im_assert(result.second);
+            source = Utils::getDefaultAvatar(_aimId, drawDisplayName, _sizePx).toImage();
+            im_assert(!source.isNull());
 
-            iterByAimId = result.first;
+            insertToCache(sourceKey(_aimId), { source, QPixmap(), false });
         }
 
-        const auto &avatarByAimId = iterByAimId->second;
-        im_assert(!avatarByAimId.isNull());
-
-        const auto regenerateAvatar = ((avatarByAimId.width() < _sizePx) && _isDefault) && _aimId != _displayName;
+        const auto regenerateAvatar = ((source.width() < _sizePx) && _isDefault) && _aimId != _displayName;
         if (regenerateAvatar || _regenerate)
         {
-            AvatarsByAimId_.erase(iterByAimId);
-            CleanupSecondaryCaches(_aimId);
-            return Get(_aimId, _displayName, _sizePx, _isDefault, _regenerate);
+            cache_.remove(_aimId);
+            return Get(_aimId, _displayName, _sizePx, _isDefault, false);
         }
 
-        int avatarWidth = avatarByAimId.width();
-        int avatarHeight = avatarByAimId.height();
-        QPixmap scaledImage;
-        if (avatarHeight >= avatarWidth)
-            scaledImage = avatarByAimId.scaledToWidth(_sizePx, Qt::SmoothTransformation);
+        QPixmap avatar;
+        if (scaledSide(source) == _sizePx)
+        {
+            avatar = QPixmap::fromImage(source);
+            insertToCache(key, { QImage(), avatar, false });
+        }
         else
-            scaledImage = avatarByAimId.scaledToHeight(_sizePx, Qt::SmoothTransformation);
-
-        const auto result = AvatarsByAimIdAndSize_.emplace(key, std::move(scaledImage));
-        im_assert(result.second);
+        {
+            avatar = renderInBackground(key, source);
+        }
 
         if (_aimId.isEmpty() || _aimId == u"mail")
-            return result.first->second;
+            return avatar;
 
         auto requestedAvatarsIter = RequestedAvatars_.find(_aimId);
-        if ((requestedAvatarsIter == RequestedAvatars_.end() || (avatarByAimId.width() < _sizePx && avatarByAimId.height() < _sizePx)) && _aimId != Utils::getDefaultCallAvatarId())
+        if ((requestedAvatarsIter == RequestedAvatars_.end() || (source.width() < _sizePx && source.height() < _sizePx)) && _aimId != Utils::getDefaultCallAvatarId())
         {
             Ui::gui_coll_helper collection(Ui::GetDispatcher()->create_collection(), true);
             collection.set_value_as_qstring("contact", _aimId);
@@ -137,43 +122,34 @@ namespace Logic
             Ui::GetDispatcher()->post_message_to_core("avatars/show", collection.get());
         }
 
-        return result.first->second;
+        return avatar;
     }
 
     void AvatarStorage::SetAvatar(const QString& _aimId, const QPixmap& _pixmap)
     {
         im_assert(!_aimId.isEmpty());
 
-        auto iter = AvatarsByAimId_.find(_aimId);
-        if (iter == AvatarsByAimId_.end())
-            return;
+        // a decode of the previous picture still in flight must not overwrite this one
+        decoding_.erase(_aimId);
 
-        const auto size = iter->second.height();
-        auto scaled = _pixmap.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        const auto entry = cache_.find(sourceKey(_aimId));
+        if (!entry)
+            return;
 
-        iter->second = std::move(scaled);
+        const auto size = entry->source_.height();
+        auto scaled = _pixmap.toImage().scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
 
-        CleanupSecondaryCaches(_aimId);
+        cache_.remove(_aimId);
+        insertToCache(sourceKey(_aimId), { std::move(scaled), QPixmap(), false });
 
-        LoadedAvatars_.removeAll(_aimId);
-        LoadedAvatars_ << _aimId;
+        LoadedAvatars_.insert(_aimId);
 
         Q_EMIT avatarChanged(_aimId);
     }
 
-    const AvatarStorage::CacheMap &AvatarStorage::GetByAimIdAndSize() const
-    {
-        return AvatarsByAimIdAndSize_;
-    }
-
-    const AvatarStorage::CacheMap &AvatarStorage::GetByAimId() const
-    {
-        return AvatarsByAimId_;
-    }
-
-    const AvatarStorage::CacheMap &AvatarStorage::GetRoundedByAimId() const
+    const AvatarCache& AvatarStorage::GetCache() const
     {
-        return RoundedAvatarsByAimIdAndSize_;
+        return cache_;
     }
 
     bool AvatarStorage::isDefaultAvatar(const QString& _aimId) const
@@ -183,9 +159,7 @@ namespace Logic
 
     void AvatarStorage::onThemeChange()
     {
-        AvatarsByAimId_.erase(QString());
-        eraseUnnamedAvatars(AvatarsByAimIdAndSize_);
-        eraseUnnamedAvatars(RoundedAvatarsByAimIdAndSize_);
+        cache_.remove(QString());
     }
 
     void AvatarStorage::updateAvatar(const QString& _aimId, bool force)
@@ -193,25 +167,23 @@ namespace Logic
         if (!force && !isDefaultAvatar(_aimId))
             return;
 
-        if (TimesCache_.find(_aimId) != TimesCache_.end())
-        {
-            auto iter = AvatarsByAimId_.find(_aimId);
-            if (iter != AvatarsByAimId_.end() && _aimId != Utils::getDefaultCallAvatarId())
-            {
-                Ui::gui_coll_helper collection(Ui::GetDispatcher()->create_collection(), true);
-                collection.set_value_as_qstring("contact", _aimId);
-                collection.set_value_as_int("size", iter->second.height());
-                collection.set_value_as_bool("force", true);
-                auto seq = Ui::GetDispatcher()->post_message_to_core("avatars/get", collection.get());
-                requests_.insert(seq);
-            }
+        const auto entry = cache_.find(sourceKey(_aimId));
+        if (!entry)
+            return;
 
-            AvatarsByAimId_.erase(_aimId);
-            CleanupSecondaryCaches(_aimId, false);
-            RequestedAvatars_.erase(_aimId);
-            LoadedAvatars_.removeAll(_aimId);
-            TimesCache_.erase(_aimId);
+        if (_aimId != Utils::getDefaultCallAvatarId())
+        {
+            Ui::gui_coll_helper collection(Ui::GetDispatcher()->create_collection(), true);
+            collection.set_value_as_qstring("contact", _aimId);
+            collection.set_value_as_int("size", entry->source_.height());
+            collection.set_value_as_bool("force", true);
+            auto seq = Ui::GetDispatcher()->post_message_to_core("avatars/get", collection.get());
+            requests_.insert(seq);
         }
+
+        cache_.remove(_aimId, false);
+        RequestedAvatars_.erase(_aimId);
+        LoadedAvatars_.remove(_aimId);
     }
 
     void AvatarStorage::ForceRequest(const QString& _aimId, const int _sizePx)
@@ -231,14 +203,28 @@ namespace Logic
     {
         im_assert(_sizePx > 0);
 
-        const auto &avatar = Get(_aimId, _displayName, _sizePx, _isDefault, _regenerate);
+        const auto avatar = Get(_aimId, _displayName, _sizePx, _isDefault, _regenerate);
         if (avatar.isNull())
         {
             im_assert(!"avatar is null");
             return avatar;
         }
 
-        return GetRounded(avatar, _aimId, mini_icons, _isDefault);
+        const AvatarKey key = { _aimId, _sizePx, AvatarShape::Rounded };
+        if (const auto entry = cache_.find(key))
+            return entry->pixmap_;
+
+        QImage source;
+        if (const auto entry = cache_.find(sourceKey(_aimId)))
+            source = entry->source_;
+
+        if (source.isNull())
+        {
+            // evicted to fit the avatar just rendered
+            return Utils::roundImage(avatar, _isDefault, mini_icons);
+        }
+
+        return renderInBackground(key, source);
     }
 
     QString AvatarStorage::GetLocal(const QString& _aimId, const QString& _displayName, const int _sizePx)
@@ -257,7 +243,7 @@ namespace Logic
         return QFileInfo(file).absoluteFilePath();
     }
 
-    void AvatarStorage::avatarLoaded(int64_t _seq, const QString& _aimId, QPixmap& _pixmap, int _size, bool _result)
+    void AvatarStorage::avatarLoaded(int64_t _seq, const QString& _aimId, const QByteArray& _data, int _size, bool _result)
     {
         if (_seq != INITIAL_REQUEST_AVATAR_SEQ && !requests_.count(_seq))
             return;
@@ -268,162 +254,155 @@ namespace Logic
             return;
 
         if (_seq == INITIAL_REQUEST_AVATAR_SEQ)
-        {
             RequestedAvatars_.insert(_aimId);
-            TimesCache_[_aimId] = QDateTime::currentDateTime();
-        }
 
-        if (_pixmap.isNull())
+        if (_data.isEmpty())
         {
-            if (!LoadedAvatarsFails_.contains(_aimId) && _aimId != Utils::getDefaultCallAvatarId())
-            {
-                LoadedAvatarsFails_ << _aimId;
-                Ui::gui_coll_helper collection(Ui::GetDispatcher()->create_collection(), true);
-                collection.set_value_as_qstring("contact", _aimId);
-                collection.set_value_as_int("size", _size);
-                collection.set_value_as_bool("force", true);
-
-                auto seq = Ui::GetDispatcher()->post_message_to_core("avatars/get", collection.get());
-                requests_.insert(seq);
-            }
-
+            onLoadingFailed(_aimId, _size);
             return;
         }
 
         im_assert(!_aimId.isEmpty());
-        LoadedAvatarsFails_.removeAll(_aimId);
 
-        const auto avatarSize = QSize(_size, _size);
-        auto scaledImage = QPixmap(avatarSize);
-        if (_pixmap.width() == _pixmap.height())
-        {
-            scaledImage = _pixmap.scaled(avatarSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        }
-        else
+        const auto ticket = ++decodeTicket_;
+        decoding_[_aimId] = ticket;
+
+        auto task = AvatarRenderTask::decode(_data, _size, true);
+        connect(task, &AvatarRenderTask::rendered, this, [this, _aimId, _size, ticket](const QImage& _source, const QImage&, const QImage& _rounded)
         {
-            const auto cutAreaSize = avatarSize.scaled(_pixmap.size(), Qt::KeepAspectRatio);
-            auto cutArea = QRect(QPoint(), cutAreaSize);
-            cutArea.moveCenter(_pixmap.rect().center());
+            onDecoded(_aimId, _size, ticket, _source, _rounded);
+        });
+        pool_.start(task);
+    }
+
+    void AvatarStorage::onDecoded(const QString& _aimId, int _size, int64_t _ticket, const QImage& _source, const QImage& _rounded)
+    {
+        const auto it = decoding_.find(_aimId);
+        if (it == decoding_.end() || it->second != _ticket)
+            return;
 
-            scaledImage.fill(Qt::transparent);
+        decoding_.erase(it);
 
-            auto p = QPainter(&scaledImage);
-            p.setRenderHints(QPainter::SmoothPixmapTransform | QPainter::Antialiasing);
-            p.drawPixmap(scaledImage.rect(), _pixmap, cutArea);
+        if (_source.isNull())
+        {
+            onLoadingFailed(_aimId, _size);
+            return;
         }
-        AvatarsByAimId_[_aimId] = std::move(scaledImage);
 
-        CleanupSecondaryCaches(_aimId);
+        LoadedAvatarsFails_.remove(_aimId);
+
+        cache_.remove(_aimId);
+        insertToCache(sourceKey(_aimId), { _source, QPixmap(), false });
+
+        // the size asked for is the one to be shown first
+        if (_size > 0)
+        {
+            insertToCache({ _aimId, _size, AvatarShape::Square }, { QImage(), QPixmap::fromImage(_source), false });
+            insertToCache({ _aimId, _size, AvatarShape::Rounded }, { QImage(), QPixmap::fromImage(_rounded), false });
+        }
 
-        LoadedAvatars_ << _aimId;
+        LoadedAvatars_.insert(_aimId);
 
         Q_EMIT avatarChanged(_aimId);
     }
 
+    void AvatarStorage::onLoadingFailed(const QString& _aimId, int _size)
+    {
+        if (LoadedAvatarsFails_.contains(_aimId) || _aimId == Utils::getDefaultCallAvatarId())
+            return;
+
+        LoadedAvatarsFails_.insert(_aimId);
+        Ui::gui_coll_helper collection(Ui::GetDispatcher()->create_collection(), true);
+        collection.set_value_as_qstring("contact", _aimId);
+        collection.set_value_as_int("size", _size);
+        collection.set_value_as_bool("force", true);
+
+        auto seq = Ui::GetDispatcher()->post_message_to_core("avatars/get", collection.get());
+        requests_.insert(seq);
+    }
+
     void AvatarStorage::UpdateDefaultAvatarIfNeed(const QString& _aimId)
     {
         if (!isDefaultAvatar(_aimId))
             return;
 
-        if (AvatarsByAimId_.find(_aimId) != AvatarsByAimId_.end())
-            AvatarsByAimId_.erase(_aimId);
-        CleanupSecondaryCaches(_aimId);
+        cache_.remove(_aimId);
         Q_EMIT avatarChanged(_aimId);
     }
 
-    void AvatarStorage::cleanup()
+    void AvatarStorage::insertToCache(AvatarKey _key, AvatarCacheEntry _entry)
     {
-        const QDateTime now = QDateTime::currentDateTime();
-        const auto pages = Utils::InterConnector::instance().getVisibleHistoryPages();
-        for (auto iter = TimesCache_.begin(); iter != TimesCache_.end();)
+        // a contact without the source is requested again, as if it's never been shown
+        for (const auto& aimId : cache_.insert(std::move(_key), std::move(_entry)))
         {
-            if (iter->second.msecsTo(now) >= CLEANUP_TIMEOUT.count())
-            {
-                const auto& aimId = iter->first;
-                if (Logic::getContactListModel()->contains(aimId) || std::any_of(pages.begin(), pages.end(), [&aimId](auto p) { return p->contains(aimId); }))
-                {
-                    iter->second = now;
-                    ++iter;
-                    continue;
-                }
-
-                AvatarsByAimId_.erase(aimId);
-                CleanupSecondaryCaches(aimId);
-                RequestedAvatars_.erase(aimId);
-                LoadedAvatars_.removeAll(aimId);
-                iter = TimesCache_.erase(iter);
-            }
-            else
-            {
-                ++iter;
-            }
+            cache_.remove(aimId);
+            RequestedAvatars_.erase(aimId);
+            LoadedAvatars_.remove(aimId);
         }
     }
 
-    // TODO : use two-step hash here
-    void AvatarStorage::CleanupSecondaryCaches(QStringView _aimId, bool _isRoundedAvatarsClean)
+    QPixmap AvatarStorage::renderInBackground(const AvatarKey& _key, const QImage& _source)
     {
-        const auto cleanupSecondaryCache = [](CacheMap &cache, QStringView aimid)
-        {
-            for (auto i = cache.begin(); i != cache.end(); ++i)
-            {
-                const auto &key = i->first;
-                if (!key.startsWith(aimid))
-                {
-                    continue;
-                }
-
-                for(;;)
-                {
-                    i = cache.erase(i);
-
-                    if (i == cache.end())
-                    {
-                        break;
-                    }
-
-                    const auto &k = i->first;
-                    if (!k.startsWith(aimid))
-                    {
-                        break;
-                    }
-                }
-
-                break;
-            }
-        };
+        const auto side = scaledSide(_source);
+        auto placeholder = QPixmap::fromImage(side == _source.width() ? _source.scaledToWidth(_key.size_) : _source.scaledToHeight(_key.size_));
+        if (_key.shape_ == AvatarShape::Rounded)
+            placeholder = Utils::roundImage(placeholder, false, false);
 
-        const auto aimid = _aimId.isEmpty() ? QStringView(u"default") : _aimId;
+        insertToCache(_key, { QImage(), placeholder, true });
 
-        if (_isRoundedAvatarsClean)
-            cleanupSecondaryCache(RoundedAvatarsByAimIdAndSize_, aimid);
+        if (rendering_.insert(_key).second)
+            startRender(_key, _source);
 
-        cleanupSecondaryCache(AvatarsByAimIdAndSize_, aimid);
+        return placeholder;
     }
 
-    QPixmap AvatarStorage::GetRounded(const QPixmap& _avatar, const QString& _aimId, bool mini_icons, bool _isDefault)
+    void AvatarStorage::startRender(const AvatarKey& _key, const QImage& _source)
     {
-        im_assert(!_avatar.isNull());
+        auto task = AvatarRenderTask::scale(_source, _key.size_, _key.shape_ == AvatarShape::Rounded);
+        connect(task, &AvatarRenderTask::rendered, this, [this, _key, sourceCacheKey = _source.cacheKey()](const QImage&, const QImage& _square, const QImage& _rounded)
+        {
+            onRendered(_key, sourceCacheKey, _key.shape_ == AvatarShape::Rounded ? _rounded : _square);
+        });
+        pool_.start(task);
+    }
 
-        const QString key = CreateKey(_aimId, _avatar.width());
+    void AvatarStorage::onRendered(const AvatarKey& _key, qint64 _sourceCacheKey, const QImage& _image)
+    {
+        rendering_.erase(_key);
+
+        // the placeholder is gone with the avatar it stood for
+        const auto entry = cache_.find(_key);
+        if (!entry || !entry->provisional_)
+            return;
 
-        auto i = RoundedAvatarsByAimIdAndSize_.find(key);
-        if (i == RoundedAvatarsByAimIdAndSize_.end())
+        const auto source = cache_.find(sourceKey(_key.aimId_));
+        if (!source)
         {
-            auto roundedAvatar = Utils::roundImage(_avatar, _isDefault, mini_icons);
-            i = RoundedAvatarsByAimIdAndSize_
-                .emplace(
-                    key,
-                    std::move(roundedAvatar))
-                .first;
+            cache_.remove(_key);
+            return;
+        }
+
+        // the source has changed while rendering, the placeholder waits for the new one
+        if (source->source_.cacheKey() != _sourceCacheKey)
+        {
+            rendering_.insert(_key);
+            startRender(_key, source->source_);
+            return;
         }
 
-        return i->second;
+        if (_image.isNull())
+        {
+            cache_.remove(_key);
+            return;
+        }
+
+        insertToCache(_key, { QImage(), QPixmap::fromImage(_image), false });
+
+        Q_EMIT avatarChanged(_key.aimId_);
     }
 
     AvatarStorage* GetAvatarStorage()
     {
         static std::unique_ptr<AvatarStorage> storage(new AvatarStorage());
         return storage.get();
-    }
-}
\ No newline at end of file
+    }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../../types/contact.h"
+#include "AvatarCache.h"
 
 namespace Logic
 {
@@ -14,9 +15,7 @@ namespace Logic
         void avatarChanged(const QString& aimId);
 
     private Q_SLOTS:
-        void avatarLoaded(int64_t _seq, const QString& _aimId, QPixmap& _avatar, int _size, bool _result);
-
-        void cleanup();
+        void avatarLoaded(int64_t _seq, const QString& _aimId, const QByteArray& _data, int _size, bool _result);
 
     public Q_SLOTS:
         void updateAvatar(const QString& _aimId, bool force = true);
@@ -24,6 +23,8 @@ namespace Logic
     public:
         ~AvatarStorage();
 
+        // a loaded avatar missing in the size asked for is scaled in the background,
+        // a quick placeholder is returned meanwhile and avatarChanged is emitted when it's ready
         QPixmap Get(const QString& _aimId, const QString& _displayName, const int _sizePx, bool& _isDefault, bool _regenerate);
 
         QPixmap GetRounded(const QString& _aimId, const QString& _displayName, const int _sizePx, bool& _isDefault, bool _regenerate, bool mini_icons);
@@ -35,39 +36,42 @@ namespace Logic
 
         void SetAvatar(const QString& _aimId, const QPixmap& _pixmap);
 
-        using CacheMap = std::map<QString, QPixmap>;
-        const CacheMap& GetByAimIdAndSize() const;
-        const CacheMap& GetByAimId() const;
-        const CacheMap& GetRoundedByAimId() const;
+        const AvatarCache& GetCache() const;
 
         bool isDefaultAvatar(const QString& _aimId) const;
 
     private:
         AvatarStorage();
 
-        void CleanupSecondaryCaches(QStringView _aimId, bool _isRoundedAvatarsClean = true);
+        void insertToCache(AvatarKey _key, AvatarCacheEntry _entry);
+
+        QPixmap renderInBackground(const AvatarKey& _key, const QImage& _source);
+        void startRender(const AvatarKey& _key, const QImage& _source);
+        void onRendered(const AvatarKey& _key, qint64 _sourceCacheKey, const QImage& _image);
 
-        QPixmap GetRounded(const QPixmap& _avatar, const QString& _aimId, bool mini_icons, bool _isDefault);
+        void onDecoded(const QString& _aimId, int _size, int64_t _ticket, const QImage& _source, const QImage& _rounded);
+        void onLoadingFailed(const QString& _aimId, int _size);
 
     private Q_SLOTS:
         void onThemeChange();
 
     private:
-        CacheMap AvatarsByAimIdAndSize_;
+        AvatarCache cache_;
 
-        CacheMap AvatarsByAimId_;
+        QThreadPool pool_;
 
-        CacheMap RoundedAvatarsByAimIdAndSize_;
+        // renders in flight, a placeholder stands in the cache for each
+        std::set<AvatarKey> rendering_;
 
-        std::set<QString> RequestedAvatars_;
+        // the latest picture being decoded for the contact, the ones received before it are dropped
+        std::map<QString, int64_t> decoding_;
+        int64_t decodeTicket_ = 0;
 
-        QStringList LoadedAvatars_;
-
-        QStringList LoadedAvatarsFails_;
+        std::set<QString> RequestedAvatars_;
 
-        std::map<QString, QDateTime> TimesCache_;
+        QSet<QString> LoadedAvatars_;
 
-        QTimer* Timer_;
+        QSet<QString> LoadedAvatarsFails_;
 
         std::set<int64_t> requests_;
     };
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 
 #include "Emoji.h"
+#include "EmojiAtlas.h"
 #include "EmojiDb.h"
 
 #include "../../utils/SChar.h"
@@ -18,15 +19,63 @@ namespace
 {
     using namespace Emoji;
 
-    std::unordered_map<int64_t, const QImage> EmojiCache_;
+    struct CachedEmoji
+    {
+        QImage image_;
+        std::list<int64_t>::iterator recent_;
+    };
+
+    // emojis rasterized on the gui thread while their size has no atlas, the most recent first
+    std::unordered_map<int64_t, CachedEmoji> EmojiCache_;
+    std::list<int64_t> RecentEmojis_;
+    qint64 EmojiCacheSize_ = 0;
+
+    std::unordered_map<int64_t, std::unique_ptr<EmojiAtlas>> EmojiAtlases_;
 
     std::unordered_map<QString, QString, Utils::QStringHasher> EmojiFilePathCache_;
 
+    constexpr qint64 emojiCacheBudget() noexcept { return 16 * 1024 * 1024; }
+
+    // a 64px atlas is about 55MB on disk, bigger sizes are rare enough for the cache
+    constexpr int32_t maxAtlasSizePx() noexcept { return 64; }
+    constexpr size_t maxAtlasCount() noexcept { return 4; }
+
     constexpr int64_t MakeCacheKey(int32_t _index, int32_t _sizePx) noexcept
     {
         return int64_t(_index) | (int64_t(_sizePx) << 32);
     }
 
+    QImage findCachedEmoji(int64_t _key)
+    {
+        const auto it = EmojiCache_.find(_key);
+        if (it == EmojiCache_.end())
+            return QImage();
+
+        RecentEmojis_.splice(RecentEmojis_.begin(), RecentEmojis_, it->second.recent_);
+        return it->second.image_;
+    }
+
+    void cacheEmoji(int64_t _key, const QImage& _image)
+    {
+        RecentEmojis_.push_front(_key);
+        EmojiCache_.insert({ _key, { _image, RecentEmojis_.begin() } });
+        EmojiCacheSize_ += _image.sizeInBytes();
+
+        while (EmojiCacheSize_ > emojiCacheBudget() && RecentEmojis_.size() > 1)
+        {
+            const auto it = EmojiCache_.find(RecentEmojis_.back());
+            im_assert(it != EmojiCache_.end());
+            EmojiCacheSize_ -= it->second.image_.sizeInBytes();
+            EmojiCache_.erase(it);
+            RecentEmojis_.pop_back();
+        }
+    }
+
+    QString getEmojiAtlasDir()
+    {
+        return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) % u"/emoji";
+    }
+
     const std::vector<std::pair<int32_t, QString>>& appleEmojiSizes()
     {
         static const std::vector<std::pair<int32_t, QString>> sizes = { {104, qsl("104")} }; // only one size currently, but may change in the future
@@ -106,6 +155,9 @@ namespace Emoji
     void Cleanup()
     {
         EmojiCache_.clear();
+        RecentEmojis_.clear();
+        EmojiCacheSize_ = 0;
+        EmojiAtlases_.clear();
     }
 
     Emoji::EmojiSizePx getEmojiSize() noexcept
@@ -209,6 +261,41 @@ namespace Emoji
         return image;
     }
 
+    // runs in the thread pool, so it doesn't go through the path cache of getEmojiFilePath
+    static QImage renderAtlasEmoji(QLatin1String _base, int32_t _sizePx, bool _apple)
+    {
+        if (_apple)
+            return getEmoji_png(getAppleEmojiFullPath(_base, _sizePx), _sizePx);
+        else
+            return getEmoji_svg(getEmojiOneFullPath(_base), _sizePx);
+    }
+
+    static EmojiAtlas* getEmojiAtlas(int32_t _sizePx)
+    {
+        if (_sizePx > maxAtlasSizePx())
+            return nullptr;
+
+        const auto useAppleEmoji = Features::useAppleEmoji();
+        const auto key = MakeCacheKey(useAppleEmoji ? 1 : 0, _sizePx);
+        if (const auto it = EmojiAtlases_.find(key); it != EmojiAtlases_.end())
+            return it->second.get();
+
+        if (EmojiAtlases_.size() >= maxAtlasCount())
+            return nullptr;
+
+        const auto& records = GetEmojiRecords();
+        EmojiAtlas::Sources sources;
+        sources.reserve(records.size());
+        for (const auto& record : records)
+            sources.push_back({ record.Index_, record.FileName_ });
+
+        auto& atlas = EmojiAtlases_[key];
+        atlas = std::make_unique<EmojiAtlas>(getEmojiAtlasDir(), _sizePx, useAppleEmoji);
+        atlas->open(std::move(sources), renderAtlasEmoji);
+
+        return atlas.get();
+    }
+
     static QImage getEmojiImage(QLatin1String _base, int32_t _sizePx)
     {
         const auto useAppleEmoji = Features::useAppleEmoji();
@@ -234,14 +321,23 @@ namespace Emoji
         im_assert(info.FileName_.size() > 0);
 
         const auto key = MakeCacheKey(info.Index_, _sizePx);
-        if (const auto cacheIter = std::as_const(EmojiCache_).find(key); cacheIter != std::as_const(EmojiCache_).end())
+        if (auto cached = findCachedEmoji(key); !cached.isNull())
+            return cached;
+
+#if defined(__APPLE__)
+        const auto nativeEmoji = useNativeEmoji() && mac::supportEmoji(_code);
+#else
+        constexpr auto nativeEmoji = false;
+#endif
+        // the atlas keeps its images itself, they aren't counted against the cache budget
+        if (auto atlas = nativeEmoji ? nullptr : getEmojiAtlas(_sizePx))
         {
-            im_assert(!cacheIter->second.isNull());
-            return cacheIter->second;
+            if (auto image = atlas->get(info.Index_); !image.isNull())
+                return image;
         }
 
 #if defined(__APPLE__)
-        auto image = useNativeEmoji() && mac::supportEmoji(_code) ? getEmoji_mac(_code, _sizePx) : getEmojiImage(info.FileName_, _sizePx);
+        auto image = nativeEmoji ? getEmoji_mac(_code, _sizePx) : getEmojiImage(info.FileName_, _sizePx);
 #else
         auto image = getEmojiImage(info.FileName_, _sizePx);
 #endif
@@ -255,7 +351,7 @@ namespace Emoji
         image = filled;
 #endif //DEBUG_EMOJI
 
-        EmojiCache_.insert({ key, image });
+        cacheEmoji(key, image);
 
         return image;
     }
@@ -321,9 +417,24 @@ namespace Emoji
     }
 
     // This is meant to be used for "debug" purposes only
-    const std::unordered_map<int64_t, const QImage> &GetEmojiCache()
+    EmojiCacheStats GetEmojiCacheStats()
     {
-        return EmojiCache_;
+        EmojiCacheStats stats;
+
+        stats.rasterized_.reserve(EmojiCache_.size());
+        for (const auto& [_, cached] : EmojiCache_)
+            stats.rasterized_.push_back(cached.image_);
+
+        for (const auto& [_, atlas] : EmojiAtlases_)
+        {
+            if (!atlas->isReady())
+                continue;
+
+            stats.atlasSizes_.push_back(atlas->sizePx());
+            stats.atlasMappedSize_ += atlas->mappedSize();
+        }
+
+        return stats;
     }
 
     bool isSupported(QLatin1String _filename)
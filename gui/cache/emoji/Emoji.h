@@ -41,8 +41,15 @@ namespace Emoji
 
     bool isSupported(QLatin1String _filename);
 
+    struct EmojiCacheStats
+    {
+        std::vector<QImage> rasterized_;
+        std::vector<int32_t> atlasSizes_;
+        qint64 atlasMappedSize_ = 0;
+    };
+
     // This is meant to be used for "debug" purposes only
-    const std::unordered_map<int64_t, const QImage>& GetEmojiCache();
+    EmojiCacheStats GetEmojiCacheStats();
 
     int32_t GetEmojiSizeForCurrentUiScale();
 }
@@ -0,0 +1,242 @@
+#include "stdafx.h"
+
+#include "EmojiAtlas.h"
+
+#include <QSaveFile>
+
+#include "../../../common.shared/version_info_constants.h"
+
+namespace
+{
+    constexpr quint32 atlasMagic = 0x414A4D45; // EMJA
+    constexpr quint32 atlasVersion = 1;
+
+    constexpr qint64 tileBytes(int32_t _sizePx) noexcept
+    {
+        return qint64(_sizePx) * _sizePx * 4;
+    }
+
+    void releaseMapping(void* _file)
+    {
+        delete static_cast<std::shared_ptr<QFile>*>(_file);
+    }
+}
+
+namespace Emoji
+{
+    struct EmojiAtlas::Header
+    {
+        quint32 magic_;
+        quint32 version_;
+        quint32 sourcesHash_;
+        qint32 sizePx_;
+        qint32 apple_;
+        qint32 slotsCount_;
+        qint32 tilesCount_;
+        qint32 reserved_;
+    };
+
+    struct EmojiAtlas::BuildState
+    {
+        std::atomic<bool> finished_{ false };
+        std::atomic<bool> cancelled_{ false };
+    };
+
+    class EmojiAtlas::BuildTask : public QRunnable
+    {
+    public:
+        BuildTask(QString _fileName, int32_t _sizePx, bool _apple, quint32 _sourcesHash, Sources _sources, Renderer _renderer, std::shared_ptr<BuildState> _state)
+            : fileName_(std::move(_fileName))
+            , sizePx_(_sizePx)
+            , apple_(_apple)
+            , sourcesHash_(_sourcesHash)
+            , sources_(std::move(_sources))
+            , renderer_(_renderer)
+            , state_(std::move(_state))
+        {
+        }
+
+        void run() override
+        {
+            build();
+            state_->finished_.store(true, std::memory_order_release);
+        }
+
+    private:
+        void build()
+        {
+            int maxIndex = -1;
+            for (const auto& source : sources_)
+                maxIndex = std::max(maxIndex, source.index_);
+
+            std::vector<qint32> slots(size_t(maxIndex + 1), -1);
+            qint32 tilesCount = 0;
+            for (const auto& source : sources_)
+            {
+                if (source.index_ >= 0 && slots[source.index_] < 0)
+                    slots[source.index_] = tilesCount++;
+            }
+
+            if (!QDir().mkpath(QFileInfo(fileName_).absolutePath()))
+                return;
+
+            // QSaveFile replaces the atlas only on commit, a killed build leaves no broken file
+            QSaveFile file(fileName_);
+            if (!file.open(QIODevice::WriteOnly))
+                return;
+
+            Header header;
+            header.magic_ = atlasMagic;
+            header.version_ = atlasVersion;
+            header.sourcesHash_ = sourcesHash_;
+            header.sizePx_ = sizePx_;
+            header.apple_ = apple_ ? 1 : 0;
+            header.slotsCount_ = qint32(slots.size());
+            header.tilesCount_ = tilesCount;
+            header.reserved_ = 0;
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(slots.data()), qint64(slots.size() * sizeof(qint32)));
+
+            const auto lineSize = qint64(sizePx_) * 4;
+            qint32 written = 0;
+            for (const auto& source : sources_)
+            {
+                if (state_->cancelled_.load(std::memory_order_relaxed))
+                    return;
+
+                if (source.index_ < 0 || slots[source.index_] != written)
+                    continue;
+
+                auto image = renderer_(source.fileName_, sizePx_, apple_);
+                if (image.isNull())
+                {
+                    image = QImage(sizePx_, sizePx_, QImage::Format_ARGB32_Premultiplied);
+                    image.fill(Qt::transparent);
+                }
+                else if (image.width() != sizePx_ || image.height() != sizePx_)
+                {
+                    image = image.scaled(sizePx_, sizePx_, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+                }
+
+                if (image.format() != QImage::Format_ARGB32_Premultiplied)
+                    image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+                for (int y = 0; y < sizePx_; ++y)
+                    file.write(reinterpret_cast<const char*>(image.constScanLine(y)), lineSize);
+
+                ++written;
+            }
+
+            im_assert(written == tilesCount);
+            file.commit();
+        }
+
+        const QString fileName_;
+        const int32_t sizePx_;
+        const bool apple_;
+        const quint32 sourcesHash_;
+        const Sources sources_;
+        const Renderer renderer_;
+        const std::shared_ptr<BuildState> state_;
+    };
+
+    EmojiAtlas::EmojiAtlas(const QString& _dir, int32_t _sizePx, bool _apple)
+        : fileName_(_dir % (_apple ? ql1s("/apple_") : ql1s("/svg_")) % QString::number(_sizePx) % u".atlas")
+        , sizePx_(_sizePx)
+        , apple_(_apple)
+    {
+        im_assert(sizePx_ > 0);
+    }
+
+    EmojiAtlas::~EmojiAtlas()
+    {
+        if (build_)
+            build_->cancelled_ = true;
+    }
+
+    void EmojiAtlas::open(Sources _sources, Renderer _renderer)
+    {
+        im_assert(!isReady() && !build_);
+        im_assert(_renderer);
+
+        sourcesHash_ = qHash(QLatin1String(VERSION_INFO_STR));
+        for (const auto& source : _sources)
+        {
+            sourcesHash_ = qHash(source.index_, sourcesHash_);
+            sourcesHash_ = qHash(source.fileName_, sourcesHash_);
+        }
+
+        if (map())
+            return;
+
+        build_ = std::make_shared<BuildState>();
+        QThreadPool::globalInstance()->start(new BuildTask(fileName_, sizePx_, apple_, sourcesHash_, std::move(_sources), _renderer, build_));
+    }
+
+    QImage EmojiAtlas::get(int _index)
+    {
+        if (!isReady())
+        {
+            if (!build_ || !build_->finished_.load(std::memory_order_acquire))
+                return QImage();
+
+            // a failed build isn't retried until the next run
+            build_.reset();
+            if (!map())
+                return QImage();
+        }
+
+        if (_index < 0 || _index >= slotsCount_)
+            return QImage();
+
+        const auto slot = slots_[_index];
+        if (slot < 0 || slot >= qint32(images_.size()))
+            return QImage();
+
+        auto& image = images_[slot];
+        if (image.isNull())
+        {
+            const auto data = tiles_ + slot * tileBytes(sizePx_);
+            image = QImage(data, sizePx_, sizePx_, sizePx_ * 4, QImage::Format_ARGB32_Premultiplied, releaseMapping, new std::shared_ptr<QFile>(file_));
+        }
+
+        return image;
+    }
+
+    bool EmojiAtlas::map()
+    {
+        static_assert(sizeof(Header) == 32);
+
+        auto file = std::make_shared<QFile>(fileName_);
+        if (!file->open(QIODevice::ReadOnly) || file->size() < qint64(sizeof(Header)))
+            return false;
+
+        const auto data = file->map(0, file->size());
+        if (!data)
+            return false;
+
+        Header header;
+        memcpy(&header, data, sizeof(header));
+
+        if (header.magic_ != atlasMagic || header.version_ != atlasVersion || header.sourcesHash_ != sourcesHash_)
+            return false;
+
+        if (header.sizePx_ != sizePx_ || header.apple_ != (apple_ ? 1 : 0) || header.slotsCount_ < 0 || header.tilesCount_ < 0)
+            return false;
+
+        const auto slotsSize = qint64(header.slotsCount_) * qint64(sizeof(qint32));
+        if (file->size() != qint64(sizeof(header)) + slotsSize + header.tilesCount_ * tileBytes(sizePx_))
+            return false;
+
+        slots_ = reinterpret_cast<const qint32*>(data + sizeof(header));
+        slotsCount_ = header.slotsCount_;
+        tiles_ = data + sizeof(header) + slotsSize;
+        images_.resize(size_t(header.tilesCount_));
+
+        file_ = std::move(file);
+        data_ = data;
+
+        return true;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+namespace Emoji
+{
+    // pre-rasterized emojis of one pixel size, kept in a file and mapped into memory
+    //
+    // the file is a header, a table of tile slots by emoji index and the ARGB32 premultiplied tiles.
+    // it's built in the background the first time the size is needed and reused by the next runs
+    // while the app version, the emoji set and the emoji list stay the same
+    class EmojiAtlas
+    {
+    public:
+        struct Source
+        {
+            int index_ = -1;
+            QLatin1String fileName_;
+        };
+
+        using Sources = std::vector<Source>;
+
+        // called from the thread pool, must not touch the gui thread state
+        using Renderer = QImage(*)(QLatin1String _fileName, int32_t _sizePx, bool _apple);
+
+        EmojiAtlas(const QString& _dir, int32_t _sizePx, bool _apple);
+        ~EmojiAtlas();
+
+        EmojiAtlas(const EmojiAtlas&) = delete;
+        EmojiAtlas& operator=(const EmojiAtlas&) = delete;
+
+        // maps the atlas file or starts building it if it's missing or stale
+        void open(Sources _sources, Renderer _renderer);
+
+        // null image if the atlas isn't ready yet or has no such emoji
+        QImage get(int _index);
+
+        bool isReady() const noexcept { return data_ != nullptr; }
+        int32_t sizePx() const noexcept { return sizePx_; }
+        qint64 mappedSize() const noexcept { return isReady() ? file_->size() : 0; }
+
+    private:
+        struct Header;
+        struct BuildState;
+        class BuildTask;
+
+        bool map();
+
+        const QString fileName_;
+        const int32_t sizePx_;
+        const bool apple_;
+
+        quint32 sourcesHash_ = 0;
+        std::shared_ptr<BuildState> build_;
+
+        // shared with the images so the mapping outlives the atlas if they are still in use
+        std::shared_ptr<QFile> file_;
+        const uchar* data_ = nullptr;
+        const qint32* slots_ = nullptr;
+        qint32 slotsCount_ = 0;
+        const uchar* tiles_ = nullptr;
+        std::vector<QImage> images_;
+    };
+}
@@ -210,6 +210,13 @@ namespace Emoji
         }
     }
 
+    const EmojiRecordVec& GetEmojiRecords()
+    {
+        im_assert(!EmojiIndexByOrder_.empty());
+
+        return EmojiIndexByOrder_;
+    }
+
     bool isEmoji(const EmojiCode& _code)
     {
         im_assert(!_code.isNull());
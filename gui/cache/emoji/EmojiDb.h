@@ -48,6 +48,8 @@ namespace Emoji
 
     void InitEmojiDb();
 
+    const EmojiRecordVec& GetEmojiRecords();
+
     bool isEmoji(const EmojiCode& _code);
 
     const EmojiRecord& GetEmojiInfoByCodepoint(const EmojiCode& _code);
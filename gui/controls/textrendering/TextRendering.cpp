@@ -2,6 +2,7 @@
 
 #include "TextRenderingUtils.h"
 #include "TextRendering.h"
+#include "TextShapingCache.h"
 #include "FormattedTextRendering.h"
 #include "TextWordRenderer.h"
 
@@ -382,9 +383,10 @@ namespace Ui::TextRendering
             if (isEmoji())
                 cachedWidth_ = emojiSize_;
             else
-                cachedWidth_ = _isLastWord && italic()
-                    ? textVisibleWidth(font_, plainVisibleTextNoEndSpace().toString())
-                    : textWidth(font_, plainVisibleTextNoEndSpace().toString());
+                cachedWidth_ = ShapingCache::instance().width(
+                    font_,
+                    plainVisibleTextNoEndSpace().toString(),
+                    _isLastWord && italic() ? ShapingBounds::Visible : ShapingBounds::Advance);
         }
         else
         {
@@ -0,0 +1,105 @@
+#include "stdafx.h"
+
+#include "TextShapingCache.h"
+#include "TextRenderingUtils.h"
+
+#include "utils/async/AsyncTask.h"
+
+namespace
+{
+    // longer words are split by the width anyway and rarely repeat
+    constexpr qsizetype maxPrefetchedWordSize() noexcept { return 64; }
+
+    std::vector<QString> splitBySpaces(const std::vector<QString>& _texts)
+    {
+        std::vector<QString> words;
+        for (const auto& text : _texts)
+        {
+            qsizetype wordStart = 0;
+            for (qsizetype i = 0; i <= text.size(); ++i)
+            {
+                if (i != text.size() && !text.at(i).isSpace())
+                    continue;
+
+                if (const auto size = i - wordStart; size > 0 && size <= maxPrefetchedWordSize())
+                    words.push_back(text.mid(wordStart, size));
+                wordStart = i + 1;
+            }
+        }
+
+        std::sort(words.begin(), words.end());
+        words.erase(std::unique(words.begin(), words.end()), words.end());
+        return words;
+    }
+}
+
+namespace Ui
+{
+    namespace TextRendering
+    {
+        ShapingCache& ShapingCache::instance()
+        {
+            static ShapingCache cache;
+            return cache;
+        }
+
+        double ShapingCache::width(const QFont& _font, const QString& _word, ShapingBounds _bounds)
+        {
+            Key key{ _font, _word, _bounds };
+            if (const auto cached = find(key))
+                return *cached;
+
+            // getMetrics isn't shared with the pool, the misses are measured on the gui thread only
+            const auto width = _bounds == ShapingBounds::Visible ? textVisibleWidth(_font, _word) : textWidth(_font, _word);
+            insert(std::move(key), width);
+            return width;
+        }
+
+        void ShapingCache::prefetch(const QFont& _font, std::vector<QString> _texts)
+        {
+            if (_texts.empty())
+                return;
+
+            Async::runAsync([this, _font, texts = std::move(_texts)]()
+            {
+                const QFontMetricsF metrics(_font);
+                for (auto& word : splitBySpaces(texts))
+                {
+                    Key key{ _font, std::move(word), ShapingBounds::Advance };
+                    if (!find(key))
+                    {
+                        const auto width = metrics.horizontalAdvance(key.word_);
+                        insert(std::move(key), width);
+                    }
+                }
+            });
+        }
+
+        std::optional<double> ShapingCache::find(const Key& _key)
+        {
+            std::scoped_lock lock(mutex_);
+            if (const auto it = current_.find(_key); it != current_.end())
+                return it->second;
+
+            if (const auto it = previous_.find(_key); it != previous_.end())
+            {
+                const auto width = it->second;
+                current_.insert(previous_.extract(it));
+                return width;
+            }
+
+            return std::nullopt;
+        }
+
+        void ShapingCache::insert(Key&& _key, double _width)
+        {
+            std::scoped_lock lock(mutex_);
+            if (current_.size() >= maxSize)
+            {
+                previous_ = std::move(current_);
+                current_.clear();
+            }
+            current_.insert_or_assign(std::move(_key), _width);
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+namespace Ui
+{
+    namespace TextRendering
+    {
+        enum class ShapingBounds
+        {
+            Advance,
+            Visible, // see textVisibleWidth
+        };
+
+        // widths of the words shaped with a font, shared by all the text blocks of the process.
+        // the layout fills it on the gui thread, the words of the arriving messages are measured
+        // ahead on the pool by prefetch, so a relayout is mostly the wrap pass over cached widths.
+        // width is called on the gui thread, prefetch may be called from any
+        class ShapingCache
+        {
+        public:
+            // per generation, the previous one is dropped when the current one is full
+            static constexpr size_t maxSize = 16 * 1024;
+
+            static ShapingCache& instance();
+
+            double width(const QFont& _font, const QString& _word, ShapingBounds _bounds = ShapingBounds::Advance);
+
+            // splits _texts by spaces and measures the words not cached yet on the pool
+            void prefetch(const QFont& _font, std::vector<QString> _texts);
+
+        private:
+            ShapingCache() = default;
+
+            struct Key
+            {
+                QFont font_;
+                QString word_;
+                ShapingBounds bounds_;
+
+                bool operator==(const Key& _other) const
+                {
+                    return bounds_ == _other.bounds_ && word_ == _other.word_ && font_ == _other.font_;
+                }
+            };
+
+            struct KeyHash
+            {
+                size_t operator()(const Key& _key) const noexcept
+                {
+                    return size_t(qHash(_key.word_, qHash(_key.font_))) ^ size_t(_key.bounds_);
+                }
+            };
+
+            using Widths = std::unordered_map<Key, double, KeyHash>;
+
+            std::optional<double> find(const Key& _key);
+            void insert(Key&& _key, double _width);
+
+            std::mutex mutex_;
+            Widths current_;
+            Widths previous_;
+        };
+    }
+}
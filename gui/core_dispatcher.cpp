@@ -33,6 +33,7 @@
 #include "../common.shared/loader_errors.h"
 #include "../common.shared/version_info.h"
 #include "../common.shared/config/config.h"
+#include "../common.shared/message_table.h"
 #include "memory_stats/gui_memory_monitor.h"
 #include "main_window/LocalPIN.h"
 #include "omicron/omicron_helper.h"
@@ -53,6 +54,17 @@ using namespace Ui;
 
 namespace
 {
+    constexpr std::string_view core_message_names[] =
+    {
+#define CORE_MESSAGE(_message_string, _callback) _message_string,
+#include "core_dispatcher_messages.inc"
+#undef CORE_MESSAGE
+    };
+
+    // the message name is resolved to its handler index on the core thread, the gui thread only indexes
+    constexpr common::message_table core_messages(core_message_names);
+    static_assert(core_messages.is_collision_free(), "core message names must be unique");
+
     using highlightsV = std::vector<QString>;
     Ui::highlightsV unserializeHighlights(const core::coll_helper& _helper)
     {
@@ -255,7 +267,7 @@ void Ui::gui_connector::receive(std::string_view _message, int64_t _seq, core::i
     if (_messageData)
         _messageData->addref();
 
-    Q_EMIT received(QString::fromLatin1(_message.data(), _message.size()), _seq, _messageData);
+    Q_EMIT received(int(core_messages.find(_message)), _seq, _messageData);
 }
 
 core_dispatcher::core_dispatcher()
@@ -900,262 +912,14 @@ bool core_dispatcher::init()
 
 void core_dispatcher::initMessageMap()
 {
-    REGISTER_IM_MESSAGE("need_login", onNeedLogin);
-    REGISTER_IM_MESSAGE("need_external_user_agreement", onNeedExternalUserAgreement);
-    REGISTER_IM_MESSAGE("im/created", onImCreated);
-    REGISTER_IM_MESSAGE("login/require_oauth", onOAuthRequired);
-    REGISTER_IM_MESSAGE("login/complete", onLoginComplete);
-    REGISTER_IM_MESSAGE("contactlist", onContactList);
-    REGISTER_IM_MESSAGE("contactlist/diff", onContactList);
-    REGISTER_IM_MESSAGE("login_get_sms_code_result", onLoginGetSmsCodeResult);
-    REGISTER_IM_MESSAGE("login_result", onLoginResult);
-    REGISTER_IM_MESSAGE("avatars/get/result", onAvatarsGetResult);
-    REGISTER_IM_MESSAGE("avatars/presence/updated", onAvatarsPresenceUpdated);
-    REGISTER_IM_MESSAGE("contact/presence", onContactPresence);
-    REGISTER_IM_MESSAGE("contact/outgoing_count", onContactOutgoingMsgCount);
-    REGISTER_IM_MESSAGE("gui_settings", onGuiSettings);
-    REGISTER_IM_MESSAGE("core/logins", onCoreLogins);
-    REGISTER_IM_MESSAGE("archive/messages/get/result", onArchiveMessagesGetResult);
-    REGISTER_IM_MESSAGE("archive/messages/pending", onArchiveMessagesPending);
-    REGISTER_IM_MESSAGE("archive/buddies/get/result", onArchiveBuddiesGetResult);
-    REGISTER_IM_MESSAGE("archive/mentions/get/result", onArchiveMentionsGetResult);
-    REGISTER_IM_MESSAGE("messages/received/dlg_state", onMessagesReceivedDlgState);
-    REGISTER_IM_MESSAGE("messages/received/server", onMessagesReceivedServer);
-    REGISTER_IM_MESSAGE("messages/received/search_mode", onMessagesReceivedSearch);
-    REGISTER_IM_MESSAGE("messages/received/updated", onMessagesReceivedUpdated);
-    REGISTER_IM_MESSAGE("messages/received/patched/modified", onMessagesReceivedPatched);
-    REGISTER_IM_MESSAGE("messages/received/init", onMessagesReceivedInit);
-    REGISTER_IM_MESSAGE("messages/received/context", onMessagesReceivedContext);
-    REGISTER_IM_MESSAGE("messages/load_after_search/error", onMessagesLoadAfterSearchError);
-    REGISTER_IM_MESSAGE("messages/context/error", onMessagesContextError);
-    REGISTER_IM_MESSAGE("messages/received/message_status", onMessagesReceivedMessageStatus);
-    REGISTER_IM_MESSAGE("messages/del_up_to", onMessagesDelUpTo);
-    REGISTER_IM_MESSAGE("messages/clear", onMessagesClear);
-    REGISTER_IM_MESSAGE("messages/empty", onMessagesEmpty);
-    REGISTER_IM_MESSAGE("dlg_states", onDlgStates);
-
-    REGISTER_IM_MESSAGE("dialogs/search/local/result", onDialogsSearchLocalResults);
-    REGISTER_IM_MESSAGE("dialogs/search/local/empty", onDialogsSearchLocalEmptyResult);
-    REGISTER_IM_MESSAGE("dialogs/search/server/result", onDialogsSearchServerResults);
-
-    REGISTER_IM_MESSAGE("threads/search/local/result", onThreadsSearchLocalResults);
-    REGISTER_IM_MESSAGE("threads/search/local/empty", onThreadsSearchLocalEmptyResult);
-    REGISTER_IM_MESSAGE("threads/search/server/result", onThreadsSearchServerResults);
-
-    REGISTER_IM_MESSAGE("dialogs/search/pattern_history", onDialogsSearchPatternHistory);
-
-    REGISTER_IM_MESSAGE("contacts/search/local/result", onContactsSearchLocalResults);
-    REGISTER_IM_MESSAGE("contacts/search/server/result", onContactsSearchServerResults);
-    REGISTER_IM_MESSAGE("addressbook/sync/update", onSyncAddressBook);
-
-#ifndef STRIP_VOIP
-    REGISTER_IM_MESSAGE("voip_signal", onVoipSignal);
-#endif
-    REGISTER_IM_MESSAGE("active_dialogs_are_empty", onActiveDialogsAreEmpty);
-    REGISTER_IM_MESSAGE("active_dialogs_sent", onActiveDialogsSent);
-    REGISTER_IM_MESSAGE("active_dialogs_hide", onActiveDialogsHide);
-    REGISTER_IM_MESSAGE("stickers/meta/get/result", onStickersMetaGetResult);
-
-    REGISTER_IM_MESSAGE("stickers/sticker/get/result", onStickersStickerGetResult);
-    REGISTER_IM_MESSAGE("stickers/set_icon_big", onStickersGetSetBigIconResult);
-    REGISTER_IM_MESSAGE("stickers/set_icon", onStickersSetIcon);
-    REGISTER_IM_MESSAGE("stickers/pack/info/result", onStickersPackInfo);
-    REGISTER_IM_MESSAGE("stickers/store/get/result", onStickersStore);
-    REGISTER_IM_MESSAGE("stickers/store/search/result", onStickersStoreSearch);
-    REGISTER_IM_MESSAGE("stickers/suggests", onStickersSuggests);
-    REGISTER_IM_MESSAGE("stickers/fs_by_ids/get/result", onStickerGetFsByIdResult);
-    REGISTER_IM_MESSAGE("stickers/suggests/result", onStickersRequestedSuggests);
-
-    REGISTER_IM_MESSAGE("smartreply/suggests/instant", onSmartreplyInstantSuggests);
-    REGISTER_IM_MESSAGE("smartreply/get/result", onSmartreplyRequestedSuggests);
-
-    REGISTER_IM_MESSAGE("themes/settings", onThemeSettings);
-    REGISTER_IM_MESSAGE("themes/wallpaper/get/result", onThemesWallpaperGetResult);
-    REGISTER_IM_MESSAGE("themes/wallpaper/preview/get/result", onThemesWallpaperPreviewGetResult);
-
-    REGISTER_IM_MESSAGE("chats/info/get/result", onChatsInfoGetResult);
-    REGISTER_IM_MESSAGE("chats/info/get/failed", onChatsInfoGetFailed);
-    REGISTER_IM_MESSAGE("chats/member/add/failed", onMemberAddFailed);
-    REGISTER_IM_MESSAGE("chats/member/info/result", onChatsMemberInfoResult);
-    REGISTER_IM_MESSAGE("chats/members/get/result", onChatsMembersGetResult);
-    REGISTER_IM_MESSAGE("chats/members/get/cached", onChatsMembersGetCached);
-    REGISTER_IM_MESSAGE("chats/members/search/result", onChatsMembersSearchResult);
-    REGISTER_IM_MESSAGE("chats/contacts/result", onChatsContactsResult);
-
-    REGISTER_IM_MESSAGE("files/error", fileSharingErrorResult);
-    REGISTER_IM_MESSAGE("files/download/progress", fileSharingDownloadProgress);
-    REGISTER_IM_MESSAGE("files/preview_size/result", fileSharingGetPreviewSizeResult);
-    REGISTER_IM_MESSAGE("files/metainfo/result", fileSharingMetainfoResult);
-    REGISTER_IM_MESSAGE("files/metainfo/error", fileSharingMetainfoError);
-    REGISTER_IM_MESSAGE("files/check_exists/result", fileSharingCheckExistsResult);
-    REGISTER_IM_MESSAGE("files/download/result", fileSharingDownloadResult);
-    REGISTER_IM_MESSAGE("image/download/result", imageDownloadResult);
-    REGISTER_IM_MESSAGE("image/download/progress", imageDownloadProgress);
-    REGISTER_IM_MESSAGE("image/download/result/meta", imageDownloadResultMeta);
-    REGISTER_IM_MESSAGE("external_file_path/result", externalFilePathResult);
-    REGISTER_IM_MESSAGE("link_metainfo/download/result/meta", linkMetainfoDownloadResultMeta);
-    REGISTER_IM_MESSAGE("link_metainfo/download/result/image", linkMetainfoDownloadResultImage);
-    REGISTER_IM_MESSAGE("link_metainfo/download/result/favicon", linkMetainfoDownloadResultFavicon);
-    REGISTER_IM_MESSAGE("files/upload/progress", fileUploadingProgress);
-    REGISTER_IM_MESSAGE("files/upload/result", fileUploadingResult);
-
-    REGISTER_IM_MESSAGE("files/speech_to_text/result", onFilesSpeechToTextResult);
-    REGISTER_IM_MESSAGE("contacts/remove/result", onContactsRemoveResult);
-    REGISTER_IM_MESSAGE("app_config", onAppConfig);
-    REGISTER_IM_MESSAGE("app_config_changed", onAppConfigChanged);
-
-    REGISTER_IM_MESSAGE("my_info", onMyInfo);
-    REGISTER_IM_MESSAGE("feedback/sent", onFeedbackSent);
-    REGISTER_IM_MESSAGE("messages/received/senders", onMessagesReceivedSenders);
-    REGISTER_IM_MESSAGE("typing", onTyping);
-    REGISTER_IM_MESSAGE("typing/stop", onTypingStop);
-    REGISTER_IM_MESSAGE("contacts/get_ignore/result", onContactsGetIgnoreResult);
-
-    REGISTER_IM_MESSAGE("login_result_attach_phone", onLoginResultAttachPhone);
-    REGISTER_IM_MESSAGE("update_profile/result", onUpdateProfileResult);
-    REGISTER_IM_MESSAGE("chats/home/get/result", onChatsHomeGetResult);
-    REGISTER_IM_MESSAGE("chats/home/get/failed", onChatsHomeGetFailed);
-    REGISTER_IM_MESSAGE("proxy_change", onProxyChange);
-    REGISTER_IM_MESSAGE("open_created_chat", onOpenCreatedChat);
-    REGISTER_IM_MESSAGE("login_new_user", onLoginNewUser);
-    REGISTER_IM_MESSAGE("set_avatar/result", onSetAvatarResult);
-    REGISTER_IM_MESSAGE("chats/role/set/result", onChatsRoleSetResult);
-    REGISTER_IM_MESSAGE("chats/block/result", onChatsBlockResult);
-    REGISTER_IM_MESSAGE("livechat/invite/cancel/result", onCancelInviteResult);
-    REGISTER_IM_MESSAGE("chats/pending/resolve/result", onChatsPendingResolveResult);
-    REGISTER_IM_MESSAGE("phoneinfo/result", onPhoneinfoResult);
-    REGISTER_IM_MESSAGE("contacts/ignore/remove", onContactRemovedFromIgnore);
-
-    REGISTER_IM_MESSAGE("friendly/update", onFriendlyUpdate);
-
-    REGISTER_IM_MESSAGE("mailboxes/status", onMailStatus);
-    REGISTER_IM_MESSAGE("mailboxes/new", onMailNew);
-
-    REGISTER_IM_MESSAGE("mrim/get_key/result", getMrimKeyResult);
-    REGISTER_IM_MESSAGE("mentions/me/received", onMentionsMeReceived);
-    REGISTER_IM_MESSAGE("mentions/suggests/result", onMentionsSuggestResults);
-
-    REGISTER_IM_MESSAGE("chat/heads", onChatHeads);
-    REGISTER_IM_MESSAGE("update_ready", onUpdateReady);
-    REGISTER_IM_MESSAGE("up_to_date", onUpToDate);
-    REGISTER_IM_MESSAGE("cachedobjects/loaded", onEventCachedObjectsLoaded);
-    REGISTER_IM_MESSAGE("connection/state", onEventConnectionState);
-
-    REGISTER_IM_MESSAGE("dialog/gallery/get/result", onGetDialogGalleryResult);
-    REGISTER_IM_MESSAGE("dialog/gallery/get_by_msg/result", onGetDialogGalleryByMsgResult);
-    REGISTER_IM_MESSAGE("dialog/gallery/state", onGalleryState);
-    REGISTER_IM_MESSAGE("dialog/gallery/update", onGalleryUpdate);
-    REGISTER_IM_MESSAGE("dialog/gallery/init", onGalleryInit);
-    REGISTER_IM_MESSAGE("dialog/gallery/holes_downloaded", onGalleryHolesDownloaded);
-    REGISTER_IM_MESSAGE("dialog/gallery/holes_downloading", onGalleryHolesDownloading);
-    REGISTER_IM_MESSAGE("dialog/gallery/erased", onGalleryErased);
-    REGISTER_IM_MESSAGE("dialog/gallery/index", onGalleryIndex);
-
-    REGISTER_IM_MESSAGE("localpin/checked", onLocalPINChecked);
-
-    REGISTER_IM_MESSAGE("idinfo/get/result", onIdInfo);
-
-    // core asks gui for its memory reports
-    REGISTER_IM_MESSAGE("request_memory_consumption_gui_components", onRequestMemoryConsumption);
-    // core has finished generating reports for a previous request
-    REGISTER_IM_MESSAGE("memory_usage_report_ready", onMemUsageReportReady);
-
-    REGISTER_IM_MESSAGE("get_user_info/result", onGetUserInfoResult);
-
-    REGISTER_IM_MESSAGE("get_user_last_seen/result", onGetUserLastSeenResult);
-
-    REGISTER_IM_MESSAGE("nickname/check/set/result", onNickCheckSetResult);
-
-    REGISTER_IM_MESSAGE("group_nickname/check/set/result", onGroupNickCheckSetResult);
-
-    REGISTER_IM_MESSAGE("omicron/update/data", onOmicronUpdateData);
-
-    REGISTER_IM_MESSAGE("privacy_settings/set/result", onSetPrivacySettingsResult);
-
-    REGISTER_IM_MESSAGE("common_chats/get/result", onGetCommonChatsResult);
-    REGISTER_IM_MESSAGE("files_sharing/upload/aborted", onFilesharingUploadAborted);
-
-    REGISTER_IM_MESSAGE("poll/get/result", onPollGetResult);
-    REGISTER_IM_MESSAGE("poll/vote/result", onPollVoteResult);
-    REGISTER_IM_MESSAGE("poll/revoke/result", onPollRevokeResult);
-    REGISTER_IM_MESSAGE("poll/stop/result", onPollStopResult);
-    REGISTER_IM_MESSAGE("poll/update", onPollUpdate);
-
-    REGISTER_IM_MESSAGE("chats/mod/params/result", onModChatParamsResult);
-
-    REGISTER_IM_MESSAGE("chats/mod/about/result", onModChatAboutResult);
-
-    REGISTER_IM_MESSAGE("suggest_group_nick/result", onSuggestGroupNickResult);
-
-    REGISTER_IM_MESSAGE("session_started", onSessionStarted);
-    REGISTER_IM_MESSAGE("session_finished", onSessionFinished);
-
-    REGISTER_IM_MESSAGE("external_url_config/error", onExternalUrlConfigError);
-    REGISTER_IM_MESSAGE("external_url_config/hosts", onExternalUrlConfigHosts);
-
-    REGISTER_IM_MESSAGE("group/subscribe/result", onGroupSubscribeResult);
-
-    REGISTER_IM_MESSAGE("get_bot_callback_answer/result", onBotCallbackAnswer);
-    REGISTER_IM_MESSAGE("async_responce", onBotCallbackAnswer);
-
-    REGISTER_IM_MESSAGE("sessions/get/result", onGetSessionsResult);
-    REGISTER_IM_MESSAGE("sessions/reset/result", onResetSessionResult);
-
-    REGISTER_IM_MESSAGE("conference/create/result", onCreateConferenceResult);
+    messages_.reserve(core_messages.size());
 
-    REGISTER_IM_MESSAGE("call_log/log", onCallLog);
-    REGISTER_IM_MESSAGE("call_log/add_call", onNewCall);
-    REGISTER_IM_MESSAGE("call_log/removed_messages", onCallRemoveMessages);
-    REGISTER_IM_MESSAGE("call_log/del_up_to", onCallDelUpTo);
-    REGISTER_IM_MESSAGE("call_log/remove_contact", onCallRemoveContact);
+#define CORE_MESSAGE(_message_string, _callback) \
+    messages_.push_back(std::bind(&core_dispatcher::_callback, this, std::placeholders::_1, std::placeholders::_2));
+#include "core_dispatcher_messages.inc"
+#undef CORE_MESSAGE
 
-    REGISTER_IM_MESSAGE("reactions", onReactions);
-    REGISTER_IM_MESSAGE("reactions/list/result", onReactionsListResult);
-    REGISTER_IM_MESSAGE("reaction/add/result", onReactionAddResult);
-    REGISTER_IM_MESSAGE("reaction/remove/result", onReactionRemoveResult);
-
-    REGISTER_IM_MESSAGE("status", onStatus);
-
-    REGISTER_IM_MESSAGE("call_room_info", onCallRoomInfo);
-    REGISTER_IM_MESSAGE("livechat/join/result", onChatJoinResult);
-
-    REGISTER_IM_MESSAGE("add_members/result", onAddMembersResult);
-    REGISTER_IM_MESSAGE("remove_members/result", onRemoveMembersResult);
-
-    REGISTER_IM_MESSAGE("group/invitebl/search/result", onInviterBlacklistSearchResult);
-    REGISTER_IM_MESSAGE("group/invitebl/cl/result", onInviterBlacklistedCLContacts);
-    REGISTER_IM_MESSAGE("group/invitebl/remove/result", onInviterBlacklistRemoveResult);
-    REGISTER_IM_MESSAGE("group/invitebl/add/result", onInviterBlacklistAddResult);
-
-    REGISTER_IM_MESSAGE("emoji/get/result", onGetEmojiResult);
-
-    REGISTER_IM_MESSAGE("suggest_to_notify_user", onSuggestToNotifyUser);
-
-    REGISTER_IM_MESSAGE("threads/update", onThreadsUpdate);
-    REGISTER_IM_MESSAGE("threads/unread_count", onUnreadThreadsCount);
-    REGISTER_IM_MESSAGE("threads/add/result", onAddThreadResult);
-    REGISTER_IM_MESSAGE("threads/get/result", onGetThreadResult);
-    REGISTER_IM_MESSAGE("threads/feed/get/result", onThreadsFeedGetResult);
-    REGISTER_IM_MESSAGE("threads/subscribe/result", onSubscripionChanged);
-    REGISTER_IM_MESSAGE("threads/unsubscribe/result", onSubscripionChanged);
-    REGISTER_IM_MESSAGE("thread/subscribers/get/result", onThreadsSubscribersGetResult);
-    REGISTER_IM_MESSAGE("thread/subscribers/search/result", onThreadsSubscribersSearchResult);
-    REGISTER_IM_MESSAGE("thread/autosubscribe/result", onThreadAutosubscribeResult);
-
-    REGISTER_IM_MESSAGE("auth_data", onAuthData);
-
-    REGISTER_IM_MESSAGE("draft", onDraft);
-
-    REGISTER_IM_MESSAGE("task/create/result", onTaskCreateResult);
-    REGISTER_IM_MESSAGE("task/update", onTaskUpdate);
-    REGISTER_IM_MESSAGE("task/edit_result", onTaskEditResult);
-    REGISTER_IM_MESSAGE("task/load_all", onTasksLoaded);
-    REGISTER_IM_MESSAGE("task/update_counter", onUnreadTasksCounter);
-
-    REGISTER_IM_MESSAGE("mail/update_counter", onUnreadMailsCounter);
-
-    REGISTER_IM_MESSAGE("antivirus/check_result", onAntivirusCheckResult);
-    REGISTER_IM_MESSAGE("miniapp/unavailable", onMiniappUnavailable);
+    im_assert(messages_.size() == core_messages.size());
 }
 
 void core_dispatcher::uninit()
@@ -1738,7 +1502,7 @@ qint64 core_dispatcher::post_im_stats_to_core(core::stats::im_stat_event_names _
     return post_message_to_core("im_stats", coll.get());
 }
 
-void core_dispatcher::received(const QString& _receivedMessage, const qint64 _seq, core::icollection* _params)
+void core_dispatcher::received(const int _messageId, const qint64 _seq, core::icollection* _params)
 {
     if (_seq > 0)
         executeCallback(_seq, _params);
@@ -1747,8 +1511,23 @@ void core_dispatcher::received(const QString& _receivedMessage, const qint64 _se
 
     core::coll_helper collParams(_params, true);
 
-    if (const auto iter_handler = messages_map_.find(_receivedMessage.toStdString()); iter_handler != messages_map_.end())
-        iter_handler->second(_seq, collParams);
+    if (_messageId >= 0 && size_t(_messageId) < messages_.size())
+        messages_[_messageId](_seq, collParams);
+}
+
+void core_dispatcher::onCoreBatch(const int64_t _seq, core::coll_helper _params)
+{
+    // notifications coalesced by core within a frame, each one is handled as if it came alone
+    const auto events = _params.get_value_as_array("events");
+    for (int32_t i = 0, size = events->size(); i < size; ++i)
+    {
+        core::coll_helper event(events->get_at(i)->get_as_collection(), false);
+        if (const auto id = core_messages.find(event.get_value_as_string("message")); id < messages_.size())
+        {
+            core::coll_helper data(event.get_value_as_collection("data"), false);
+            messages_[id](0, data);
+        }
+    }
 }
 
 bool core_dispatcher::isImCreated() const
@@ -1938,7 +1717,7 @@ void core_dispatcher::onLoginResult(const int64_t _seq, core::coll_helper _param
 
 void core_dispatcher::onAvatarsGetResult(const int64_t _seq, core::coll_helper _params)
 {
-    QPixmap avatar;
+    QByteArray avatar;
 
     bool result = Data::UnserializeAvatar(&_params, avatar);
 
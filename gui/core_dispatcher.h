@@ -61,11 +61,6 @@ namespace Ui
 
     using message_function = std::function<void(int64_t, core::coll_helper&)>;
 
-    #define REGISTER_IM_MESSAGE(_message_string, _callback) \
-        messages_map_.emplace( \
-        _message_string, \
-        std::bind(&core_dispatcher::_callback, this, std::placeholders::_1, std::placeholders::_2));
-
     namespace Stickers
     {
         class Set;
@@ -78,7 +73,8 @@ namespace Ui
     public:
 
 Q_SIGNALS:
-        void received(const QString&, const qint64, core::icollection*);
+        // the id is the position of the message in core_dispatcher_messages.inc, out of range for the ones gui doesn't handle
+        void received(const int, const qint64, core::icollection*);
     };
 
     class gui_connector : public gui_signal, public core::iconnector
@@ -170,7 +166,7 @@ Q_SIGNALS:
         void getSmsResult(int64_t, int _errCode, int _codeLength, const QString& _ivrUrl, const QString& _checks);
         void loginResult(int64_t, int code, bool fill);
         void loginResultAttachPhone(int64_t, int _code);
-        void avatarLoaded(int64_t, const QString&, QPixmap&, int, bool _result);
+        void avatarLoaded(int64_t, const QString&, const QByteArray&, int, bool _result);
         void avatarUpdated(const QString &);
 
         void presense(const std::shared_ptr<Data::Buddy>&);
@@ -413,7 +409,7 @@ Q_SIGNALS:
         void appUnavailable(const QString&);
 
     public Q_SLOTS:
-        void received(const QString&, const qint64, core::icollection*);
+        void received(const int, const qint64, core::icollection*);
 
     public:
         core_dispatcher();
@@ -664,6 +660,7 @@ Q_SIGNALS:
         void removeChatsThread(const QString& _contact, int64_t _msgId, const QString& _threadId);
 
         // messages
+        void onCoreBatch(const int64_t _seq, core::coll_helper _params);
         void onNeedLogin(const int64_t _seq, core::coll_helper _params);
         void onNeedExternalUserAgreement(const int64_t _seq, core::coll_helper _params);
         void onImCreated(const int64_t _seq, core::coll_helper _params);
@@ -944,7 +941,8 @@ Q_SIGNALS:
 
     private:
 
-        std::unordered_map<std::string, message_function> messages_map_;
+        // handlers indexed by the message id
+        std::vector<message_function> messages_;
 
         core::iconnector* coreConnector_;
         core::icore_interface* coreFace_;
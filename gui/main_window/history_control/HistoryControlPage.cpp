@@ -1276,7 +1276,7 @@ namespace Ui
         return { Logic::MessageKey(_id, Logic::ControlType::NewMessages), hist::MessageBuilder::createNew(_aimId, _width, _parent) };
     }
 
-    static InsertHistMessagesParams::WidgetsList makeWidgets(const QString& _aimId, const Data::MessageBuddies& _messages, int _width, Heads::HeadContainer* headsContainer, std::optional<qint64> _newPlateId, QWidget* _parent)
+    static InsertHistMessagesParams::WidgetsList makeWidgets(const QString& _aimId, const Data::MessageBuddies& _messages, int _width, Heads::HeadContainer* headsContainer, std::optional<qint64> _newPlateId, MessagesScrollArea* _parent)
     {
         const auto& heads = headsContainer->headsById();
 
@@ -1284,7 +1284,7 @@ namespace Ui
         widgets.reserve(_messages.size() + (_newPlateId ? 1 : 0));
         for (const auto& msg : _messages)
         {
-            if (auto item = hist::MessageBuilder::makePageItem(*msg, _width, _parent))
+            if (auto item = hist::MessageBuilder::makePageItem(*msg, _width, _parent, &_parent->getItemsPool()))
             {
                 if (const auto it = heads.find(item->getId()); it != heads.end())
                     item->setHeads(it.value());
@@ -1460,7 +1460,7 @@ namespace Ui
             connect(complexMessageItem, &ComplexMessage::ComplexMessageItem::edit, this, &HistoryControlPage::edit, Qt::UniqueConnection),
             connect(complexMessageItem, &ComplexMessage::ComplexMessageItem::needUpdateRecentsText, this, &HistoryControlPage::onNeedUpdateRecentsText, Qt::UniqueConnection),
             connect(complexMessageItem, &ComplexMessage::ComplexMessageItem::layoutChanged, this, &HistoryControlPage::onItemLayoutChanged, Qt::UniqueConnection),
-            connect(complexMessageItem, &ComplexMessage::ComplexMessageItem::addToFavorites, this, &HistoryControlPage::addToFavorites, Qt::QueuedConnection),
+            connect(complexMessageItem, &ComplexMessage::ComplexMessageItem::addToFavorites, this, &HistoryControlPage::addToFavorites, Qt::ConnectionType(Qt::QueuedConnection | Qt::UniqueConnection)),
             connect(complexMessageItem, &ComplexMessage::ComplexMessageItem::readOnlyUser, this, &HistoryControlPage::onReadOnlyUser, Qt::UniqueConnection),
             connect(complexMessageItem, &ComplexMessage::ComplexMessageItem::blockUser, this, &HistoryControlPage::onBlockUser, Qt::UniqueConnection),
         };
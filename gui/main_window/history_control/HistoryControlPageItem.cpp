@@ -1625,6 +1625,50 @@ namespace Ui
         isChat_ = _isChat;
     }
 
+    void HistoryControlPageItem::resetPageItemState()
+    {
+        hideCornerMenuForce();
+
+        // the plate and the status are laid out for the previous message, the next one creates them on activation
+        if (reactions_)
+        {
+            reactions_->deleteControls();
+            reactions_.reset();
+        }
+
+        if (lastStatusAnimation_)
+            lastStatusAnimation_->setLastStatus(LastStatus::None);
+
+        initialized_ = false;
+        isChat_ = false;
+        Selected_ = false;
+        HasTopMargin_ = false;
+        HasAvatar_ = false;
+        hasSenderName_ = false;
+        isChainedToPrev_ = false;
+        isChainedToNext_ = false;
+        HasAvatarSet_ = false;
+        isDeleted_ = false;
+        isEdited_ = false;
+        selectedTop_ = false;
+        selectedBottom_ = false;
+        hoveredTop_ = false;
+        hoveredBottom_ = false;
+        selectionCenter_ = 0;
+        lastStatus_ = LastStatus::None;
+        intersected_ = false;
+        wasSelected_ = false;
+        isUnsupported_ = false;
+        nextHasSenderName_ = false;
+        nextIsOutgoing_ = false;
+        heads_.clear();
+        prev_ = {};
+        next_ = {};
+        prevTo_ = {};
+        prevFrom_ = {};
+        msg_ = {};
+    }
+
     void HistoryControlPageItem::showMessageStatus()
     {
         if (lastStatus_ == LastStatus::DeliveredToPeer || lastStatus_ == LastStatus::DeliveredToServer)
@@ -141,6 +141,10 @@ namespace Ui
 
         virtual void cancelRequests() {}
 
+        // resets the item taken out of the history to be shown for another message,
+        // false if the item can't be reused and has to be deleted
+        virtual bool prepareForReuse() { return false; }
+
         static QMap<QString, QVariant> makeData(const QString& _command, const QString& _arg = QString());
 
         bool isChainedToPrevMessage() const;
@@ -243,6 +247,9 @@ namespace Ui
         virtual bool canBeThreadParent() const { return true; }
         virtual bool supportsOverlays() const { return true; }
 
+        // the message, selection and chaining state back to the one after construction
+        void resetPageItemState();
+
         int64_t getThreadMsgId() const;
 
         void copyPlates(const HistoryControlPageItem* _other);
@@ -28,6 +28,7 @@
 
 #include "MentionCompleter.h"
 #include "../MainWindow.h"
+#include "../common.shared/string_utils.h"
 
 namespace
 {
@@ -75,6 +76,17 @@ namespace
     const auto scrollAnimationInterval = 10;
     const auto wheelEventsBufferInterval = 300;
     constexpr auto hideScrollBarTimeout = std::chrono::seconds(2);
+
+    // the benchmark scrolls by a fixed step per frame, at the start of the history it waits
+    // for the older messages to be fetched and turns back after benchmarkMaxStalledFrames
+    constexpr auto benchmarkFrameInterval = std::chrono::milliseconds(16);
+    constexpr int benchmarkMaxStalledFrames = 60;
+    constexpr size_t benchmarkMaxFrames = 3000;
+
+    int getBenchmarkScrollStep()
+    {
+        return Utils::scale_value(120);
+    }
 }
 
 namespace Ui
@@ -178,11 +190,14 @@ namespace Ui
         connect(&Utils::InterConnector::instance(), &Utils::InterConnector::multiSelectCurrentMessageDown, this, &MessagesScrollArea::multiSelectCurrentMessageDown);
         connect(&Utils::InterConnector::instance(), &Utils::InterConnector::messageSelected, this, &MessagesScrollArea::messageSelected);
         connect(&Utils::InterConnector::instance(), &Utils::InterConnector::clearSelection, this, [this]() { clearSelection(); });
+        connect(&Utils::InterConnector::instance(), &Utils::InterConnector::benchmarkHistoryScroll, this, &MessagesScrollArea::runScrollBenchmark);
         Utils::grabTouchWidget(this);
 
         setMouseTracking(true);
     }
 
+    MessagesScrollArea::~MessagesScrollArea() = default;
+
     void MessagesScrollArea::onUpdateHistoryPosition(int32_t position, int32_t offset)
     {
         Q_EMIT updateHistoryPosition(position, offset);
@@ -592,10 +607,7 @@ namespace Ui
         eraseContact(widget);
 
         Layout_->removeWidget(widget);
-#ifdef IM_AUTO_TESTING
-        widget->setParent(nullptr);
-#endif //IM_AUTO_TESTING
-        widget->deleteLater();
+        disposeWidget(widget);
 
         updateScrollbar();
 
@@ -628,17 +640,25 @@ namespace Ui
             }
         }
         Layout_->removeWidgets(widgets);
-        std::for_each(widgets.begin(), widgets.end(), [](auto w)
-        {
-#ifdef IM_AUTO_TESTING
-            w->setParent(nullptr);
-#endif //IM_AUTO_TESTING
-            w->deleteLater();
-        });
+        std::for_each(widgets.begin(), widgets.end(), [this](auto w) { disposeWidget(w); });
 
         Q_EMIT widgetRemoved();
     }
 
+    void MessagesScrollArea::disposeWidget(QWidget* _widget)
+    {
+        im_assert(_widget);
+        im_assert(!containsWidget(_widget));
+
+        if (itemsPool_.release(_widget))
+            return;
+
+#ifdef IM_AUTO_TESTING
+        _widget->setParent(nullptr);
+#endif //IM_AUTO_TESTING
+        _widget->deleteLater();
+    }
+
     void MessagesScrollArea::removeAll()
     {
         const auto keys = getItemsKeys();
@@ -691,6 +711,103 @@ namespace Ui
         setScrollbarVisible(true);
     }
 
+    struct MessagesScrollArea::ScrollBenchmark
+    {
+        QTimer* timer_ = nullptr;
+        ScrollDirection direction_ = ScrollDirection::UP;
+        int stalledFrames_ = 0;
+        std::vector<qint64> frameTimesUs_;
+        hist::ItemsPool::Stats poolStatsBefore_;
+    };
+
+    void MessagesScrollArea::runScrollBenchmark(const QString& _aimId)
+    {
+        if (_aimId != aimid_ || scrollBenchmark_)
+            return;
+
+        scrollBenchmark_ = std::make_unique<ScrollBenchmark>();
+        scrollBenchmark_->frameTimesUs_.reserve(benchmarkMaxFrames);
+        scrollBenchmark_->poolStatsBefore_ = itemsPool_.getStats();
+
+        scrollBenchmark_->timer_ = new QTimer(this);
+        scrollBenchmark_->timer_->setInterval(benchmarkFrameInterval);
+        connect(scrollBenchmark_->timer_, &QTimer::timeout, this, &MessagesScrollArea::onScrollBenchmarkFrame);
+        scrollBenchmark_->timer_->start();
+    }
+
+    void MessagesScrollArea::onScrollBenchmarkFrame()
+    {
+        im_assert(scrollBenchmark_);
+
+        // started from the settings, waits for the chat to be shown
+        if (!isVisible())
+            return;
+
+        auto& benchmark = *scrollBenchmark_;
+
+        const auto step = (benchmark.direction_ == ScrollDirection::UP) ? -getBenchmarkScrollStep() : getBenchmarkScrollStep();
+        const auto viewportBefore = Layout_->getViewportAbsY();
+
+        QElapsedTimer frameTimer;
+        frameTimer.start();
+
+        scrollContent(step);
+        repaint();
+
+        const auto frameTimeUs = frameTimer.nsecsElapsed() / 1000;
+
+        if (Layout_->getViewportAbsY() == viewportBefore)
+        {
+            if (++benchmark.stalledFrames_ < benchmarkMaxStalledFrames)
+                return;
+
+            benchmark.stalledFrames_ = 0;
+
+            if (benchmark.direction_ == ScrollDirection::UP)
+                benchmark.direction_ = ScrollDirection::DOWN;
+            else
+                finishScrollBenchmark();
+
+            return;
+        }
+
+        benchmark.stalledFrames_ = 0;
+        benchmark.frameTimesUs_.push_back(frameTimeUs);
+
+        if (benchmark.frameTimesUs_.size() >= benchmarkMaxFrames)
+            finishScrollBenchmark();
+    }
+
+    void MessagesScrollArea::finishScrollBenchmark()
+    {
+        im_assert(scrollBenchmark_);
+
+        // finished from the timer slot
+        scrollBenchmark_->timer_->stop();
+        scrollBenchmark_->timer_->deleteLater();
+
+        auto times = std::move(scrollBenchmark_->frameTimesUs_);
+        const auto poolBefore = scrollBenchmark_->poolStatsBefore_;
+        scrollBenchmark_.reset();
+
+        if (times.empty())
+            return;
+
+        std::sort(times.begin(), times.end());
+
+        const auto percentile = [&times](size_t _p) { return std::to_string(times[(times.size() - 1) * _p / 100]); };
+        const auto total = std::accumulate(times.begin(), times.end(), qint64(0));
+        const auto overBudget = times.end() - std::upper_bound(times.begin(), times.end(), qint64(16000));
+        const auto pool = itemsPool_.getStats();
+
+        Log::write_network_log(su::concat("scroll-benchmark <", aimid_.toStdString(), ">",
+            "\nframes ", std::to_string(times.size()), ", over 16 ms ", std::to_string(overBudget),
+            "\nframe time avg ", std::to_string(total / qint64(times.size())), " us, p50 ", percentile(50), " us, p90 ", percentile(90),
+            " us, p99 ", percentile(99), " us, max ", std::to_string(times.back()), " us",
+            "\nitems pool reused ", std::to_string(pool.reused_ - poolBefore.reused_), ", created ", std::to_string(pool.created_ - poolBefore.created_),
+            ", dropped ", std::to_string(pool.dropped_ - poolBefore.dropped_), ", parked ", std::to_string(pool.parked_), "\r\n"));
+    }
+
     void MessagesScrollArea::updateScrollbar()
     {
         const auto viewportScrollBounds = Layout_->getViewportScrollBounds();
@@ -1362,6 +1479,9 @@ namespace Ui
     {
         im_assert(!LastMouseGlobalPos_.isNull());
 
+        // the selection is evaluated by the geometry of the widgets
+        Layout_->syncItemsGeometry();
+
         auto selectionBegin = Layout_->absolute2Viewport(SelectionBeginAbsPos_);
         auto selectionEnd = Layout_->absolute2Viewport(SelectionEndAbsPos_);
         auto selectionBeginGlobal = mapToGlobal(selectionBegin);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "history/History.h"
+#include "history/ItemsPool.h"
 #include "history/Message.h"
 #include "../../types/filesharing_meta.h"
 #include "complex_message/FileSharingUtils.h"
@@ -83,6 +84,7 @@ namespace Ui
         using WidgetVisitor = std::function<bool(QWidget*, const bool)>;
 
         MessagesScrollArea(QWidget *parent, QWidget *typingWidget, hist::DateInserter* dateInserter, const QString& _aimid);
+        ~MessagesScrollArea();
 
         void cancelSelection();
 
@@ -140,6 +142,10 @@ namespace Ui
         void cancelWidgetRequests(const QVector<Logic::MessageKey>&);
         void removeWidgets(const QVector<Logic::MessageKey>&);
 
+        // for a widget already removed from the layout, parks it in the items pool or deletes it
+        void disposeWidget(QWidget* _widget);
+        hist::ItemsPool& getItemsPool() noexcept { return itemsPool_; }
+
         void removeAll();
 
         void replaceWidget(const Logic::MessageKey &key, std::unique_ptr<QWidget> widget);
@@ -271,6 +277,9 @@ namespace Ui
         void multiselectChanged();
         void updatePttProgress(qint64, const Utils::FileSharingId&, int);
 
+        // scrolls to the start of the loaded history and back, logs the frame times
+        void runScrollBenchmark(const QString& _aimId);
+
     private:
         bool isHidingScrollbar() const;
         void hideScrollbar();
@@ -303,6 +312,9 @@ namespace Ui
 
         void updateStateFlag(State _flag, bool _enabled);
 
+        void onScrollBenchmarkFrame();
+        void finishScrollBenchmark();
+
     private:
         int64_t LastAnimationMoment_;
 
@@ -352,6 +364,11 @@ namespace Ui
         std::vector<PttProgress> pttProgress_;
 
         States areaState_ = State::None;
+
+        hist::ItemsPool itemsPool_;
+
+        struct ScrollBenchmark;
+        std::unique_ptr<ScrollBenchmark> scrollBenchmark_;
     };
 }
 
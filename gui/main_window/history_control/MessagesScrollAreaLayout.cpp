@@ -644,7 +644,7 @@ namespace Ui
         }
 
         removeWidgets(toRemove);
-        std::for_each(toRemove.begin(), toRemove.end(), [](auto x) { x->deleteLater(); });
+        std::for_each(toRemove.begin(), toRemove.end(), [this](auto x) { ScrollArea_->disposeWidget(x); });
     }
 
     void MessagesScrollAreaLayout::removeItemsByType(Logic::ControlType _type)
@@ -658,7 +658,7 @@ namespace Ui
         }
 
         removeWidgets(toRemove);
-        std::for_each(toRemove.begin(), toRemove.end(), [](auto x) { x->deleteLater(); });
+        std::for_each(toRemove.begin(), toRemove.end(), [this](auto x) { ScrollArea_->disposeWidget(x); });
     }
 
     bool MessagesScrollAreaLayout::hasItemsOfType(Logic::ControlType _type) const
@@ -673,7 +673,7 @@ namespace Ui
         {
             auto w = (*it)->Widget_;
             removeWidget(w);
-            w->deleteLater();
+            ScrollArea_->disposeWidget(w);
             return true;
         }
         return false;
@@ -918,7 +918,7 @@ namespace Ui
         return absolute;
     }
 
-    void MessagesScrollAreaLayout::applyItemsGeometry()
+    void MessagesScrollAreaLayout::applyItemsGeometry(ItemsRange _range)
     {
         const bool isWindowActive = Utils::InterConnector::instance().getMainWindow()->isActiveWindow();
         const bool isUIActive = Utils::InterConnector::instance().getMainWindow()->isUIActive();
@@ -939,8 +939,9 @@ namespace Ui
 
         const auto isPartialReadEnabled = scrollActivityFlag_;
         const auto atBottom = isViewportAtBottom();
+        const auto isAreaVisible = ScrollArea_->isVisible();
 
-        for (auto &item : LayoutItems_)
+        const auto applyItem = [&](const ItemInfoUptr& item)
         {
             const auto &widgetAbsGeometry = item->AbsGeometry_;
 
@@ -954,7 +955,7 @@ namespace Ui
                 onItemActivityChanged(item->Widget_, isGeometryActive);
             }
 
-            if (ScrollArea_->isVisible())
+            if (isAreaVisible)
             {
                 const auto visRect = isWindowActive ? getItemVisibleRect(widgetAbsGeometry, viewportVisibilityAbsRect) : QRect();
                 const auto isVisibleForRead = ((item == LayoutItems_.front() && atBottom) ||
@@ -994,7 +995,62 @@ namespace Ui
             }
 
             item->IsGeometrySet_ = true;
+        };
+
+        // an item outside of both the previous and the new activity rects stays inactive and invisible,
+        // its widget was moved out of the viewport when it left the previous one
+        const auto canApplyChanged = (
+            _range == ItemsRange::changed &&
+            isAreaVisible &&
+            !activeAbsRect_.isEmpty() &&
+            activeAbsRect_.size() == viewportActivityAbsRect.size()
+        );
+
+        if (canApplyChanged)
+        {
+            const auto top = std::min(activeAbsRect_.top(), viewportActivityAbsRect.top());
+            const auto bottom = std::max(activeAbsRect_.bottom(), viewportActivityAbsRect.bottom());
+            const auto [first, last] = findItemsInRange(top, bottom);
+
+            for (auto i = first; i < last; ++i)
+                applyItem(LayoutItems_[i]);
+
+            // the bottom item is read while the viewport is at the bottom
+            if (first != 0)
+                applyItem(LayoutItems_.front());
+
+            isItemsGeometryStale_ |= (first != 0 || last != LayoutItems_.size());
         }
+        else
+        {
+            for (const auto& item : LayoutItems_)
+                applyItem(item);
+
+            isItemsGeometryStale_ = false;
+        }
+
+        activeAbsRect_ = isAreaVisible ? viewportActivityAbsRect : QRect();
+    }
+
+    std::pair<size_t, size_t> MessagesScrollAreaLayout::findItemsInRange(int32_t _top, int32_t _bottom) const
+    {
+        // going from the front both the tops and the bottoms of the items decrease
+        const auto begin = LayoutItems_.cbegin();
+        const auto end = LayoutItems_.cend();
+
+        const auto first = std::partition_point(begin, end, [_bottom](const auto& item) { return item->AbsGeometry_.top() > _bottom; });
+        const auto last = std::partition_point(first, end, [_top](const auto& item) { return item->AbsGeometry_.bottom() >= _top; });
+
+        // the neighbours too, empty items and the ones sharing an edge may be out of order by one
+        const auto firstIndex = size_t(first - begin);
+        const auto lastIndex = size_t(last - begin);
+        return { firstIndex > 0 ? firstIndex - 1 : 0, std::min(lastIndex + 1, LayoutItems_.size()) };
+    }
+
+    void MessagesScrollAreaLayout::syncItemsGeometry()
+    {
+        if (isItemsGeometryStale_)
+            applyItemsGeometry();
     }
 
     void MessagesScrollAreaLayout::readVisibleItems()
@@ -1280,7 +1336,7 @@ namespace Ui
         }
 
         removeWidgets(dates);
-        std::for_each(dates.begin(), dates.end(), [](auto x) { x->deleteLater(); });
+        std::for_each(dates.begin(), dates.end(), [this](auto x) { ScrollArea_->disposeWidget(x); });
     }
 
     std::vector<Logic::MessageKey> MessagesScrollAreaLayout::getKeysForDates() const
@@ -1320,7 +1376,7 @@ namespace Ui
         for (const auto& key : _keys)
         {
             const auto dateKey = dateInserter_->makeDateKey(key);
-            auto w = dateInserter_->makeDateItem(dateKey, getWidthForItem(), ScrollArea_);
+            auto w = dateInserter_->makeDateItem(dateKey, getWidthForItem(), ScrollArea_, &ScrollArea_->getItemsPool());
             result.push_back({ dateKey, std::move(w) });
         }
         return result;
@@ -1664,6 +1720,8 @@ namespace Ui
     {
         im_assert(widget);
 
+        activeAbsRect_ = QRect();
+
         auto info = std::make_unique<ItemInfo>(widget, key);
 
         auto inserted = qobject_cast<HistoryControlPageItem*>(widget);
@@ -1692,7 +1750,7 @@ namespace Ui
                     }
                 }
 
-                LayoutItems_.emplace_front(std::move(info));
+                LayoutItems_.emplace(LayoutItems_.begin(), std::move(info));
 
                 return LayoutItems_.begin();
             }
@@ -1833,19 +1891,16 @@ namespace Ui
 
     void MessagesScrollAreaLayout::updateDistanceForViewportItems()
     {
+        const auto viewportAbsRect = evalViewportAbsRect();
+
+        const auto visibilityMargin = Utils::scale_value(0);
+        const QMargins visibilityMargins(0, visibilityMargin, 0, visibilityMargin);
+        const auto viewportVisibilityAbsRect = viewportAbsRect.marginsAdded(visibilityMargins);
+
         for (auto &item : LayoutItems_)
         {
             if (item->IsGeometrySet_)
-            {
-                const auto &widgetAbsGeometry = item->AbsGeometry_;
-                const auto viewportAbsRect = evalViewportAbsRect();
-
-                const auto visibilityMargin = Utils::scale_value(0);
-                const QMargins visibilityMargins(0, visibilityMargin, 0, visibilityMargin);
-                const auto viewportVisibilityAbsRect = viewportAbsRect.marginsAdded(visibilityMargins);
-
-                onItemDistanseToViewPortChanged(item->Widget_, widgetAbsGeometry, viewportVisibilityAbsRect);
-            }
+                onItemDistanseToViewPortChanged(item->Widget_, item->AbsGeometry_, viewportVisibilityAbsRect);
         }
     }
 
@@ -1937,7 +1992,7 @@ namespace Ui
 
             updateDistanceForViewportItems();
 
-            applyItemsGeometry();
+            applyItemsGeometry(ItemsRange::changed);
 
             applyBottomWidgetsGeometry();
         }
@@ -2007,6 +2062,8 @@ namespace Ui
             (slideOp == SlideOp::NoSlide) ||
             (slideY != 0));
 
+        activeAbsRect_ = QRect();
+
         __TRACE(
             "geometry",
             "    widget=<" << (*changedItemIter)->Widget_ << ">\n"
@@ -2083,6 +2140,8 @@ namespace Ui
         const bool atBottom = ScrollArea_->isScrollAtBottom();
         const auto widthForItem = getWidthForItem();
 
+        activeAbsRect_ = QRect();
+
         for (auto iter = LayoutItems_.begin(); iter != LayoutItems_.end(); ++iter)
         {
             auto &item = *iter;
@@ -2612,6 +2671,10 @@ namespace Ui
         if (!widget)
             return;
 
+        // the abs geometry is restored from the widgets below
+        syncItemsGeometry();
+        activeAbsRect_ = QRect();
+
         const auto r = widget->geometry();
 
         const int new_pos = r.top();
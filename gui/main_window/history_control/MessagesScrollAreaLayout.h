@@ -200,6 +200,9 @@ namespace Ui
 
         void updateItemsGeometry();
 
+        // moves the widgets left behind by scrolling, before reading the geometry of widgets outside the viewport
+        void syncItemsGeometry();
+
         void setHeadContainer(Heads::HeadContainer*);
 
         void checkVisibilityForRead();
@@ -239,7 +242,8 @@ namespace Ui
         };
 
         using ItemInfoUptr = std::unique_ptr<ItemInfo>;
-        using ItemsInfo = std::deque<ItemInfoUptr>;
+        // ordered from the bottom up, AbsGeometry_ of the items doesn't intersect
+        using ItemsInfo = std::vector<ItemInfoUptr>;
         using ItemsInfoIter = ItemsInfo::iterator;
 
         std::unordered_set<QWidget*> Widgets_;
@@ -283,7 +287,18 @@ namespace Ui
 
         QRect absolute2Viewport(QRect absolute) const;
 
-        void applyItemsGeometry();
+        enum class ItemsRange
+        {
+            all,
+            changed
+        };
+
+        // changed: only the items around the viewport before and after its move,
+        // falls back to all if the items were moved since the previous pass
+        void applyItemsGeometry(ItemsRange _range = ItemsRange::all);
+
+        // [first, last) of LayoutItems_ intersecting [_top, _bottom] by the abs geometry
+        std::pair<size_t, size_t> findItemsInRange(int32_t _top, int32_t _bottom) const;
 
         void applyBottomWidgetsGeometry();
         void applyTypingWidgetGeometry();
@@ -357,7 +372,7 @@ namespace Ui
         };
         void extractItemImpl(QWidget *_widget, SuspendAfterExtract _mode = SuspendAfterExtract::yes);
 
-        std::list<QWidget*> ScrollingItems_;
+        std::vector<QWidget*> ScrollingItems_;
 
         /// observe to scrolling item position
         void moveViewportUpByScrollingItems();
@@ -376,6 +391,11 @@ namespace Ui
         int bottomOverflow_ = 0;
         bool quoteHeightChangeWaited_ = false;
 
+        // activity rect of the previous geometry pass, the items outside of it are inactive and placed
+        // out of the viewport. empty if the items were inserted, removed or moved after the pass
+        QRect activeAbsRect_;
+        bool isItemsGeometryStale_ = false;
+
     public:
         size_t widgetsCount() const noexcept;
 
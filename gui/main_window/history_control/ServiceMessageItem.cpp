@@ -249,6 +249,28 @@ namespace Ui
         setFixedWidth(_width);
     }
 
+    bool ServiceMessageItem::prepareForReuse()
+    {
+        if (isOverlay())
+            return false;
+
+        resetPageItemState();
+
+        // the text unit is kept for the next date, its font and color depend on the type
+        if (type_ != Type::date)
+        {
+            type_ = Type::date;
+            message_.clear();
+            messageUnit_.reset();
+        }
+
+        date_ = QDate();
+        lastUpdated_ = QDate();
+        setFixedHeight(getDateHeight() + 2 * getDateBubbleVerMargin(isFloating()));
+
+        return true;
+    }
+
     bool ServiceMessageItem::isNew() const
     {
         return (type_ == Type::plateNew);
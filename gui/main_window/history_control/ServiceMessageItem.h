@@ -37,6 +37,8 @@ namespace Ui
         bool isOutgoing() const override { return false; }
         int32_t getTime() const override { return -1; }
 
+        bool prepareForReuse() override;
+
     protected:
         void setQuoteSelection() override {}
         void paintEvent(QPaintEvent* _event) override;
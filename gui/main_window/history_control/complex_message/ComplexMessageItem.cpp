@@ -1246,6 +1246,97 @@ void ComplexMessageItem::getUpdatableInfoFrom(ComplexMessageItem& _update)
     copyPlates(&_update);
 }
 
+bool ComplexMessageItem::prepareForReuse()
+{
+    if (isHeadless() || isContextMenuOpened_ || hasThread() || shareButton_ || !buttons_.empty())
+        return false;
+
+    if (Blocks_.size() != 1 || !dynamic_cast<TextBlock*>(Blocks_.front()))
+        return false;
+
+    if (!snippetsWaitingForInitialization_.empty() || !snippetsWaitingForMeta_.empty())
+        return false;
+
+    Logic::GetStatusContainer()->setAvatarVisible(SenderAimidForDisplay_, false);
+
+    // the removal of a pending message is connected in MessageBuilder for the key of the message
+    disconnect(this, &ComplexMessageItem::removeMe, nullptr, nullptr);
+
+    resetPageItemState();
+    resetHover();
+    Blocks_.front()->clearSelection();
+
+    if (timeAnimation_)
+    {
+        timeAnimation_->stop();
+        timeAnimation_->disconnect(this);
+    }
+
+    // the time widget keeps the contact, the direction and the edit mark of the message
+    delete TimeWidget_;
+    TimeWidget_ = nullptr;
+    Time_ = -1;
+
+    Avatar_ = QPixmap();
+    Sender_.reset();
+    desiredSenderWidth_ = 0;
+    MenuBlock_ = nullptr;
+    MouseLeftPressedOverAvatar_ = false;
+    MouseLeftPressedOverSender_ = false;
+    MouseRightPressedOverItem_ = false;
+    bQuoteAnimation_ = false;
+    bObserveToSize_ = false;
+    bubbleHovered_ = false;
+    hasTrailingLink_ = false;
+    hasLinkInText_ = false;
+    hideEdit_ = false;
+    Url_.clear();
+    Description_.clear();
+    files_.clear();
+
+    return true;
+}
+
+void ComplexMessageItem::reuseFor(const Data::MessageBuddy& _msg, const Data::FString& _text)
+{
+    im_assert(Blocks_.size() == 1);
+    im_assert(!_text.isEmpty());
+
+    // not redone here, the item keeps what its constructor set up:
+    // - the layout, the text block widget and the signal connections of connectSignals
+    // - the buttons label, an item with buttons isn't kept
+    // - the contact of HistoryControlPageItem, the pool belongs to the history of one contact
+    // the edit mark, the plates and the chaining are set by MessageBuilder for both new and reused items,
+    // a plain text message has no quote or forward blocks to rebuild
+    ChatAimid_ = _msg.AimId_;
+    Date_ = _msg.GetDate();
+    Id_ = _msg.Id_;
+    PrevId_ = _msg.Prev_;
+    internalId_ = _msg.InternalId_;
+    IsOutgoing_ = _msg.IsOutgoing();
+    deliveredToServer_ = _msg.IsDeliveredToServer();
+    SenderAimid_ = _msg.getSender();
+    SourceText_ = _msg.GetSourceText();
+    mentions_ = _msg.Mentions_;
+
+    im_assert(!SenderAimid_.isEmpty());
+    im_assert(!ChatAimid_.isEmpty());
+    im_assert(Date_.isValid());
+
+    setContact(ChatAimid_);
+    setBuddy(_msg);
+
+    SenderAimidForDisplay_ = Logic::getContactListModel()->isChannel(ChatAimid_) ? ChatAimid_ : _msg.getSender();
+    SenderFriendly_ = Logic::GetFriendlyContainer()->getFriendly(_msg.Chat_ ? SenderAimid_ : (_msg.IsOutgoing() ? Ui::MyInfo()->aimId() : _msg.AimId_));
+
+    // the mentions of the text unit are taken from the item, so the text goes after them
+    auto textBlock = static_cast<TextBlock*>(Blocks_.front());
+    textBlock->setText(_text);
+    Testing::setAccessibleName(textBlock, u"AS HistoryPage messageText " % QString::number(Id_));
+
+    initSize();
+}
+
 void ComplexMessageItem::leaveEvent(QEvent *event)
 {
     event->ignore();
@@ -184,6 +184,12 @@ public:
 
     void getUpdatableInfoFrom(ComplexMessageItem &update);
 
+    // only an item of a single text block is kept, see ComplexMessageItemBuilder::makeComplexItem
+    bool prepareForReuse() override;
+
+    // refills the item kept by prepareForReuse for _msg, _text goes to its text block
+    void reuseFor(const Data::MessageBuddy& _msg, const Data::FString& _text);
+
     bool isSelected() const override;
 
     bool isAllSelected() const;
@@ -31,6 +31,7 @@
 #include "../../../app_config.h"
 #include "../../../gui_settings.h"
 #include "memory_stats/MessageItemMemMonitor.h"
+#include "../history/ItemsPool.h"
 #include "main_window/contact_list/RecentsModel.h"
 #include "url_config.h"
 
@@ -507,10 +508,78 @@ std::vector<GenericBlock*> createBlocks(const ParseResult& _parseRes, ComplexMes
     return blocks;
 }
 
+bool isPlainTextMessage(const Data::MessageBuddy& _msg)
+{
+    return _msg.Quotes_.isEmpty()
+        && !_msg.GetSticker()
+        && !_msg.sharedContact_
+        && !_msg.geo_
+        && !_msg.task_
+        && !_msg.poll_
+        && !_msg.GetFileSharing()
+        && _msg.GetDescription().isEmpty()
+        && _msg.buttons_.empty()
+        && !_msg.isUnsupported()
+        && !GetAppConfig().IsShowMsgIdsEnabled();
+}
+
+// the text of the only block createBlocks makes of _parseRes, empty if it makes other blocks
+Data::FString getSingleTextBlockText(const ParseResult& _parseRes)
+{
+    if (_parseRes.poll_ || _parseRes.task_ || _parseRes.chunks.size() != 1)
+        return {};
+
+    const auto& chunk = _parseRes.chunks.front();
+    switch (chunk.Type_)
+    {
+        case TextChunk::Type::Text:
+        case TextChunk::Type::GenericLink:
+            if (auto plainText = chunk.getPlainText(); !plainText.trimmed().isEmpty())
+                return plainText.toString();
+            break;
+
+        case TextChunk::Type::FormattedText:
+            return chunk.getFView().toFString();
+
+        default:
+            break;
+    }
+
+    return {};
+}
+
 namespace ComplexMessageItemBuilder
 {
-    std::unique_ptr<ComplexMessageItem> makeComplexItem(QWidget* _parent, const Data::MessageBuddy& _msg, ForcePreview _forcePreview)
+    std::unique_ptr<ComplexMessageItem> makeComplexItem(QWidget* _parent, const Data::MessageBuddy& _msg, ForcePreview _forcePreview, hist::ItemsPool* _pool)
     {
+        std::optional<ParseResult> parsedText;
+        if (_pool && isPlainTextMessage(_msg))
+        {
+            const bool allowSnippet = config::get().is_on(config::features::snippet_in_chat)
+                && (_msg.IsOutgoing() || !Logic::getRecentsModel()->isSuspicious(_msg.AimId_));
+
+            parsedText = parseText(_msg.getFormattedText(), allowSnippet, _forcePreview == ForcePreview::Yes);
+            if (const auto text = getSingleTextBlockText(*parsedText); !text.isEmpty())
+            {
+                if (auto complexItem = _pool->take<ComplexMessageItem>())
+                {
+                    if (complexItem->parentWidget() != _parent)
+                        complexItem->setParent(_parent);
+
+                    complexItem->reuseFor(_msg, text);
+                    complexItem->setHasTrailingLink(parsedText->hasTrailingLink);
+                    complexItem->setHasLinkInText(parsedText->linkInsideText);
+                    complexItem->setHideEdit(_msg.hideEdit());
+                    complexItem->setUrlAndDescription(_msg.GetUrl(), Data::FString());
+
+                    if (GetAppConfig().WatchGuiMemoryEnabled())
+                        MessageItemMemMonitor::instance().watchComplexMsgItem(complexItem.get());
+
+                    return complexItem;
+                }
+            }
+        }
+
         auto complexItem = std::make_unique<ComplexMessage::ComplexMessageItem>(_parent, _msg);
 
         const auto text = _msg.GetText();
@@ -630,7 +699,7 @@ namespace ComplexMessageItemBuilder
         else
         {
             const Data::FString textToParse = description.isEmpty() ? formattedText : _msg.GetUrl();
-            auto parsedMsg = parseText(textToParse, allowSnippet, _forcePreview == ForcePreview::Yes);
+            auto parsedMsg = parsedText ? std::move(*parsedText) : parseText(textToParse, allowSnippet, _forcePreview == ForcePreview::Yes);
             if (!description.isEmpty())
                 addDescriptionChunk(description, parsedMsg.chunks);
             messageBlocks = createBlocks(parsedMsg, complexItem.get(), id, prev, quoteBlocks.size());
@@ -2,6 +2,11 @@
 
 #include "../../../namespaces.h"
 
+namespace hist
+{
+    class ItemsPool;
+}
+
 UI_COMPLEX_MESSAGE_NS_BEGIN
 
 class ComplexMessageItem;
@@ -14,7 +19,8 @@ namespace ComplexMessageItemBuilder
         Yes
     };
 
-    std::unique_ptr<ComplexMessageItem> makeComplexItem(QWidget *_parent, const Data::MessageBuddy& _msg, ForcePreview _forcePreview);
+    // a message of a single text block takes an item parked in _pool, if there is one
+    std::unique_ptr<ComplexMessageItem> makeComplexItem(QWidget *_parent, const Data::MessageBuddy& _msg, ForcePreview _forcePreview, hist::ItemsPool* _pool = nullptr);
 
 }
 
@@ -53,10 +53,10 @@ namespace hist
         return message;
     }
 
-    std::unique_ptr<Ui::HistoryControlPageItem> DateInserter::makeDateItem(const Logic::MessageKey& _key, int _width, QWidget* _parent) const
+    std::unique_ptr<Ui::HistoryControlPageItem> DateInserter::makeDateItem(const Logic::MessageKey& _key, int _width, QWidget* _parent, ItemsPool* _pool) const
     {
         Data::MessageBuddy message = makeDateMessage(_key);
-        return hist::MessageBuilder::makePageItem(message, _width, _parent);
+        return hist::MessageBuilder::makePageItem(message, _width, _parent, _pool);
     }
 
     std::unique_ptr<Ui::HistoryControlPageItem> DateInserter::makeDateItem(const Data::MessageBuddy& _message, int _width, QWidget* _parent) const
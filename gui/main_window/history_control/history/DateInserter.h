@@ -23,6 +23,8 @@ namespace Data
 
 namespace hist
 {
+    class ItemsPool;
+
     class DateInserter : public QObject
     {
         Q_OBJECT
@@ -37,7 +39,7 @@ namespace hist
 
         Logic::MessageKey makeDateKey(const Logic::MessageKey& _key) const;
         Data::MessageBuddy makeDateMessage(const Logic::MessageKey& _key) const;
-        std::unique_ptr<Ui::HistoryControlPageItem> makeDateItem(const Logic::MessageKey& _key, int _width, QWidget* _parent) const;
+        std::unique_ptr<Ui::HistoryControlPageItem> makeDateItem(const Logic::MessageKey& _key, int _width, QWidget* _parent, ItemsPool* _pool = nullptr) const;
         std::unique_ptr<Ui::HistoryControlPageItem> makeDateItem(const Data::MessageBuddy& _message, int _width, QWidget* _parent) const;
 
     private:
@@ -8,6 +8,8 @@
 #include "../../containers/FriendlyContainer.h"
 #include "../../history_control/ChatEventInfo.h"
 #include "../../history_control/VoipEventInfo.h"
+#include "../../history_control/MessageStyle.h"
+#include "../../../controls/textrendering/TextShapingCache.h"
 
 #include "../../../core_dispatcher.h"
 #include "../../../gui_settings.h"
@@ -77,6 +79,20 @@ namespace
 
     constexpr size_t preloadCount() noexcept { return 30; }
 
+    // the words of the texts are measured on the pool before the items are built and laid out
+    void prefetchTextShaping(const Data::MessageBuddies& _buddies)
+    {
+        std::vector<QString> texts;
+        texts.reserve(_buddies.size());
+        for (const auto& buddy : _buddies)
+        {
+            if (!buddy->GetSticker() && !buddy->getFormattedText().isEmpty())
+                texts.push_back(buddy->getFormattedText().string());
+        }
+
+        Ui::TextRendering::ShapingCache::instance().prefetch(Ui::MessageStyle::getTextFont(), std::move(texts));
+    }
+
     bool isInvisibleVoip(const Data::MessageBuddy& _buddy)
     {
         return _buddy.IsVoipEvent() && !_buddy.GetVoipEvent()->isVisible();
@@ -680,6 +696,8 @@ namespace hist
 
         qCDebug(history) << aimId_ <<"messageBuddies size" << _buddies.size() << "seq" << _seq << "option:" << optionToStr<QLatin1String>(_option);
 
+        prefetchTextShaping(_buddies);
+
         std::unique_lock locker(lockForViewFetchCounter_);
 
         const bool needWaitingForSeq = waitingInitSeq_.has_value();
@@ -0,0 +1,75 @@
+#include "stdafx.h"
+
+#include "ItemsPool.h"
+
+#include "../HistoryControlPageItem.h"
+
+namespace
+{
+    constexpr bool isPoolEnabled() noexcept
+    {
+#ifdef IM_AUTO_TESTING
+        // the autotests look the items up among the children of the history
+        return false;
+#else
+        return true;
+#endif //IM_AUTO_TESTING
+    }
+}
+
+namespace hist
+{
+    ItemsPool::ItemsPool() = default;
+
+    ItemsPool::~ItemsPool() = default;
+
+    bool ItemsPool::release(QWidget* _widget)
+    {
+        im_assert(_widget);
+
+        if constexpr (!isPoolEnabled())
+            return false;
+
+        auto item = qobject_cast<Ui::HistoryControlPageItem*>(_widget);
+        if (!item)
+            return false;
+
+        auto& parked = parked_[item->metaObject()];
+        if (parked.size() >= maxPerType || !item->prepareForReuse())
+        {
+            ++stats_.dropped_;
+            return false;
+        }
+
+        item->hide();
+        parked.emplace_back(item);
+        return true;
+    }
+
+    std::unique_ptr<Ui::HistoryControlPageItem> ItemsPool::takeImpl(const QMetaObject* _type)
+    {
+        if (const auto it = parked_.find(_type); it != parked_.end() && !it->second.empty())
+        {
+            auto item = std::move(it->second.back());
+            it->second.pop_back();
+            ++stats_.reused_;
+            return item;
+        }
+
+        ++stats_.created_;
+        return nullptr;
+    }
+
+    void ItemsPool::clear()
+    {
+        parked_.clear();
+    }
+
+    ItemsPool::Stats ItemsPool::getStats() const
+    {
+        auto stats = stats_;
+        for (const auto& [_, items] : parked_)
+            stats.parked_ += items.size();
+        return stats;
+    }
+}
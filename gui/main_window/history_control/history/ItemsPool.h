@@ -0,0 +1,51 @@
+#pragma once
+
+namespace Ui
+{
+    class HistoryControlPageItem;
+}
+
+namespace hist
+{
+    // history items taken out of the layout are kept hidden by their type and handed out again
+    // instead of constructing new ones. an item is kept only if it resets itself in prepareForReuse
+    class ItemsPool
+    {
+    public:
+        static constexpr size_t maxPerType = 32;
+
+        struct Stats
+        {
+            size_t parked_ = 0;
+            uint64_t reused_ = 0;
+            uint64_t created_ = 0;
+            uint64_t dropped_ = 0;
+        };
+
+        ItemsPool();
+        ~ItemsPool();
+
+        ItemsPool(const ItemsPool&) = delete;
+        ItemsPool& operator=(const ItemsPool&) = delete;
+
+        // false if the widget isn't kept and has to be deleted by the caller
+        bool release(QWidget* _widget);
+
+        // nullptr if there is no parked item of the type, the caller constructs one then
+        template <class T>
+        std::unique_ptr<T> take()
+        {
+            return std::unique_ptr<T>(static_cast<T*>(takeImpl(&T::staticMetaObject).release()));
+        }
+
+        void clear();
+
+        Stats getStats() const;
+
+    private:
+        std::unique_ptr<Ui::HistoryControlPageItem> takeImpl(const QMetaObject* _type);
+
+        std::unordered_map<const QMetaObject*, std::vector<std::unique_ptr<Ui::HistoryControlPageItem>>> parked_;
+        Stats stats_;
+    };
+}
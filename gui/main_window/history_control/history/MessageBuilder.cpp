@@ -18,13 +18,14 @@
 #include "../../../my_info.h"
 #include "../../../core_dispatcher.h"
 #include "History.h"
+#include "ItemsPool.h"
 #include "utils/features.h"
 #include "spellcheck/Spellchecker.h"
 #include "../../../gui_settings.h"
 
 namespace hist::MessageBuilder
 {
-    std::unique_ptr<Ui::HistoryControlPageItem> makePageItem(const Data::MessageBuddy& _msg, int _itemWidth, QWidget* _parent)
+    std::unique_ptr<Ui::HistoryControlPageItem> makePageItem(const Data::MessageBuddy& _msg, int _itemWidth, QWidget* _parent, ItemsPool* _pool)
     {
         if (_msg.IsEmpty())
             return nullptr;
@@ -34,7 +35,11 @@ namespace hist::MessageBuilder
 
         if (_msg.IsServiceMessage())
         {
-            auto serviceMessageItem = std::make_unique<Ui::ServiceMessageItem>(_parent);
+            auto serviceMessageItem = _pool ? _pool->take<Ui::ServiceMessageItem>() : nullptr;
+            if (!serviceMessageItem)
+                serviceMessageItem = std::make_unique<Ui::ServiceMessageItem>(_parent);
+            else if (serviceMessageItem->parentWidget() != _parent)
+                serviceMessageItem->setParent(_parent);
             serviceMessageItem->setContact(_msg.AimId_);
             serviceMessageItem->setDate(_msg.GetDate());
             if (_itemWidth > 0)
@@ -83,7 +88,7 @@ namespace hist::MessageBuilder
             return item;
         }
 
-        auto item = Ui::ComplexMessage::ComplexMessageItemBuilder::makeComplexItem(_parent, _msg, Ui::ComplexMessage::ComplexMessageItemBuilder::ForcePreview::No);
+        auto item = Ui::ComplexMessage::ComplexMessageItemBuilder::makeComplexItem(_parent, _msg, Ui::ComplexMessage::ComplexMessageItemBuilder::ForcePreview::No, _pool);
         item->setContact(_msg.AimId_);
         item->setTime(_msg.GetTime());
         item->setHasAvatar(_msg.HasAvatar());
@@ -104,11 +109,8 @@ namespace hist::MessageBuilder
         if (_itemWidth > 0)
             item->setFixedWidth(_itemWidth);
 
-        QObject::connect(Logic::GetFriendlyContainer(), &Logic::FriendlyContainer::friendlyChanged, item.get(),
-            [item = item.get()](const QString& _aimId, const QString& _friendly)
-        {
-            item->updateFriendly(_aimId, _friendly);
-        });
+        // an item taken from the pool is connected already
+        QObject::connect(Logic::GetFriendlyContainer(), &Logic::FriendlyContainer::friendlyChanged, item.get(), &Ui::ComplexMessage::ComplexMessageItem::updateFriendly, Qt::UniqueConnection);
 
         QObject::connect(
             item.get(),
@@ -52,6 +52,38 @@ namespace
     }
 
     constexpr std::chrono::milliseconds onDataReadyTimeout() noexcept { return std::chrono::milliseconds(50); }
+
+    constexpr std::chrono::milliseconds starvedRetryTimeout() noexcept { return std::chrono::milliseconds(10); }
+
+    bool isStarved(const Ui::VideoData& _data) noexcept
+    {
+        // starvedAt_ belongs to the decode task while it is in the pool
+        return !_data.decoding_ && _data.starvedAt_;
+    }
+
+    constexpr int maxDecodeThreads = 4;
+    constexpr int maxConvertThreads = 2;
+
+    // frames smaller than this are decoded by one codec thread, the pool decodes several media at once instead
+    constexpr int threadedDecodeMinPixels = 1280 * 720;
+    constexpr int maxCodecThreads = 4;
+
+    template <typename F>
+    class PoolTask : public QRunnable
+    {
+        F task_;
+
+    public:
+        explicit PoolTask(F&& _task) : task_(std::move(_task)) {}
+
+        void run() override { task_(); }
+    };
+
+    template <typename F>
+    QRunnable* makePoolTask(F&& _task)
+    {
+        return new PoolTask<std::decay_t<F>>(std::forward<F>(_task));
+    }
 }
 
 class AVCodecScope
@@ -336,6 +368,12 @@ namespace Ui
             return 0;
         }
 
+        if (_type == ffmpeg::AVMEDIA_TYPE_VIDEO && codecContext->width * codecContext->height >= threadedDecodeMinPixels)
+        {
+            codecContext->thread_count = std::clamp(QThread::idealThreadCount(), 1, maxCodecThreads);
+            codecContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        }
+
         if (avcodec_open2(codecContext, codec, 0) < 0)
         {
             // Failed to open codec
@@ -444,12 +482,15 @@ namespace Ui
 
         ffmpeg::AVCodecContext* videoCodecContext = _media.videoStream_->codec;
 
-        while (!isVideoQuit(_videoId))
+        while (!isQuit() && !isVideoQuit(_videoId))
         {
             if (!_videoData.stream_finished_)
             {
                 if (!_media.videoQueue_->get(*_packet))
-                    continue;
+                {
+                    _videoData.starvedAt_ = std::chrono::steady_clock::now();
+                    return false;
+                }
             }
 
             if (isFlushPacket(*_packet))
@@ -1502,7 +1543,6 @@ namespace Ui
         if (_media.scaledSize_ != _sz)
         {
             _media.scaledSize_ = _sz;
-            _media.needUpdateSwsContext_ = true;
 
             Q_EMIT videoSizeChanged(_media.scaledSize_);
         }
@@ -1519,8 +1559,11 @@ namespace Ui
         }
 
         _media.frameRGB_ = nullptr;
+    }
 
-        sws_freeContext(_media.swsContext_);
+    FrameConverter::~FrameConverter()
+    {
+        ffmpeg::sws_freeContext(swsContext_);
     }
 
     void VideoContext::setVolume(int32_t _volume, MediaData& _media)
@@ -2034,15 +2077,16 @@ namespace Ui
         : ctx_(_ctx)
     {
         setObjectName(qsl("VideoDecode"));
+
+        decodePool_.setMaxThreadCount(std::clamp(QThread::idealThreadCount() - 1, 1, maxDecodeThreads));
+        convertPool_.setMaxThreadCount(std::clamp(QThread::idealThreadCount() / 2, 1, maxConvertThreads));
     }
 
     void VideoDecodeThread::run()
     {
         qCDebug(ffmpegPlayer) << "video decode thread start";
 
-        ffmpeg::AVFrame* frame = ffmpeg::av_frame_alloc();
-
-        std::unordered_map<uint32_t, VideoData> videoData;
+        VideoDataMap videoData;
 
         ThreadMessageList messages;
 
@@ -2051,91 +2095,21 @@ namespace Ui
 
         int32_t waitMsgTimeout = 60000;
 
-        ffmpeg::AVPacket av_packet;
-
         while (!ctx_.isQuit())
         {
-            if (!ctx_.getAllVideoThreadMessages(messages, waitMsgTimeout))
-                continue;
+            const auto hasStarved = std::any_of(videoData.cbegin(), videoData.cend(), [](const auto& _item) { return isStarved(_item.second); });
+            const auto timeout = hasStarved ? int32_t(starvedRetryTimeout().count()) : waitMsgTimeout;
 
-            qCDebug(ffmpegPlayer) << "video decode processing" << messages.size() << "messages";
-            for (auto& msg : messages)
+            if (ctx_.getAllVideoThreadMessages(messages, timeout))
             {
-                const auto videoId = msg.videoId_;
-                auto it = videoData.find(videoId);
-                if (it == videoData.end())
-                {
-                    if (msg.message_ == thread_message_type::tmt_init)
-                    {
-                        VideoData data;
-                        data.current_state_ = decode_thread_state::dts_playing;
-                        data.stream_finished_ = false;
-                        data.eof_ = false;
-                        data.media_ = ctx_.getMediaData(videoId);
-                        it = videoData.insert({ videoId, std::move(data) }).first;
-                    }
-                    else if (msg.message_ == thread_message_type::tmt_quit)
-                    {
-                        Q_EMIT ctx_.videoQuit(videoId);
-                        continue;
-                    }
-                    else
-                    {
-                        continue;
-                    }
-                }
-
-                auto& data = it->second;
-                if (processDataMessage(data, msg))
-                    continue;
-
-                auto media_ptr = data.media_.lock();
-                if (!media_ptr)
-                    continue;
-
-                auto& media = *media_ptr;
-                switch (msg.message_)
-                {
-                    case thread_message_type::tmt_quit:
-                    {
-                        videoData.erase(it);
-                        ctx_.freeScaleContext(media);
-
-                        Q_EMIT ctx_.videoQuit(videoId);
-                        break;
-                    }
-                    case thread_message_type::tmt_update_scaled_size:
-                    {
-                        const QSize scaledSize = ctx_.getTargetSize(media);
-
-                        QSize newSize(msg.x_, msg.y_);
-
-                        if (scaledSize != newSize)
-                            ctx_.updateScaleContext(media, newSize);
-                        break;
-                    }
-                    case thread_message_type::tmt_get_next_video_frame:
-                    {
-                        if (data.current_state_ == decode_thread_state::dts_end_of_media || data.current_state_ == decode_thread_state::dts_failed)
-                            break;
-
-                        if (media.isLottie_)
-                        {
-                            auto rdata = renderLottieFrame(data, media, videoId);
-                            if (rdata.isValid())
-                                lottieData.emplace_back(std::move(rdata));
-                        }
-                        else
-                        {
-                            renderVideoFrame(data, media, frame, av_packet, videoId);
-                        }
-                        break;
-                    }
-                    default:
-                        break;
-                }
+                qCDebug(ffmpegPlayer) << "video decode processing" << messages.size() << "messages";
+                for (auto& msg : messages)
+                    processMessage(videoData, msg, lottieData);
             }
 
+            if (hasStarved && !ctx_.isQuit())
+                retryStarvedVideos(videoData, lottieData);
+
             for (auto& rdata : lottieData)
             {
                 rdata.fut_.get();
@@ -2147,16 +2121,149 @@ namespace Ui
             lottieData.clear();
         }
 
+        decodePool_.waitForDone();
+        convertPool_.waitForDone();
+
         for (const auto& [_, data] : videoData)
             if (auto media = data.media_.lock())
                 ctx_.freeScaleContext(*media);
 
-        ffmpeg::av_frame_unref(frame);
-        ffmpeg::av_frame_free(&frame);
-
         qCDebug(ffmpegPlayer) << "video decode thread finished";
     }
 
+    void VideoDecodeThread::processMessage(VideoDataMap& _videoData, ThreadMessage& _msg, std::vector<LottieRenderData>& _lottieData)
+    {
+        const auto videoId = _msg.videoId_;
+        auto it = _videoData.find(videoId);
+        if (it == _videoData.end())
+        {
+            if (_msg.message_ == thread_message_type::tmt_init)
+            {
+                VideoData data;
+                data.current_state_ = decode_thread_state::dts_playing;
+                data.stream_finished_ = false;
+                data.eof_ = false;
+                data.media_ = ctx_.getMediaData(videoId);
+                it = _videoData.insert({ videoId, std::move(data) }).first;
+            }
+            else if (_msg.message_ == thread_message_type::tmt_quit)
+            {
+                Q_EMIT ctx_.videoQuit(videoId);
+                return;
+            }
+            else
+            {
+                return;
+            }
+        }
+
+        auto& data = it->second;
+        if (_msg.message_ == thread_message_type::tmt_frame_decoded)
+        {
+            data.decoding_ = false;
+
+            // the messages which came during the decode are handled in order until the next decode starts
+            auto deferred = std::move(data.deferred_);
+            while (!deferred.empty())
+            {
+                auto msg = std::move(deferred.front());
+                deferred.pop_front();
+
+                const auto quit = msg.message_ == thread_message_type::tmt_quit;
+                processMessage(_videoData, msg, _lottieData);
+                if (quit)
+                    return;
+
+                if (data.decoding_)
+                {
+                    data.deferred_.splice(data.deferred_.end(), deferred);
+                    return;
+                }
+            }
+            return;
+        }
+
+        if (data.decoding_)
+        {
+            const auto compressed = isCompressedType(_msg.message_) && std::any_of(data.deferred_.cbegin(), data.deferred_.cend(), [type = _msg.message_](const auto& x) { return x.message_ == type; });
+            if (!compressed)
+                data.deferred_.push_back(std::move(_msg));
+            return;
+        }
+
+        if (processDataMessage(data, _msg))
+            return;
+
+        auto media_ptr = data.media_.lock();
+        if (!media_ptr)
+            return;
+
+        auto& media = *media_ptr;
+        switch (_msg.message_)
+        {
+            case thread_message_type::tmt_quit:
+            {
+                _videoData.erase(it);
+                ctx_.freeScaleContext(media);
+
+                Q_EMIT ctx_.videoQuit(videoId);
+                break;
+            }
+            case thread_message_type::tmt_update_scaled_size:
+            {
+                const QSize scaledSize = ctx_.getTargetSize(media);
+
+                QSize newSize(_msg.x_, _msg.y_);
+
+                if (scaledSize != newSize)
+                    ctx_.updateScaleContext(media, newSize);
+                break;
+            }
+            case thread_message_type::tmt_get_next_video_frame:
+            {
+                if (data.current_state_ == decode_thread_state::dts_end_of_media || data.current_state_ == decode_thread_state::dts_failed)
+                    break;
+
+                if (media.isLottie_)
+                {
+                    auto rdata = renderLottieFrame(data, media, videoId);
+                    if (rdata.isValid())
+                        _lottieData.emplace_back(std::move(rdata));
+                }
+                else
+                {
+                    startVideoFrame(data, media_ptr, videoId, _msg.time_);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void VideoDecodeThread::retryStarvedVideos(VideoDataMap& _videoData, std::vector<LottieRenderData>& _lottieData)
+    {
+        const auto now = std::chrono::steady_clock::now();
+
+        std::vector<uint32_t> videoIds;
+        for (const auto& [videoId, data] : _videoData)
+        {
+            if (isStarved(data) && now - *data.starvedAt_ >= starvedRetryTimeout())
+                videoIds.push_back(videoId);
+        }
+
+        for (const auto videoId : videoIds)
+        {
+            if (const auto it = _videoData.find(videoId); it != _videoData.end() && isStarved(it->second))
+            {
+                it->second.starvedAt_.reset();
+
+                ThreadMessage msg(videoId, thread_message_type::tmt_get_next_video_frame);
+                processMessage(_videoData, msg, _lottieData);
+            }
+        }
+    }
+
     LottieRenderData VideoDecodeThread::renderLottieFrame(VideoData& _data, MediaData& _media, int32_t _videoId)
     {
         if (!_media.lottieRenderer_ || ctx_.isQuit() || ctx_.isVideoQuit(_videoId))
@@ -2205,28 +2312,47 @@ namespace Ui
         return {};
     }
 
-    void VideoDecodeThread::renderVideoFrame(VideoData& _data, MediaData& _media, ffmpeg::AVFrame* _frame, ffmpeg::AVPacket& _av_packet, int32_t _videoId)
+    void VideoDecodeThread::startVideoFrame(VideoData& _data, const std::shared_ptr<MediaData>& _media, uint32_t _videoId, std::chrono::steady_clock::time_point _requested)
     {
-        ffmpeg::av_frame_unref(_frame);
+        _data.decoding_ = true;
+
+        // the playing media are on screen, they go before the ones decoding a frame in background
+        const auto priority = _data.current_state_ == decode_thread_state::dts_playing ? 1 : 0;
+
+        decodePool_.start(makePoolTask([this, &_data, _media, _videoId, _requested]()
+        {
+            renderVideoFrame(_data, *_media, _videoId, _requested);
+
+            ctx_.postVideoThreadMessage(ThreadMessage(_videoId, thread_message_type::tmt_frame_decoded), false);
+        }), priority);
+    }
+
+    void VideoDecodeThread::renderVideoFrame(VideoData& _data, MediaData& _media, uint32_t _videoId, std::chrono::steady_clock::time_point _requested)
+    {
+        ffmpeg::AVFrame* frame = ffmpeg::av_frame_alloc();
 
         _data.eof_ = false;
+        _data.starvedAt_.reset();
 
-        if (ctx_.getNextVideoFrame(_frame, &_av_packet, _data, _media, _videoId))
+        if (ctx_.getNextVideoFrame(frame, &_data.packet_, _data, _media, _videoId))
         {
-            ctx_.setStartTimeVideo(_frame->pkt_dts, _media);
+            ctx_.setStartTimeVideo(frame->pkt_dts, _media);
 
             // Consider sync
-            double pts = _frame->pkt_dts;
+            double pts = frame->pkt_dts;
             if (pts == AV_NOPTS_VALUE)
-                pts = _frame->pkt_pts;
+                pts = frame->pkt_pts;
             if (pts == AV_NOPTS_VALUE)
                 pts = 0;
 
             pts *= ctx_.getVideoTimebase(_media);
-            pts = ctx_.synchronizeVideo(_frame, pts, _media);
+            pts = ctx_.synchronizeVideo(frame, pts, _media);
 
             if (ctx_.isQuit())
+            {
+                ffmpeg::av_frame_free(&frame);
                 return;
+            }
 
             auto scaledSize = ctx_.getTargetSize(_media);
             const auto sourceSize = ctx_.getSourceSize(_media);
@@ -2259,7 +2385,7 @@ namespace Ui
             {
                 while (true)
                 {
-                    if (_frame->linesize[0] % align == 0)
+                    if (frame->linesize[0] % align == 0)
                         break;
 
                     align = align / 2;
@@ -2269,36 +2395,71 @@ namespace Ui
             if (lastFrame.isNull() || lastFrame.size() != scaledSize || !lastFrame.isDetached() || !isAlignedImage(lastFrame, align))
                 lastFrame = createAlignedImage(scaledSize, align);
 
-            if ((_media.needUpdateSwsContext_) || (_frame->format != -1 && _frame->format != _media.codecContext_->pix_fmt) || !_media.swsContext_)
+            // the next frame of the media is decoded while this one is converted, but it waits here for its turn
+            auto converter = _data.converter_;
+            if (converter->converted_.valid())
+                converter->converted_.wait();
+
+            std::promise<void> converted;
+            converter->converted_ = converted.get_future();
+
+            convertPool_.start(makePoolTask([this, converter, converted = std::move(converted), frame, lastFrame = std::move(lastFrame), rotation, pts, _videoId, _requested, media = _data.media_]() mutable
             {
-                _media.needUpdateSwsContext_ = false;
-                _media.swsContext_ = sws_getCachedContext(
-                    _media.swsContext_,
-                    _frame->width,
-                    _frame->height,
-                    ffmpeg::AVPixelFormat(_frame->format), scaledSize.width(), scaledSize.height(), ffmpeg::AV_PIX_FMT_BGRA, SWS_POINT, 0, 0, 0);
-            }
+                convertVideoFrame(*converter, frame, lastFrame);
+                ffmpeg::av_frame_free(&frame);
+
+                if (rotation)
+                    lastFrame = lastFrame.transformed(QTransform().rotate(rotation));
+
+                Q_EMIT ctx_.nextframeReady(_videoId, lastFrame, pts, false);
+
+                if (auto media_ptr = media.lock())
+                {
+                    const int64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _requested).count();
 
-            uint8_t* toData[AV_NUM_DATA_POINTERS] = { lastFrame.bits(), nullptr };
-            int toLinesize[AV_NUM_DATA_POINTERS] = { lastFrame.bytesPerLine(), 0 };
-            ffmpeg::sws_scale(_media.swsContext_, _frame->data, _frame->linesize, 0, _frame->height, toData, toLinesize);
+                    ++media_ptr->framesDecoded_;
+                    media_ptr->frameLatencySumUs_ += latency;
 
-            if (rotation)
-                lastFrame = lastFrame.transformed(QTransform().rotate(rotation));
+                    auto maxLatency = media_ptr->frameLatencyMaxUs_.load();
+                    while (maxLatency < latency && !media_ptr->frameLatencyMaxUs_.compare_exchange_weak(maxLatency, latency));
+                }
 
-            Q_EMIT ctx_.nextframeReady(_videoId, lastFrame, pts, false);
+                converted.set_value();
+            }));
         }
-        else if (_data.eof_)
+        else
         {
-            _data.current_state_ = decode_thread_state::dts_end_of_media;
-            _data.stream_finished_ = false;
+            ffmpeg::av_frame_free(&frame);
 
-            ctx_.resetVideoClock(_media);
+            if (_data.eof_)
+            {
+                _data.current_state_ = decode_thread_state::dts_end_of_media;
+                _data.stream_finished_ = false;
 
-            Q_EMIT ctx_.nextframeReady(_videoId, QImage(), 0, true);
+                ctx_.resetVideoClock(_media);
+
+                Q_EMIT ctx_.nextframeReady(_videoId, QImage(), 0, true);
+            }
         }
     }
 
+    void VideoDecodeThread::convertVideoFrame(FrameConverter& _converter, ffmpeg::AVFrame* _frame, QImage& _image) const
+    {
+        // returns the same context while the frame format and the target size stay the same
+        _converter.swsContext_ = ffmpeg::sws_getCachedContext(
+            _converter.swsContext_,
+            _frame->width,
+            _frame->height,
+            ffmpeg::AVPixelFormat(_frame->format), _image.width(), _image.height(), ffmpeg::AV_PIX_FMT_BGRA, SWS_POINT, 0, 0, 0);
+
+        if (!_converter.swsContext_)
+            return;
+
+        uint8_t* toData[AV_NUM_DATA_POINTERS] = { _image.bits(), nullptr };
+        int toLinesize[AV_NUM_DATA_POINTERS] = { _image.bytesPerLine(), 0 };
+        ffmpeg::sws_scale(_converter.swsContext_, _frame->data, _frame->linesize, 0, _frame->height, toData, toLinesize);
+    }
+
     QImage VideoDecodeThread::getLastFrame(VideoData& _data) const
     {
         QImage lastFrame = _data.emptyFrames_.empty() ? QImage() : std::move(_data.emptyFrames_.front());
@@ -2612,7 +2773,8 @@ namespace Ui
             mute_(false),
             dataReady_(false),
             pausedByUser_(false),
-            seek_request_id_(0)
+            seek_request_id_(0),
+            droppedFrames_(0)
     {
         static auto is_init = false;
 
@@ -2846,6 +3008,9 @@ namespace Ui
 
         if (decodedFrames_.empty())
         {
+            if (firstFrame_)
+                ++droppedFrames_;
+
             if (getStarted())
             {
                 const int interval = std::min(100., (media->frameLastDelay_ > 0. ? media->frameLastDelay_ : 0.1) * 1000.0 + 0.5);
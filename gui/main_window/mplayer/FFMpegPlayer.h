@@ -1,5 +1,7 @@
 #pragma once
 
+#include <QThreadPool>
+
 #include "ffmpeg.h"
 #include "LottieHandle.h"
 #include "../../memory_stats/FFmpegPlayerMemMonitor.h"
@@ -51,8 +53,9 @@ namespace Ui
         tmt_get_first_frame = 16,
         tmt_reinit_audio = 17,
         tmt_empty_frame = 18,
+        tmt_frame_decoded = 19,
 
-        last = 19
+        last = 20
     };
 
     struct ThreadMessage
@@ -66,6 +69,8 @@ namespace Ui
 
         QImage emptyFrame_;
 
+        std::chrono::steady_clock::time_point time_ = std::chrono::steady_clock::now();
+
         ThreadMessage(uint32_t _videoId = std::numeric_limits<uint32_t>::max(), thread_message_type _message = thread_message_type::tmt_unknown)
             : message_(_message)
             , videoId_(_videoId)
@@ -174,8 +179,6 @@ namespace Ui
         QSharedPointer<PacketQueue> videoQueue_;
         QSharedPointer<PacketQueue> audioQueue_;
 
-        bool needUpdateSwsContext_ = false;
-        ffmpeg::SwsContext* swsContext_ = nullptr;
         std::vector<uint8_t> scaledBuffer_;
         ffmpeg::AVFrame* frameRGB_ = nullptr;
         DecodeAudioData audioData_;
@@ -216,12 +219,26 @@ namespace Ui
         bool isLottie_ = false;
         LottieHandle lottieRenderer_;
 
+        // time from a frame request to the converted frame, read by FFmpegPlayerMemMonitor
+        std::atomic<int64_t> framesDecoded_ = { 0 };
+        std::atomic<int64_t> frameLatencySumUs_ = { 0 };
+        std::atomic<int64_t> frameLatencyMaxUs_ = { 0 };
+
         MediaData();
 
         bool hasVideo() const { return !!videoStream_ || lottieRenderer_; }
         bool hasAudio() const { return !!audioStream_; }
     };
 
+    // converts the decoded frames of a media to BGRA, the frames of a media are converted one at a time in order
+    struct FrameConverter
+    {
+        ffmpeg::SwsContext* swsContext_ = nullptr;
+        std::future<void> converted_;
+
+        ~FrameConverter();
+    };
+
     struct VideoData
     {
         decode_thread_state current_state_ = decode_thread_state::dts_none;
@@ -229,7 +246,17 @@ namespace Ui
         bool stream_finished_ = false;
         std::list<QImage> emptyFrames_;
         std::weak_ptr<MediaData> media_;
+
+        // while a decode task of the media is in the pool its messages wait in deferred_
+        bool decoding_ = false;
+        ThreadMessageList deferred_;
+        ffmpeg::AVPacket packet_ = {};
+
+        // the decode found no packets, the decode thread starts it again later instead of a worker waiting for them
+        std::optional<std::chrono::steady_clock::time_point> starvedAt_;
+        std::shared_ptr<FrameConverter> converter_ = std::make_shared<FrameConverter>();
     };
+    using VideoDataMap = std::unordered_map<uint32_t, VideoData>;
 
     struct AudioData
     {
@@ -472,17 +499,27 @@ namespace Ui
     //////////////////////////////////////////////////////////////////////////
     // VideoDecodeThread
     //////////////////////////////////////////////////////////////////////////
+    // dispatches the video messages, video frames are decoded by decodePool_ and converted by convertPool_.
+    // a media has at most one decode task in the pool, the playing ones go first
     class VideoDecodeThread : public QThread
     {
 
         VideoContext& ctx_;
 
+        QThreadPool decodePool_;
+        QThreadPool convertPool_;
+
     protected:
 
         virtual void run() override;
 
+        void processMessage(VideoDataMap& _videoData, ThreadMessage& _msg, std::vector<LottieRenderData>& _lottieData);
+        void retryStarvedVideos(VideoDataMap& _videoData, std::vector<LottieRenderData>& _lottieData);
+
         LottieRenderData renderLottieFrame(VideoData& _data, MediaData& _media, int32_t _videoId);
-        void renderVideoFrame(VideoData& _data, MediaData& _media, ffmpeg::AVFrame* _frame, ffmpeg::AVPacket& _av_packet, int32_t _videoId);
+        void startVideoFrame(VideoData& _data, const std::shared_ptr<MediaData>& _media, uint32_t _videoId, std::chrono::steady_clock::time_point _requested);
+        void renderVideoFrame(VideoData& _data, MediaData& _media, uint32_t _videoId, std::chrono::steady_clock::time_point _requested);
+        void convertVideoFrame(FrameConverter& _converter, ffmpeg::AVFrame* _frame, QImage& _image) const;
         QImage getLastFrame(VideoData& _data) const;
 
         bool processDataMessage(VideoData& _data, ThreadMessage& _msg) const;
@@ -644,6 +681,9 @@ namespace Ui
 
         int seek_request_id_;
 
+        // timer ticks which found no decoded frame to show
+        int64_t droppedFrames_;
+
     private:
 
         void updateVideoPosition(const DecodedFrame& _frame);
@@ -119,6 +119,8 @@ namespace Ui
         Testing::setAccessibleName(clearAvatarsBtn_, qsl("AS AdditionalSettingsPage logMessageModelButton"));
         logMemorySnapshot_ = setupButton(defaultIconName, QT_TRANSLATE_NOOP("popup_window", "Log Memory Report"));
         Testing::setAccessibleName(logMemorySnapshot_, qsl("AS AdditionalSettingsPage logMemoryReport"));
+        benchmarkHistoryScroll_ = setupButton(defaultIconName, QT_TRANSLATE_NOOP("popup_window", "Benchmark history scroll"));
+        Testing::setAccessibleName(benchmarkHistoryScroll_, qsl("AS AdditionalSettingsPage benchmarkHistoryScroll"));
 
         if constexpr (environment::is_develop())
         {
@@ -145,6 +147,11 @@ namespace Ui
             GuiMemoryMonitor::instance().writeLogMemoryReport({});
         });
 
+        connect(benchmarkHistoryScroll_, &QPushButton::clicked, this, []() {
+            if (const auto contact = Logic::getContactListModel()->selectedContact(); !contact.isEmpty())
+                Q_EMIT Utils::InterConnector::instance().benchmarkHistoryScroll(contact);
+        });
+
         connect(clearCacheBtn_, &QPushButton::clicked, this, [this]() {
             GetDispatcher()->post_message_to_core("remove_content_cache", nullptr, this,
                                                   [](core::icollection* _coll)
@@ -193,10 +200,17 @@ namespace Ui
                                                            {},
                                                            Utils::scale_value(36), qsl("AS AdditionalSettingsPage showSeconds"));
 
+        recordTraceCheckbox_ = GeneralCreator::addSwitcher(this, mainLayout_,
+                                                           QT_TRANSLATE_NOOP("popup_window", "Record core performance trace"),
+                                                           false,
+                                                           {},
+                                                           Utils::scale_value(36), qsl("AS AdditionalSettingsPage recordTrace"));
+
         connect(fullLogModeCheckbox_, &Ui::SidebarCheckboxButton::checked, this, &SettingsForTesters::onToggleFullLogMode);
         connect(devShowMsgIdsCheckbox_, &Ui::SidebarCheckboxButton::checked, this, &SettingsForTesters::onToggleShowMsgIdsMenu);
         connect(watchGuiMemoryCheckbox_, &Ui::SidebarCheckboxButton::checked, this, &SettingsForTesters::onToggleWatchGuiMemory);
         connect(showSecondsCheckbox_, &Ui::SidebarCheckboxButton::checked, this, &SettingsForTesters::onToggleShowSeconds);
+        connect(recordTraceCheckbox_, &Ui::SidebarCheckboxButton::checked, this, &SettingsForTesters::onToggleRecordTrace);
 
         if constexpr (environment::is_develop())
         {
@@ -393,5 +407,11 @@ namespace Ui
         }, this);
     }
 
+    void SettingsForTesters::onToggleRecordTrace(bool _checked)
+    {
+        // the switcher isn't saved, the trace goes to the logs folder until it's switched off or the app exits
+        GetDispatcher()->post_message_to_core(_checked ? "profiler/trace/start" : "profiler/trace/stop", nullptr);
+    }
+
     SettingsForTesters::~SettingsForTesters() = default;
 }
@@ -43,6 +43,7 @@ namespace Ui
         void onToggleWatchGuiMemory(bool checked);
         void onToggleShowSeconds(bool checked);
         void onToggleNetCompression(bool checked);
+        void onToggleRecordTrace(bool checked);
 
     private:
         QVBoxLayout* mainLayout_ = nullptr;
@@ -53,6 +54,7 @@ namespace Ui
         Ui::CustomButton* clearAvatarsBtn_ = nullptr;
         Ui::CustomButton* logCurrentMessagesModel_ = nullptr;
         Ui::CustomButton* logMemorySnapshot_ = nullptr;
+        Ui::CustomButton* benchmarkHistoryScroll_ = nullptr;
         Ui::SidebarCheckboxButton* fullLogModeCheckbox_ = nullptr;
         Ui::SidebarCheckboxButton* updatebleCheckbox_ = nullptr;
         Ui::SidebarCheckboxButton* devShowMsgIdsCheckbox_ = nullptr;
@@ -62,6 +64,7 @@ namespace Ui
         Ui::SidebarCheckboxButton* watchGuiMemoryCheckbox_ = nullptr;
         Ui::SidebarCheckboxButton* showSecondsCheckbox_ = nullptr;
         Ui::SidebarCheckboxButton* netCompressionCheckbox_ = nullptr;
+        Ui::SidebarCheckboxButton* recordTraceCheckbox_ = nullptr;
 
         Ui::CustomButton* sendDevStatistic_ = nullptr;
 
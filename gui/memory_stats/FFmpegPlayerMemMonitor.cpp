@@ -73,6 +73,14 @@ FFmpegPlayerMemMonitor::FFMpegStats FFmpegPlayerMemMonitor::getCurrentStats()
             info.decodedFramesPixmapSize_ += Utils::getMemoryFootprint(player->firstFrame_->image_);
         }
 
+        info.droppedFramesCount_ = player->droppedFrames_;
+        if (const auto media = getMediaContainer()->ctx_.getMediaData(player->mediaId_))
+        {
+            if (const auto frames = media->framesDecoded_.load())
+                info.frameLatencyAvgUs_ = media->frameLatencySumUs_ / frames;
+            info.frameLatencyMaxUs_ = media->frameLatencyMaxUs_;
+        }
+
         stats.push_back(info);
     }
 
@@ -21,6 +21,9 @@ public:
         uint32_t mediaId_ = std::numeric_limits<uint32_t>::max();
         int64_t decodedFramesCount_ = 0;
         int64_t decodedFramesPixmapSize_ = 0;
+        int64_t droppedFramesCount_ = 0;
+        int64_t frameLatencyAvgUs_ = 0;
+        int64_t frameLatencyMaxUs_ = 0;
     };
 
     using FFMpegStats = std::vector<FFMpegPlayerInfo> ;
@@ -152,5 +152,9 @@ Ui::ComplexMessage::QuoteBlock *MessageItemMemMonitor::tryGetQuoteBlock(Ui::Comp
 
 bool MessageItemMemMonitor::watchComplexMsgItem(Ui::ComplexMessage::ComplexMessageItem* _msgItem)
 {
+    // an item taken from the pool is watched since it was created
+    if (messageItemsWatcher()->allObjects().contains(_msgItem))
+        return true;
+
     return messageItemsWatcher()->addObject(qobject_cast<QObject *>(_msgItem));
 }
@@ -21,8 +21,6 @@ namespace
 {
 const Memory_Stats::NameString_t ReporteeName("GuiMemoryMonitor");
 
-qint64 calculateFootprintFor(const Logic::AvatarStorage::CacheMap& cacheMap);
-
 constexpr std::chrono::milliseconds sendStatInterval = std::chrono::hours(1);
 constexpr std::chrono::milliseconds sendStatIntervalDebug = std::chrono::minutes(1);
 constexpr int64_t memoryLimitStep = 200 * (1 << 20);
@@ -34,6 +32,65 @@ struct QSizeComparator
         return lhs.width() * lhs.height() > rhs.width() * rhs.height();
     }
 };
+
+void writeHistogram(std::stringstream& _out, const Ui::gui_coll_helper& _coll, std::string_view _name, std::string_view _unit)
+{
+    const std::string name(_name);
+    _out << name << " p50 " << _coll.get_value_as_int64(name + "_p50") << _unit
+         << " p99 " << _coll.get_value_as_int64(name + "_p99") << _unit
+         << " max " << _coll.get_value_as_int64(name + "_max") << _unit;
+}
+
+// the answer to core/executers/stats
+void writeExecutersReport(std::stringstream& _out, core::icollection* _coll)
+{
+    Ui::gui_coll_helper coll(_coll, false);
+    if (!coll.is_value_exist("executers"))
+        return;
+
+    _out << "Executers:\r\n";
+
+    const auto executers = coll.get_value_as_array("executers");
+    for (auto i = 0; i < executers->size(); ++i)
+    {
+        Ui::gui_coll_helper executer(executers->get_at(i)->get_as_collection(), false);
+
+        _out << executer.get_value_as_string("name") << ": " << executer.get_value_as_int("threads") << " threads, busy "
+             << int(100 * executer.get_value_as_double("busy")) << "%, " << executer.get_value_as_int64("depth_count") << " tasks, ";
+        writeHistogram(_out, executer, "depth", {});
+        _out << "\r\n";
+
+        const auto tasks = executer.get_value_as_array("tasks");
+        for (auto j = 0; j < tasks->size(); ++j)
+        {
+            Ui::gui_coll_helper task(tasks->get_at(j)->get_as_collection(), false);
+
+            _out << "    " << task.get_value_as_string("name") << ": " << task.get_value_as_int64("run_us_count") << " runs, wait ";
+            writeHistogram(_out, task, "wait_us", "us");
+            _out << ", run ";
+            writeHistogram(_out, task, "run_us", "us");
+            _out << "\r\n";
+        }
+    }
+}
+
+// notifications core coalesced before posting them to gui, from the same answer
+void writeGuiBatchReport(std::stringstream& _out, core::icollection* _coll)
+{
+    Ui::gui_coll_helper coll(_coll, false);
+    if (!coll.is_value_exist("gui_batch"))
+        return;
+
+    _out << "Batched notifications:\r\n";
+
+    const auto messages = coll.get_value_as_array("gui_batch");
+    for (auto i = 0; i < messages->size(); ++i)
+    {
+        Ui::gui_coll_helper message(messages->get_at(i)->get_as_collection(), false);
+        _out << message.get_value_as_string("message") << ": " << message.get_value_as_int64("posted") << " posted, "
+             << message.get_value_as_int64("merged") << " merged\r\n";
+    }
+}
 }
 
 GuiMemoryMonitor &GuiMemoryMonitor::instance()
@@ -133,24 +190,15 @@ void GuiMemoryMonitor::onRequestFinished(const Memory_Stats::RequestHandle &_req
 
 Memory_Stats::MemoryStatsReport GuiMemoryMonitor::getAvatarsReport()
 {
-    qint64 total = 0;
-
-    qint64 totalByAimId = calculateFootprintFor(Logic::GetAvatarStorage()->GetByAimId());
-    total += totalByAimId;
-
-    qint64 totalByAimIdAndSize = calculateFootprintFor(Logic::GetAvatarStorage()->GetByAimIdAndSize());
-    total += totalByAimIdAndSize;
-
-    qint64 totalRounded = calculateFootprintFor(Logic::GetAvatarStorage()->GetRoundedByAimId());
-    total += totalRounded;
+    const auto& cache = Logic::GetAvatarStorage()->GetCache();
 
     Memory_Stats::MemoryStatsReport report(ReporteeName,
-                                           total,
+                                           cache.getBytes(),
                                            Memory_Stats::StatType::CachedAvatars);
 
-    report.addSubcategory("by_aim_id", totalByAimId);
-    report.addSubcategory("by_aim_id_and_size", totalByAimIdAndSize);
-    report.addSubcategory("rounded", totalRounded);
+    report.addSubcategory("by_aim_id", cache.getBytes(Logic::AvatarShape::Source));
+    report.addSubcategory("by_aim_id_and_size", cache.getBytes(Logic::AvatarShape::Square));
+    report.addSubcategory("rounded", cache.getBytes(Logic::AvatarShape::Rounded));
 
     return report;
 }
@@ -187,8 +235,8 @@ Memory_Stats::MemoryStatsReport GuiMemoryMonitor::getEmojisReport()
     qint64 total = 0;
     std::set<QSize, QSizeComparator> differentSizes;
 
-    const auto& emojisCache = Emoji::GetEmojiCache();
-    for (const auto& [_, image] : emojisCache)
+    const auto stats = Emoji::GetEmojiCacheStats();
+    for (const auto& image : stats.rasterized_)
     {
         total += Utils::getMemoryFootprint(image);
         differentSizes.insert(image.size());
@@ -196,10 +244,10 @@ Memory_Stats::MemoryStatsReport GuiMemoryMonitor::getEmojisReport()
 
 
     Memory_Stats::MemoryStatsReport report(ReporteeName,
-                                           total,
+                                           total + stats.atlasMappedSize_,
                                            Memory_Stats::StatType::CachedEmojis);
 
-    std::string emojiCacheSub = "Emojis in cache (" + std::to_string(emojisCache.size()) + ")";
+    std::string emojiCacheSub = "Emojis in cache (" + std::to_string(stats.rasterized_.size()) + ")";
     for (const auto& size: differentSizes)
     {
         emojiCacheSub += "\n";
@@ -208,6 +256,12 @@ Memory_Stats::MemoryStatsReport GuiMemoryMonitor::getEmojisReport()
 
     report.addSubcategory(emojiCacheSub, total);
 
+    std::string emojiAtlasSub = "Emoji atlases, mapped (" + std::to_string(stats.atlasSizes_.size()) + ")";
+    for (const auto size : stats.atlasSizes_)
+        emojiAtlasSub += "\n" + std::to_string(size) + "x" + std::to_string(size);
+
+    report.addSubcategory(emojiAtlasSub, stats.atlasMappedSize_);
+
     return report;
 }
 
@@ -296,10 +350,13 @@ Memory_Stats::MemoryStatsReport GuiMemoryMonitor::getVideoPlayersReport()
 #ifndef STRIP_AV_MEDIA
     for (auto &videoStat: Ui::FFmpegPlayerMemMonitor::instance().getCurrentStats())
     {
-        QString format(qsl("Player:\nmedia_id = %1\ndecodedFrames(%2):\n\t\t\t"));
+        QString format(qsl("Player:\nmedia_id = %1\ndropped frames = %3\nframe latency avg/max = %4/%5 ms\ndecodedFrames(%2):\n\t\t\t"));
 
         result.addSubcategory(format.arg(videoStat.mediaId_)
-                              .arg(videoStat.decodedFramesCount_).toStdString(),
+                              .arg(videoStat.decodedFramesCount_)
+                              .arg(videoStat.droppedFramesCount_)
+                              .arg(videoStat.frameLatencyAvgUs_ / 1000)
+                              .arg(videoStat.frameLatencyMaxUs_ / 1000).toStdString(),
                               videoStat.decodedFramesPixmapSize_);
     }
 
@@ -388,6 +445,10 @@ void GuiMemoryMonitor::writeLogMemoryReport(std::function<void()> _onComplete)
         const int64_t ramUsageArchiveGallery = coll.get_value_as_int64("archive_gallery");
         const int64_t ramVoipInit = coll.get_value_as_int64("voip_initialization");
         const int32_t ramUsageMb = int32_t(ramUsageFull >> 20);
+        const int64_t archivesLoaded = coll.get_value_as_int64("archive_loaded");
+        const int64_t archivesBudget = coll.get_value_as_int64("archive_budget");
+        const int64_t archivesEvicted = coll.get_value_as_int64("archive_evicted");
+        const int64_t archivesReloaded = coll.get_value_as_int64("archive_reloaded");
 
 
         std::stringstream logData;
@@ -408,12 +469,21 @@ void GuiMemoryMonitor::writeLogMemoryReport(std::function<void()> _onComplete)
 
         logData << "_archive_index " << (ramUsageArchiveIndex >> 10) << " Kb\r\n";
         logData << "_archive_gallery " << (ramUsageArchiveGallery >> 10) << " Kb\r\n";
+        logData << "_archive_cache " << archivesLoaded << " loaded, budget " << (archivesBudget >> 10) << " Kb, "
+                << archivesEvicted << " evicted, " << archivesReloaded << " reloaded\r\n";
         logData << "_voip_initialization " << (ramVoipInit >> 10) << " Kb\r\n";
 
-        Log::write_network_log(logData.str());
+        Ui::GetDispatcher()->post_message_to_core("core/executers/stats", nullptr, this, [logData = logData.str(), _onComplete](core::icollection* _coll)
+        {
+            std::stringstream executersData;
+            writeExecutersReport(executersData, _coll);
+            writeGuiBatchReport(executersData, _coll);
+
+            Log::write_network_log(logData + executersData.str());
 
-        if (_onComplete)
-            _onComplete();
+            if (_onComplete)
+                _onComplete();
+        });
     });
 
 }
@@ -450,18 +520,3 @@ void GuiMemoryMonitor::writeLogMemoryReport(std::function<void()> _onComplete)
 
 //    return report;
 //}
-
-namespace
-{
-qint64 calculateFootprintFor(const Logic::AvatarStorage::CacheMap& cacheMap)
-{
-    qint64 result = 0;
-
-    for (auto it = cacheMap.begin(); it != cacheMap.end(); it++)
-    {
-        result += Utils::getMemoryFootprint(it->second);
-    }
-
-    return result;
-}
-}
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 
 #include "core_dispatcher.h"
+#include "cache/avatars/AvatarRenderTask.h"
 #include "utils/gui_coll_helper.h"
 #include "utils/utils.h"
 #include "main_window/containers/FriendlyContainer.h"
@@ -60,12 +61,17 @@ void AvatarItem::copyToClipboard()
     QApplication::clipboard()->setPixmap(pixmap_);
 }
 
-void AvatarItem::avatarLoaded(int64_t _seq, const QString &_aimId, QPixmap& _pixmap, int _size, bool _result)
+void AvatarItem::avatarLoaded(int64_t _seq, const QString &_aimId, const QByteArray& _data, int _size, bool _result)
 {
     if (seq_ != _seq || !_result)
         return;
 
-    pixmap_ = _pixmap;
+    auto task = Logic::AvatarRenderTask::decode(_data, 0, false);
+    connect(task, &Logic::AvatarRenderTask::rendered, this, [this](const QImage& _source)
+    {
+        pixmap_ = QPixmap::fromImage(_source);
 
-    Q_EMIT loaded();
+        Q_EMIT loaded();
+    });
+    QThreadPool::globalInstance()->start(task);
 }
\ No newline at end of file
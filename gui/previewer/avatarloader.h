@@ -37,7 +37,7 @@ Q_SIGNALS:
     void loaded();
 
 private Q_SLOTS:
-    void avatarLoaded(int64_t _seq, const QString& _aimId, QPixmap& _pixmap, int _size, bool _result);
+    void avatarLoaded(int64_t _seq, const QString& _aimId, const QByteArray& _data, int _size, bool _result);
 
 private:
     QString aimId_;
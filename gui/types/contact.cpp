@@ -59,7 +59,7 @@ namespace Data
         }
     }
 
-    bool UnserializeAvatar(core::coll_helper* helper, QPixmap& _avatar)
+    bool UnserializeAvatar(core::coll_helper* helper, QByteArray& _data)
     {
         if (helper->get_value_as_bool("result"))
         {
@@ -68,7 +68,8 @@ namespace Data
             {
                 uint32_t size = stream->size();
 
-                _avatar.loadFromData(stream->read(size), size);
+                // decoded by the avatar storage on its thread pool
+                _data = QByteArray(reinterpret_cast<const char*>(stream->read(size)), int(size));
 
                 stream->reset();
             }
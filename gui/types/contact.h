@@ -216,7 +216,7 @@ namespace Data
 
     void UnserializeContactList(core::coll_helper* helper, ContactList& cl, QString& type);
 
-    bool UnserializeAvatar(core::coll_helper* helper, QPixmap& _avatar);
+    bool UnserializeAvatar(core::coll_helper* helper, QByteArray& _data);
 
     BuddyPtr UnserializePresence(core::coll_helper* helper);
 
@@ -225,6 +225,7 @@ namespace Utils
 
         void historyControlReady(const QString&, qint64 _message_id, const Data::DlgState&, qint64 _last_read_msg, bool _isFirstRequest);
         void logHistory(const QString&);
+        void benchmarkHistoryScroll(const QString&);
         void chatEvents(const QString&, const QVector<HistoryControl::ChatEventInfoSptr>&) const;
 
         void imageCropDialogIsShown(QWidget *);
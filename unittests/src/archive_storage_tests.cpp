@@ -0,0 +1,252 @@
+#include "common.h"
+#include "temp_dir_fixture.h"
+
+#include "../../gui/stdafx.h"
+#include "../../core/tools/binary_stream.h"
+#include "../../core/archive/storage.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace core;
+using namespace core::archive;
+
+namespace
+{
+    class archive_storage_test : public temp_dir_test
+    {
+    protected:
+        archive_storage_test() : temp_dir_test("archive_storage_test") {}
+
+        const std::filesystem::path file_ = path("_db");
+
+        std::unique_ptr<storage> make_storage() const
+        {
+            return std::make_unique<storage>(file_.wstring());
+        }
+
+        // appends blocks filled with their index, returns file offsets of the blocks
+        std::vector<int64_t> append(const std::vector<uint32_t>& _sizes, int _first_value)
+        {
+            data_block_batch batch;
+            std::vector<int64_t> offsets;
+
+            for (auto size : _sizes)
+            {
+                auto& block = batch.begin_block();
+                const std::string payload(size, char('a' + (_first_value++ % 26)));
+                block.write(payload.data(), int64_t(payload.size()));
+
+                int64_t offset = 0;
+                uint32_t data_size = 0;
+                EXPECT_EQ(batch.end_block(offset, data_size), size != 0);
+                if (size != 0)
+                {
+                    EXPECT_EQ(data_size, size);
+                    offsets.push_back(offset);
+                }
+            }
+
+            auto s = make_storage();
+            storage_mode mode;
+            mode.flags_.write_ = mode.flags_.append_ = true;
+            EXPECT_TRUE(s->open(mode));
+
+            int64_t batch_offset = 0;
+            EXPECT_TRUE(s->write_data_blocks(batch, batch_offset));
+            s->close();
+
+            for (auto& offset : offsets)
+                offset += batch_offset;
+
+            return offsets;
+        }
+
+        // reads blocks one after another like archive_index::load_from_local does
+        std::vector<std::string> read_sequentially(archive::error& _last_error) const
+        {
+            auto s = make_storage();
+            storage_mode mode;
+            mode.flags_.read_ = true;
+            if (!s->open(mode))
+                return {};
+
+            std::vector<std::string> blocks;
+
+            core::tools::binary_stream data;
+            while (s->read_data_block(-1, data))
+            {
+                blocks.emplace_back(data.get_data_for_log(), size_t(data.available()));
+                data.reset();
+            }
+
+            _last_error = s->get_last_error();
+            s->close();
+
+            return blocks;
+        }
+
+        std::string read_mapped(int64_t _offset, bool& _result) const
+        {
+            auto s = make_storage();
+            EXPECT_TRUE(s->map());
+
+            std::string_view block;
+            _result = s->read_data_block(_offset, block);
+            return std::string(block);
+        }
+    };
+}
+
+TEST_F(archive_storage_test, batch_frames_blocks)
+{
+    const auto offsets = append({ 10, 1, 0, 1000 }, 0);
+    ASSERT_EQ(offsets.size(), 3u);
+
+    EXPECT_EQ(offsets[0], 0);
+    EXPECT_EQ(offsets[1], 10 + 4 * sizeof(uint32_t));
+
+    bool result = false;
+    EXPECT_EQ(read_mapped(offsets[2], result), std::string(1000, 'd'));
+    EXPECT_TRUE(result);
+
+    archive::error error = archive::error::ok;
+    const auto blocks = read_sequentially(error);
+    ASSERT_EQ(blocks.size(), 3u);
+    EXPECT_EQ(blocks[0], std::string(10, 'a'));
+    EXPECT_EQ(blocks[1], std::string(1, 'b'));
+    EXPECT_EQ(blocks[2], std::string(1000, 'd'));
+    EXPECT_EQ(error, archive::error::end_of_file);
+}
+
+TEST_F(archive_storage_test, batches_append)
+{
+    const auto first = append({ 5, 6 }, 0);
+    const auto second = append({ 7 }, 2);
+
+    ASSERT_EQ(first.size(), 2u);
+    ASSERT_EQ(second.size(), 1u);
+    EXPECT_EQ(second[0], 5 + 6 + 8 * sizeof(uint32_t));
+
+    bool result = false;
+    EXPECT_EQ(read_mapped(second[0], result), std::string(7, 'c'));
+    EXPECT_TRUE(result);
+}
+
+TEST_F(archive_storage_test, truncated_mid_block)
+{
+    const auto complete = append({ 100, 200 }, 0);
+    const auto complete_size = int64_t(std::filesystem::file_size(file_));
+
+    const auto torn = append({ 300, 400 }, 2);
+    const auto full_size = int64_t(std::filesystem::file_size(file_));
+
+    const auto saved = path("_db.full");
+    std::filesystem::copy_file(file_, saved, std::filesystem::copy_options::overwrite_existing);
+
+    // a crash can cut the batch at any byte: blocks written before it stay readable,
+    // the cut block is never read as a valid one
+    for (auto size = complete_size + 1; size < full_size; size += 7)
+    {
+        std::filesystem::copy_file(saved, file_, std::filesystem::copy_options::overwrite_existing);
+        std::filesystem::resize_file(file_, uintmax_t(size));
+
+        archive::error error = archive::error::ok;
+        const auto blocks = read_sequentially(error);
+
+        const auto first_torn_complete = size >= torn[1];
+        ASSERT_EQ(blocks.size(), first_torn_complete ? 3u : 2u) << "size " << size;
+        EXPECT_EQ(blocks[1], std::string(200, 'b'));
+        if (first_torn_complete)
+            EXPECT_EQ(blocks[2], std::string(300, 'c'));
+
+        bool result = true;
+        read_mapped(torn[1], result);
+        EXPECT_FALSE(result) << "size " << size;
+
+        read_mapped(complete[1], result);
+        EXPECT_TRUE(result) << "size " << size;
+    }
+}
+
+TEST_F(archive_storage_test, fast_read_skips_torn_tail)
+{
+    append({ 100 }, 0);
+    const auto torn_end = int64_t(std::filesystem::file_size(file_)) + 150;
+    append({ 300 }, 1);
+    std::filesystem::resize_file(file_, uintmax_t(torn_end));
+
+    // the next batch goes after the torn bytes, the search scan has to find it there
+    const auto next = append({ 50 }, 2);
+
+    std::ifstream file(file_, std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    core::tools::binary_stream data;
+    data.write(content.data(), int64_t(content.size()));
+
+    std::vector<int64_t> found;
+    const auto end = data.available();
+    int64_t pos = 0;
+    int64_t begin = 0;
+    while (storage::fast_read_data_block(data, pos, begin, end, true))
+        found.push_back(begin);
+
+    ASSERT_EQ(found.size(), 2u);
+    EXPECT_EQ(found[0], 2 * int64_t(sizeof(uint32_t)));
+    EXPECT_EQ(found[1], next[0] + 2 * int64_t(sizeof(uint32_t)));
+}
+
+TEST_F(archive_storage_test, fast_read_resumes_block_crossing_chunk)
+{
+    const auto offsets = append({ 30, 50, 40, 60, 20, 45 }, 0);
+
+    std::ifstream file(file_, std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // the search reads a file in chunks, each next one starts where the scan of the previous stopped
+    constexpr int64_t chunk_size = 100;
+    const auto file_size = int64_t(content.size());
+
+    std::vector<int64_t> found;
+    int64_t chunk_start = 0;
+    while (chunk_start < file_size)
+    {
+        const auto chunk_end = std::min(chunk_start + chunk_size, file_size);
+
+        core::tools::binary_stream data;
+        data.write(content.data() + chunk_start, chunk_end - chunk_start);
+
+        int64_t pos = 0;
+        int64_t begin = 0;
+        while (storage::fast_read_data_block(data, pos, begin, chunk_end - chunk_start, chunk_end == file_size))
+            found.push_back(chunk_start + begin - 2 * int64_t(sizeof(uint32_t)));
+
+        if (pos == 0)
+            break;
+        chunk_start += pos;
+    }
+
+    EXPECT_EQ(found, offsets);
+}
+
+TEST_F(archive_storage_test, finds_block_after_broken_one)
+{
+    const auto offsets = append({ 40, 60, 30 }, 0);
+
+    // the header of the second block is damaged, the third one is still found
+    {
+        std::fstream file(file_, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(offsets[1]);
+        const uint32_t broken = 7;
+        file.write(reinterpret_cast<const char*>(&broken), sizeof(broken));
+    }
+
+    auto s = make_storage();
+    ASSERT_TRUE(s->map());
+
+    std::string_view block;
+    EXPECT_FALSE(s->read_data_block(offsets[1], block));
+    EXPECT_EQ(s->find_data_block(offsets[1] + 1), offsets[2]);
+    EXPECT_EQ(s->find_data_block(offsets[2] + 1), -1);
+}
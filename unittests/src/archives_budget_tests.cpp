@@ -0,0 +1,125 @@
+#include "common.h"
+#include "temp_dir_fixture.h"
+
+#include "../../gui/stdafx.h"
+#include "../../core/archive/local_history.h"
+#include "../../core/archive/history_message.h"
+#include "../../core/archive/dlg_state.h"
+
+#include <filesystem>
+
+using namespace core;
+using namespace core::archive;
+
+namespace
+{
+    // any archive holding a message is over it
+    constexpr int64_t tiny_budget = 1;
+
+    class archives_budget_test : public temp_dir_test
+    {
+    protected:
+        archives_budget_test() : temp_dir_test("archives_budget_test") {}
+
+        std::unique_ptr<local_history> make_history(int64_t _budget) const
+        {
+            return std::make_unique<local_history>(dir_.wstring(), _budget);
+        }
+
+        // incoming messages only, the outgoing counter is reported to the core
+        static void insert_messages(local_history& _history, const std::string& _contact, int64_t _first, int64_t _count)
+        {
+            auto block = std::make_shared<history_block>();
+            for (auto id = _first; id < _first + _count; ++id)
+            {
+                auto message = std::make_shared<history_message>();
+                message->set_msgid(id);
+                message->set_prev_msgid(id == _first ? -1 : id - 1);
+                message->set_time(1000 + id);
+                message->set_text("message " + std::to_string(id));
+                block->push_back(std::move(message));
+            }
+
+            headers_list inserted;
+            dlg_state state;
+            dlg_state_changes changes;
+            storage::result_type result;
+            _history.update_history(_contact, block, inserted, state, changes, result, -1, local_history::has_older_message_id::no);
+        }
+
+        static archives_cache_stats get_stats(local_history& _history, int64_t& _index_size)
+        {
+            int64_t gallery_size = 0;
+            archives_cache_stats stats;
+            _history.get_memory_usage(_index_size, gallery_size, stats);
+            return stats;
+        }
+    };
+}
+
+TEST_F(archives_budget_test, least_recently_used_archive_is_evicted_over_budget)
+{
+    auto history = make_history(tiny_budget);
+
+    insert_messages(*history, "a@agent", 1, 10);
+    insert_messages(*history, "b@agent", 1, 10);
+
+    int64_t index_size = 0;
+    auto stats = get_stats(*history, index_size);
+    EXPECT_EQ(stats.memory_budget_, tiny_budget);
+    EXPECT_EQ(stats.loaded_count_, 1);
+    EXPECT_EQ(stats.evicted_count_, 1);
+    EXPECT_EQ(stats.reloaded_count_, 0);
+    EXPECT_GT(index_size, 0);
+
+    insert_messages(*history, "c@agent", 1, 10);
+
+    stats = get_stats(*history, index_size);
+    EXPECT_EQ(stats.loaded_count_, 1);
+    EXPECT_EQ(stats.evicted_count_, 2);
+    EXPECT_EQ(stats.reloaded_count_, 0);
+}
+
+TEST_F(archives_budget_test, evicted_archive_is_counted_on_reload)
+{
+    auto history = make_history(tiny_budget);
+
+    insert_messages(*history, "a@agent", 1, 10);
+    insert_messages(*history, "b@agent", 1, 10);
+    insert_messages(*history, "a@agent", 11, 10);
+
+    int64_t index_size = 0;
+    const auto stats = get_stats(*history, index_size);
+    EXPECT_EQ(stats.loaded_count_, 1);
+    EXPECT_EQ(stats.evicted_count_, 2);
+    EXPECT_EQ(stats.reloaded_count_, 1);
+}
+
+TEST_F(archives_budget_test, archives_under_budget_stay_loaded)
+{
+    auto history = make_history(64 << 20);
+
+    insert_messages(*history, "a@agent", 1, 10);
+    insert_messages(*history, "b@agent", 1, 10);
+    insert_messages(*history, "a@agent", 11, 10);
+
+    int64_t index_size = 0;
+    const auto stats = get_stats(*history, index_size);
+    EXPECT_EQ(stats.loaded_count_, 2);
+    EXPECT_EQ(stats.evicted_count_, 0);
+    EXPECT_EQ(stats.reloaded_count_, 0);
+}
+
+TEST_F(archives_budget_test, zero_budget_disables_eviction)
+{
+    auto history = make_history(0);
+
+    insert_messages(*history, "a@agent", 1, 10);
+    insert_messages(*history, "b@agent", 1, 10);
+    insert_messages(*history, "c@agent", 1, 10);
+
+    int64_t index_size = 0;
+    const auto stats = get_stats(*history, index_size);
+    EXPECT_EQ(stats.loaded_count_, 3);
+    EXPECT_EQ(stats.evicted_count_, 0);
+}
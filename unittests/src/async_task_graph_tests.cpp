@@ -0,0 +1,111 @@
+#include "common.h"
+
+#include "../../gui/stdafx.h"
+#include "../../core/async_task.h"
+
+using namespace core;
+
+namespace
+{
+    // tasks are finished by hand, like results delivered to the core thread one by one
+    class graph_fixture
+    {
+    public:
+        std::shared_ptr<async_task_graph> graph_ = std::make_shared<async_task_graph>();
+        std::vector<std::string> started_;
+        std::map<std::string, std::shared_ptr<async_task_handlers>> running_;
+
+        std::optional<bool> result_;
+
+        async_task_graph::task_id add(const std::string& _name, std::vector<async_task_graph::task_id> _dependencies = {}, bool _required = false)
+        {
+            return graph_->add(_name, [this, _name]()
+            {
+                started_.push_back(_name);
+                return running_[_name] = std::make_shared<async_task_handlers>();
+            }, std::move(_dependencies), _required);
+        }
+
+        void run()
+        {
+            graph_->run([this](bool _success) { result_ = _success; });
+        }
+
+        void finish(const std::string& _name, int32_t _error = 0)
+        {
+            auto handler = std::move(running_.at(_name));
+            running_.erase(_name);
+            handler->on_result_(_error);
+        }
+    };
+}
+
+TEST(async_task_graph_test, independent_tasks_start_together)
+{
+    graph_fixture f;
+    const auto a = f.add("a");
+    const auto b = f.add("b");
+    f.add("c", { a, b });
+    f.add("d");
+
+    f.run();
+    EXPECT_EQ(f.started_, std::vector<std::string>({ "a", "b", "d" }));
+
+    f.finish("b");
+    f.finish("d");
+    EXPECT_EQ(f.started_.size(), 3u);
+
+    f.finish("a");
+    EXPECT_EQ(f.started_.back(), "c");
+    EXPECT_FALSE(f.result_);
+
+    f.finish("c");
+    ASSERT_TRUE(f.result_);
+    EXPECT_TRUE(*f.result_);
+}
+
+TEST(async_task_graph_test, optional_failure_continues)
+{
+    graph_fixture f;
+    const auto a = f.add("a");
+    f.add("b", { a });
+
+    f.run();
+    f.finish("a", -1);
+    f.finish("b");
+
+    ASSERT_TRUE(f.result_);
+    EXPECT_TRUE(*f.result_);
+    EXPECT_EQ(f.graph_->get_stages()[0].error_, -1);
+}
+
+TEST(async_task_graph_test, required_failure_skips_the_rest)
+{
+    graph_fixture f;
+    const auto a = f.add("a", {}, true);
+    f.add("b", { a });
+    f.add("c");
+
+    f.run();
+    f.finish("a", -1);
+    EXPECT_FALSE(f.result_);
+
+    f.finish("c");
+    ASSERT_TRUE(f.result_);
+    EXPECT_FALSE(*f.result_);
+
+    EXPECT_EQ(f.started_, std::vector<std::string>({ "a", "c" }));
+    EXPECT_FALSE(f.graph_->get_stages()[1].started_);
+    EXPECT_NE(f.graph_->get_timings_for_log().find("b: skipped"), std::string::npos);
+}
+
+TEST(async_task_graph_test, empty_graph)
+{
+    auto graph = std::make_shared<async_task_graph>();
+
+    std::optional<bool> result;
+    graph->run([&result](bool _success) { result = _success; });
+
+    ASSERT_TRUE(result);
+    EXPECT_TRUE(*result);
+}
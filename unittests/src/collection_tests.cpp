@@ -0,0 +1,286 @@
+#include "common.h"
+
+#include "../../gui/stdafx.h"
+#include "../../corelib/collection.h"
+#include "../../corelib/collection_helper.h"
+#include "../../corelib/arena_collection.h"
+
+#include <chrono>
+
+using namespace core;
+
+namespace
+{
+    icollection* create_legacy_collection()
+    {
+        return new core::collection();
+    }
+
+    icollection* create_arena_collection()
+    {
+        return core::arena_collection::create();
+    }
+
+    // the shape of archive/messages/get/result: a page of messages with nested chat and quote data
+    void fill_messages_page(coll_helper& _coll, int32_t _count)
+    {
+        _coll.set_value_as_string("contact", "1000000001@chat.agent");
+        _coll.set_value_as_bool("result", true);
+        _coll.set_value_as_int64("theirs_last_delivered", 6900000000000000123);
+        _coll.set_value_as_int64("theirs_last_read", 6900000000000000120);
+
+        ifptr<iarray> messages(_coll->create_array());
+        messages->reserve(_count);
+
+        for (auto i = 0; i < _count; ++i)
+        {
+            coll_helper message(_coll->create_collection(), true);
+            message.set_value_as_int64("id", 6900000000000000000 + i);
+            message.set_value_as_int64("prev_id", 6900000000000000000 + i - 1);
+            message.set_value_as_string("internal_id", "a4b5c6d7-e8f9-4a0b-8c1d-2e3f4a5b6c7d");
+            message.set_value_as_int64("time", 1600000000 + i);
+            message.set_value_as_string("text", "the quick brown fox jumps over the lazy dog, again and again and again");
+            message.set_value_as_bool("outgoing", i % 2 == 0);
+            message.set_value_as_bool("unread", false);
+            message.set_value_as_string("contact", "1000000001@chat.agent");
+            message.set_value_as_string("update_patch_version", "0.1.2.3");
+            message.set_value_as_int("flags", 0x100);
+
+            coll_helper chat(_coll->create_collection(), true);
+            chat.set_value_as_string("sender", "user" + std::to_string(i % 10) + "@agent");
+            chat.set_value_as_string("friendly", "Some Friendly Name");
+            chat.set_value_as_string("name", "Chat name");
+            message.set_value_as_collection("chat", chat.get());
+
+            if (i % 4 == 0)
+            {
+                coll_helper quote(_coll->create_collection(), true);
+                quote.set_value_as_string("text", "a quoted message text");
+                quote.set_value_as_string("sender", "user1@agent");
+                quote.set_value_as_int64("msg_id", 6900000000000000001);
+                quote.set_value_as_int("time", 1600000000);
+                message.set_value_as_collection("quote", quote.get());
+            }
+
+            ifptr<ivalue> value(_coll->create_value());
+            value->set_as_collection(message.get());
+            messages->push_back(value.get());
+        }
+
+        _coll.set_value_as_array("messages", messages.get());
+    }
+
+    int64_t read_messages_page(const coll_helper& _coll)
+    {
+        int64_t checksum = _coll.get_value_as_int64("theirs_last_read");
+
+        const auto messages = _coll.get_value_as_array("messages");
+        for (core::iarray::size_type i = 0, size = messages->size(); i < size; ++i)
+        {
+            coll_helper message(messages->get_at(i)->get_as_collection(), false);
+            checksum += message.get_value_as_int64("id");
+            checksum += std::string_view(message.get_value_as_string("text")).size();
+            checksum += message.get_value_as_bool("outgoing") ? 1 : 0;
+
+            coll_helper chat(message.get_value_as_collection("chat"), false);
+            checksum += std::string_view(chat.get_value_as_string("sender")).size();
+
+            if (message.is_value_exist("quote"))
+            {
+                coll_helper quote(message.get_value_as_collection("quote"), false);
+                checksum += quote.get_value_as_int64("msg_id");
+            }
+        }
+
+        return checksum;
+    }
+
+    // the shape of contact presence and typing notifications
+    void fill_presence(coll_helper& _coll)
+    {
+        _coll.set_value_as_string("aimId", "user1@agent");
+        _coll.set_value_as_string("friendly", "Some Friendly Name");
+        _coll.set_value_as_string("state", "online");
+        _coll.set_value_as_int("lastseen", 1600000000);
+        _coll.set_value_as_bool("is_chat", false);
+        _coll.set_value_as_bool("mute", false);
+    }
+
+    int64_t read_presence(const coll_helper& _coll)
+    {
+        return std::string_view(_coll.get_value_as_string("aimId")).size() + _coll.get_value_as_int("lastseen") + (_coll.get_value_as_bool("mute") ? 1 : 0);
+    }
+}
+
+TEST(arena_collection_test, set_and_get)
+{
+    coll_helper coll(create_arena_collection(), true);
+    coll.set_value_as_int("int", -5);
+    coll.set_value_as_uint("uint", 5);
+    coll.set_value_as_int64("int64", 1LL << 40);
+    coll.set_value_as_double("double", 0.5);
+    coll.set_value_as_bool("bool", true);
+    coll.set_value_as_string("string", std::string_view("abc\0def", 7));
+    coll.set_value_as_string("empty", std::string_view());
+
+    EXPECT_EQ(coll.get_value_as_int("int"), -5);
+    EXPECT_EQ(coll.get_value_as_uint("uint"), 5u);
+    EXPECT_EQ(coll.get_value_as_int64("int64"), 1LL << 40);
+    EXPECT_EQ(coll.get_value_as_double("double"), 0.5);
+    EXPECT_TRUE(coll.get_value_as_bool("bool"));
+    EXPECT_EQ(std::string_view(coll.get_value_as_string("string"), 8), std::string_view("abc\0def", 8));
+    EXPECT_STREQ(coll.get_value_as_string("empty"), "");
+
+    EXPECT_EQ(coll.count(), 7);
+    EXPECT_TRUE(coll.is_value_exist("bool"));
+    EXPECT_FALSE(coll.is_value_exist("boo"));
+    EXPECT_FALSE(coll.is_value_exist("bool1"));
+    EXPECT_EQ(coll.get_value_as_int("missing", 42), 42);
+}
+
+TEST(arena_collection_test, overwrites_values)
+{
+    coll_helper coll(create_arena_collection(), true);
+    coll.set_value_as_string("key", "first");
+    coll.set_value_as_string("key", "second");
+    coll.set_value_as_int("key", 3);
+
+    EXPECT_EQ(coll.count(), 1);
+    EXPECT_EQ(coll.get_value_as_int("key"), 3);
+}
+
+TEST(arena_collection_test, iterates_like_collection)
+{
+    coll_helper legacy(create_legacy_collection(), true);
+    coll_helper arena(create_arena_collection(), true);
+
+    // more keys than fit inline, in an order that shuffles the sorted vector
+    for (auto i = 0; i < 50; ++i)
+    {
+        const auto key = std::to_string((i * 37) % 50);
+        legacy.set_value_as_int(key, i);
+        arena.set_value_as_int(key, i);
+    }
+
+    std::vector<int32_t> legacy_values;
+    for (auto v = legacy.first(); v; v = legacy.next())
+        legacy_values.push_back(v->get_as_int());
+
+    std::vector<int32_t> arena_values;
+    for (auto v = arena.first(); v; v = arena.next())
+        arena_values.push_back(v->get_as_int());
+
+    EXPECT_EQ(legacy_values, arena_values);
+    EXPECT_EQ(arena.count(), 50);
+    EXPECT_STREQ(legacy->log(), arena->log());
+}
+
+TEST(arena_collection_test, nested_objects_outlive_root)
+{
+    ifptr<icollection> child;
+    ifptr<iarray> array;
+
+    {
+        coll_helper root(create_arena_collection(), true);
+
+        coll_helper nested(root->create_collection(), true);
+        nested.set_value_as_string("name", "nested");
+        root.set_value_as_collection("nested", nested.get());
+
+        ifptr<iarray> values(root->create_array());
+        for (auto i = 0; i < 100; ++i)
+        {
+            ifptr<ivalue> value(root->create_value());
+            value->set_as_int(i);
+            values->push_back(value.get());
+        }
+        root.set_value_as_array("array", values.get());
+
+        child = ifptr<icollection>(root.get_value_as_collection("nested"));
+        child->addref();
+        array = ifptr<iarray>(root.get_value_as_array("array"));
+        array->addref();
+    }
+
+    coll_helper nested(child.get(), false);
+    EXPECT_STREQ(nested.get_value_as_string("name"), "nested");
+    ASSERT_EQ(array->size(), 100);
+    EXPECT_EQ(array->get_at(99)->get_as_int(), 99);
+}
+
+TEST(arena_collection_test, holds_objects_of_other_collections)
+{
+    coll_helper arena(create_arena_collection(), true);
+
+    {
+        coll_helper other(create_arena_collection(), true);
+        other.set_value_as_string("text", "other arena");
+
+        coll_helper legacy(create_legacy_collection(), true);
+        legacy.set_value_as_string("text", "legacy");
+
+        arena.set_value_as_collection("other", other.get());
+        arena.set_value_as_collection("legacy", legacy.get());
+
+        ifptr<istream> stream(arena->create_stream());
+        stream->write(reinterpret_cast<const uint8_t*>("data"), 4);
+        arena.set_value_as_stream("stream", stream.get());
+    }
+
+    EXPECT_STREQ(coll_helper(arena.get_value_as_collection("other"), false).get_value_as_string("text"), "other arena");
+    EXPECT_STREQ(coll_helper(arena.get_value_as_collection("legacy"), false).get_value_as_string("text"), "legacy");
+    EXPECT_EQ(arena.get_value_as_stream("stream")->size(), 4);
+}
+
+TEST(arena_collection_test, big_strings)
+{
+    coll_helper coll(create_arena_collection(), true);
+
+    const std::string big(1024 * 1024, 'x');
+    for (auto i = 0; i < 10; ++i)
+        coll.set_value_as_string(std::to_string(i), big);
+
+    for (auto i = 0; i < 10; ++i)
+        EXPECT_EQ(coll.get_value_as_string(std::to_string(i)), big);
+}
+
+TEST(arena_collection_test, messages_page)
+{
+    coll_helper legacy(create_legacy_collection(), true);
+    fill_messages_page(legacy, 100);
+
+    coll_helper arena(create_arena_collection(), true);
+    fill_messages_page(arena, 100);
+
+    EXPECT_EQ(read_messages_page(legacy), read_messages_page(arena));
+}
+
+// run with --gtest_also_run_disabled_tests
+TEST(arena_collection_test, DISABLED_benchmark)
+{
+    using clock = std::chrono::steady_clock;
+
+    const auto measure = [](std::string_view _name, auto _create, auto _fill, auto _read, int _iterations)
+    {
+        int64_t checksum = 0;
+        const auto start = clock::now();
+        for (auto i = 0; i < _iterations; ++i)
+        {
+            coll_helper coll(_create(), true);
+            _fill(coll);
+            checksum += _read(coll);
+        }
+        const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+
+        std::cout << _name << ": " << time / _iterations << " ns per message" << std::endl;
+        return checksum;
+    };
+
+    const auto page = [](coll_helper& _coll) { fill_messages_page(_coll, 100); };
+
+    EXPECT_EQ(measure("messages page, collection", create_legacy_collection, page, read_messages_page, 2000),
+              measure("messages page, arena_collection", create_arena_collection, page, read_messages_page, 2000));
+
+    EXPECT_EQ(measure("presence, collection", create_legacy_collection, fill_presence, read_presence, 200000),
+              measure("presence, arena_collection", create_arena_collection, fill_presence, read_presence, 200000));
+}
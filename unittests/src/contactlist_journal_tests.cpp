@@ -0,0 +1,255 @@
+#include "common.h"
+#include "temp_dir_fixture.h"
+
+#include "../../gui/stdafx.h"
+#include "../../core/archive/storage.h"
+#include "../../core/connections/wim/wim_contactlist_cache.h"
+
+#include <filesystem>
+
+using namespace core;
+using namespace core::wim;
+
+namespace
+{
+    constexpr std::string_view snapshot_json = R"({"groups":[
+        {"id":1,"name":"General","buddies":[
+            {"aimId":"user1@agent","friendly":"User One"},
+            {"aimId":"user2@agent","friendly":"User Two","outgoingCount":3},
+            {"aimId":"100@chat.agent","friendly":"Chat"}]},
+        {"id":2,"name":"Work","buddies":[
+            {"aimId":"user2@agent","friendly":"User Two","outgoingCount":3},
+            {"aimId":"user3@agent","friendly":"User Three"}]}],
+        "ignorelist":[]})";
+
+    class contactlist_journal_test : public temp_dir_test
+    {
+    protected:
+        contactlist_journal_test() : temp_dir_test("contactlist_journal_test") {}
+
+        const std::filesystem::path file_ = path("journal.cl");
+
+        static std::shared_ptr<contactlist> load(std::string_view _json)
+        {
+            auto cl = std::make_shared<contactlist>();
+
+            rapidjson::Document doc;
+            doc.Parse(_json.data(), _json.size());
+            EXPECT_FALSE(doc.HasParseError());
+            EXPECT_EQ(cl->unserialize(doc), 0);
+
+            return cl;
+        }
+
+        static std::string save(const contactlist& _cl)
+        {
+            rapidjson::Document doc(rapidjson::Type::kObjectType);
+            _cl.serialize(doc, doc.GetAllocator());
+
+            rapidjson::StringBuffer buffer;
+            rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+            doc.Accept(writer);
+
+            return std::string(buffer.GetString(), buffer.GetSize());
+        }
+
+        void write(const archive::data_block_batch& _batch, bool _truncate)
+        {
+            archive::storage journal(file_.wstring());
+
+            archive::storage_mode mode;
+            mode.flags_.write_ = true;
+            if (_truncate)
+                mode.flags_.truncate_ = true;
+            else
+                mode.flags_.append_ = true;
+
+            ASSERT_TRUE(journal.open(mode));
+
+            int64_t offset = 0;
+            EXPECT_TRUE(journal.write_data_blocks(_batch, offset));
+            journal.close();
+        }
+
+        // saves a snapshot the way im::save_contact_list does
+        std::string snapshot(contactlist& _cl)
+        {
+            archive::data_block_batch header;
+            const auto generation = _cl.start_snapshot(header);
+            _cl.set_changed_status(contactlist::changed_status::none);
+
+            auto json = save(_cl);
+            write(header, true);
+            _cl.commit_snapshot(generation);
+            return json;
+        }
+
+        void append_journal(contactlist& _cl)
+        {
+            ASSERT_FALSE(_cl.need_snapshot());
+
+            archive::data_block_batch batch;
+            _cl.serialize_journal(batch);
+            _cl.set_changed_status(contactlist::changed_status::none);
+
+            write(batch, false);
+        }
+
+        static std::shared_ptr<cl_presence> make_presence(std::string_view _friendly)
+        {
+            auto presence = std::make_shared<cl_presence>();
+            presence->friendly_ = _friendly;
+            presence->status_msg_ = "away";
+            return presence;
+        }
+    };
+}
+
+TEST_F(contactlist_journal_test, replays_changes)
+{
+    auto cl = load(snapshot_json);
+    EXPECT_TRUE(cl->need_snapshot());
+
+    const auto json = snapshot(*cl);
+    EXPECT_FALSE(cl->need_snapshot());
+
+    cl->update_presence("user1@agent", make_presence("Renamed"));
+    cl->set_outgoing_msg_count("user3@agent", 7);
+    append_journal(*cl);
+
+    cl->update_presence("user1@agent", make_presence("Renamed again"));
+    append_journal(*cl);
+
+    auto loaded = load(json);
+    loaded->replay_journal(file_.wstring());
+
+    EXPECT_EQ(loaded->get_changed_status(), contactlist::changed_status::none);
+    EXPECT_EQ(loaded->get_presence("user1@agent")->friendly_, "Renamed again");
+    EXPECT_EQ(loaded->get_presence("user1@agent")->status_msg_, "away");
+    EXPECT_EQ(loaded->get_presence("user3@agent")->outgoing_msg_count_, 7);
+    EXPECT_EQ(loaded->get_presence("user2@agent")->outgoing_msg_count_, 3);
+    EXPECT_TRUE(loaded->get_presence("100@chat.agent")->is_chat_);
+    EXPECT_EQ(save(*loaded), save(*cl));
+}
+
+TEST_F(contactlist_journal_test, replays_removes)
+{
+    auto cl = load(snapshot_json);
+    const auto json = snapshot(*cl);
+
+    // user2 stays in the list while it is in the second group
+    auto diff = load(R"({"groups":[{"id":1,"name":"General","buddies":[{"aimId":"user1@agent"},{"aimId":"user2@agent"}]}]})");
+    auto removed = std::make_shared<std::list<std::string>>();
+    cl->merge_from_diff("deleted", diff, removed);
+    append_journal(*cl);
+
+    auto loaded = load(json);
+    loaded->replay_journal(file_.wstring());
+
+    EXPECT_FALSE(loaded->contains("user1@agent"));
+    EXPECT_TRUE(loaded->contains("user2@agent"));
+    EXPECT_EQ(loaded->get_contacts_count(), cl->get_contacts_count());
+    EXPECT_EQ(save(*loaded), save(*cl));
+}
+
+TEST_F(contactlist_journal_test, ignores_other_generation)
+{
+    auto cl = load(snapshot_json);
+    const auto old_json = snapshot(*cl);
+
+    cl->update_presence("user1@agent", make_presence("Renamed"));
+    append_journal(*cl);
+
+    // the new snapshot was saved, but the journal of the previous generation is still there
+    archive::data_block_batch header;
+    cl->start_snapshot(header);
+    const auto new_json = save(*cl);
+
+    auto loaded = load(new_json);
+    loaded->replay_journal(file_.wstring());
+    EXPECT_TRUE(loaded->need_snapshot());
+    EXPECT_EQ(loaded->get_presence("user1@agent")->friendly_, "Renamed");
+
+    auto old_loaded = load(old_json);
+    old_loaded->replay_journal(file_.wstring());
+    EXPECT_EQ(old_loaded->get_presence("user1@agent")->friendly_, "Renamed");
+}
+
+TEST_F(contactlist_journal_test, failed_snapshot_keeps_generation)
+{
+    auto cl = load(snapshot_json);
+    snapshot(*cl);
+
+    archive::data_block_batch header;
+    const auto generation = cl->start_snapshot(header);
+    cl->set_changed_status(contactlist::changed_status::none);
+
+    // the snapshot write failed, nothing goes to the journal until a snapshot is saved
+    cl->update_presence("user1@agent", make_presence("Renamed"));
+    EXPECT_TRUE(cl->need_snapshot());
+
+    // a retry writes the same generation
+    archive::data_block_batch retry_header;
+    EXPECT_EQ(cl->start_snapshot(retry_header), generation);
+    cl->commit_snapshot(generation);
+    cl->set_changed_status(contactlist::changed_status::none);
+    EXPECT_FALSE(cl->need_snapshot());
+}
+
+TEST_F(contactlist_journal_test, replayed_add_is_idempotent)
+{
+    auto cl = load(snapshot_json);
+    snapshot(*cl);
+
+    auto diff = load(R"({"groups":[{"id":2,"name":"Work","buddies":[{"aimId":"user4@agent","friendly":"User Four"}]}]})");
+    cl->merge_from_diff("created", diff, std::make_shared<std::list<std::string>>());
+    append_journal(*cl);
+
+    // the contact is in the snapshot already when the journal is replayed over it
+    auto loaded = load(save(*cl));
+    loaded->replay_journal(file_.wstring());
+
+    EXPECT_EQ(save(*loaded), save(*cl));
+}
+
+TEST_F(contactlist_journal_test, torn_tail)
+{
+    auto cl = load(snapshot_json);
+    const auto json = snapshot(*cl);
+
+    cl->update_presence("user1@agent", make_presence("Renamed"));
+    append_journal(*cl);
+
+    const auto size = std::filesystem::file_size(file_);
+
+    cl->update_presence("user3@agent", make_presence("Torn"));
+    append_journal(*cl);
+
+    std::filesystem::resize_file(file_, size + (std::filesystem::file_size(file_) - size) / 2);
+
+    auto loaded = load(json);
+    loaded->replay_journal(file_.wstring());
+
+    EXPECT_EQ(loaded->get_presence("user1@agent")->friendly_, "Renamed");
+    EXPECT_EQ(loaded->get_presence("user3@agent")->friendly_, "User Three");
+    EXPECT_EQ(loaded->get_changed_status(), contactlist::changed_status::full);
+}
+
+TEST_F(contactlist_journal_test, compacts_long_journal)
+{
+    auto cl = load(snapshot_json);
+    snapshot(*cl);
+
+    // small lists are compacted after a fixed number of records
+    auto records = 0;
+    for (; records < 1000; ++records)
+    {
+        cl->set_outgoing_msg_count("user1@agent", records + 1);
+        if (cl->need_snapshot())
+            break;
+
+        append_journal(*cl);
+    }
+
+    EXPECT_EQ(records, 256);
+}
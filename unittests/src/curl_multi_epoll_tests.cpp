@@ -0,0 +1,221 @@
+#ifdef __linux__
+
+#include "common.h"
+
+#include "../../gui/stdafx.h"
+#include "../../core/linux/curl_multi_epoll.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+    // minimal HTTP/1.1 stand-in: answers every request with a fixed body and closes the connection
+    class local_http_server
+    {
+    public:
+        explicit local_http_server(std::string _body)
+            : body_(std::move(_body))
+        {
+            listener_ = ::socket(AF_INET, SOCK_STREAM, 0);
+
+            const int reuse = 1;
+            ::setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+            sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            ::bind(listener_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+            ::listen(listener_, SOMAXCONN);
+
+            socklen_t len = sizeof(addr);
+            ::getsockname(listener_, reinterpret_cast<sockaddr*>(&addr), &len);
+            port_ = ntohs(addr.sin_port);
+
+            acceptor_ = std::thread([this]() { accept_loop(); });
+        }
+
+        ~local_http_server()
+        {
+            stop_ = true;
+            ::shutdown(listener_, SHUT_RDWR);
+            ::close(listener_);
+            acceptor_.join();
+
+            for (auto& worker : workers_)
+                worker.join();
+        }
+
+        std::string url() const
+        {
+            return "http://127.0.0.1:" + std::to_string(port_) + "/";
+        }
+
+        size_t served() const
+        {
+            return served_;
+        }
+
+    private:
+        void accept_loop()
+        {
+            while (!stop_)
+            {
+                const auto fd = ::accept(listener_, nullptr, nullptr);
+                if (fd < 0)
+                    continue;
+
+                workers_.emplace_back([this, fd]() { serve(fd); });
+            }
+        }
+
+        void serve(int _fd)
+        {
+            std::string request;
+            char buffer[4096];
+            while (request.find("\r\n\r\n") == std::string::npos)
+            {
+                const auto read = ::recv(_fd, buffer, sizeof(buffer), 0);
+                if (read <= 0)
+                    break;
+                request.append(buffer, read);
+            }
+
+            const auto response = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body_.size()) + "\r\nConnection: close\r\n\r\n" + body_;
+            ::send(_fd, response.data(), response.size(), MSG_NOSIGNAL);
+            ::close(_fd);
+
+            ++served_;
+        }
+
+        const std::string body_;
+
+        int listener_ = -1;
+        uint16_t port_ = 0;
+
+        std::atomic_bool stop_ = false;
+        std::atomic_size_t served_ = 0;
+
+        std::thread acceptor_;
+        std::vector<std::thread> workers_;
+    };
+
+    size_t on_write(char*, size_t _size, size_t _count, void* _userp)
+    {
+        *static_cast<size_t*>(_userp) += _size * _count;
+        return _size * _count;
+    }
+
+    void raise_files_limit()
+    {
+        rlimit limit = {};
+        if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+        {
+            limit.rlim_cur = limit.rlim_max;
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+}
+
+// more parallel transfers than FD_SETSIZE allows with select()
+TEST(curl_multi_epoll_test, parallel_load)
+{
+    constexpr size_t requests_count = 3000;
+    constexpr size_t parallel_count = 1200;
+
+    raise_files_limit();
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    {
+        const std::string body(1024, 'x');
+        local_http_server server(body);
+
+        core::curl_multi_epoll epoll;
+        ASSERT_TRUE(epoll.init());
+
+        auto multi = curl_multi_init();
+        epoll.attach(multi);
+
+        std::vector<size_t> received(requests_count);
+        size_t started = 0;
+        size_t succeeded = 0;
+        size_t finished = 0;
+        int still_running = 0;
+
+        const auto start_request = [&]()
+        {
+            auto easy = curl_easy_init();
+            curl_easy_setopt(easy, CURLOPT_URL, server.url().c_str());
+            curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, on_write);
+            curl_easy_setopt(easy, CURLOPT_WRITEDATA, &received[started]);
+            curl_easy_setopt(easy, CURLOPT_TIMEOUT, 30L);
+            curl_multi_add_handle(multi, easy);
+            ++started;
+        };
+
+        while (started < std::min(parallel_count, requests_count))
+            start_request();
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::minutes(1);
+        while (finished < requests_count && std::chrono::steady_clock::now() < deadline)
+        {
+            ASSERT_TRUE(epoll.wait(std::chrono::seconds(1), still_running));
+
+            int left = 0;
+            while (auto msg = curl_multi_info_read(multi, &left))
+            {
+                if (msg->msg != CURLMSG_DONE)
+                    continue;
+
+                long code = 0;
+                curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &code);
+                if (msg->data.result == CURLE_OK && code == 200)
+                    ++succeeded;
+
+                curl_multi_remove_handle(multi, msg->easy_handle);
+                curl_easy_cleanup(msg->easy_handle);
+                ++finished;
+
+                if (started < requests_count)
+                    start_request();
+            }
+        }
+
+        curl_multi_cleanup(multi);
+
+        EXPECT_EQ(finished, requests_count);
+        EXPECT_EQ(succeeded, requests_count);
+        EXPECT_EQ(server.served(), requests_count);
+        EXPECT_TRUE(std::all_of(received.begin(), received.end(), [size = body.size()](auto _received) { return _received == size; }));
+    }
+
+    curl_global_cleanup();
+}
+
+TEST(curl_multi_epoll_test, notify_wakes_up)
+{
+    core::curl_multi_epoll epoll;
+    ASSERT_TRUE(epoll.init());
+
+    auto multi = curl_multi_init();
+    epoll.attach(multi);
+
+    std::thread notifier([&epoll]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        epoll.notify();
+    });
+
+    int still_running = 0;
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(epoll.wait(std::chrono::seconds(10), still_running));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+    notifier.join();
+    curl_multi_cleanup(multi);
+}
+
+#endif //__linux__
@@ -0,0 +1,151 @@
+#include "common.h"
+
+#include "../../gui/stdafx.h"
+#include "../../corelib/arena_collection.h"
+#include "../../corelib/collection_helper.h"
+#include "../../core/gui_batch.h"
+
+using namespace core;
+
+namespace
+{
+    coll_helper make_presence(std::string_view _aimid, std::string_view _state)
+    {
+        coll_helper coll(arena_collection::create(), true);
+        coll.set_value_as_string("aimid", _aimid);
+        coll.set_value_as_string("state", _state);
+        return coll;
+    }
+
+    coll_helper make_typing(std::string_view _aimid, std::string_view _chatter)
+    {
+        coll_helper coll(arena_collection::create(), true);
+        coll.set_value_as_string("aimId", _aimid);
+        coll.set_value_as_string("chatterAimId", _chatter);
+        coll.set_value_as_string("chatterName", "name");
+        return coll;
+    }
+
+    struct delivered_event
+    {
+        std::string message_;
+        std::string key_;
+        std::string state_;
+    };
+
+    std::vector<delivered_event> take_events(gui_batch& _batch, int64_t& _merged)
+    {
+        coll_helper envelope(arena_collection::create(), true);
+        _batch.take(envelope.get());
+
+        _merged = envelope.get_value_as_int64("merged");
+
+        std::vector<delivered_event> result;
+        const auto events = envelope.get_value_as_array("events");
+        for (int32_t i = 0; i < events->size(); ++i)
+        {
+            coll_helper event(events->get_at(i)->get_as_collection(), false);
+            coll_helper data(event.get_value_as_collection("data"), false);
+
+            delivered_event e;
+            e.message_ = event.get_value_as_string("message");
+            if (data.is_value_exist("aimid"))
+                e.key_ = data.get_value_as_string("aimid");
+            else if (data.is_value_exist("aimId"))
+                e.key_ = data.get_value_as_string("aimId");
+            if (data.is_value_exist("state"))
+                e.state_ = data.get_value_as_string("state");
+            result.push_back(std::move(e));
+        }
+        return result;
+    }
+
+    const gui_batch::counters& find_counters(const std::vector<gui_batch::counters>& _counters, std::string_view _message)
+    {
+        const auto it = std::find_if(_counters.begin(), _counters.end(), [_message](const auto& c) { return c.message_ == _message; });
+        EXPECT_NE(_counters.end(), it);
+        return *it;
+    }
+}
+
+TEST(gui_batch_test, keeps_latest_presence_per_contact)
+{
+    gui_batch batch;
+
+    EXPECT_TRUE(batch.add("contact/presence", make_presence("1", "online").get()));
+    EXPECT_TRUE(batch.add("contact/presence", make_presence("2", "online").get()));
+    EXPECT_TRUE(batch.add("contact/presence", make_presence("1", "away").get()));
+    EXPECT_TRUE(batch.add("contact/presence", make_presence("1", "offline").get()));
+    EXPECT_EQ(2u, batch.size());
+
+    int64_t merged = 0;
+    const auto events = take_events(batch, merged);
+    EXPECT_EQ(2, merged);
+    EXPECT_TRUE(batch.empty());
+
+    ASSERT_EQ(2u, events.size());
+    EXPECT_EQ("1", events[0].key_);
+    EXPECT_EQ("offline", events[0].state_);
+    EXPECT_EQ("2", events[1].key_);
+    EXPECT_EQ("online", events[1].state_);
+}
+
+TEST(gui_batch_test, typing_stop_replaces_typing)
+{
+    gui_batch batch;
+
+    batch.add("typing", make_typing("chat", "1").get());
+    batch.add("typing", make_typing("chat", "2").get());
+    batch.add("typing/stop", make_typing("chat", "1").get());
+
+    int64_t merged = 0;
+    const auto events = take_events(batch, merged);
+    EXPECT_EQ(1, merged);
+
+    ASSERT_EQ(2u, events.size());
+    EXPECT_EQ("typing/stop", events[0].message_);
+    EXPECT_EQ("typing", events[1].message_);
+}
+
+TEST(gui_batch_test, keeps_unkeyed_and_skips_other_messages)
+{
+    gui_batch batch;
+
+    coll_helper dlg_states(arena_collection::create(), true);
+    dlg_states.set_value_as_string("my_aimid", "me");
+
+    EXPECT_TRUE(batch.add("dlg_states", dlg_states.get()));
+    EXPECT_TRUE(batch.add("dlg_states", dlg_states.get()));
+    EXPECT_FALSE(batch.add("archive/messages/get/result", dlg_states.get()));
+    EXPECT_FALSE(batch.add("contact/presence", nullptr));
+
+    EXPECT_EQ(2u, batch.size());
+
+    int64_t merged = 0;
+    const auto events = take_events(batch, merged);
+    EXPECT_EQ(0, merged);
+    EXPECT_EQ(2u, events.size());
+}
+
+TEST(gui_batch_test, counts_posted_and_merged)
+{
+    gui_batch batch;
+
+    for (auto i = 0; i < 100; ++i)
+        batch.add("contact/presence", make_presence(std::to_string(i % 10), "online").get());
+    batch.add("status", make_typing("1", "1").get());
+
+    int64_t merged = 0;
+    EXPECT_EQ(11u, take_events(batch, merged).size());
+    EXPECT_EQ(90, merged);
+
+    batch.add("contact/presence", make_presence("1", "online").get());
+    EXPECT_EQ(1u, take_events(batch, merged).size());
+    EXPECT_EQ(0, merged);
+
+    const auto counters = batch.get_counters();
+    EXPECT_EQ(101u, find_counters(counters, "contact/presence").posted_);
+    EXPECT_EQ(90u, find_counters(counters, "contact/presence").merged_);
+    EXPECT_EQ(1u, find_counters(counters, "status").posted_);
+    EXPECT_EQ(0u, find_counters(counters, "status").merged_);
+}
@@ -0,0 +1,151 @@
+#include "common.h"
+#include "temp_dir_fixture.h"
+
+#include "../../gui/stdafx.h"
+#include "../../core/archive/headers_table.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace core;
+using namespace core::archive;
+
+namespace
+{
+    message_header make_header(int64_t _id, int64_t _prev_id, std::string_view _patch_version = {})
+    {
+        message_flags flags;
+        flags.flags_.outgoing_ = _id % 2;
+
+        return message_header(flags, 1000 + _id, _id, _prev_id, _id * 100, uint32_t(_id), common::tools::patch_version(_patch_version), false, _id % 3 == 0, false, true, false);
+    }
+
+    std::vector<message_header> make_headers(int64_t _first, int64_t _count)
+    {
+        std::vector<message_header> headers;
+        for (auto id = _first; id < _first + _count; ++id)
+            headers.push_back(make_header(id, id - 1, id % 10 == 0 ? std::to_string(id) : std::string()));
+        return headers;
+    }
+
+    void expect_equal(const message_header& _header, const message_header& _expected)
+    {
+        EXPECT_EQ(_header.get_id(), _expected.get_id());
+        EXPECT_EQ(_header.get_prev_msgid(), _expected.get_prev_msgid());
+        EXPECT_EQ(_header.get_time(), _expected.get_time());
+        EXPECT_EQ(_header.get_flags().value_, _expected.get_flags().value_);
+        EXPECT_EQ(_header.get_data_offset(), _expected.get_data_offset());
+        EXPECT_EQ(_header.get_data_size(), _expected.get_data_size());
+        EXPECT_EQ(_header.get_version(), _expected.get_version());
+        EXPECT_EQ(_header.get_update_patch_version(), _expected.get_update_patch_version());
+        EXPECT_EQ(_header.has_poll_with_id(), _expected.has_poll_with_id());
+        EXPECT_EQ(_header.has_reactions(), _expected.has_reactions());
+        EXPECT_EQ(_header.has_thread(), _expected.has_thread());
+    }
+
+    std::vector<int64_t> ids(const headers_table& _table)
+    {
+        std::vector<int64_t> result;
+        for (const auto& header : _table)
+            result.push_back(header.get_id());
+        return result;
+    }
+
+    class headers_table_test : public temp_dir_test
+    {
+    protected:
+        headers_table_test() : temp_dir_test("headers_table_test") {}
+
+        const std::filesystem::path file_ = path("_hidx");
+    };
+}
+
+TEST_F(headers_table_test, keeps_headers_sorted)
+{
+    headers_table table;
+
+    const auto block = make_headers(10, 5);
+    table.insert(table.end(), block.begin(), block.end());
+
+    const auto older = make_headers(1, 3);
+    table.insert(table.lower_bound(1), older.begin(), older.end());
+
+    table.insert(table.lower_bound(7), make_header(7, 3));
+
+    EXPECT_EQ(ids(table), std::vector<int64_t>({ 1, 2, 3, 7, 10, 11, 12, 13, 14 }));
+    EXPECT_EQ(table.find(5), table.end());
+    ASSERT_NE(table.find(10), table.end());
+
+    expect_equal(table.get(table.find(10)), block[0]);
+    expect_equal(table.get(table.find(7)), make_header(7, 3));
+    EXPECT_EQ(table.get(table.find(10)).get_update_patch_version().as_string(), "10");
+}
+
+TEST_F(headers_table_test, updates_in_place)
+{
+    headers_table table;
+    const auto block = make_headers(1, 20);
+    table.insert(table.end(), block.begin(), block.end());
+
+    auto header = table.get(table.find(10));
+    header.set_update_patch_version(common::tools::patch_version(std::string("11")));
+    header.increment_offline_version();
+    table.set(table.find(10), header);
+
+    const auto updated = table.get(table.find(10));
+    EXPECT_EQ(updated.get_update_patch_version().as_string(), "11");
+    EXPECT_EQ(updated.get_update_patch_version().get_offline_version(), 1);
+
+    auto packed = table.find(11);
+    packed->set_prev_msgid(9);
+    packed->invalidate_data_offset();
+    EXPECT_EQ(table.get(packed).get_prev_msgid(), 9);
+    EXPECT_FALSE(table.get(packed).is_message_data_valid());
+
+    // dropping a header drops its patch version as well
+    table.erase(table.find(10), table.find(11));
+    table.insert(table.lower_bound(10), make_header(10, 9));
+    EXPECT_TRUE(table.get(table.find(10)).get_update_patch_version().is_empty());
+
+    table.erase_if([](const packed_header& _header) { return _header.get_id() % 2 == 0; });
+    EXPECT_EQ(table.size(), 10u);
+    EXPECT_EQ(table.find(10), table.end());
+}
+
+TEST_F(headers_table_test, saves_and_loads)
+{
+    headers_table table;
+    const auto block = make_headers(100, 1000);
+    table.insert(table.end(), block.begin(), block.end());
+
+    ASSERT_TRUE(table.save(file_.wstring(), 7));
+
+    headers_table loaded;
+    const auto generation = loaded.load(file_.wstring());
+    ASSERT_TRUE(generation);
+    EXPECT_EQ(*generation, 7);
+    ASSERT_EQ(loaded.size(), block.size());
+
+    auto it = loaded.begin();
+    for (const auto& header : block)
+        expect_equal(loaded.get(it++), header);
+
+    EXPECT_EQ(loaded.get_memory_usage(), table.get_memory_usage());
+}
+
+TEST_F(headers_table_test, rejects_broken_file)
+{
+    headers_table table;
+    const auto block = make_headers(1, 100);
+    table.insert(table.end(), block.begin(), block.end());
+    ASSERT_TRUE(table.save(file_.wstring(), 1));
+
+    std::filesystem::resize_file(file_, std::filesystem::file_size(file_) - 1);
+
+    headers_table loaded;
+    EXPECT_FALSE(loaded.load(file_.wstring()));
+    EXPECT_TRUE(loaded.empty());
+
+    std::filesystem::remove(file_);
+    EXPECT_FALSE(loaded.load(file_.wstring()));
+}
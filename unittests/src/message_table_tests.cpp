@@ -0,0 +1,72 @@
+#include "common.h"
+
+#include "../../gui/stdafx.h"
+#include "../../common.shared/message_table.h"
+
+namespace
+{
+    constexpr std::string_view names[] =
+    {
+        "login_by_password",
+        "archive/messages/get",
+        "archive/messages/get/result",
+        "dialogs/search/local",
+        "dialogs/search/local/end",
+        "voip_call",
+    };
+
+    constexpr common::message_table table(names);
+    static_assert(table.is_collision_free());
+    static_assert(table.find("voip_call") == 5);
+    static_assert(table.find("voip") == table.npos);
+}
+
+TEST(message_table_test, finds_id_by_name)
+{
+    for (size_t i = 0; i < std::size(names); ++i)
+    {
+        EXPECT_EQ(i, table.find(names[i]));
+        EXPECT_EQ(names[i], table.name(i));
+    }
+
+    // the name doesn't have to outlive the call
+    const std::string name = "dialogs/search/local";
+    EXPECT_EQ(3u, table.find(name));
+}
+
+TEST(message_table_test, unknown_name)
+{
+    EXPECT_EQ(table.npos, table.find(""));
+    EXPECT_EQ(table.npos, table.find("archive/messages"));
+    EXPECT_EQ(table.npos, table.find("archive/messages/get/"));
+    EXPECT_EQ(table.npos, table.find("ARCHIVE/MESSAGES/GET"));
+
+    EXPECT_TRUE(table.name(table.npos).empty());
+}
+
+TEST(message_table_test, duplicate_names_collide)
+{
+    constexpr std::string_view duplicates[] = { "stats", "im_stats", "stats" };
+    constexpr common::message_table duplicates_table(duplicates);
+
+    EXPECT_FALSE(duplicates_table.is_collision_free());
+}
+
+TEST(message_table_test, many_names)
+{
+    std::vector<std::string> storage;
+    for (int i = 0; i < 300; ++i)
+        storage.push_back("message/" + std::to_string(i));
+
+    std::string_view many[300];
+    for (size_t i = 0; i < std::size(many); ++i)
+        many[i] = storage[i];
+
+    const common::message_table many_table(many);
+    EXPECT_TRUE(many_table.is_collision_free());
+
+    for (size_t i = 0; i < std::size(many); ++i)
+        EXPECT_EQ(i, many_table.find(many[i]));
+
+    EXPECT_EQ(many_table.npos, many_table.find("message/300"));
+}
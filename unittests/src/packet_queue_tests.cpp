@@ -297,3 +297,192 @@ TEST(packet_queue_test, pop_top_element)
         ASSERT_EQ(e0->key_, 0);
     }
 }
+
+TEST(packet_queue_test, string_keys)
+{
+    struct named_element
+    {
+        std::shared_ptr<std::string> method_;
+        int priority_ = 0;
+    };
+
+    struct method_getter
+    {
+        std::string_view key(const named_element& _element) const { return *_element.method_; }
+        core::priority_t priority(const named_element& _element) const { return _element.priority_; }
+    };
+
+    core::wim::packet_queue<named_element, method_getter> queue;
+    queue.set_limit(10);
+    queue.enqueue({ std::make_shared<std::string>("a"), 1 });
+    queue.enqueue({ std::make_shared<std::string>("a"), 1 });
+    queue.enqueue({ std::make_shared<std::string>("b"), 2 });
+
+    // the key outlives the element it came from
+    ASSERT_EQ(*queue.pop()->method_, "a");
+    ASSERT_EQ(*queue.pop()->method_, "b");
+    EXPECT_FALSE(queue.can_pop_element());
+
+    queue.allow_using("a");
+    ASSERT_TRUE(queue.can_pop_element());
+    ASSERT_EQ(*queue.pop()->method_, "a");
+    EXPECT_TRUE(queue.is_empty());
+}
+
+namespace
+{
+    // the queue as it was: a sorted list searched for the first element of a key not popped
+    class linear_queue
+    {
+    public:
+        bool can_pop_element() const
+        {
+            return extracted_.size() < limit_ && std::any_of(queue_.begin(), queue_.end(), [this](const auto& _e) { return extracted_.count(_e.key_) == 0; });
+        }
+
+        std::optional<queue_element_with_priority> pop()
+        {
+            const auto it = std::find_if(queue_.begin(), queue_.end(), [this](const auto& _e) { return extracted_.count(_e.key_) == 0; });
+            const auto element = *it;
+            queue_.erase(it);
+            extracted_.insert(element.key_);
+            return element;
+        }
+
+        void enqueue(const queue_element_with_priority& _element)
+        {
+            const auto it = std::find_if(queue_.begin(), queue_.end(), [&_element](const auto& _e) { return _element.priority_ < _e.priority_; });
+            queue_.insert(it, _element);
+        }
+
+        void allow_using(int _key) { extracted_.erase(_key); }
+        void set_limit(size_t _limit) { limit_ = _limit; }
+        bool is_limit_reached() const { return extracted_.size() >= limit_; }
+        bool is_empty() const { return queue_.empty(); }
+
+    private:
+        std::list<queue_element_with_priority> queue_;
+        std::set<int> extracted_;
+        size_t limit_ = 1;
+    };
+
+    // a burst of packets over a few methods dispatched with _limit of them in flight, returns the pop order
+    template <typename Queue>
+    std::vector<int> dispatch_burst(Queue& _queue, size_t _packets_count, int _keys_count, size_t _limit)
+    {
+        std::mt19937 rng(7);
+        _queue.set_limit(_limit);
+
+        for (size_t i = 0; i < _packets_count; ++i)
+            _queue.enqueue({ int(rng() % _keys_count), int(rng() % 3) });
+
+        std::vector<int> popped;
+        popped.reserve(_packets_count);
+
+        std::deque<int> in_flight;
+        while (!_queue.is_empty())
+        {
+            while (_queue.can_pop_element())
+            {
+                const auto key = _queue.pop()->key_;
+                popped.push_back(key);
+                in_flight.push_back(key);
+            }
+
+            // the oldest request completes, a network error sends every tenth back to the queue
+            if (in_flight.empty())
+                break;
+
+            const auto key = in_flight.front();
+            in_flight.pop_front();
+            if (popped.size() % 10 == 0)
+                _queue.enqueue({ key, 0 });
+            _queue.allow_using(key);
+        }
+
+        return popped;
+    }
+}
+
+TEST(packet_queue_test, pops_as_linear_queue)
+{
+    std::mt19937 rng(1);
+
+    for (int round = 0; round < 50; ++round)
+    {
+        priority_test_queue queue;
+        linear_queue expected;
+
+        const auto limit = 1 + rng() % 4;
+        queue.set_limit(limit);
+        expected.set_limit(limit);
+
+        std::vector<int> extracted;
+        for (int step = 0; step < 500; ++step)
+        {
+            const auto action = rng() % 3;
+            if (action == 0)
+            {
+                const queue_element_with_priority element = { int(rng() % 8), int(rng() % 4) };
+                queue.enqueue(element);
+                expected.enqueue(element);
+            }
+            else if (action == 1 && expected.can_pop_element())
+            {
+                ASSERT_TRUE(queue.can_pop_element());
+                const auto e = queue.pop();
+                const auto expected_e = expected.pop();
+                ASSERT_EQ(e->key_, expected_e->key_);
+                ASSERT_EQ(e->priority_, expected_e->priority_);
+                extracted.push_back(e->key_);
+            }
+            else if (action == 2 && !extracted.empty())
+            {
+                const auto it = extracted.begin() + rng() % extracted.size();
+                queue.allow_using(*it);
+                expected.allow_using(*it);
+                extracted.erase(it);
+            }
+
+            ASSERT_EQ(queue.can_pop_element(), expected.can_pop_element());
+            ASSERT_EQ(queue.is_limit_reached(), expected.is_limit_reached());
+            ASSERT_EQ(queue.is_empty(), expected.is_empty());
+        }
+    }
+}
+
+TEST(packet_queue_test, dispatches_burst_as_linear_queue)
+{
+    priority_test_queue queue;
+    linear_queue expected;
+    EXPECT_EQ(dispatch_burst(queue, 2000, 40, 4), dispatch_burst(expected, 2000, 40, 4));
+}
+
+// run with --gtest_also_run_disabled_tests
+TEST(packet_queue_test, DISABLED_benchmark_reconnect_burst)
+{
+    using clock = std::chrono::steady_clock;
+
+    // packets queued while offline over the methods the client sends, 4 in flight as with a slow connection
+    constexpr int keys_count = 60;
+    constexpr size_t limit = 4;
+
+    for (const size_t packets_count : { 1000, 5000, 20000 })
+    {
+        const auto measure = [packets_count](auto& _queue)
+        {
+            const auto start = clock::now();
+            const auto popped = dispatch_burst(_queue, packets_count, keys_count, limit);
+            const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+            EXPECT_GE(popped.size(), packets_count);
+            return time / int64_t(popped.size());
+        };
+
+        priority_test_queue queue;
+        linear_queue linear;
+
+        const auto indexed_ns = measure(queue);
+        const auto linear_ns = measure(linear);
+        std::cout << packets_count << " packets: indexed " << indexed_ns << " ns per packet, linear " << linear_ns << " ns per packet" << std::endl;
+    }
+}
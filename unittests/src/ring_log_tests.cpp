@@ -0,0 +1,249 @@
+#include "common.h"
+
+#include "../../gui/stdafx.h"
+#include "../../core/log/ring_log.h"
+
+#include <chrono>
+
+using namespace core::log;
+
+namespace
+{
+    constexpr uint16_t message_format = 1;
+
+    void format_message(uint16_t _format, ring_args& _args, std::string& _out)
+    {
+        EXPECT_EQ(_format, message_format);
+
+        _out += "message=";
+        _out += _args.next_string();
+        _out += " seq=";
+        _out += std::to_string(_args.next_int());
+        EXPECT_TRUE(_args.empty());
+    }
+
+    // collects the batches, can hold the drainer inside the sink
+    class collector
+    {
+    public:
+        ring_log::sink make_sink()
+        {
+            return [this](const ring_log::entries& _entries, int64_t _dropped)
+            {
+                std::unique_lock lock(mutex_);
+                for (const auto& entry : _entries)
+                    received_.push_back({ entry.time_, entry.thread_, std::string(entry.text_) });
+                dropped_ += _dropped;
+
+                entered_ = true;
+                condition_.notify_all();
+                condition_.wait(lock, [this]() { return !hold_; });
+            };
+        }
+
+        void hold()
+        {
+            std::scoped_lock lock(mutex_);
+            hold_ = true;
+            entered_ = false;
+        }
+
+        void wait_entered()
+        {
+            std::unique_lock lock(mutex_);
+            condition_.wait(lock, [this]() { return entered_; });
+        }
+
+        void release()
+        {
+            {
+                std::scoped_lock lock(mutex_);
+                hold_ = false;
+            }
+            condition_.notify_all();
+        }
+
+        std::vector<std::string> texts() const
+        {
+            std::vector<std::string> result;
+            for (const auto& item : received_)
+                result.push_back(item.text_);
+            return result;
+        }
+
+        struct item
+        {
+            std::chrono::system_clock::time_point time_;
+            std::thread::id thread_;
+            std::string text_;
+        };
+
+        std::vector<item> received_;
+        int64_t dropped_ = 0;
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        bool hold_ = false;
+        bool entered_ = false;
+    };
+}
+
+TEST(ring_log_test, writes_text_and_structured_records)
+{
+    collector result;
+    {
+        ring_log log("ring_log_test", format_message, result.make_sink());
+
+        const std::string long_text(1000, 'l');
+        const std::string oversized_text(200 * 1024, 'o');
+
+        log.write_text("first");
+        log.write(message_format, std::string_view("im/get"), 42);
+        log.write_text(long_text);
+        log.write(message_format, std::string("archive/messages/get"), int64_t(-1));
+        log.write_text(oversized_text);
+        log.flush();
+
+        EXPECT_EQ(result.texts(), std::vector<std::string>({ "first", "message=im/get seq=42", long_text, "message=archive/messages/get seq=-1", oversized_text }));
+        EXPECT_EQ(log.get_dropped_count(), 0);
+    }
+
+    for (const auto& item : result.received_)
+        EXPECT_EQ(item.thread_, std::this_thread::get_id());
+}
+
+TEST(ring_log_test, merges_threads_by_time)
+{
+    constexpr int threads_count = 4;
+    constexpr int records_count = 500;
+
+    collector result;
+    ring_log log("ring_log_test", format_message, result.make_sink(), std::chrono::milliseconds(1));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threads_count; ++t)
+    {
+        threads.emplace_back([&log, t]()
+        {
+            for (int i = 0; i < records_count; ++i)
+                log.write(message_format, std::to_string(t), i);
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    log.flush();
+
+    ASSERT_EQ(int64_t(result.received_.size()) + result.dropped_, threads_count * records_count);
+    EXPECT_EQ(result.dropped_, log.get_dropped_count());
+
+    // the records of a thread keep their order
+    std::map<std::thread::id, int64_t> last_seq;
+    for (const auto& item : result.received_)
+    {
+        const auto seq = std::stoll(item.text_.substr(item.text_.find("seq=") + 4));
+        auto& last = last_seq.emplace(item.thread_, -1).first->second;
+        EXPECT_LT(last, seq);
+        last = seq;
+    }
+}
+
+TEST(ring_log_test, counts_dropped_records)
+{
+    collector result;
+    ring_log log("ring_log_test", format_message, result.make_sink());
+
+    // the drainer is stuck in the sink, so the ring of this thread fills up
+    result.hold();
+    log.write_text("first");
+    std::thread flusher([&log]() { log.flush(); });
+    result.wait_entered();
+
+    constexpr int records_count = 2000;
+    for (int i = 0; i < records_count; ++i)
+        log.write(message_format, std::string_view("overload"), i);
+
+    EXPECT_GT(log.get_dropped_count(), 0);
+
+    result.release();
+    flusher.join();
+    log.flush();
+
+    EXPECT_EQ(result.dropped_, log.get_dropped_count());
+    EXPECT_EQ(int64_t(result.received_.size()) + result.dropped_, records_count + 1);
+}
+
+// run with --gtest_also_run_disabled_tests
+TEST(ring_log_test, DISABLED_benchmark)
+{
+    using clock = std::chrono::steady_clock;
+
+    constexpr int iterations = 200000;
+    const std::string line = "GUI->CORE: message=archive/messages/get <1234567890@chat.agent> 7012345678901234567\r\n";
+
+    const auto measure = [iterations](std::string_view _name, auto _write)
+    {
+        const auto start = clock::now();
+        for (int i = 0; i < iterations; ++i)
+            _write(i);
+        const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+
+        std::cout << _name << ": " << time / iterations << " ns per record" << std::endl;
+    };
+
+    {
+        // what the logging thread of core::log does: a locked queue of strings and a notification
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::list<std::unique_ptr<std::string>> queue;
+        bool stop = false;
+
+        std::thread consumer([&]()
+        {
+            std::unique_lock lock(mutex);
+            while (!stop || !queue.empty())
+            {
+                condition.wait(lock, [&]() { return stop || !queue.empty(); });
+                std::list<std::unique_ptr<std::string>> records;
+                records.swap(queue);
+                lock.unlock();
+                records.clear();
+                lock.lock();
+            }
+        });
+
+        measure("locked queue, formatted line", [&](int)
+        {
+            auto record = std::make_unique<std::string>(line);
+            {
+                std::scoped_lock lock(mutex);
+                queue.push_back(std::move(record));
+            }
+            condition.notify_one();
+        });
+
+        {
+            std::scoped_lock lock(mutex);
+            stop = true;
+        }
+        condition.notify_one();
+        consumer.join();
+    }
+
+    int64_t received = 0;
+    int64_t dropped = 0;
+    ring_log log("ring_log_bench", format_message, [&received, &dropped](const ring_log::entries& _entries, int64_t _dropped)
+    {
+        received += int64_t(_entries.size());
+        dropped += _dropped;
+    }, std::chrono::milliseconds(1));
+
+    measure("ring_log, text line", [&log, &line](int) { log.write_text(line); });
+    measure("ring_log, format id and arguments", [&log](int _i) { log.write(message_format, std::string_view("archive/messages/get"), _i); });
+    log.flush();
+
+    std::cout << "received " << received << ", dropped " << dropped << std::endl;
+    EXPECT_EQ(received + dropped, 2 * iterations);
+}
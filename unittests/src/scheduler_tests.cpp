@@ -0,0 +1,158 @@
+#include "common.h"
+
+#include "../../gui/stdafx.h"
+#include "../../core/core.h"
+#include "../../core/scheduler.h"
+
+#include <random>
+
+namespace
+{
+    using clock = std::chrono::steady_clock;
+
+    // collects the fired tasks and runs them on the scheduler thread right away
+    struct executor
+    {
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        size_t executed_ = 0;
+
+        std::function<void(core::stacked_task)> get()
+        {
+            return [this](core::stacked_task _task)
+            {
+                _task.execute();
+
+                {
+                    std::scoped_lock lock(mutex_);
+                    ++executed_;
+                }
+                condition_.notify_all();
+            };
+        }
+
+        bool wait_for(size_t _count, std::chrono::milliseconds _timeout)
+        {
+            std::unique_lock lock(mutex_);
+            return condition_.wait_for(lock, _timeout, [this, _count]() { return executed_ >= _count; });
+        }
+    };
+}
+
+TEST(scheduler_test, single_shot_fires_once)
+{
+    executor exec;
+    core::scheduler scheduler(exec.get());
+
+    std::atomic_int fired = 0;
+    scheduler.push_single_shot_timer({ [&fired]() { ++fired; } }, std::chrono::milliseconds(10));
+
+    EXPECT_TRUE(exec.wait_for(1, std::chrono::seconds(5)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(fired, 1);
+}
+
+TEST(scheduler_test, periodic_timer_repeats_until_stopped)
+{
+    executor exec;
+    core::scheduler scheduler(exec.get());
+
+    std::atomic_int fired = 0;
+    const auto id = scheduler.push_timer({ [&fired]() { ++fired; } }, std::chrono::milliseconds(5));
+
+    EXPECT_TRUE(exec.wait_for(3, std::chrono::seconds(5)));
+    scheduler.stop_timer(id);
+
+    const int stopped_at = fired;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(fired, stopped_at);
+}
+
+TEST(scheduler_test, stopped_timer_doesnt_fire)
+{
+    executor exec;
+    core::scheduler scheduler(exec.get());
+
+    std::atomic_int fired = 0;
+    const auto id = scheduler.push_single_shot_timer({ [&fired]() { ++fired; } }, std::chrono::milliseconds(20));
+    scheduler.stop_timer(id);
+    scheduler.push_single_shot_timer({ []() {} }, std::chrono::milliseconds(40));
+
+    EXPECT_TRUE(exec.wait_for(1, std::chrono::seconds(5)));
+    EXPECT_EQ(fired, 0);
+}
+
+TEST(scheduler_test, fires_in_deadline_order)
+{
+    executor exec;
+    core::scheduler scheduler(exec.get());
+
+    std::vector<int> order;
+    for (auto i : { 3, 1, 2 })
+        scheduler.push_single_shot_timer({ [&order, i]() { order.push_back(i); } }, std::chrono::milliseconds(10 * i));
+
+    ASSERT_TRUE(exec.wait_for(3, std::chrono::seconds(5)));
+    EXPECT_EQ(order, (std::vector<int>{ 1, 2, 3 }));
+}
+
+TEST(scheduler_test, nearer_timer_wakes_up_sleeping_thread)
+{
+    executor exec;
+    core::scheduler scheduler(exec.get());
+
+    scheduler.push_single_shot_timer({ []() {} }, std::chrono::hours(1));
+
+    const auto start = clock::now();
+    scheduler.push_single_shot_timer({ []() {} }, std::chrono::milliseconds(10));
+
+    EXPECT_TRUE(exec.wait_for(1, std::chrono::seconds(5)));
+    EXPECT_LT(clock::now() - start, std::chrono::seconds(1));
+}
+
+// run with --gtest_also_run_disabled_tests
+TEST(scheduler_test, DISABLED_benchmark_10k_timers)
+{
+    constexpr size_t timers_count = 10000;
+
+    std::vector<clock::time_point> deadlines(timers_count);
+    std::vector<clock::duration> lateness(timers_count);
+
+    executor exec;
+    core::scheduler scheduler(exec.get());
+
+    std::mt19937 rng(1);
+
+    // half of the timers are stopped right away, as most of the request timeouts are
+    const auto push_start = clock::now();
+    std::vector<uint32_t> ids;
+    ids.reserve(timers_count);
+    for (size_t i = 0; i < timers_count; ++i)
+    {
+        const auto timeout = std::chrono::milliseconds(10 + rng() % 1000);
+        deadlines[i] = clock::now() + timeout;
+        ids.push_back(scheduler.push_single_shot_timer({ [&deadlines, &lateness, i]() { lateness[i] = clock::now() - deadlines[i]; } }, timeout));
+    }
+    const auto push_time = clock::now() - push_start;
+
+    const auto stop_start = clock::now();
+    for (size_t i = 0; i < timers_count; i += 2)
+        scheduler.stop_timer(ids[i]);
+    const auto stop_time = clock::now() - stop_start;
+
+    ASSERT_TRUE(exec.wait_for(timers_count / 2, std::chrono::seconds(10)));
+
+    std::vector<clock::duration> fired;
+    for (size_t i = 1; i < timers_count; i += 2)
+        fired.push_back(lateness[i]);
+    std::sort(fired.begin(), fired.end());
+
+    const auto to_us = [](auto _duration) { return std::chrono::duration_cast<std::chrono::microseconds>(_duration).count(); };
+
+    std::cout << "push " << to_us(push_time) * 1000 / timers_count << " ns/timer"
+        << ", stop " << to_us(stop_time) * 2000 / timers_count << " ns/timer"
+        << ", lateness p50 " << to_us(fired[fired.size() / 2]) << " us"
+        << ", p99 " << to_us(fired[fired.size() * 99 / 100]) << " us"
+        << ", max " << to_us(fired.back()) << " us" << std::endl;
+
+    EXPECT_LT(fired[fired.size() * 99 / 100], std::chrono::milliseconds(50));
+}
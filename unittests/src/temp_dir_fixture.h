@@ -0,0 +1,34 @@
+#pragma once
+#include "common.h"
+
+#include <filesystem>
+
+// a directory of its own for every test in the temp directory: it is empty when the test starts
+// and is removed with everything in it after the test. _suite keeps the tests of different suites apart
+class temp_dir_test : public ::testing::Test
+{
+protected:
+    explicit temp_dir_test(std::string_view _suite)
+        : dir_(std::filesystem::temp_directory_path() / (std::string(_suite) + '_' + ::testing::UnitTest::GetInstance()->current_test_info()->name()))
+    {
+    }
+
+    void SetUp() override
+    {
+        std::filesystem::remove_all(dir_);
+        std::filesystem::create_directories(dir_);
+    }
+
+    void TearDown() override
+    {
+        std::error_code error;
+        std::filesystem::remove_all(dir_, error);
+    }
+
+    std::filesystem::path path(std::string_view _name) const
+    {
+        return dir_ / _name;
+    }
+
+    const std::filesystem::path dir_;
+};
@@ -0,0 +1,136 @@
+#include "common.h"
+
+#include "../../gui/stdafx.h"
+#include "../../core/tools/strings.h"
+#include "../../core/tools/system.h"
+#include "../../core/archive/term_matcher.h"
+
+#include <chrono>
+#include <random>
+
+using namespace core::archive;
+
+namespace
+{
+    coded_term make_term(const std::string& _term)
+    {
+        coded_term term;
+        term.lower_term = core::tools::system::to_lower(_term);
+        term.coded_string = core::tools::convert_string_to_vector(_term, std::make_shared<int32_t>(0), term.symbs, term.symb_indexes, term.symb_table);
+        term.prefix = core::tools::build_prefix(term.coded_string);
+        return term;
+    }
+
+    bool kmp_contains(const std::string& _text, const coded_term& _term)
+    {
+        return kmp_strstr(_text.data(), uint32_t(_text.size()), _term.coded_string, _term.prefix, _term.symbs, _term.symb_indexes) != -1;
+    }
+
+    bool contains(const std::string& _text, const coded_term& _term)
+    {
+        return term_matcher(_term).find(_text.data(), uint32_t(_text.size())) != -1;
+    }
+
+    std::string random_text(std::mt19937& _rng, size_t _symbols)
+    {
+        static const char* alphabet[] = { "a", "b", "A", "B", "\xD1\x84", "\xD0\xA4", "\xD1\x8F", "\xD0\xAF", " ", "1" };
+
+        std::string text;
+        for (size_t i = 0; i < _symbols; ++i)
+            text += alphabet[_rng() % std::size(alphabet)];
+        return text;
+    }
+}
+
+TEST(term_matcher_test, finds_case_insensitive)
+{
+    const auto term = make_term("Hello");
+
+    EXPECT_TRUE(contains("hello", term));
+    EXPECT_TRUE(contains("say HELLO world", term));
+    EXPECT_TRUE(contains("0123456789abcdef0123456789abcdef hElLo", term));
+    EXPECT_FALSE(contains("hell o", term));
+    EXPECT_FALSE(contains("hell", term));
+    EXPECT_FALSE(contains("", term));
+
+    EXPECT_EQ(term_matcher(term).find("xx hello", 8), 3);
+}
+
+TEST(term_matcher_test, finds_cyrillic)
+{
+    const auto term = make_term("\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82"); // "Привет"
+
+    EXPECT_TRUE(contains("\xD0\xBF\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82", term));
+    EXPECT_TRUE(contains("0123456789abcdef0123456789abcdef \xD0\x9F\xD0\xA0\xD0\x98\xD0\x92\xD0\x95\xD0\xA2!", term));
+    EXPECT_FALSE(contains("\xD0\xBF\xD1\x80\xD0\xB8\xD0\xB2", term));
+}
+
+TEST(term_matcher_test, doesnt_read_past_the_end)
+{
+    const auto term = make_term("ab");
+    const std::string text = "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxab";
+
+    // the match would only be complete one byte past the given size
+    EXPECT_EQ(term_matcher(term).find(text.data(), uint32_t(text.size() - 1)), -1);
+    EXPECT_EQ(term_matcher(term).find(text.data(), uint32_t(text.size())), int32_t(text.size() - 2));
+    EXPECT_EQ(term_matcher(term).find(nullptr, 0), -1);
+}
+
+TEST(term_matcher_test, agrees_with_kmp)
+{
+    std::mt19937 rng(1);
+
+    for (auto i = 0; i < 20000; ++i)
+    {
+        const auto text = random_text(rng, rng() % 100);
+        const auto term = make_term(random_text(rng, 1 + rng() % 4));
+
+        ASSERT_EQ(kmp_contains(text, term), contains(text, term)) << "text: " << text << ", term: " << term.lower_term;
+    }
+}
+
+// run with --gtest_also_run_disabled_tests, set TERM_MATCHER_DUMP to an archive _db file to measure on real history
+TEST(term_matcher_test, DISABLED_benchmark)
+{
+    std::string text;
+    if (const auto dump = std::getenv("TERM_MATCHER_DUMP"))
+    {
+        std::ifstream file(dump, std::ios::binary);
+        text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    if (text.empty())
+    {
+        std::mt19937 rng(1);
+        text = random_text(rng, 4 * 1024 * 1024);
+    }
+
+    const auto term = make_term("zqxw");
+    const term_matcher matcher(term);
+
+    constexpr auto iterations = 20;
+
+    using clock = std::chrono::steady_clock;
+
+    auto start = clock::now();
+    auto kmp_found = 0;
+    for (auto i = 0; i < iterations; ++i)
+        kmp_found += kmp_contains(text, term) ? 1 : 0;
+    const auto kmp_time = clock::now() - start;
+
+    start = clock::now();
+    auto found = 0;
+    for (auto i = 0; i < iterations; ++i)
+        found += matcher.find(text.data(), uint32_t(text.size())) != -1 ? 1 : 0;
+    const auto matcher_time = clock::now() - start;
+
+    EXPECT_EQ(kmp_found, found);
+
+    const auto mb_per_s = [size = double(text.size()) * iterations](auto _time)
+    {
+        return size / std::max(1.0, double(std::chrono::duration_cast<std::chrono::microseconds>(_time).count()));
+    };
+
+    std::cout << "text " << text.size() << " bytes, isa " << term_matcher::get_isa_name()
+        << ": kmp " << mb_per_s(kmp_time) << " MB/s, term_matcher " << mb_per_s(matcher_time) << " MB/s" << std::endl;
+}
@@ -0,0 +1,314 @@
+#include "common.h"
+
+#include "../../gui/stdafx.h"
+#include "../../core/tools/threadpool.h"
+
+namespace
+{
+    using core::tools::threadpool;
+    using core::tools::threadpool_mode;
+    using core::tools::log2_histogram;
+    using core::tools::threadpool_stats_snapshot;
+
+    // waits until the given number of tasks has been run
+    class counter
+    {
+    public:
+        void increment()
+        {
+            {
+                std::scoped_lock lock(mutex_);
+                ++count_;
+            }
+            condition_.notify_all();
+        }
+
+        bool wait_for(size_t _count, std::chrono::seconds _timeout = std::chrono::seconds(10))
+        {
+            std::unique_lock lock(mutex_);
+            return condition_.wait_for(lock, _timeout, [this, _count]() { return count_ >= _count; });
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        size_t count_ = 0;
+    };
+
+    // blocks the single worker until released, so the queue order can be set up
+    class gate
+    {
+    public:
+        void wait()
+        {
+            std::unique_lock lock(mutex_);
+            entered_ = true;
+            condition_.notify_all();
+            condition_.wait(lock, [this]() { return open_; });
+        }
+
+        void wait_entered()
+        {
+            std::unique_lock lock(mutex_);
+            condition_.wait(lock, [this]() { return entered_; });
+        }
+
+        void open()
+        {
+            {
+                std::scoped_lock lock(mutex_);
+                open_ = true;
+            }
+            condition_.notify_all();
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        bool entered_ = false;
+        bool open_ = false;
+    };
+
+    // the stats of a task are written after it returns, so they lag behind the task itself
+    threadpool_stats_snapshot wait_for_stats(const threadpool& _pool, uint64_t _tasks_count)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        for (;;)
+        {
+            auto snapshot = _pool.get_stats().get_snapshot();
+            if (snapshot.queue_depth_.get_count() >= _tasks_count || std::chrono::steady_clock::now() > deadline)
+                return snapshot;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+TEST(log2_histogram_test, buckets_and_percentiles)
+{
+    log2_histogram histogram;
+    EXPECT_EQ(histogram.get_percentile(0.5), 0u);
+
+    for (uint64_t value : { 0, 1, 2, 3, 100, 1000 })
+        histogram.add(value);
+
+    EXPECT_EQ(log2_histogram::bucket_of(0), 0u);
+    EXPECT_EQ(log2_histogram::bucket_of(1), 1u);
+    EXPECT_EQ(log2_histogram::bucket_of(3), 2u);
+    EXPECT_EQ(log2_histogram::bucket_of(100), 7u);
+    EXPECT_EQ(log2_histogram::bucket_of(std::numeric_limits<uint64_t>::max()), log2_histogram::buckets_count - 1);
+
+    EXPECT_EQ(histogram.get_count(), 6u);
+    EXPECT_EQ(histogram.get_sum(), 1106u);
+    EXPECT_EQ(histogram.get_max(), 1000u);
+    EXPECT_EQ(histogram.get_percentile(0.5), 4u);
+    EXPECT_EQ(histogram.get_percentile(0.99), 1000u);
+
+    log2_histogram other;
+    other.add(5000);
+    histogram.merge(other);
+    EXPECT_EQ(histogram.get_count(), 7u);
+    EXPECT_EQ(histogram.get_max(), 5000u);
+    EXPECT_EQ(histogram.get_buckets()[log2_histogram::bucket_of(5000)], 1u);
+}
+
+class threadpool_test : public ::testing::TestWithParam<threadpool_mode>
+{
+};
+
+TEST_P(threadpool_test, runs_all_tasks)
+{
+    constexpr size_t tasks_count = 10000;
+
+    counter done;
+    {
+        threadpool pool("test", 4, {}, false, GetParam());
+        for (size_t i = 0; i < tasks_count; ++i)
+            pool.push_back({ [&done]() { done.increment(); } });
+
+        EXPECT_TRUE(done.wait_for(tasks_count));
+    }
+}
+
+TEST_P(threadpool_test, runs_nested_tasks)
+{
+    constexpr size_t tasks_count = 1000;
+
+    counter done;
+    threadpool pool("test", 4, {}, false, GetParam());
+    for (size_t i = 0; i < tasks_count; ++i)
+    {
+        pool.push_back({ [&pool, &done]()
+        {
+            pool.push_back({ [&done]() { done.increment(); } });
+        } });
+    }
+
+    EXPECT_TRUE(done.wait_for(tasks_count));
+}
+
+TEST_P(threadpool_test, push_front_goes_first)
+{
+    gate blocker;
+    std::vector<int> order;
+    counter done;
+
+    threadpool pool("test", 1, {}, false, GetParam());
+    pool.push_back({ [&blocker]() { blocker.wait(); } });
+    blocker.wait_entered();
+
+    pool.push_back({ [&order, &done]() { order.push_back(1); done.increment(); } });
+    pool.push_back({ [&order, &done]() { order.push_back(2); done.increment(); } });
+    pool.push_front({ [&order, &done]() { order.push_back(0); done.increment(); } });
+
+    blocker.open();
+
+    ASSERT_TRUE(done.wait_for(3));
+    EXPECT_EQ(order, (std::vector<int>{ 0, 1, 2 }));
+}
+
+TEST_P(threadpool_test, raise_task_goes_first)
+{
+    gate blocker;
+    std::vector<int> order;
+    counter done;
+
+    threadpool pool("test", 1, {}, false, GetParam());
+    pool.push_back({ [&blocker]() { blocker.wait(); } });
+    blocker.wait_entered();
+
+    for (auto i : { 1, 2, 3 })
+        pool.push_back({ [&order, &done, i]() { order.push_back(i); done.increment(); } }, i);
+
+    pool.raise_task(3);
+    blocker.open();
+
+    ASSERT_TRUE(done.wait_for(3));
+    EXPECT_EQ(order, (std::vector<int>{ 3, 1, 2 }));
+}
+
+TEST_P(threadpool_test, cancelled_task_is_skipped)
+{
+    std::atomic_bool executed = false;
+    counter done;
+
+    threadpool pool("test", 2, {}, false, GetParam());
+    pool.push_back({ [&executed]() { executed = true; } }, -1, "cancelled", []() { return true; });
+    pool.push_back({ [&done]() { done.increment(); } });
+
+    ASSERT_TRUE(done.wait_for(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(executed);
+}
+
+TEST_P(threadpool_test, records_task_stats)
+{
+    constexpr auto blocked_time = std::chrono::milliseconds(20);
+
+    gate blocker;
+    counter done;
+
+    threadpool pool("stats_test", 1, {}, false, GetParam());
+    pool.push_back({ [&blocker]() { blocker.wait(); } }, -1, "blocker");
+    blocker.wait_entered();
+
+    for (int i = 0; i < 3; ++i)
+        pool.push_back({ [&done]() { done.increment(); } }, -1, "quick");
+    pool.push_back({ [&done]() { done.increment(); } });
+
+    std::this_thread::sleep_for(blocked_time);
+    blocker.open();
+    ASSERT_TRUE(done.wait_for(4));
+
+    const auto snapshot = wait_for_stats(pool, 5);
+    EXPECT_EQ(snapshot.name_, "stats_test");
+    EXPECT_EQ(snapshot.threads_count_, 1u);
+    EXPECT_GT(snapshot.get_busy_share(), 0.0);
+
+    // the queue held three tasks behind the first quick one
+    EXPECT_EQ(snapshot.queue_depth_.get_count(), 5u);
+    EXPECT_EQ(snapshot.queue_depth_.get_max(), 3u);
+
+    ASSERT_EQ(snapshot.tasks_.size(), 3u);
+
+    const auto& blocker_stats = snapshot.tasks_.at("blocker");
+    EXPECT_EQ(blocker_stats.run_us_.get_count(), 1u);
+    EXPECT_GE(blocker_stats.run_us_.get_max(), uint64_t(std::chrono::microseconds(blocked_time).count()));
+
+    const auto& quick_stats = snapshot.tasks_.at("quick");
+    EXPECT_EQ(quick_stats.wait_us_.get_count(), 3u);
+    EXPECT_GE(quick_stats.wait_us_.get_max(), uint64_t(std::chrono::microseconds(blocked_time).count()));
+
+    EXPECT_EQ(snapshot.tasks_.at("unnamed").run_us_.get_count(), 1u);
+
+    const auto pools = core::tools::get_threadpools_stats();
+    EXPECT_TRUE(std::any_of(pools.begin(), pools.end(), [](const auto& _pool) { return _pool.name_ == "stats_test"; }));
+}
+
+TEST_P(threadpool_test, drains_queue_on_destruction)
+{
+    constexpr size_t tasks_count = 1000;
+
+    std::atomic_size_t executed = 0;
+    {
+        threadpool pool("test", 3, {}, false, GetParam());
+        for (size_t i = 0; i < tasks_count; ++i)
+            pool.push_back({ [&executed]() { ++executed; } });
+    }
+
+    EXPECT_EQ(executed, tasks_count);
+}
+
+// bursts of small tasks from several producers, the way avatar and file meta loading behaves
+// run with --gtest_also_run_disabled_tests
+TEST_P(threadpool_test, DISABLED_benchmark_bursts)
+{
+    constexpr size_t producers_count = 4;
+    constexpr size_t bursts_count = 50;
+    constexpr size_t burst_size = 2000;
+    constexpr size_t tasks_count = producers_count * bursts_count * burst_size;
+
+    counter done;
+    std::atomic_size_t sink = 0;
+
+    threadpool pool("bench", std::max(2u, std::thread::hardware_concurrency()), {}, false, GetParam());
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < producers_count; ++p)
+    {
+        producers.emplace_back([&pool, &done, &sink]()
+        {
+            for (size_t b = 0; b < bursts_count; ++b)
+            {
+                for (size_t i = 0; i < burst_size; ++i)
+                {
+                    pool.push_back({ [&done, &sink, i]()
+                    {
+                        size_t value = i;
+                        for (auto k = 0; k < 200; ++k)
+                            value = value * 31 + k;
+                        sink += value & 1;
+
+                        if (i % 64 == 0)
+                            done.increment();
+                    } });
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        });
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    ASSERT_TRUE(done.wait_for(tasks_count / 64 + (tasks_count % 64 ? 1 : 0), std::chrono::seconds(60)));
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << (GetParam() == threadpool_mode::work_stealing ? "work_stealing" : "shared_queue")
+        << ": " << tasks_count << " tasks in " << elapsed / 1000 << " ms, "
+        << elapsed * 1000 / tasks_count << " ns/task" << std::endl;
+}
+
+INSTANTIATE_TEST_SUITE_P(modes, threadpool_test, ::testing::Values(threadpool_mode::shared_queue, threadpool_mode::work_stealing));
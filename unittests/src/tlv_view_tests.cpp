@@ -0,0 +1,273 @@
+#include "common.h"
+
+#include "../../gui/stdafx.h"
+#include "../../core/tools/binary_stream.h"
+#include "../../core/tools/tlv.h"
+#include "../../core/tools/tlv_view.h"
+#include "../../core/archive/history_message.h"
+
+#include <chrono>
+#include <fstream>
+
+using namespace core::tools;
+
+namespace
+{
+    constexpr uint32_t nested_type = 20;
+    constexpr uint32_t fields_count = 24;
+
+    // the shape of an archive message record: a few dozen scalars and strings and a nested pack
+    tlvpack make_record(int64_t _id)
+    {
+        tlvpack pack;
+        for (uint32_t type = 1; type < nested_type; ++type)
+        {
+            if (type % 3 == 0)
+                pack.push_child(tlv(type, "text of the field " + std::to_string(type)));
+            else
+                pack.push_child(tlv(type, _id + type));
+        }
+
+        tlvpack nested;
+        nested.push_child(tlv(1, std::string("user@agent")));
+        nested.push_child(tlv(2, int32_t(42)));
+        pack.push_child(tlv(nested_type, nested));
+
+        for (uint32_t type = nested_type + 1; type <= fields_count; ++type)
+            pack.push_child(tlv(type, uint32_t(type)));
+
+        return pack;
+    }
+
+    binary_stream to_stream(const tlvpack& _pack)
+    {
+        binary_stream stream;
+        _pack.serialize(stream);
+        return stream;
+    }
+
+    int64_t read_with_tlvpack(const binary_stream& _data)
+    {
+        tlvpack pack;
+        if (!pack.unserialize(_data))
+            return 0;
+
+        int64_t checksum = 0;
+        for (uint32_t type = 1; type <= fields_count; ++type)
+        {
+            if (const auto item = pack.get_item(type))
+            {
+                if (type == nested_type)
+                    checksum += item->get_value<tlvpack>().size();
+                else if (type % 3 == 0)
+                    checksum += item->get_value<std::string>().size();
+                else
+                    checksum += item->get_value<uint32_t>();
+            }
+        }
+
+        return checksum;
+    }
+
+    int64_t read_with_tlv_view(const binary_stream& _data)
+    {
+        tlv_view pack;
+        if (!pack.unserialize(_data))
+            return 0;
+
+        int64_t checksum = 0;
+        for (uint32_t type = 1; type <= fields_count; ++type)
+        {
+            if (const auto item = pack.get_item(type))
+            {
+                if (type == nested_type)
+                    checksum += item->get_value<tlv_view>().size();
+                else if (type % 3 == 0)
+                    checksum += item->get_value<std::string>().size();
+                else
+                    checksum += item->get_value<uint32_t>();
+            }
+        }
+
+        return checksum;
+    }
+
+    // data blocks of an archive _db file are framed as size, size, data, size, size
+    std::vector<binary_stream> read_db_blocks(const char* _file_name)
+    {
+        std::ifstream file(_file_name, std::ios::binary);
+        const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        std::vector<binary_stream> blocks;
+
+        size_t pos = 0;
+        while (data.size() - pos >= sizeof(uint32_t) * 2)
+        {
+            uint32_t size1 = 0, size2 = 0;
+            memcpy(&size1, data.data() + pos, sizeof(size1));
+            memcpy(&size2, data.data() + pos + sizeof(size1), sizeof(size2));
+            if (size1 != size2 || data.size() - pos < sizeof(uint32_t) * 4 + size1)
+                break;
+
+            binary_stream block;
+            block.write(data.data() + pos + sizeof(uint32_t) * 2, size1);
+            blocks.push_back(std::move(block));
+
+            pos += sizeof(uint32_t) * 4 + size1;
+        }
+
+        return blocks;
+    }
+}
+
+TEST(tlv_view_test, reads_what_tlvpack_writes)
+{
+    auto stream = to_stream(make_record(1000));
+
+    tlv_view view;
+    ASSERT_TRUE(view.unserialize(stream));
+    EXPECT_EQ(view.size(), fields_count);
+    EXPECT_EQ(stream.available(), 0);
+
+    EXPECT_EQ(view.get_item(1)->get_value<int64_t>(), 1001);
+    EXPECT_EQ(view.get_item(3)->get_value<std::string>(), "text of the field 3");
+    EXPECT_EQ(view.get_item(6)->get_value<std::string_view>(), "text of the field 6");
+    EXPECT_EQ(view.get_item(fields_count)->get_value<uint32_t>(), fields_count);
+    EXPECT_EQ(view.get_item(fields_count + 1), nullptr);
+
+    const auto nested = view.get_item(nested_type)->get_value<tlv_view>();
+    ASSERT_EQ(nested.size(), 2u);
+    EXPECT_EQ(nested.get_item(1)->get_value<std::string>(), "user@agent");
+    EXPECT_EQ(nested.get_item(2)->get_value<int32_t>(), 42);
+
+    uint32_t expected_type = 1;
+    for (const auto& field : view)
+        EXPECT_EQ(field.get_type(), expected_type++);
+}
+
+TEST(tlv_view_test, finds_first_of_duplicated_and_big_types)
+{
+    tlvpack pack;
+    pack.push_child(tlv(7, int32_t(1)));
+    pack.push_child(tlv(7, int32_t(2)));
+    pack.push_child(tlv(1000, int32_t(3)));
+    pack.push_child(tlv(127, int32_t(4)));
+    pack.push_child(tlv(128, int32_t(5)));
+
+    const auto stream = to_stream(pack);
+
+    tlv_view view;
+    ASSERT_TRUE(view.unserialize(stream));
+    EXPECT_EQ(view.get_item(7)->get_value<int32_t>(), 1);
+    EXPECT_EQ(view.get_item(1000)->get_value<int32_t>(), 3);
+    EXPECT_EQ(view.get_item(127)->get_value<int32_t>(), 4);
+    EXPECT_EQ(view.get_item(128)->get_value<int32_t>(), 5);
+    EXPECT_EQ(view.get_item(129), nullptr);
+}
+
+TEST(tlv_view_test, looks_up_many_fields)
+{
+    tlvpack pack;
+    for (uint32_t i = 0; i < 300; ++i)
+        pack.push_child(tlv(i % 100, i));
+
+    const auto stream = to_stream(pack);
+
+    tlv_view view;
+    ASSERT_TRUE(view.unserialize(stream));
+    for (uint32_t type = 0; type < 100; ++type)
+        EXPECT_EQ(view.get_item(type)->get_value<uint32_t>(), type);
+}
+
+TEST(tlv_view_test, broken_data)
+{
+    const auto stream = to_stream(make_record(1));
+    const std::string_view data(stream.get_data(), size_t(stream.all_size()));
+
+    tlv_view view;
+
+    // a truncated header at the end is ignored like tlvpack does
+    const auto first_size = sizeof(uint32_t) * 2 + sizeof(int64_t);
+    EXPECT_TRUE(view.unserialize(data.substr(0, first_size + 3)));
+    EXPECT_EQ(view.size(), 1u);
+
+    // a length running over the end of the buffer is an error
+    EXPECT_FALSE(view.unserialize(data.substr(0, first_size + sizeof(uint32_t) * 2 + 1)));
+
+    EXPECT_TRUE(view.unserialize(std::string_view()));
+    EXPECT_TRUE(view.empty());
+    EXPECT_EQ(view.get_item(1), nullptr);
+}
+
+TEST(tlv_view_test, matches_tlvpack)
+{
+    for (auto id = 0; id < 10; ++id)
+    {
+        const auto stream = to_stream(make_record(id));
+        const auto expected = read_with_tlvpack(stream);
+
+        stream.reset_out();
+        EXPECT_EQ(expected, read_with_tlv_view(stream));
+    }
+}
+
+TEST(tlv_view_test, history_message_fields_match_stream_scans)
+{
+    core::archive::history_message message;
+    message.set_msgid(1234);
+    message.set_text("text of the message");
+
+    binary_stream stream;
+    message.serialize(stream);
+
+    tlv_view view;
+    ASSERT_TRUE(view.unserialize(std::string_view(stream.get_data(), size_t(stream.available()))));
+
+    EXPECT_EQ(core::archive::history_message::get_id_field(view), core::archive::history_message::get_id_field(stream));
+
+    stream.reset_out();
+    uint32_t text_length = 0;
+    core::archive::history_message::jump_to_text_field(stream, text_length);
+    ASSERT_EQ(text_length, uint32_t(std::string_view("text of the message").size()));
+    EXPECT_EQ(core::archive::history_message::get_text_field(view), std::string_view(stream.read(text_length), text_length));
+
+    stream.reset_out();
+    EXPECT_EQ(core::archive::history_message::is_sticker(view), core::archive::history_message::is_sticker(stream));
+    stream.reset_out();
+    EXPECT_EQ(core::archive::history_message::is_chat_event(view), core::archive::history_message::is_chat_event(stream));
+}
+
+// run with --gtest_also_run_disabled_tests, set TLV_VIEW_DUMP to an archive _db file to measure on real history
+TEST(tlv_view_test, DISABLED_benchmark)
+{
+    std::vector<binary_stream> blocks;
+    if (const auto dump = std::getenv("TLV_VIEW_DUMP"))
+        blocks = read_db_blocks(dump);
+
+    if (blocks.empty())
+    {
+        for (auto id = 0; id < 100000; ++id)
+            blocks.push_back(to_stream(make_record(id)));
+    }
+
+    using clock = std::chrono::steady_clock;
+
+    const auto measure = [&blocks](std::string_view _name, auto _read)
+    {
+        int64_t checksum = 0;
+        const auto start = clock::now();
+        for (auto& block : blocks)
+        {
+            block.reset_out();
+            checksum += _read(block);
+        }
+        const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+
+        std::cout << _name << ": " << time / int64_t(blocks.size()) << " ns per record" << std::endl;
+        return checksum;
+    };
+
+    std::cout << blocks.size() << " records" << std::endl;
+
+    EXPECT_EQ(measure("tlvpack", read_with_tlvpack), measure("tlv_view", read_with_tlv_view));
+}
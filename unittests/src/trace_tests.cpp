@@ -0,0 +1,173 @@
+#include "common.h"
+#include "temp_dir_fixture.h"
+
+#include "../../gui/stdafx.h"
+#include "../../core/profiling/trace.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace core::profiler;
+
+namespace
+{
+    class trace_test : public temp_dir_test
+    {
+    protected:
+        trace_test() : temp_dir_test("trace_test") {}
+
+        const std::filesystem::path file_ = path("trace.json");
+
+        void TearDown() override
+        {
+            trace::stop();
+            temp_dir_test::TearDown();
+        }
+
+        std::string read() const
+        {
+            std::ifstream stream(file_, std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        }
+
+        static size_t count(std::string_view _text, std::string_view _what)
+        {
+            size_t result = 0;
+            for (auto pos = _text.find(_what); pos != std::string_view::npos; pos = _text.find(_what, pos + _what.size()))
+                ++result;
+            return result;
+        }
+    };
+}
+
+TEST_F(trace_test, writes_complete_events)
+{
+    ASSERT_TRUE(trace::start(file_.wstring()));
+    EXPECT_TRUE(trace::is_enabled());
+    EXPECT_FALSE(trace::start(file_.wstring()));
+
+    {
+        PROFILER_ZONE("test", "outer");
+        PROFILER_ZONE_DETAIL("test", "inner", "say \"hi\"\\");
+    }
+
+    std::thread thread([]()
+    {
+        trace::set_thread_name("trace_test_worker");
+        const std::string detail(100, 'd');
+        PROFILER_ZONE_DETAIL("test", "worker", detail);
+    });
+    thread.join();
+
+    trace::stop();
+    EXPECT_FALSE(trace::is_enabled());
+
+    const auto text = read();
+    EXPECT_EQ(text.rfind("{\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(text.find("\"dropped_zones\":\"0\"}}"), std::string::npos);
+
+    EXPECT_EQ(count(text, "\"ph\":\"X\""), 3u);
+    EXPECT_EQ(count(text, "\"ph\":\"M\""), 2u);
+    EXPECT_NE(text.find("{\"name\":\"outer\",\"cat\":\"test\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(text.find("\"args\":{\"detail\":\"say \\\"hi\\\"\\\\\"}"), std::string::npos);
+    EXPECT_NE(text.find("\"args\":{\"name\":\"trace_test_worker\"}"), std::string::npos);
+
+    // the detail is cut, not the event
+    EXPECT_NE(text.find("\"args\":{\"detail\":\"" + std::string(31, 'd') + "\"}"), std::string::npos);
+}
+
+TEST_F(trace_test, skips_zones_outside_of_trace)
+{
+    {
+        PROFILER_ZONE("test", "before");
+    }
+
+    std::optional<trace::zone> open_zone;
+    open_zone.emplace("test", "started before");
+
+    ASSERT_TRUE(trace::start(file_.wstring()));
+    open_zone.reset();
+    {
+        PROFILER_ZONE("test", "during");
+        open_zone.emplace("test", "stopped after");
+    }
+    trace::stop();
+    open_zone.reset();
+
+    {
+        PROFILER_ZONE("test", "after");
+    }
+
+    const auto text = read();
+    EXPECT_EQ(count(text, "\"ph\":\"X\""), 1u);
+    EXPECT_NE(text.find("\"name\":\"during\""), std::string::npos);
+}
+
+TEST_F(trace_test, counts_dropped_zones)
+{
+    ASSERT_TRUE(trace::start(file_.wstring()));
+
+    // more than a ring holds between two drains of the trace thread
+    constexpr int zones_count = 100000;
+    const auto dropped = trace::get_dropped_count();
+    for (int i = 0; i < zones_count; ++i)
+    {
+        PROFILER_ZONE("test", "zone");
+    }
+    const auto dropped_now = trace::get_dropped_count() - dropped;
+
+    trace::stop();
+
+    const auto text = read();
+    EXPECT_GT(dropped_now, 0);
+    EXPECT_EQ(int64_t(count(text, "\"ph\":\"X\"")) + dropped_now, zones_count);
+    EXPECT_NE(text.find("\"dropped_zones\":\"" + std::to_string(dropped_now) + '"'), std::string::npos);
+}
+
+// run with --gtest_also_run_disabled_tests
+TEST_F(trace_test, DISABLED_benchmark)
+{
+    using clock = std::chrono::steady_clock;
+
+    // below a ring, so nothing is dropped while tracing
+    constexpr int iterations = 4000;
+    constexpr int rounds = 50;
+
+    const auto measure = [](std::string_view _name)
+    {
+        int64_t total = 0;
+        for (int r = 0; r < rounds; ++r)
+        {
+            const auto start = clock::now();
+            for (int i = 0; i < iterations; ++i)
+            {
+                PROFILER_ZONE_DETAIL("bench", "zone", "archive/messages/get");
+            }
+            total += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+
+            // let the trace thread catch up
+            std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        }
+
+        std::cout << _name << ": " << total / (int64_t(iterations) * rounds) << " ns per zone" << std::endl;
+    };
+
+    {
+        // the floor of an enabled zone, it takes two time stamps
+        int64_t sum = 0;
+        const auto start = clock::now();
+        for (int i = 0; i < iterations * rounds; ++i)
+            sum += trace::details::now() - trace::details::now();
+        const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+        std::cout << "two time stamps: " << time / (int64_t(iterations) * rounds) << " ns" << std::endl;
+        EXPECT_LE(sum, 0);
+    }
+
+    measure("trace disabled");
+
+    ASSERT_TRUE(trace::start(file_.wstring()));
+    const auto dropped = trace::get_dropped_count();
+    measure("trace enabled");
+    EXPECT_EQ(trace::get_dropped_count(), dropped);
+    trace::stop();
+}